@@ -0,0 +1,510 @@
+#include "datastorage/actor.h"
+#include "datastorage/blockchain.h"
+#include "datastorage/dfs/fragment_storage.h"
+#include "datastorage/index/actor_directory.h"
+#include "datastorage/index/blockindex.h"
+#include "datastorage/index/memindex.h"
+#include "enc/enc_tools.h"
+#include "managers/logs_manager.h"
+#include "utils/bignumber_float.h"
+#include "utils/dfs_utils.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QTemporaryDir>
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sodium.h>
+
+// Synthetic data only, generated with fixed seeds inside a temporary directory
+// that is the working directory while benchmarks run. Results are written as
+// JSON to extrachain-benchmarks.json unless --benchmark_out is given.
+
+namespace {
+const Actor<KeyPrivate> &approver() {
+    static const Actor<KeyPrivate> actor = [] {
+        Actor<KeyPrivate> actor;
+        actor.create(ActorType::User);
+        return actor;
+    }();
+    return actor;
+}
+
+const Actor<KeyPrivate> &receiver() {
+    static const Actor<KeyPrivate> actor = [] {
+        Actor<KeyPrivate> actor;
+        actor.create(ActorType::User);
+        return actor;
+    }();
+    return actor;
+}
+
+std::string randomData(std::size_t size, uint64_t seed = 1) {
+    std::mt19937_64 random(seed);
+    std::string data(size, '\0');
+    for (auto &byte : data)
+        byte = char(random());
+    return data;
+}
+
+Block makeBlock(const Block &prev, int txCount) {
+    std::vector<std::string> txs;
+    txs.reserve(txCount);
+    for (int i = 0; i < txCount; i++) {
+        Transaction tx(approver().id(), receiver().id(), Transaction::visibleToAmount("1"));
+        tx.setToken(approver().id());
+        tx.sign(approver());
+        txs.push_back(tx.serialize());
+    }
+    Block block(Serialization::serialize(txs), prev);
+    block.sign(approver());
+    return block;
+}
+
+Transaction makeTransaction() {
+    Transaction tx(approver().id(), receiver().id(), Transaction::visibleToAmount("12.5"));
+    tx.setToken(approver().id());
+    tx.setPrevBlock(BigNumber(123456));
+    tx.setProducer(approver().id());
+    tx.sign(approver());
+    return tx;
+}
+
+// Transaction as packed by versions without binary encoding, numbers and ids are strings
+std::string legacyTransaction(const Transaction &tx) {
+    msgpack::sbuffer buffer;
+    msgpack::packer packer(buffer);
+    packer.pack_array(14);
+    packer.pack(tx.getSender().toStdString());
+    packer.pack(tx.getReceiver().toStdString());
+    packer.pack(tx.getAmount().toLegacyString());
+    packer.pack(tx.getDate());
+    packer.pack(tx.getData());
+    packer.pack(tx.getToken().toStdString());
+    packer.pack(tx.getPrevBlock().toStdString());
+    packer.pack(tx.getGas());
+    packer.pack(tx.getHop());
+    packer.pack(tx.getHash());
+    packer.pack(tx.getApprover().toStdString());
+    packer.pack(tx.getProducer().toStdString());
+    packer.pack(tx.getDigSig());
+    packer.pack(tx.getTypeTx());
+    return std::string(buffer.data(), buffer.size());
+}
+
+std::vector<Block> makeChain(std::size_t count, int txCount) {
+    std::vector<Block> chain;
+    chain.reserve(count);
+    Block prev;
+    for (std::size_t i = 0; i < count; i++) {
+        chain.push_back(makeBlock(prev, txCount));
+        prev = chain.back();
+    }
+    return chain;
+}
+}
+
+// Blocks //
+
+static void blockIndexAdd(benchmark::State &state) {
+    const auto chain = makeChain(std::size_t(state.max_iterations), int(state.range(0)));
+    BlockIndex index;
+    index.removeAll();
+    std::size_t i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(index.addBlock(chain[i++]));
+    index.removeAll();
+}
+BENCHMARK(blockIndexAdd)->Arg(16)->Iterations(1000)->Unit(benchmark::kMicrosecond);
+
+static void blockIndexGetById(benchmark::State &state) {
+    const std::size_t count = 1000;
+    BlockIndex index;
+    index.removeAll();
+    for (const auto &block : makeChain(count, int(state.range(0))))
+        index.addBlock(block);
+
+    std::mt19937_64 random(1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(index.getBlockById(BigNumber(int(random() % count))));
+    index.removeAll();
+}
+BENCHMARK(blockIndexGetById)->Arg(16)->Unit(benchmark::kMicrosecond);
+
+static void memIndexGetById(benchmark::State &state) {
+    const std::size_t count = 1000;
+    MemIndex index(int(count));
+    for (const auto &block : makeChain(count, int(state.range(0))))
+        index.addBlock(block);
+
+    std::mt19937_64 random(1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(index[BigNumber(int(random() % count))]);
+}
+BENCHMARK(memIndexGetById)->Arg(16)->Unit(benchmark::kMicrosecond);
+
+static void userBalance(benchmark::State &state) {
+    Blockchain blockchain(nullptr);
+    auto &index = blockchain.getBlockIndex();
+    index.removeAll();
+    for (const auto &block : makeChain(std::size_t(state.range(0)), 16))
+        index.addBlock(block);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(blockchain.getUserBalance(receiver().id(), approver().id()));
+    state.SetComplexityN(state.range(0));
+    index.removeAll();
+}
+BENCHMARK(userBalance)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond)->Complexity();
+
+static void blockDataForHash(benchmark::State &state) {
+    const Block block = makeBlock(Block(), int(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(block.getDataForHash());
+}
+BENCHMARK(blockDataForHash)->Arg(1)->Arg(16)->Arg(256);
+
+// Serialization //
+
+static void serializeList(benchmark::State &state) {
+    std::vector<std::string> list;
+    for (int i = 0; i < state.range(0); i++)
+        list.push_back(randomData(256, uint64_t(i)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Serialization::serialize(list));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(serializeList)->Arg(16)->Arg(1024);
+
+static void deserializeList(benchmark::State &state) {
+    std::vector<std::string> list;
+    for (int i = 0; i < state.range(0); i++)
+        list.push_back(randomData(256, uint64_t(i)));
+    const std::string serialized = Serialization::serialize(list);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Serialization::deserialize(serialized));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(deserializeList)->Arg(16)->Arg(1024);
+
+static void blockSerialize(benchmark::State &state) {
+    const Block block = makeBlock(Block(), int(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(block.serialize());
+}
+BENCHMARK(blockSerialize)->Arg(16)->Arg(256);
+
+static void blockDeserialize(benchmark::State &state) {
+    const QByteArray serialized = makeBlock(Block(), int(state.range(0))).serialize();
+    for (auto _ : state) {
+        Block block(serialized);
+        benchmark::DoNotOptimize(block);
+    }
+}
+BENCHMARK(blockDeserialize)->Arg(16)->Arg(256);
+
+static void transactionEncode(benchmark::State &state) {
+    const Transaction tx = makeTransaction();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(MessagePack::serialize(tx));
+    state.counters["bytes"] = double(MessagePack::serialize(tx).size());
+}
+BENCHMARK(transactionEncode);
+
+static void transactionEncodeLegacy(benchmark::State &state) {
+    const Transaction tx = makeTransaction();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(legacyTransaction(tx));
+    state.counters["bytes"] = double(legacyTransaction(tx).size());
+}
+BENCHMARK(transactionEncodeLegacy);
+
+// decoded into existing object, constructor of Transaction calculates hash
+static void transactionDecode(benchmark::State &state) {
+    const std::string serialized = MessagePack::serialize(makeTransaction());
+    Transaction tx;
+    for (auto _ : state) {
+        msgpack::unpack(serialized.data(), serialized.size()).get().convert(tx);
+        benchmark::DoNotOptimize(tx);
+    }
+    state.counters["bytes"] = double(serialized.size());
+}
+BENCHMARK(transactionDecode);
+
+static void transactionDecodeLegacy(benchmark::State &state) {
+    const std::string serialized = legacyTransaction(makeTransaction());
+    Transaction tx;
+    for (auto _ : state) {
+        msgpack::unpack(serialized.data(), serialized.size()).get().convert(tx);
+        benchmark::DoNotOptimize(tx);
+    }
+    state.counters["bytes"] = double(serialized.size());
+}
+BENCHMARK(transactionDecodeLegacy);
+
+// Amounts //
+
+static void sumAmounts(benchmark::State &state) {
+    std::vector<Amount> amounts;
+    amounts.reserve(std::size_t(state.range(0)));
+    for (long long i = 0; i < state.range(0); i++)
+        amounts.push_back(Amount::unit() + Amount(i));
+    for (auto _ : state) {
+        Amount sum;
+        for (const auto &amount : amounts)
+            sum += amount;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(sumAmounts)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// Same values in type used for amounts before
+static void sumBigNumberFloats(benchmark::State &state) {
+    std::vector<BigNumberFloat> amounts;
+    amounts.reserve(std::size_t(state.range(0)));
+    for (long long i = 0; i < state.range(0); i++)
+        amounts.push_back(BigNumberFloat(1000000000000000000LL + i));
+    for (auto _ : state) {
+        BigNumberFloat sum;
+        for (const auto &amount : amounts)
+            sum += amount;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(sumBigNumberFloats)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// BigNumber //
+
+// block ids for 0, values over 64 bits for 1
+std::vector<BigNumber> bigNumbers(bool big) {
+    std::vector<BigNumber> numbers;
+    std::mt19937_64 random(1);
+    for (int i = 0; i < 1024; i++) {
+        const BigNumber number(static_cast<long long>(random() >> 16));
+        numbers.push_back(big ? number * BigNumber(static_cast<long long>(random() >> 1)) : number);
+    }
+    return numbers;
+}
+
+static void bigNumberParse(benchmark::State &state) {
+    std::vector<std::string> hex;
+    for (const auto &number : bigNumbers(state.range(0)))
+        hex.push_back(number.toStdString());
+    for (auto _ : state)
+        for (const auto &text : hex)
+            benchmark::DoNotOptimize(BigNumber(text));
+    state.SetItemsProcessed(state.iterations() * int64_t(hex.size()));
+}
+BENCHMARK(bigNumberParse)->Arg(0)->Arg(1);
+
+static void bigNumberFormat(benchmark::State &state) {
+    const auto numbers = bigNumbers(state.range(0));
+    for (auto _ : state)
+        for (const auto &number : numbers)
+            benchmark::DoNotOptimize(number.toStdString());
+    state.SetItemsProcessed(state.iterations() * int64_t(numbers.size()));
+}
+BENCHMARK(bigNumberFormat)->Arg(0)->Arg(1);
+
+static void bigNumberArithmetic(benchmark::State &state) {
+    const auto numbers = bigNumbers(state.range(0));
+    for (auto _ : state) {
+        BigNumber sum;
+        BigNumber counter;
+        for (const auto &number : numbers) {
+            sum += number;
+            if (sum > number)
+                ++counter;
+        }
+        benchmark::DoNotOptimize(sum);
+        benchmark::DoNotOptimize(counter);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(numbers.size()));
+}
+BENCHMARK(bigNumberArithmetic)->Arg(0)->Arg(1);
+
+// Actors //
+
+std::string actorId(std::size_t i) {
+    return BigNumber(static_cast<long long>(i + 1)).toZeroStdString(20);
+}
+
+// table of count actors with random keys, filled in one transaction
+void fillActors(const std::string &folder, std::size_t count) {
+    std::filesystem::remove_all(folder);
+    std::filesystem::create_directories(folder);
+    ActorDirectory directory(folder);
+    std::vector<std::vector<std::string>> rows;
+    rows.reserve(count);
+    for (std::size_t i = 0; i < count; i++)
+        rows.push_back({ actorId(i), "0", randomData(32, i) });
+    DBConnector db(folder + "actors");
+    db.open();
+    db.execMany("INSERT INTO " + Config::DataStorage::actorsTable
+                    + " (id, type, key) VALUES (?, ?, CAST(? AS BLOB));",
+                rows);
+}
+
+static void actorDirectoryOpen(benchmark::State &state) {
+    const std::string folder = "actors-bench/";
+    fillActors(folder, std::size_t(state.range(0)));
+    for (auto _ : state) {
+        ActorDirectory directory(folder);
+        benchmark::DoNotOptimize(directory.count());
+    }
+    std::filesystem::remove_all(folder);
+}
+BENCHMARK(actorDirectoryOpen)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// lookups of recently used actors for 1, lookups that read table for 0
+static void actorDirectoryGet(benchmark::State &state) {
+    const std::string folder = "actors-bench/";
+    const std::size_t count = std::size_t(state.range(0));
+    fillActors(folder, count);
+    const bool cached = state.range(1);
+    ActorDirectory directory(folder, cached ? ActorDirectory::DEFAULT_CAPACITY : 0);
+    const std::size_t used = cached ? std::min<std::size_t>(count, 1024) : count;
+    for (std::size_t i = 0; i < used && cached; i++)
+        directory.get(actorId(i));
+
+    std::mt19937_64 random(1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(directory.get(actorId(random() % used)));
+    std::filesystem::remove_all(folder);
+}
+BENCHMARK(actorDirectoryGet)->Args({ 1000000, 1 })->Args({ 1000000, 0 })->Unit(benchmark::kMicrosecond);
+
+// Keys //
+
+static void sign(benchmark::State &state) {
+    const std::string data = randomData(std::size_t(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(approver().key().sign(data));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(sign)->Arg(64)->Arg(4 * 1024)->Arg(64 * 1024);
+
+static void verify(benchmark::State &state) {
+    const std::string data = randomData(std::size_t(state.range(0)));
+    const std::string signature = approver().key().sign(data);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(approver().key().verify(data, signature));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(verify)->Arg(64)->Arg(4 * 1024)->Arg(64 * 1024);
+
+// Same calls as SocketService::prepareSendMessage, prepareSendFrame and prepareReceiveMessage
+static void socketEncryptMessage(benchmark::State &state) {
+    const std::string data = randomData(std::size_t(state.range(0)));
+    const auto &priv = approver().key();
+    const auto &pub = receiver().key();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(priv.encrypt(data, pub.publicKey()));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(socketEncryptMessage)->Arg(256)->Arg(64 * 1024)->Arg(1024 * 1024);
+
+static void socketEncryptFrame(benchmark::State &state) {
+    const std::string data = randomData(std::size_t(state.range(0)));
+    const std::string sharedKey =
+        SecretKey::asymmetricSharedKey(approver().key().secretKey(), receiver().key().publicKey());
+    std::string result;
+    for (auto _ : state) {
+        SecretKey::encryptAsymmetricTo(result, data, sharedKey);
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(socketEncryptFrame)->Arg(256)->Arg(64 * 1024)->Arg(1024 * 1024);
+
+static void socketDecryptMessage(benchmark::State &state) {
+    const auto &priv = approver().key();
+    const auto &peer = receiver().key();
+    const std::string encrypted = peer.encrypt(randomData(std::size_t(state.range(0))), priv.publicKey());
+    for (auto _ : state)
+        benchmark::DoNotOptimize(priv.decrypt(encrypted, peer.publicKey()));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(socketDecryptMessage)->Arg(256)->Arg(64 * 1024)->Arg(1024 * 1024);
+
+// Files //
+
+static void fragmentWrite(benchmark::State &state) {
+    const ActorId actor = approver().id();
+    const std::string fileName = "fragments-" + std::to_string(state.range(0));
+    const auto path = DFS_PATH::filePath(actor, fileName);
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary | std::ios::trunc);
+
+    const std::string data = randomData(std::size_t(state.range(0)));
+    uint64_t offset = 0;
+    {
+        FragmentStorage storage(actor, fileName, "");
+        for (auto _ : state) {
+            const DFSP::SegmentMessage msg = { .Actor = actor.toStdString(),
+                                               .FileName = fileName,
+                                               .FileHash = "",
+                                               .Data = data,
+                                               .Offset = offset };
+            benchmark::DoNotOptimize(storage.insertFragment(msg));
+            offset += data.size();
+        }
+    }
+    state.SetBytesProcessed(int64_t(offset));
+    std::filesystem::remove(path);
+    std::filesystem::remove(path.string() + DFSF::Extension);
+}
+BENCHMARK(fragmentWrite)->Arg(4 * 1024)->Arg(64 * 1024)->Iterations(500)->Unit(benchmark::kMicrosecond);
+
+static void hashFile(benchmark::State &state) {
+    const std::filesystem::path path = "hash-" + std::to_string(state.range(0));
+    std::ofstream(path, std::ios::binary) << randomData(std::size_t(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Utils::calcHashForFile(path));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    std::filesystem::remove(path);
+}
+BENCHMARK(hashFile)->Arg(64 * 1024)->Arg(16 * 1024 * 1024)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char **argv) {
+    QCoreApplication app(argc, argv);
+    if (sodium_init() < 0)
+        return 1;
+    LogsManager::emptyHandler();
+
+    // output is opened after working directory is changed
+    std::vector<std::string> args(argv, argv + argc);
+    bool hasOut = false;
+    for (auto &arg : args) {
+        const std::string flag = "--benchmark_out=";
+        if (arg.starts_with(flag)) {
+            arg = flag + std::filesystem::absolute(arg.substr(flag.size())).string();
+            hasOut = true;
+        }
+    }
+    if (!hasOut) {
+        args.push_back("--benchmark_out="
+                       + std::filesystem::absolute("extrachain-benchmarks.json").string());
+        args.push_back("--benchmark_out_format=json");
+    }
+    std::vector<char *> argsData;
+    for (auto &arg : args)
+        argsData.push_back(arg.data());
+    int argsCount = int(argsData.size());
+    benchmark::Initialize(&argsCount, argsData.data());
+    if (benchmark::ReportUnrecognizedArguments(argsCount, argsData.data()))
+        return 1;
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        return 1;
+    const QString workingDir = QDir::currentPath();
+    QDir::setCurrent(dir.path());
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    QDir::setCurrent(workingDir);
+    return 0;
+}
@@ -109,17 +109,54 @@ public:
         return actor.isEmpty();
     }
 
+    // ids of 20 hex digits are packed as ext of 10 bytes, others as string
     template <typename Packer>
     void msgpack_pack(Packer &msgpack_pk) const {
+        char bytes[Size / 2];
+        if (toBytes(bytes)) {
+            msgpack_pk.pack_ext(sizeof(bytes), MessagePackExt::ActorIdV1);
+            msgpack_pk.pack_ext_body(bytes, sizeof(bytes));
+            return;
+        }
         msgpack_pk.pack_str(m_id.size());
         msgpack_pk.pack_str_body(m_id.data(), m_id.size());
     }
 
     void msgpack_unpack(msgpack::object const &msgpack_o) {
-        m_id = msgpack_o.as<std::string>();
+        if (msgpack_o.type != msgpack::type::EXT) {
+            m_id = msgpack_o.as<std::string>();
+            return;
+        }
+        if (msgpack_o.via.ext.type() != MessagePackExt::ActorIdV1 || msgpack_o.via.ext.size != Size / 2)
+            throw msgpack::type_error();
+        static const char digits[] = "0123456789abcdef";
+        m_id.resize(Size);
+        for (std::size_t i = 0; i < Size / 2; i++) {
+            const auto byte = uint8_t(msgpack_o.via.ext.data()[i]);
+            m_id[2 * i] = digits[byte >> 4];
+            m_id[2 * i + 1] = digits[byte & 0xf];
+        }
     }
 
 private:
+    static const std::size_t Size = 20;
+
+    bool toBytes(char *bytes) const {
+        if (m_id.size() != Size)
+            return false;
+        for (std::size_t i = 0; i < Size; i++) {
+            const char c = m_id[i];
+            const int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+            if (digit < 0)
+                return false;
+            if (i % 2 == 0)
+                bytes[i / 2] = char(digit << 4);
+            else
+                bytes[i / 2] = char(bytes[i / 2] | digit);
+        }
+        return true;
+    }
+
     void normalize() {
         m_id = QByteArray("0").repeated(20 - m_id.length()).toStdString() + m_id;
     }
@@ -133,6 +133,11 @@ public:
     // digital signature
     virtual void sign(const Actor<KeyPrivate> &actor) final;
     virtual bool verify(const Actor<KeyPublic> &actor) const final;
+    /**
+     * @brief Recalculates hash from block fields
+     * @return true if it matches the stored hash
+     */
+    bool checkHash() const;
 
     // serialization
 
@@ -159,6 +164,7 @@ public:
     std::string getPrevHash() const;
     std::string getDigSig() const;
     QByteArrayList getListSignatures() const;
+    const std::vector<Approvers> &getSignatures() const;
     void addSignature(const QByteArray &id, const QByteArray &sign, const bool &isApprover);
     // void setType(QByteArray type);
     long long getDate() const;
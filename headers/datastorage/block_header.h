@@ -0,0 +1,69 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef BLOCK_HEADER_H
+#define BLOCK_HEADER_H
+
+#include <string>
+#include <vector>
+
+#include "datastorage/block.h"
+#include "utils/bignumber.h"
+
+/**
+ * @brief Compact representation of a block without payload
+ * Carries everything needed to compare chains and detect forks:
+ * height, hash, prevHash, Merkle root of the payload and the signer set.
+ */
+struct EXTRACHAIN_EXPORT BlockHeader {
+    BigNumber index = BigNumber(-1);
+    std::string type;
+    long long date = 0;
+    std::string hash;
+    std::string prevHash;
+    std::string dataRoot; // Merkle root of transaction hashes (or of data for other block types)
+    std::vector<Approvers> signers;
+
+    MSGPACK_DEFINE(index, type, date, hash, prevHash, dataRoot, signers)
+
+    BlockHeader() = default;
+    explicit BlockHeader(const Block &block);
+
+    bool isEmpty() const;
+    ActorId approver() const;
+    /**
+     * @brief Check that block has the same height, hashes and payload
+     */
+    bool matches(const Block &block) const;
+    /**
+     * @brief Verify approver signature of header hash, payload is not needed
+     */
+    bool verify(const Actor<KeyPublic> &actor) const;
+
+    static std::string payloadRoot(const Block &block);
+    static std::string merkleRoot(std::vector<std::string> leaves);
+
+    bool operator==(const BlockHeader &other) const {
+        return index == other.index && hash == other.hash && prevHash == other.prevHash
+            && dataRoot == other.dataRoot;
+    }
+};
+
+#endif // BLOCK_HEADER_H
@@ -0,0 +1,161 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef BLOCK_SYNC_H
+#define BLOCK_SYNC_H
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <QFuture>
+
+#include "datastorage/block.h"
+#include "datastorage/block_header.h"
+#include "utils/bignumber.h"
+
+namespace BlockSyncPackets {
+struct Tip {
+    BigNumber Index;
+    std::string Hash;
+    MSGPACK_DEFINE(Index, Hash)
+};
+
+struct RangeRequest {
+    BigNumber From;
+    uint32_t Count;
+    MSGPACK_DEFINE(From, Count)
+};
+
+struct RangeResponse {
+    BigNumber From;
+    std::vector<std::string> Blocks; // serialized Block or GenesisBlock
+    MSGPACK_DEFINE(From, Blocks)
+};
+
+struct HeaderRange {
+    BigNumber From;
+    std::vector<BlockHeader> Headers;
+    MSGPACK_DEFINE(From, Headers)
+};
+}
+namespace BSP = BlockSyncPackets;
+
+/**
+ * @brief Catch up with peers by height ranges
+ * Exchanges tips, requests contiguous ranges with a bounded window,
+ * verifies hashes and signatures of every received range in parallel
+ * and commits ranges in height order when their check is done. Every range
+ * is asked from one peer that advertised it, a range a peer can't serve
+ * goes to another one.
+ */
+class EXTRACHAIN_EXPORT BlockSync {
+public:
+    struct Storage {
+        std::function<BSP::Tip()> tip;
+        std::function<QByteArray(const BigNumber &id)> blockData;
+        std::function<bool(const Block &block)> verify;
+        std::function<int(const std::vector<std::string> &blocks)> commit;
+        // runs function in thread of storage, ranges are committed there after their check
+        std::function<void(std::function<void()> function)> post;
+    };
+
+    struct Transport {
+        std::function<void()> requestTip;
+        // empty peer is any peer, used while no peer advertised its tip
+        std::function<void(const std::string &peer, const BSP::RangeRequest &request)> requestRange;
+    };
+
+    // Blocks requested with one message
+    static const uint32_t BATCH_SIZE = 500;
+    // Upper bound for blocks served with one message
+    static const uint32_t MAX_BATCH_SIZE = 2000;
+    // Upper bound for headers served with one message
+    static const uint32_t MAX_HEADERS = 20000;
+    // Ranges requested but not committed yet
+    static const int WINDOW = 4;
+
+private:
+    struct Request {
+        uint32_t count;
+        std::string peer;
+    };
+
+    struct Pending {
+        std::vector<std::string> serialized;
+        std::vector<Block> blocks;
+        QFuture<bool> valid;
+    };
+
+    Storage m_storage;
+    Transport m_transport;
+    mutable std::recursive_mutex m_mutex;
+
+    bool m_syncing = false;
+    BigNumber m_target = -1;
+    BigNumber m_nextRequest = 0;
+    BigNumber m_nextCommit = 0;
+    std::string m_lastHash;
+    std::map<BigNumber, Request> m_inFlight; // by from
+    std::map<BigNumber, Pending> m_pending;
+    std::vector<QFuture<void>> m_resumes; // continuations of checks, awaited on destruction
+    std::map<std::string, BigNumber> m_peers; // advertised tips
+    uint64_t m_committed = 0;
+
+public:
+    BlockSync(Storage storage, Transport transport);
+    /**
+     * @brief Waits for checks of received ranges
+     */
+    ~BlockSync();
+
+    void requestTip();
+    BSP::Tip localTip() const;
+    BSP::RangeResponse blockRange(const BSP::RangeRequest &request) const;
+
+    /**
+     * @brief Remember tip of peer, ranges up to it can be asked from peer
+     */
+    void addPeer(const std::string &peer, const BigNumber &tip);
+    /**
+     * @brief Start or extend sync if remote tip is higher than local
+     */
+    void handleTip(const BSP::Tip &tip, const std::string &peer = std::string());
+    void handleRange(const BSP::RangeResponse &response, const std::string &peer = std::string());
+
+    bool isSyncing() const;
+    BigNumber target() const;
+    uint64_t committed() const;
+
+private:
+    void fillWindow();
+    /**
+     * @return false if no known peer has the range
+     */
+    bool sendRequest(const BigNumber &from, uint32_t count);
+    std::optional<std::string> choosePeer(const BigNumber &from, uint32_t count) const;
+    void commitReady();
+    bool checkChain(const std::vector<Block> &blocks) const;
+    void stop();
+};
+
+#endif // BLOCK_SYNC_H
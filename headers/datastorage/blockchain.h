@@ -22,8 +22,10 @@
 
 #include "datastorage/actor.h"
 #include "datastorage/block.h"
+#include "datastorage/block_sync.h"
 #include "datastorage/genesis_block.h"
 #include "datastorage/index/blockindex.h"
+#include "datastorage/index/header_index.h"
 #include "datastorage/index/memindex.h"
 #include "datastorage/transaction.h"
 #include "managers/account_controller.h"
@@ -33,10 +35,13 @@
 #include <QByteArray>
 #include <QMutex>
 #include <QObject>
+#include <QReadWriteLock>
 #include <QString>
 #include <QTemporaryFile>
 #include <QtNetwork/QHostAddress>
 #include <cassert>
+#include <map>
+#include <optional>
 // database
 #include "utils/db_connector.h"
 
@@ -61,20 +66,47 @@ private:
     ExtraChainNode *node;
 
     // storage //
-    bool fileMode;         // true = block storage mode
-    BlockIndex blockIndex; // blocks (if fileMode is true)
-    MemIndex memIndex;     // blocks (if fileMode is false)
-                           //    Actor<KeyPrivate>   approver;       // current user.
+    bool fileMode;           // true = block storage mode
+    BlockIndex blockIndex;   // blocks (if fileMode is true)
+    MemIndex memIndex;       // blocks (if fileMode is false)
+    HeaderIndex headerIndex; // headers of stored blocks
+    BlockSync m_blockSync;   // catch up with peers by height ranges
+                             //    Actor<KeyPrivate>   approver;       // current user.
     TransactionManager *txManager;
     // service //
     QList<GenesisDataRow> genBlockData; // actorid -> token
     int blocksFromLastGenesis = 0;
+    mutable std::optional<DBConnector> m_cacheEC; // balances changed since last genesis block
+    mutable std::optional<std::string> m_lastGenesisHash; // read from index when unknown
+    struct TokenSupply {
+        BigNumber genesis; // states of last genesis block
+        BigNumber changed; // positive states of cacheEC
+    };
+    mutable QMutex m_supplyMutex;
+    // blocks and first actor are changed in node thread and read by proveTx in pool workers
+    mutable QReadWriteLock m_chainLock { QReadWriteLock::Recursive };
+    mutable std::optional<std::map<std::string, TokenSupply>> m_supply; // by token, kept in cacheEC
 
     bool launched;
     BigNumber circulativeSupply;
     bool possibleMining = true;
 
 public:
+    /**
+     * @brief Result of checks of received transaction
+     */
+    struct TxProof {
+        enum class Verdict {
+            Proved,
+            Rejected,
+            Sign,        // tx of first actor, proved after it is signed by this node
+            CheckBalance // sender can pay if balance with pending txs covers amount and fee
+        };
+
+        Verdict verdict = Verdict::Rejected;
+        Amount balance; // sender balance in blockchain, for CheckBalance
+    };
+
     explicit Blockchain(ExtraChainNode *node, bool fileMode = true);
     Block getBlockByHash(const QByteArray &hash);
     ~Blockchain();
@@ -96,13 +128,29 @@ private:
     std::pair<Transaction, QByteArray> getTxByApprover(const BigNumber &id, const QByteArray &token = "0");
     std::pair<Transaction, QByteArray> getTxByUser(const BigNumber &id, const QByteArray &token = "0");
 
+    /**
+     * @brief Apply balance changes of data block to cacheEC, one upsert per account and token
+     */
     void saveTxInfoInEC(const std::string &data) const;
+    DBConnector &cacheEC() const;
+    /**
+     * @brief Start new epoch of cacheEC
+     * @return states of the ended epoch
+     */
+    std::vector<DBRow> switchCacheEC() const;
+    std::string lastGenesisHash() const;
+    /**
+     * @brief Supply totals by token, loaded from cacheEC or rebuilt if they are not saved
+     * m_supplyMutex must be locked
+     */
+    std::map<std::string, TokenSupply> &supply() const;
+    bool storeSupply(const std::vector<std::string> &tokens) const;
+    void setGenesisSupply(const GenesisBlock &genesis);
+    void resetSupply();
 
     // genesis blocks //
     bool shouldStartGenesisCreation();
 
-    void addRecordsIfNew(const GenesisDataRow &row1, const GenesisDataRow &row2);
-    QByteArray findRecordsInBlock(const Block &block);
     bool signCheckAdd(Block &block);
     QMap<QByteArray, BigNumber> getInvestmentsStaking(const ActorId &wallet, const ActorId &token);
 
@@ -118,10 +166,17 @@ public:
     QList<Transaction> getTxsBySenderOrReceiverInRow(const BigNumber &id, BigNumber from = -1, int count = 10,
                                                      BigNumber token = 0);
     void getBlockZero();
-    BigNumber getSupply(const QByteArray &idToken);
-    BigNumber getFullSupply(const QByteArray &idToken);
+    /**
+     * @brief Supply of token in last genesis block
+     */
+    BigNumber getSupply(const QByteArray &idToken) const;
+    /**
+     * @brief Supply of token in last genesis block and positive balances changed since
+     */
+    BigNumber getFullSupply(const QByteArray &idToken) const;
 
 private:
+    void rebuildHeaderIndex();
     void addGenesisBlockFromTempFile(const QByteArray &prevGenesisHash);
     Block checkBlock(const Block &block);
     // merging //
@@ -189,6 +244,30 @@ public:
      */
     int addBlock(Block &block, bool isGenesis = false);
 
+    /**
+     * Add already validated blocks received with BlockSync, in height order
+     * Blocks are not signed by current approver and genesis blocks are not created
+     * @return 0 is success, or error code
+     */
+    int addSyncedBlocks(const std::vector<std::string> &blocks);
+
+    BlockSync &blockSync();
+    const HeaderIndex &getHeaderIndex() const;
+
+    /**
+     * @brief Tip of local chain taken from header index
+     */
+    BSP::Tip localTip() const;
+    /**
+     * @brief Request headers after local tip from peer if its tip is higher
+     * @param peer socket identifier of sender, empty if unknown
+     */
+    void handleTip(const BSP::Tip &tip, const std::string &peer = std::string());
+    /**
+     * @brief Check received headers for fork and start block sync if they extend local chain
+     */
+    void handleHeaders(const std::vector<BlockHeader> &headers, const std::string &peer = std::string());
+
     /**
      * Removes block and all blocks after them
      * @return 0 is success, or error code
@@ -272,7 +351,7 @@ public:
      */
     BigNumber getRecords() const;
 
-    BigNumberFloat getUserBalance(ActorId userId, ActorId tokenId) const;
+    Amount getUserBalance(ActorId userId, ActorId tokenId) const;
 
     /**
      * @brief Show blockchain
@@ -398,8 +477,10 @@ public slots:
     void VerifyTx(Transaction &tx);
 
     /**
-     * @brief finds needed transaction by sender or receiver
+     * @brief Checks of received tx that don't depend on pending txs
+     * Only reads blockchain and actors, so it's called from worker threads.
+     * Holds chain lock for reading, blocks are not added or removed meanwhile.
      */
-    void proveTx(Transaction &tx);
+    TxProof proveTx(const Transaction &tx);
 };
 #endif // BLOCKCHAIN_H
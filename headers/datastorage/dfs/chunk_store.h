@@ -0,0 +1,94 @@
+#ifndef CHUNK_STORE_H
+#define CHUNK_STORE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "datastorage/dfs/chunker.h"
+#include "utils/dfs_utils.h"
+
+/**
+ * @brief Store of content-defined chunks of stored files
+ * Every chunk is written once under its hash, files keep the list of their
+ * chunks and can be rebuilt from them. Chunk is referenced by every file
+ * that contains it and is removed with the last one.
+ */
+class EXTRACHAIN_EXPORT ChunkStore {
+public:
+    struct Stats {
+        uint64_t files = 0;
+        uint64_t chunks = 0;          // stored chunks
+        uint64_t uniqueBytes = 0;     // bytes of stored chunks
+        uint64_t referencedBytes = 0; // bytes of all indexed files
+
+        /**
+         * @brief Bytes of indexed files per byte stored in chunks
+         */
+        double dedupRatio() const;
+    };
+
+    // Larger files are transferred by segments only
+    static const uint64_t MAX_MANIFEST_CHUNKS = 65536;
+
+private:
+    std::filesystem::path m_path;
+    Chunker m_chunker;
+    mutable std::mutex m_mutex;
+
+public:
+    /**
+     * @param path directory of chunks and their index
+     */
+    explicit ChunkStore(const std::string &path = DFSB::chunksPath, const Chunker &chunker = Chunker());
+
+    /**
+     * @brief Split stored file, store its new chunks and reference all of them,
+     * replaces previous chunks of file
+     * @return chunks of file, empty if file can't be read
+     */
+    std::vector<DFSP::ChunkRef> addFile(const std::string &actorId, const std::string &fileName);
+    /**
+     * @brief Chunks of file, file is indexed if it wasn't yet
+     */
+    std::vector<DFSP::ChunkRef> manifest(const std::string &actorId, const std::string &fileName);
+    /**
+     * @brief Drop references of file, call when file is removed or edited
+     */
+    void removeFile(const std::string &actorId, const std::string &fileName);
+    /**
+     * @brief Write file from its chunks
+     * @return false if file isn't indexed or some chunk can't be read
+     */
+    bool restore(const std::string &actorId, const std::string &fileName,
+                 const std::filesystem::path &path) const;
+
+    uint64_t references(const std::string &hash) const;
+    /**
+     * @brief Read stored chunk
+     * @return empty if chunk is not stored
+     */
+    std::string read(const std::string &hash) const;
+    /**
+     * @brief Write chunks of manifest that are stored locally into file at their offsets
+     * @return written ranges as offset and size, in file order
+     */
+    std::vector<std::pair<uint64_t, uint64_t>> copyLocal(const std::vector<DFSP::ChunkRef> &manifest,
+                                                         const std::filesystem::path &path) const;
+    Stats stats() const;
+
+private:
+    DBConnector open() const;
+    std::filesystem::path chunkPath(const std::string &hash) const;
+    /**
+     * @brief Replace chunks of file in index, new chunks are written from data
+     * @return false if index or chunk can't be written
+     */
+    bool reindex(const std::string &key, const std::vector<DFSP::ChunkRef> &manifest, std::string_view data);
+    static std::string fileKey(const std::string &actorId, const std::string &fileName);
+};
+
+#endif // CHUNK_STORE_H
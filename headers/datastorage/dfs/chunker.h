@@ -0,0 +1,55 @@
+#ifndef CHUNKER_H
+#define CHUNKER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "extrachain_global.h"
+
+/**
+ * @brief Content-defined chunking (FastCDC)
+ * Boundaries are found with a gear rolling hash, so they depend only on
+ * nearby bytes: an insertion or deletion changes chunks around the edit,
+ * the rest of the file is split the same way.
+ */
+class EXTRACHAIN_EXPORT Chunker {
+public:
+    struct Chunk {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    static const uint32_t MIN_SIZE = 2 * 1024;
+    static const uint32_t AVG_SIZE = 8 * 1024;
+    static const uint32_t MAX_SIZE = 64 * 1024;
+
+private:
+    uint32_t m_minSize;
+    uint32_t m_avgSize;
+    uint32_t m_maxSize;
+    uint64_t m_maskSmall; // before average size, cut is less likely
+    uint64_t m_maskLarge; // after average size, cut is more likely
+
+public:
+    /**
+     * @param avgSize rounded down to power of two
+     */
+    explicit Chunker(uint32_t minSize = MIN_SIZE, uint32_t avgSize = AVG_SIZE, uint32_t maxSize = MAX_SIZE);
+
+    /**
+     * @return size of the first chunk of data
+     */
+    uint64_t cut(std::string_view data) const;
+    std::vector<Chunk> split(std::string_view data) const;
+
+    uint32_t maxSize() const;
+
+    /**
+     * @brief Hex of 256-bit BLAKE2b of chunk
+     */
+    static std::string hash(std::string_view data);
+};
+
+#endif // CHUNKER_H
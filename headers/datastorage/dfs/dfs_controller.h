@@ -4,6 +4,7 @@
 #include <cstdlib>
 #include <filesystem>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -21,8 +22,14 @@
 #include <fstream>
 
 #include "datastorage/actor.h"
+#include "datastorage/dfs/chunk_store.h"
+#include "datastorage/dfs/dfs_counters.h"
+#include "datastorage/dfs/dfs_download.h"
+#include "datastorage/dfs/dfs_ingestion.h"
 #include "datastorage/dfs/fragment_storage.h"
 #include "datastorage/dfs/historical_chain.h"
+#include "datastorage/dfs/mapped_file.h"
+#include "datastorage/dfs/mapped_file_cache.h"
 #include "datastorage/index/actorindex.h"
 #include "managers/account_controller.h"
 #include "managers/extrachain_node.h"
@@ -34,17 +41,25 @@
 #include <boost/algorithm/string.hpp>
 
 #include <QThread>
-class ThreadAddFiles;
+#include <QTimer>
 class EXTRACHAIN_EXPORT DfsController : public QObject {
     Q_OBJECT
 
 private:
     ExtraChainNode &node;
     uint64_t m_bytesLimit = 10995116277760;
-    uint64_t m_sizeTaken = 0;
     std::map<std::string, DFSP::AddFileMessage> files;
     std::vector<std::string> m_compliteFiles;
-    uint64_t m_totalDfsSize = 0;
+    DfsCounters m_counters;
+    ChunkStore m_chunks;
+    MappedFileCache m_fileCache; // stored files read by segment requests
+    std::map<std::string, std::unique_ptr<DfsDownload>> m_downloads; // actor + file name
+    std::map<std::string, std::deque<DFSP::SegmentMessage>> m_fragmentQueues; // actor + file name
+    std::set<std::string> m_manifests; // downloads that got manifest, actor + file name
+    std::set<std::string> m_verifying; // downloads whose file is hashed, actor + file name
+    std::map<std::string, std::string> m_peerSockets; // socket identifier by actor id of download peer
+    DfsIngestion *m_ingestion;
+    QTimer *m_downloadTimer;
 
 public:
     explicit DfsController(ExtraChainNode &node, QObject *parent = nullptr);
@@ -53,6 +68,16 @@ public:
     void initializeActor(const ActorId &actorId);
 
     // Internal use only
+    /**
+     * @brief Add local file through ingestion pipeline, doesn't block
+     */
+    QFuture<DfsIngestion::Item> ingest(const Actor<KeyPrivate> &actor, const std::filesystem::path &filePath,
+                                       const std::string &targetVirtualFilePath,
+                                       DFS::Encryption securityLevel = DFS::Encryption::Public);
+    /**
+     * @brief Same as ingest, but waits for result
+     * @return file name or error
+     */
     std::string addLocalFile(const Actor<KeyPrivate> &actor, const std::filesystem::path &filePath,
                              std::string targetVirtualFilePath, DFS::Encryption securityLevel);
     bool removeLocalFile(const Actor<KeyPrivate> &actor, const std::string &filePath);
@@ -70,20 +95,31 @@ public:
                            std::string filePath, uint64_t fileSize);
     uint64_t sizeTaken() const;
     uint64_t totalDfsSize() const;
-    void increaseSizeTaken(uintmax_t value);
+    uint64_t dataAmountStored() const;
+    DfsCounters &counters();
+    ChunkStore &chunks();
+    MappedFileCache &fileCache();
     void insertToFiles(DFSP::AddFileMessage msg);
     void exportFile(const std::string &pathTo, const std::string &pathFrom, const std::string &nameFile = "");
-    uint64_t calculateDataAmountStored(const std::string &folder = DFSB::fsActrRoot) const;
 
 private:
+    std::vector<std::filesystem::path> filePaths(const std::string &actorId,
+                                                 const std::string &fileName) const;
+    /**
+     * @brief Counters change of one stored file and its service files, applied at the end of scope
+     */
+    DfsCounters::Change fileChange(const std::string &actorId, const std::string &fileName);
+    /**
+     * @brief Map stored file for reading, file is rebuilt from its chunks if its copy is gone
+     */
+    std::shared_ptr<const MappedFile> mapFile(const std::string &actorId, const std::string &fileName);
+    std::map<std::string, DfsCounters::Sizes> calculateSizes() const;
     bool insertDataChunk(std::string data, uint64_t position, std::filesystem::path file);
     bool removeDataChunk(uint64_t position, uint64_t length, std::filesystem::path file);
     uint64_t calculateSizeTaken(const std::string &folder = DFSB::fsActrRoot) const;
     uint64_t calculateFilesSize(const std::string &folder = DFSB::fsActrRoot) const;
+    uint64_t calculateDataAmountStored(const std::string &folder = DFSB::fsActrRoot) const;
     std::string extractNextFragment();
-    std::string extractFragment(boost::interprocess::file_mapping &fmapTarget, uint64_t offset,
-                                uint64_t fragmentSize);
-    std::string extractFragment(boost::interprocess::file_mapping &fmapTarget, uint64_t offset);
 
 public:
     void sendSizeRequestMsg(const ActorId &actorId) const;
@@ -102,6 +138,37 @@ public:
     void verifyFiles(std::vector<DFSP::VerifyFileMessage> &fileList, std::string &messageId);
     float percentVerified(std::vector<DFSP::VerifyFileMessage> &fileList);
 
+    // Multi-peer download
+    void startDownload(const DFSP::AddFileMessage &msg, const std::string &bitmap = "");
+    void sendFileSource(const DFSP::FindFileMessage &msg, const std::string &messageId);
+    /**
+     * @param identifier socket of peer, its segments are requested only there
+     */
+    void addDownloadPeer(const ActorId &peer, const DFSP::FindFileMessage &msg,
+                         const std::string &identifier = std::string());
+    void sendSegment(const DFSP::RequestSegmentMessage &msg, const std::string &messageId);
+    void handleSegment(const ActorId &peer, const DFSP::SegmentMessage &msg);
+    // Chunks of file that are stored locally are not downloaded
+    void sendManifest(const DFSP::FindFileMessage &msg, const std::string &messageId);
+    void applyManifest(const DFSP::ManifestMessage &msg);
+
+private:
+    // Ingestion stages, called from worker threads
+    std::string ingestCopy(DfsIngestion::Item &item);
+    std::string ingestEncrypt(DfsIngestion::Item &item);
+    std::string ingestHash(DfsIngestion::Item &item);
+    std::string ingestIndex(DfsIngestion::Item &item);
+    std::string ingestAnnounce(DfsIngestion::Item &item);
+    void startFragmentWriter(const std::string &key);
+
+    void resumeDownloads();
+    /**
+     * @brief Hash downloaded file on the pool, download stays registered until it is checked
+     */
+    void finishDownload(const std::string &key);
+    void completeDownload(const std::string &key, const std::string &fileHash);
+    void checkDownloads();
+
 public slots:
     std::string addFragment(const DFSP::SegmentMessage &msg);
     void threadAddFragment(const DFSP::SegmentMessage &msg);
@@ -127,26 +194,4 @@ signals:
     void resultAddFile(const QString &result, const QString &fileName);
 };
 
-class ThreadAddFiles : public QThread {
-    Q_OBJECT
-    DfsController *m_dfsController;
-    QStringList m_files;
-    Actor<KeyPrivate> m_actor;
-
-public:
-    ThreadAddFiles(DfsController *dfsController, const Actor<KeyPrivate> &actor, const QStringList &files,
-                   QObject *parent = nullptr);
-    ~ThreadAddFiles();
-
-    virtual void run() override;
-    void addFile(const Actor<KeyPrivate> &actor, const std::filesystem::path &filePath,
-                 std::string targetVirtualFilePath);
-
-signals:
-    void error(std::string error, std::string fileName);
-    void sendMessage(DFSP::AddFileMessage msg, MessageType messageType);
-    void added(const DFSP::AddFileMessage &msg, const std::string &filePath,
-               const std::string &scriptPath = "");
-};
-
 #endif // DFS_CONTROLLER_H
@@ -0,0 +1,80 @@
+#ifndef DFS_COUNTERS_H
+#define DFS_COUNTERS_H
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils/dfs_utils.h"
+
+/**
+ * @brief Per-actor and total DFS sizes
+ * Counters are kept in the Sizes table of dfs/.dirs and updated with every
+ * change of stored files, so reading them doesn't walk the storage tree.
+ */
+class EXTRACHAIN_EXPORT DfsCounters {
+public:
+    struct Sizes {
+        int64_t disk = 0;   // bytes of files in actor directory
+        int64_t files = 0;  // logical sizes of files listed in actor dir
+        int64_t stored = 0; // bytes of fragments in .storj files
+
+        Sizes &operator+=(const Sizes &sizes);
+        bool operator==(const Sizes &sizes) const = default;
+    };
+
+    /**
+     * @brief Change of actor files, applied on destruction
+     * Disk sizes of given paths are taken on creation and on destruction,
+     * difference is added together with sizes passed to add.
+     */
+    class EXTRACHAIN_EXPORT Change {
+        DfsCounters &m_counters;
+        std::string m_actorId;
+        std::vector<std::pair<std::filesystem::path, int64_t>> m_paths;
+        Sizes m_delta;
+
+    public:
+        Change(DfsCounters &counters, const std::string &actorId,
+               const std::vector<std::filesystem::path> &paths);
+        Change(const Change &) = delete;
+        ~Change();
+
+        void add(const Sizes &delta);
+        /**
+         * @brief Apply change now, nothing is applied on destruction
+         */
+        void apply();
+    };
+
+private:
+    std::string m_dbPath;
+    mutable std::mutex m_mutex;
+    std::map<std::string, Sizes> m_actors;
+    Sizes m_total;
+
+public:
+    explicit DfsCounters(const std::string &dbPath = DFSB::dirsPath);
+
+    /**
+     * @return false if counters were not saved yet, they should be set with reset
+     */
+    bool load();
+    void reset(const std::map<std::string, Sizes> &actors);
+    void add(const std::string &actorId, const Sizes &delta);
+    Change change(const std::string &actorId, const std::vector<std::filesystem::path> &paths);
+
+    Sizes actor(const std::string &actorId) const;
+    Sizes total() const;
+
+    static int64_t diskSize(const std::filesystem::path &path);
+
+private:
+    void save(DBConnector &db, const std::string &actorId, const Sizes &sizes);
+};
+
+#endif // DFS_COUNTERS_H
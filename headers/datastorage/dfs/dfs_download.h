@@ -0,0 +1,124 @@
+#ifndef DFS_DOWNLOAD_H
+#define DFS_DOWNLOAD_H
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils/dfs_utils.h"
+
+/**
+ * @brief Download of one DFS file from several peers
+ * File is split into segments, every peer has a bounded window of requested
+ * segments. Window grows by one segment per window received in time and is
+ * halved on timeout. Segments that are not received in time are requested
+ * from other peers, the last missing segments are requested twice. Received segments are
+ * kept in a bitmap, so download resumes after restart. Bitmap is saved every
+ * BITMAP_BATCH segments and when timeouts are checked.
+ */
+class EXTRACHAIN_EXPORT DfsDownload {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Storage {
+        std::function<bool(uint64_t offset, const std::string &data)> write;
+        std::function<void(const std::string &bitmap)> saveBitmap;
+    };
+
+    struct Transport {
+        std::function<void(const std::string &peer, const DFSP::RequestSegmentMessage &request)>
+            requestSegment;
+    };
+
+    // Segments requested from one peer and not received yet, initial and maximum
+    static const uint32_t PEER_WINDOW = 4;
+    static const uint32_t MAX_PEER_WINDOW = 32;
+    // Segment is requested from another peer after this time
+    static constexpr std::chrono::seconds SEGMENT_TIMEOUT = std::chrono::seconds(15);
+    // Received segments between bitmap saves
+    static const uint32_t BITMAP_BATCH = 32;
+
+private:
+    struct Request {
+        std::string peer;
+        Clock::time_point sent;
+    };
+
+    struct Peer {
+        uint32_t inFlight = 0;
+        uint32_t timeouts = 0;
+        uint64_t received = 0;
+        uint32_t window = PEER_WINDOW;
+        uint32_t inTime = 0; // segments received in time since window was changed
+    };
+
+    DFSP::AddFileMessage m_file;
+    uint64_t m_segmentSize;
+    Storage m_storage;
+    Transport m_transport;
+    mutable std::recursive_mutex m_mutex;
+
+    std::vector<bool> m_done;
+    uint64_t m_doneCount = 0;
+    uint64_t m_cursor = 0; // first segment that can be not requested
+    uint64_t m_retried = 0;
+    uint64_t m_unsaved = 0; // segments done after last bitmap save
+    std::map<uint64_t, std::vector<Request>> m_inFlight;
+    std::map<std::string, Peer> m_peers;
+
+public:
+    /**
+     * @param bitmap saved state of previous run, empty for new download
+     */
+    DfsDownload(const DFSP::AddFileMessage &file, const std::string &bitmap, Storage storage,
+                Transport transport, uint64_t segmentSize = DFSB::sectionSize);
+
+    void addPeer(const std::string &peer, Clock::time_point now = Clock::now());
+    void removePeer(const std::string &peer, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Write segment if it was requested from this peer
+     * @return false if segment is not expected or can't be written
+     */
+    bool handleSegment(const std::string &peer, const DFSP::SegmentMessage &segment,
+                       Clock::time_point now = Clock::now());
+    /**
+     * @brief Request timed out segments from other peers and save bitmap
+     */
+    void checkTimeouts(Clock::time_point now = Clock::now());
+    /**
+     * @brief Save bitmap if segments were done after last save
+     */
+    void flushBitmap();
+    /**
+     * @brief Mark segments that were filled from local data
+     * @param ranges written offsets and sizes in file order
+     * @return number of segments fully covered by ranges
+     */
+    uint64_t addLocalRanges(const std::vector<std::pair<uint64_t, uint64_t>> &ranges);
+
+    const DFSP::AddFileMessage &file() const;
+    bool isComplete() const;
+    int progress() const;
+    uint64_t segmentCount() const;
+    uint64_t segmentsDone() const;
+    uint64_t retried() const;
+    uint32_t window(const std::string &peer) const;
+    std::string bitmap() const;
+
+private:
+    void schedule(Clock::time_point now);
+    std::optional<uint64_t> nextSegment(const std::string &peer);
+    void sendRequest(uint64_t segment, const std::string &peer, Clock::time_point now);
+    void releaseRequests(uint64_t segment);
+    static void grow(Peer &peer);
+    static void shrink(Peer &peer);
+    uint64_t segmentLength(uint64_t segment) const;
+};
+
+#endif // DFS_DOWNLOAD_H
@@ -0,0 +1,104 @@
+#ifndef DFS_INGESTION_H
+#define DFS_INGESTION_H
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <QFuture>
+#include <QObject>
+#include <QPromise>
+
+#include "enc/key_private.h"
+#include "managers/thread_pool.h"
+#include "utils/dfs_utils.h"
+
+/**
+ * @brief Pipeline of adding local files to DFS
+ * Every file goes through copy, encrypt, hash, index and announce stages.
+ * Stages run on a shared thread pool and are connected with bounded queues,
+ * a stage doesn't take new files while the queue of the next stage is full.
+ * Index and announce are sequential, other stages run in parallel.
+ */
+class EXTRACHAIN_EXPORT DfsIngestion : public QObject {
+    Q_OBJECT
+
+public:
+    enum Stage {
+        Copy,
+        Encrypt,
+        Hash,
+        Index,
+        Announce,
+        StageCount
+    };
+
+    struct Item {
+        uint64_t id = 0;
+        std::string actorId;
+        std::filesystem::path source;
+        std::string virtualPath;
+        DFS::Encryption encryption = DFS::Encryption::Public;
+        KeyPrivate key; // encrypts file if it is not public
+        std::string fileName; // name in DFS, set by stages
+        std::string fileHash;
+        uint64_t size = 0;
+        std::string error; // empty if file is added
+    };
+
+    /**
+     * @brief Work of one stage
+     * @return error, empty if item can go to the next stage
+     */
+    using Handler = std::function<std::string(Item &item)>;
+    using Handlers = std::array<Handler, StageCount>;
+
+    // Items waiting for a stage or running in the previous one
+    static const std::size_t QUEUE_SIZE = 32;
+
+private:
+    struct Entry {
+        Item item;
+        std::shared_ptr<QPromise<Item>> promise;
+    };
+
+    Handlers m_handlers;
+    ThreadPool *m_pool;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_done;
+    std::array<std::deque<Entry>, StageCount> m_queues; // first one is not bounded
+    std::array<int, StageCount> m_running = {};
+    std::array<int, StageCount> m_limits = {};
+    uint64_t m_nextId = 0;
+    uint64_t m_inProgress = 0;
+    std::size_t m_peakQueued = 0;
+
+public:
+    DfsIngestion(Handlers handlers, ThreadPool *pool = &ThreadPool::instance(),
+                 QObject *parent = nullptr);
+    ~DfsIngestion();
+
+    /**
+     * @brief Queue file, doesn't block
+     */
+    QFuture<Item> add(Item item);
+    void waitForDone();
+    uint64_t inProgress() const;
+    std::size_t peakQueued() const;
+
+signals:
+    void added(const DfsIngestion::Item &item);
+    void failed(const DfsIngestion::Item &item);
+
+private:
+    void schedule();
+    void run(Stage stage, Entry entry);
+    void finish(Entry &entry);
+};
+
+#endif // DFS_INGESTION_H
@@ -6,7 +6,7 @@
 #include "managers/extrachain_node.h"
 #include "utils/db_connector.h"
 #include "utils/dfs_utils.h"
-#include <QThread>
+#include <QObject>
 #include <boost/interprocess/file_mapping.hpp>
 #include <boost/interprocess/mapped_region.hpp>
 
@@ -17,6 +17,7 @@ private:
     ActorId actor;
     std::string fileName;
     std::string fileHash;
+    int64_t m_storedChange = 0;
 
 public:
     FragmentStorage(ActorId Actor, std::string FileName, std::string FileHash);
@@ -31,6 +32,8 @@ public:
     DFSP::SegmentMessage getFragment(uint64_t pos);
     DFSP::SegmentMessage getFragment(std::string fragHash);
     bool applyChanges(const std::string& data, uint64_t pos);
+    // Change of fragment bytes made by this object
+    int64_t storedChange() const;
 
 private:
     DBRow getPreviousFragment(uint64_t number);
@@ -48,20 +51,24 @@ private:
     bool checkRenameFile(const DFS::Packets::EditSegmentMessage& msg);
 };
 
-class FragmentWriter : public QThread {
+/**
+ * @brief Writes one received fragment, run on ThreadPool
+ */
+class FragmentWriter : public QObject {
     Q_OBJECT
     DFSP::SegmentMessage m_msg;
     std::vector<std::string> m_compliteFiles;
+    int64_t m_storedChange = 0;
 
 public:
     FragmentWriter(const DFSP::SegmentMessage& msg, std::vector<std::string> m_compliteFiles,
                    QObject* parent = nullptr);
-    ~FragmentWriter() {
-        quit();
+
+    int64_t storedChange() const {
+        return m_storedChange;
     }
 
-protected:
-    void run() override;
+    void run();
 
 signals:
     void downloadedFile(std::string& actor, std::string& fileName);
@@ -2,14 +2,29 @@
 #define HISTORICAL_CHAIN_H
 
 #include <filesystem>
+#include <optional>
+#include <string_view>
 
 #include "managers/extrachain_node.h"
 #include "utils/dfs_utils.h"
 
+/**
+ * @brief Log of edits of a DFS object
+ * Every CHECKPOINT_INTERVAL entries the state of file is saved as a compressed
+ * checkpoint, so any version is rebuilt from the nearest checkpoint with at
+ * most one interval of entries. Compaction drops entries and checkpoints that
+ * are older than the retention window.
+ */
 class EXTRACHAIN_EXPORT HistoricalChain {
+public:
+    static const uint64_t CHECKPOINT_INTERVAL = 64;
+    // Versions kept by compaction
+    static const uint64_t RETENTION = 1024;
+
 private:
     STDFS::path objectPath;
     DBConnector chainFile;
+    uint64_t m_replayed = 0;
 
 public:
     HistoricalChain(std::string chainFilePath, std::string objectFilePath);
@@ -28,10 +43,26 @@ public:
     DFSP::EditSegmentMessage makeEditSegmentMessage(const DFSP::DeleteSegmentMessage& msg,
                                                     const DFSP::SegmentMessageType& smType);
 
+    /**
+     * @brief Start chain of stored file, current content is the checkpoint of version 0
+     */
     bool initLocal(const std::string& actor, const std::string& fileName, const std::string& fileHash);
     bool remove(const std::string& actor, const std::string& fileHash);
     bool rename(const std::string& fileHash, const std::string& newFileHash);
 
+    /**
+     * @brief Content of file after log entry num, built in memory
+     * @return nothing if version was compacted or chain is not of a file
+     */
+    std::optional<std::string> version(uint64_t num);
+    std::optional<uint64_t> lastVersion();
+    /**
+     * @brief Drop entries and checkpoints not needed for the last retention versions
+     */
+    bool compact(uint64_t retention = RETENTION);
+    // Entries replayed by the last version call
+    uint64_t replayed() const;
+
 private:
     DBRow makeDBRow(uint64_t num, uint64_t prevNum, int type, std::string data);
     DBRow getLastRow();
@@ -39,6 +70,11 @@ private:
     DBRow getRow(const int& num);
     DBRow getRow(const std::string& data);
     DFSP::EditSegmentMessage segmentMessageFromDBRow(const DBRow& dbRow);
+
+    bool checkpoint(uint64_t num);
+    bool saveCheckpoint(uint64_t num, std::string_view state);
+    void dropCheckpoints(uint64_t fromNum);
+    static void replay(std::string& state, const DBRow& dbRow);
 };
 
 #endif // HISTORICAL_CHAIN_H
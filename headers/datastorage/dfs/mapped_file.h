@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "extrachain_global.h"
+
+/**
+ * @brief Read-only mapping of a whole stored file
+ * Slices point into the mapping and are valid while the object lives.
+ */
+class EXTRACHAIN_EXPORT MappedFile {
+private:
+    boost::interprocess::file_mapping m_mapping;
+    boost::interprocess::mapped_region m_region;
+    uint64_t m_size = 0;
+    bool m_open = false;
+
+public:
+    explicit MappedFile(const std::filesystem::path &path);
+
+    bool isOpen() const;
+    uint64_t size() const;
+
+    /**
+     * @brief View of file bytes, shorter if file ends before offset + size
+     */
+    std::string_view slice(uint64_t offset, uint64_t size) const;
+};
+
+#endif // MAPPED_FILE_H
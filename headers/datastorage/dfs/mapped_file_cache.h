@@ -0,0 +1,68 @@
+#ifndef MAPPED_FILE_CACHE_H
+#define MAPPED_FILE_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "datastorage/dfs/mapped_file.h"
+
+/**
+ * @brief Mappings of recently read stored files
+ * Least recently used mappings are dropped when mapped bytes exceed capacity.
+ * Writers invalidate the file before changing it, mapping is also remade when
+ * size or modification time of file differ from the mapped one.
+ */
+class EXTRACHAIN_EXPORT MappedFileCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t files = 0; // cached mappings
+        uint64_t bytes = 0; // mapped bytes of cached files
+
+        double hitRate() const;
+    };
+
+    static const uint64_t DEFAULT_CAPACITY = 256 * 1024 * 1024;
+
+private:
+    struct Entry {
+        std::shared_ptr<const MappedFile> file;
+        std::filesystem::file_time_type modified;
+        std::list<std::string>::iterator order;
+    };
+
+    uint64_t m_capacity;
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::list<std::string> m_order; // most recently used first
+    Stats m_stats;
+
+public:
+    /**
+     * @param capacity 0 disables caching, every get maps the file
+     */
+    explicit MappedFileCache(uint64_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Mapping of file, stays valid while held even if it is evicted
+     * @return closed mapping if file can't be read
+     */
+    std::shared_ptr<const MappedFile> get(const std::filesystem::path &path);
+    void invalidate(const std::filesystem::path &path);
+    void clear();
+
+    uint64_t capacity() const;
+    Stats stats() const;
+
+private:
+    void erase(std::unordered_map<std::string, Entry>::iterator it);
+};
+
+#endif // MAPPED_FILE_CACHE_H
@@ -29,14 +29,14 @@
 class EXTRACHAIN_EXPORT GenesisDataRow {
 public:
     ActorId actorId;
-    BigNumberFloat state;
+    Amount state;
     ActorId token;
     DataStorage::typeDataRow type;
 
 public:
     GenesisDataRow() = default;
 
-    explicit GenesisDataRow(const ActorId &actorId, const BigNumberFloat &state, const ActorId &token,
+    explicit GenesisDataRow(const ActorId &actorId, const Amount &state, const ActorId &token,
                             const DataStorage::typeDataRow &type)
         : actorId(actorId)
         , state(state)
@@ -62,7 +62,7 @@ public:
         std::vector<std::string> l = Serialization::deserialize(serialized);
         if (l.size() == 4) {
             actorId = l.at(0);
-            state = BigNumber(l.at(1));
+            state = Amount::fromString(l.at(1));
             token = l.at(2);
             type = DataStorage::typeDataRow(std::stoi(l.at(3)));
         }
@@ -0,0 +1,93 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef ACTOR_DIRECTORY_H
+#define ACTOR_DIRECTORY_H
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "datastorage/actor.h"
+#include "utils/db_connector.h"
+
+/**
+ * @brief Public actors kept in one table with their keys
+ * Least recently used actors stay parsed in memory up to capacity.
+ * Actors saved by older versions as json files are moved into the table
+ * when they are read first time.
+ */
+class EXTRACHAIN_EXPORT ActorDirectory {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t actors = 0; // cached actors
+
+        double hitRate() const;
+    };
+
+    static const std::size_t DEFAULT_CAPACITY = 65536;
+
+private:
+    struct Entry {
+        Actor<KeyPublic> actor;
+        std::list<std::string>::iterator order;
+    };
+
+    const std::string m_folderPath;
+    const std::size_t m_capacity;
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::list<std::string> m_order; // most recently used first
+    Stats m_stats;
+
+public:
+    /**
+     * @param folderPath folder of actors table and json files of older versions
+     * @param capacity 0 disables caching, every get reads the table
+     */
+    explicit ActorDirectory(const std::string &folderPath, std::size_t capacity = DEFAULT_CAPACITY);
+
+    std::optional<Actor<KeyPublic>> get(const ActorId &id);
+    bool contains(const ActorId &id);
+    /**
+     * @return 0 if actor is saved, FILE_ALREADY_EXISTS or FILE_IS_NOT_OPENED
+     */
+    int add(const Actor<KeyPublic> &actor);
+
+    uint64_t count() const;
+    std::vector<std::string> ids() const;
+    Stats stats() const;
+
+private:
+    DBConnector open() const;
+    std::optional<Actor<KeyPublic>> load(const ActorId &id);
+    std::optional<Actor<KeyPublic>> loadLegacy(const ActorId &id) const;
+    QString legacyPath(const ActorId &id) const;
+    void remember(const Actor<KeyPublic> &actor);
+};
+
+#endif // ACTOR_DIRECTORY_H
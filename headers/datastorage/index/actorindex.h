@@ -24,6 +24,7 @@
 
 #include "datastorage/actor.h"
 #include "datastorage/block.h"
+#include "datastorage/index/actor_directory.h"
 #include "managers/extrachain_node.h"
 #include "network/network_manager.h"
 
@@ -39,7 +40,7 @@ private:
     uint64_t records = 0;
     const std::string folderPath = DataStorage::BLOCKCHAIN_INDEX.toStdString() + "/"
         + DataStorage::ACTOR_INDEX_FOLDER_NAME.toStdString() + '/';
-    int16_t SECTION_NAME_SIZE = 2;
+    ActorDirectory m_directory;
     ActorId m_firstId;
 
 public:
@@ -53,20 +54,6 @@ public:
     ~ActorIndex() = default;
 
 private:
-    /**
-     * @brief buildFilePath
-     * @param id
-     * @return
-     */
-    QString buildFilePath(const ActorId &id) const;
-    std::string actorPath(const ActorId &id) const;
-    /**
-     * @brief add
-     * @param ActorId id actorId for add
-     * @param data
-     * @return
-     */
-    int add(const ActorId &id, const QByteArray &data);
     void sendGetActorMessage(const ActorId &actorId);
 
 public:
@@ -105,7 +92,7 @@ public:
      * @param id
      * @return
      */
-    QByteArray getById(const ActorId &id) const;
+    QByteArray getById(const ActorId &id);
 
     qint64 getRecords() const;
     void setFirstId(const ActorId &value);
@@ -117,7 +104,7 @@ public:
      */
     void handleNewActor(Actor<KeyPublic> actor);
     /**
-     * @brief Serializes an actor and make a file in fs.
+     * @brief Saves an actor to directory of actors
      * @param actor
      * @return resultCode, 0 - actor is saved
      */
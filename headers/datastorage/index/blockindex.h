@@ -108,9 +108,9 @@ public:
     int removeById(const BigNumber &id);
     void removeDummyBlocks(const BigNumber &id);
     QString buildFilePath(const BigNumber &id) const;
-    BigNumberFloat calculateCirculativeBalance() const;
-    BigNumberFloat calculateCirculativeBalanceBlock(const Block &block) const;
-    BigNumberFloat calculateCirculativeBalanceLastGenesisBlock() const;
+    Amount calculateCirculativeBalance() const;
+    Amount calculateCirculativeBalanceBlock(const Block &block) const;
+    Amount calculateCirculativeBalanceLastGenesisBlock() const;
 
 private:
     std::pair<Transaction, QByteArray> getLastTxByParam(const std::string &id, SearchEnum::TxParam param,
@@ -0,0 +1,83 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef HEADERINDEX_H
+#define HEADERINDEX_H
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "datastorage/block_header.h"
+#include "utils/db_connector.h"
+
+/**
+ * @brief Block headers stored apart from blocks
+ * Used for tip comparison, existence checks and fork detection
+ * without loading block payloads. With empty file path headers are kept
+ * in memory only, for blockchain in MemIndex mode.
+ */
+class EXTRACHAIN_EXPORT HeaderIndex {
+private:
+    const std::string filePath;
+    mutable std::mutex m_mutex;
+    BlockHeader m_tip;
+    std::map<BigNumber, BlockHeader> m_headers; // in memory mode
+
+public:
+    HeaderIndex();
+    explicit HeaderIndex(const std::string &filePath);
+
+    /**
+     * @brief Add or replace header at its height
+     * @return 0 if header is saved
+     */
+    int addHeader(const BlockHeader &header);
+    int addHeaders(const std::vector<BlockHeader> &headers);
+    int remove(const BigNumber &index);
+    /**
+     * @brief Remove headers from index to the end, as BlockIndex::removeById does with blocks
+     */
+    int removeFrom(const BigNumber &index);
+    void clear();
+
+    BlockHeader getHeader(const BigNumber &index) const;
+    std::vector<BlockHeader> getHeaders(const BigNumber &from, uint32_t count) const;
+    BlockHeader tip() const;
+    bool contains(const BigNumber &index) const;
+    bool contains(const BigNumber &index, const std::string &hash) const;
+
+    /**
+     * @brief Find first received header that conflicts with a stored one
+     * @return height of fork, or -1 if headers agree with local chain
+     */
+    BigNumber findFork(const std::vector<BlockHeader> &headers) const;
+
+    static std::string defaultPath();
+    bool inMemory() const;
+
+private:
+    std::string hashAt(const BigNumber &index) const;
+    std::string hashAt(DBConnector &db, const BigNumber &index) const;
+    BlockHeader loadTip(DBConnector &db) const;
+    static std::string height(const BigNumber &index);
+};
+
+#endif // HEADERINDEX_H
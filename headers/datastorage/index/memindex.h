@@ -25,16 +25,34 @@
 #include <QDebug>
 #include <QMap>
 #include <algorithm>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
+/**
+ * @brief Last blocks of chain kept in memory
+ * Blocks are in a ring addressed by height, block of height h is in slot
+ * h % capacity. When a block doesn't fit into the ring, the oldest blocks
+ * are dropped. Hash and approver maps give the slot without a scan.
+ */
 class MemIndex {
 private:
-    QList<Block> blocks;
+    std::vector<Block> slots;
+    long long firstHeight = 0; // lowest height in ring
+    long long endHeight = 0;   // one past highest height in ring
+    int records = 0;
+    std::unordered_map<std::string, long long> byHash;
+    std::unordered_map<std::string, std::set<long long>> byApprover;
 
 public:
-    MemIndex();
+    explicit MemIndex(int capacity = Config::DataStorage::MEM_INDEX_SIZE_LIMIT);
     ~MemIndex();
 
 public:
+    /**
+     * @return 0 if block is added, 1 if height is taken, 2 if block is older than kept ones
+     */
     int addBlock(const Block &block);
     int removeById(const BigNumber &blockId);
     int getRecords() const;
@@ -64,6 +82,12 @@ public:
 private:
     std::pair<Transaction, QByteArray> getLastTxByParam(const BigNumber &id, SearchEnum::TxParam param,
                                                         const QByteArray &token) const;
+
+    const Block &slot(long long height) const;
+    Block &slot(long long height);
+    void remove(long long height);
+    static std::optional<long long> height(const BigNumber &blockId);
+    static std::string approverKey(const BigNumber &approver);
 };
 
 #endif // MEMINDEX_H
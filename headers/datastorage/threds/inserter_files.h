@@ -1,24 +1,33 @@
 #ifndef INSERTERFILES_H
 #define INSERTERFILES_H
 
+#include <optional>
+#include <string>
+#include <vector>
+
 #include "managers/extrachain_node.h"
 #include <QObject>
-#include <QThread>
 
-class InserterFiles : public QThread {
+/**
+ * @brief Adds files through DFS ingestion, results come in order of files
+ * Work runs on ThreadPool, the object itself doesn't block or own a thread.
+ */
+class InserterFiles : public QObject {
     Q_OBJECT
 
     QStringList fList;
     ExtraChainNode &node;
+    std::vector<std::optional<std::string>> m_results;
+    int m_reported = 0;
 
 public:
     InserterFiles(ExtraChainNode &xNode, const QStringList &files, QObject *parent = nullptr);
 
-protected:
-    void run() override;
+    void start();
 
 signals:
     void resultAddFile(const QString &result, const QString &fileName);
+    void finished();
 };
 
 #endif // INSERTERFILES_H
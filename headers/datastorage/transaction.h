@@ -21,8 +21,8 @@
 #define TRANSACTION_H
 
 #include "datastorage/actor.h"
+#include "utils/amount.h"
 #include "utils/bignumber.h"
-#include "utils/bignumber_float.h"
 #include "utils/exc_utils.h"
 #include <QDateTime>
 #include <QString>
@@ -49,7 +49,7 @@ protected:
      * Uses sha3.
      */
     void calcHash();
-    BigNumberFloat amount; // coin amount
+    Amount amount;         // coin amount
     long long date;
     std::string data;    // additional payload field
     ActorId token;       // token contract address
@@ -62,6 +62,7 @@ protected:
     ActorId producer;
     std::string digSig;
     TypeTx typeTx = TypeTx::Transaction;
+    bool legacyAmount = false; // decoded with amount as BigNumberFloat text of older versions
 
 public:
     // Construct empty transaction
@@ -70,10 +71,10 @@ public:
     Transaction(const std::string &serialized);
 
     // Construct transaction
-    Transaction(const ActorId &sender, const ActorId &receiver, const BigNumberFloat &amount);
+    Transaction(const ActorId &sender, const ActorId &receiver, const Amount &amount);
 
     // Construct transaction with data
-    Transaction(const ActorId &sender, const ActorId &receiver, const BigNumberFloat &amount,
+    Transaction(const ActorId &sender, const ActorId &receiver, const Amount &amount,
                 const std::string &data);
 
     Transaction(const Transaction &other);
@@ -106,7 +107,7 @@ public:
     int getHop() const;
     ActorId getSender() const;
     ActorId getReceiver() const;
-    BigNumberFloat getAmount() const;
+    Amount getAmount() const;
     BigNumber getPrevBlock() const;
     std::string getData() const;
     std::string getHash() const;
@@ -128,29 +129,45 @@ public:
     void setToken(const ActorId &value);
     void setData(const std::string &value);
     /**
-     * @brief 1.1 -> 1.1 * 10e18 in BigNumber
+     * @brief 1.1 -> 1.1 * 10e18 in Amount
      * @param amount
      */
-    static BigNumberFloat visibleToAmount(std::string amount);
+    static Amount visibleToAmount(std::string amount);
 
     /**
-     * @brief 1 * 10e18 from BigNumber to number -> 1
+     * @brief 1 * 10e18 from Amount to number -> 1
      * @param number
      */
-    static QString amountToVisible(const BigNumberFloat &number);
-    static BigNumberFloat amountNormalizeMul(const BigNumberFloat &number);
-    static BigNumberFloat amountMul(const BigNumberFloat &number1, const BigNumberFloat &number2);
-    static BigNumberFloat amountDiv(const BigNumberFloat &number1, const BigNumberFloat &number2);
-    static BigNumberFloat amountPercent(BigNumberFloat number, uint percent);
-    void setAmount(const BigNumberFloat &value);
+    static QString amountToVisible(const Amount &number);
+    static Amount amountMul(const Amount &number1, const Amount &number2);
+    static Amount amountDiv(const Amount &number1, const Amount &number2);
+    static Amount amountPercent(Amount number, uint percent);
+    void setAmount(const Amount &value);
     void setSender(const ActorId &value);
     void setReceiver(const ActorId &value);
     bool isRewardTransaction() const;
     TypeTx getTypeTx() const;
     virtual void setTypeTx(TypeTx newTypeTx);
-
-    MSGPACK_DEFINE(sender, receiver, amount, date, data, token, prevBlock, gas, hop, hash, approver, producer,
-                   digSig, typeTx)
+    /**
+     * @brief Amount is hashed and packed as text of older versions
+     * Set for transactions decoded from that format, so their signatures stay valid
+     */
+    bool hasLegacyAmount() const;
+
+    template <typename Packer>
+    void msgpack_pack(Packer &msgpack_pk) const {
+        if (legacyAmount) {
+            const std::string legacy = amount.toLegacyString();
+            msgpack::type::make_define_array(sender, receiver, legacy, date, data, token, prevBlock, gas, hop,
+                                             hash, approver, producer, digSig, typeTx)
+                .msgpack_pack(msgpack_pk);
+            return;
+        }
+        msgpack::type::make_define_array(sender, receiver, amount, date, data, token, prevBlock, gas, hop,
+                                         hash, approver, producer, digSig, typeTx)
+            .msgpack_pack(msgpack_pk);
+    }
+    void msgpack_unpack(msgpack::object const &msgpack_o);
 };
 
 #endif // TRANSACTION_H
@@ -2,14 +2,18 @@
 #define ENC_TOOLS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "cpp-base64/base64.h"
 #include <utils/exc_utils.h>
 namespace SecretKey {
+// Nonce and MAC prepended by encryptAsymmetric
+static const std::size_t asymmetricOverhead = 24 + 16;
+
 EXTRACHAIN_EXPORT std::string keygen();
 EXTRACHAIN_EXPORT std::string getKeyFromPass(const std::string &pass, const std::string &salt = "");
-EXTRACHAIN_EXPORT std::string sign(const std::string &data, const std::string &secret_key);
+EXTRACHAIN_EXPORT std::string sign(std::string_view data, const std::string &secret_key);
 EXTRACHAIN_EXPORT bool verify(const std::string &data, const std::string &public_key,
                               const std::string &signature);
 EXTRACHAIN_EXPORT std::string encrypt(const std::string &msg, const std::string &secret_key);
@@ -22,6 +26,11 @@ EXTRACHAIN_EXPORT std::string encryptAsymmetric(const std::string &data, const s
                                                 const std::string &public_key, const std::string &nonce = "");
 EXTRACHAIN_EXPORT std::string decryptAsymmetric(const std::string &data, const std::string &secret_key,
                                                 const std::string &public_key, const std::string &nonce = "");
+EXTRACHAIN_EXPORT std::string asymmetricSharedKey(const std::string &secret_key,
+                                                  const std::string &public_key);
+// Same result as encryptAsymmetric with random nonce, written to result without copies of data
+EXTRACHAIN_EXPORT bool encryptAsymmetricTo(std::string &result, std::string_view data,
+                                           const std::string &shared_key);
 }
 
 #endif // ENC_TOOLS_H
@@ -0,0 +1,96 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef FILE_CIPHER_H
+#define FILE_CIPHER_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "extrachain_global.h"
+
+/**
+ * @brief Chunked authenticated file encryption
+ * File starts with a versioned header, every chunk is a separate
+ * crypto_secretstream_xchacha20poly1305 message bound to the header and to its
+ * index, so any chunk can be read without previous ones and reordering or
+ * truncation of chunks is detected.
+ */
+class EXTRACHAIN_EXPORT FileCipher {
+public:
+    struct Header {
+        uint8_t version = VERSION;
+        uint32_t chunkSize = DEFAULT_CHUNK_SIZE;
+        uint64_t size = 0;  // size of plain file
+        std::string fileId; // random, file key is derived from it
+
+        std::string serialize() const;
+        static std::optional<Header> parse(std::string_view data);
+    };
+
+    static const std::string MAGIC;
+    static const uint8_t VERSION = 1;
+    static const uint32_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+    static const uint32_t MAX_CHUNK_SIZE = 64 * 1024 * 1024;
+    static const std::size_t FILE_ID_SIZE = 16;
+    static const std::size_t HEADER_SIZE = 4 + 1 + 3 + 4 + 8 + FILE_ID_SIZE;
+    // secretstream header and tag of every chunk
+    static const std::size_t CHUNK_OVERHEAD = 24 + 17;
+
+private:
+    std::string m_secretKey;
+    std::ifstream m_file;
+    Header m_header;
+    std::string m_headerData;
+    std::string m_key;
+    std::string m_buffer;
+
+public:
+    explicit FileCipher(const std::string &secretKey);
+
+    bool encryptFile(const std::filesystem::path &file, const std::filesystem::path &resultFile,
+                     uint32_t chunkSize = DEFAULT_CHUNK_SIZE);
+    bool decryptFile(const std::filesystem::path &file, const std::filesystem::path &resultFile);
+
+    /**
+     * @brief Open encrypted file for reading of chunks
+     */
+    bool open(const std::filesystem::path &file);
+    uint64_t size() const;
+    uint32_t chunkSize() const;
+    uint64_t chunkCount() const;
+    /**
+     * @brief Decrypt one chunk of opened file
+     * @return false if chunk is missing or was modified
+     */
+    bool readChunk(uint64_t index, std::string &data);
+
+    static bool isEncrypted(const std::filesystem::path &file);
+
+private:
+    std::string fileKey(const std::string &fileId) const;
+    bool encryptChunk(std::string &result, std::string_view data, uint64_t index, bool last) const;
+};
+
+#endif // FILE_CIPHER_H
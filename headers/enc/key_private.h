@@ -27,6 +27,7 @@
 #include "extrachain_global.h"
 
 #include <filesystem>
+#include <string_view>
 
 class EXTRACHAIN_EXPORT KeyPrivate {
 private:
@@ -56,10 +57,16 @@ public:
     std::string encryptSelf(const std::string &data) const;
     std::string decryptSelf(const std::string &data) const;
 
-    void encryptFile(const std::filesystem::path &file, const std::filesystem::path &resultFile) const;
-    void decryptFile(const std::filesystem::path &file, const std::filesystem::path &resultFile) const;
+    /**
+     * @brief Encrypt file with FileCipher, key is derived from secret key
+     */
+    bool encryptFile(const std::filesystem::path &file, const std::filesystem::path &resultFile) const;
+    /**
+     * @brief Decrypt file of FileCipher format or of old format with encryptSelf sections
+     */
+    bool decryptFile(const std::filesystem::path &file, const std::filesystem::path &resultFile) const;
 
-    std::string sign(const std::string &data) const;
+    std::string sign(std::string_view data) const;
     bool verify(const std::string &data, const std::string &signature) const;
 
     const std::string &secretKey() const;
@@ -37,6 +37,7 @@ class Transaction;
 class ActorId;
 class BigNumber;
 class DataMiningManager;
+class MetricsServer;
 template <typename T>
 class Actor;
 class KeyPrivate;
@@ -54,6 +55,7 @@ private:
     TransactionManager *m_txManager = nullptr;
     AccountController *m_accountController = nullptr;
     DataMiningManager *m_dmm = nullptr;
+    MetricsServer *m_metrics = nullptr;
     // ContractManager *m_contractManager = nullptr;
 
     bool fileMode = true;
@@ -94,9 +96,9 @@ public:
      * @param receiver - receiver address
      * @param amount - coin count
      */
-    Transaction createTransaction(ActorId receiver, BigNumberFloat amount, ActorId token);
+    Transaction createTransaction(ActorId receiver, Amount amount, ActorId token);
 
-    Transaction createTransactionFrom(ActorId sender, ActorId receiver, BigNumberFloat amount, ActorId token);
+    Transaction createTransactionFrom(ActorId sender, ActorId receiver, Amount amount, ActorId token);
 
     std::string exportUser();
     bool importUser(const std::string &data, const std::string &login, const std::string &password);
@@ -104,6 +106,11 @@ public:
 
     void createNetworkIdentifier();
 
+    /**
+     * @brief Serve metrics on loopback, also started by EXTRACHAIN_METRICS_PORT variable
+     */
+    bool startMetrics(quint16 port);
+
 private:
     void showMessage(QString from, QString message);
     /**
@@ -0,0 +1,125 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <QString>
+
+#include "extrachain_global.h"
+
+/**
+ * @brief Asynchronous log backend
+ * Every logging thread has its own lock-free ring, one writer thread drains
+ * them and passes records to sink in batches. Logging thread doesn't lock:
+ * with full ring it yields a few times, then record is dropped, drops are
+ * reported by a record.
+ */
+class EXTRACHAIN_EXPORT LogWriter {
+public:
+    struct Record {
+        uint64_t seq = 0;  // order of records of all threads
+        qint64 time = 0;   // msecs since epoch
+        QString message;
+        std::string file;
+        std::string function;
+        int line = 0;
+    };
+
+    /**
+     * @brief Called on writer thread at least every FLUSH_INTERVAL, batch is ordered and can be empty
+     */
+    using Sink = std::function<void(std::vector<Record> &batch)>;
+
+    struct Stats {
+        uint64_t records = 0; // passed to sink
+        uint64_t dropped = 0;
+        uint64_t batches = 0;
+    };
+
+    static const std::size_t RING_SIZE = 4096;
+    static const int FLUSH_INTERVAL = 50; // ms
+    // Yields of logging thread with full ring before record is dropped
+    static const int FULL_RETRIES = 64;
+
+private:
+    struct Ring {
+        std::vector<Record> slots;
+        std::atomic<uint64_t> head = 0; // next record to drain
+        std::atomic<uint64_t> tail = 0; // next free slot
+
+        explicit Ring(std::size_t size);
+    };
+
+    Sink m_sink;
+    std::size_t m_ringSize;
+    uint64_t m_id;
+    std::atomic<uint64_t> m_seq = 0;
+    std::atomic<uint64_t> m_dropped = 0;
+    uint64_t m_reportedDropped = 0;
+    std::atomic<uint64_t> m_records = 0;
+    std::atomic<uint64_t> m_batches = 0;
+
+    std::mutex m_mutex;
+    std::unordered_map<std::thread::id, std::shared_ptr<Ring>> m_rings;
+    std::condition_variable m_wake;
+    std::condition_variable m_flushed;
+    uint64_t m_flushRequested = 0;
+    uint64_t m_flushDone = 0;
+    std::atomic<bool> m_urgent = false;
+    bool m_stop = false;
+    std::thread m_thread;
+
+public:
+    explicit LogWriter(Sink sink, std::size_t ringSize = RING_SIZE);
+    LogWriter(const LogWriter &) = delete;
+    /**
+     * @brief Passes remaining records to sink and stops writer thread
+     */
+    ~LogWriter();
+
+    /**
+     * @return false if record was dropped
+     */
+    bool push(Record record);
+    /**
+     * @brief Wait until records pushed before are passed to sink, does nothing on writer thread
+     */
+    void flush();
+    Stats stats() const;
+
+private:
+    Ring &ring();
+    void run();
+    void drain(std::vector<Record> &batch);
+};
+
+#endif // LOG_WRITER_H
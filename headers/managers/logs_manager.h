@@ -21,6 +21,7 @@
 #define LOGSMANAGER_H
 
 #include "extrachain_global.h"
+#include "managers/log_writer.h"
 #include "utils/variant_model.h"
 #include <QDateTime>
 #include <QDir>
@@ -48,6 +49,17 @@ public:
     static void emptyHandler();
     static void print(const std::string& log);
     static void setDebugLogs(bool debugLogs);
+    /**
+     * @brief Log through LogWriter, messages are written by its thread in batches
+     * etHandler turns it on, qtHandler and emptyHandler turn it off
+     */
+    static void setAsync(bool async);
+    // Wait until queued messages are written
+    static void flush();
+    /**
+     * @brief File is rotated when it reaches maxFileSize, oldest files above maxFiles are removed
+     */
+    static void setRotation(qint64 maxFileSize, int maxFiles);
 
     static bool toConsole;
     static bool toFile;
@@ -55,6 +67,11 @@ public:
     static bool antiFilter;
     static bool debugLogs;
     static VariantModel logs;
+    static QString logsPath;
+    static qint64 maxFileSize;
+    static int maxFiles;
+    // Rows are added to logs not more often, used by asynchronous logging
+    static const int MODEL_INTERVAL = 250; // ms
 
     static QStringList filesFilter;
     static void setFilesFilter(const QStringList& value);
@@ -68,6 +85,13 @@ public: // slots:
 
 private:
     static QString normalizeFileName(const QString& file);
+    /**
+     * @return false if message is filtered out
+     */
+    static bool formatLog(const QString& file, int line, const QString& function, const QString& msg,
+                          const QDateTime& dateTime, QString& logStr, QVariantMap& row);
+    static void writeFile(const QByteArray& data);
+    static void writeBatch(std::vector<LogWriter::Record>& batch);
 };
 
 struct UnicodedStream : QTextStream {
@@ -17,70 +17,138 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
 
-#include <QCoreApplication>
-#include <QDebug>
-#include <QThread>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <QObject>
+#include <QPointer>
+
+#include "extrachain_global.h"
+
+/**
+ * @brief Fixed-size work-stealing executor
+ * Every worker has its own queues, tasks submitted from a worker go to its
+ * queues and are taken newest first, idle workers steal oldest tasks of
+ * others. Higher priority tasks of any worker are taken before lower ones.
+ */
+class EXTRACHAIN_EXPORT ThreadPool {
+public:
+    enum class Priority {
+        High,
+        Normal,
+        Low
+    };
+
+    using Task = std::function<void()>;
+
+    struct Stats {
+        uint64_t executed = 0;
+        uint64_t stolen = 0; // taken from queues of other workers
+    };
 
-class ThreadPool {
 private:
-    ThreadPool() = default;
-    ~ThreadPool() = default;
+    static const std::size_t PRIORITIES = 3;
+
+    struct Worker {
+        std::mutex mutex;
+        std::array<std::deque<Task>, PRIORITIES> queues;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+    std::array<std::atomic<uint64_t>, PRIORITIES> m_queued = {};
+    std::atomic<uint64_t> m_pending = 0; // queued and running
+    std::atomic<uint64_t> m_helping = 0; // running tasks that wait for others in waitForDone
+    std::atomic<uint64_t> m_next = 0;    // worker of next outside task
+    std::atomic<uint64_t> m_executed = 0;
+    std::atomic<uint64_t> m_stolen = 0;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    bool m_stop = false;
 
 public:
-    template <class Worker>
-    static QThread *addThread(Worker *worker, QThread *newThread = nullptr) {
-        QThread *thread = newThread == nullptr ? new QThread() : newThread;
-
-        QObject::connect(thread, &QThread::started, worker, &Worker::process);
-        QObject::connect(worker, &Worker::finished, thread, &QThread::quit);
-        // QObject::connect(thread, &QThread::finished, worker, &Worker::deleteLater);
-        // QObject::connect(thread, &QThread::finished, thread, &QThread::deleteLater);
-        QObject::connect(thread, &QThread::finished, [thread, worker]() {
-            if (!threads.contains(thread)) {
-                qDebug() << "[ThreadPool] Ignore" << worker;
-                return;
-            }
-            // qDebug() << "[ThreadPool] Remove thread for" << worker;
-            // qDebug() << "[ThreadPool] Remove thread" << thread << "for" << worker <<
-            // threads.removeAll(thread)
-            //          << "to" << threads.length();
-            worker->deleteLater();
-            thread->deleteLater();
-        });
-
-        if (isFirst) {
-            qDebug() << "[ThreadPool] Connected with qApp";
-            QObject::connect(qApp, &QCoreApplication::aboutToQuit, []() {
-                // qDebug() << "[ThreadPool] Remove all threads" << threads.length() << threads;
-                // for (auto i = threads.size() - 1; i != 0; i--)
-                //     threads[i]->quit();
-                threads.clear();
-            });
-
-            isFirst = false;
-        }
-
-        // qDebug() << "[ThreadPool] Move for" << worker;
-        // qDebug() << "[ThreadPool] Move to thread" << thread << "for" << worker << threads.length();
-        worker->moveToThread(thread);
-
-        if (!thread->isRunning()) {
-            // qDebug() << "[ThreadPool] Start" << thread;
-            threads << thread;
-            thread->start();
-        } else {
-            // qDebug() << "[ThreadPool] Ignore start" << thread;
-        }
-
-        return thread;
+    /**
+     * @param threads 0 is one per hardware thread
+     */
+    explicit ThreadPool(std::size_t threads = 0);
+    ThreadPool(const ThreadPool &) = delete;
+    /**
+     * @brief Runs queued tasks and joins workers
+     */
+    ~ThreadPool();
+
+    static ThreadPool &instance();
+
+    void post(Task task, Priority priority = Priority::Normal);
+
+    template <class Function>
+    auto submit(Function &&function, Priority priority = Priority::Normal)
+        -> std::future<std::invoke_result_t<std::decay_t<Function>>> {
+        using Result = std::invoke_result_t<std::decay_t<Function>>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        auto future = task->get_future();
+        post([task] { (*task)(); }, priority);
+        return future;
+    }
+
+    /**
+     * @brief Run function on pool, done gets its result in thread of context
+     * Nothing is called if context is destroyed before function is done.
+     */
+    template <class Function, class Done>
+    void submit(Function &&function, QObject *context, Done &&done, Priority priority = Priority::Normal) {
+        using Result = std::invoke_result_t<std::decay_t<Function>>;
+        post(
+            [function = std::forward<Function>(function), receiver = QPointer<QObject>(context),
+             done = std::forward<Done>(done)]() mutable {
+                if constexpr (std::is_void_v<Result>) {
+                    function();
+                    if (receiver)
+                        QMetaObject::invokeMethod(receiver, std::move(done), Qt::QueuedConnection);
+                } else {
+                    auto result = function();
+                    if (receiver)
+                        QMetaObject::invokeMethod(
+                            receiver,
+                            [done = std::move(done), result = std::move(result)]() mutable {
+                                done(std::move(result));
+                            },
+                            Qt::QueuedConnection);
+                }
+            },
+            priority);
     }
 
+    /**
+     * @brief Wait until all tasks are done, including tasks they submit
+     * On a worker of this pool queued tasks are run by the caller, it returns when only tasks
+     * that wait as well are running.
+     */
+    void waitForDone();
+    std::size_t size() const;
+    uint64_t pending() const;
+    Stats stats() const;
+
 private:
-    static bool isFirst;
-    static QList<QThread *> threads;
+    void work(std::size_t index);
+    void run(Task &task);
+    bool take(std::size_t index, Task &task);
+    bool queued() const;
 };
 
 #endif // THREAD_POOL_H
@@ -26,6 +26,10 @@
 #include <QObject>
 #include <QThread>
 #include <QTimer>
+#include <deque>
+#include <optional>
+#include <string>
+#include <unordered_map>
 
 #include "datastorage/block.h"
 #include "datastorage/blockchain.h"
@@ -41,10 +45,23 @@ class ExtraChainNode;
 class EXTRACHAIN_EXPORT TransactionManager : public QObject {
     Q_OBJECT
 
+public:
+    enum class TxState {
+        Received,  // waiting for prove
+        Verifying, // proved on worker thread
+        Proved,    // waiting for block
+        Rejected,
+        Included // packed into block
+    };
+
+    // Received txs proved by one worker task
+    static const std::size_t PROVE_BATCH_SIZE = 64;
+    // Finished txs remembered to drop their copies
+    static const std::size_t MAX_FINISHED_TXS = 65536;
+
 private:
     // to create block's from pending txs
     QTimer blockCreationTimer;
-    QTimer proveTimer;
 
     // received transactions that will be packed into block
     std::vector<Transaction> pendingTxs;
@@ -54,6 +71,12 @@ private:
     QList<QByteArray> unApprovedTxHashes;
 
     QList<Transaction> receivedTxList;
+    // state of every known tx by hash, tx is proved once
+    std::unordered_map<std::string, TxState> txStates;
+    std::deque<std::string> finishedTxs; // oldest first
+    bool proveScheduled = false;
+    // changes when pending txs are packed, balances proved before are outdated
+    uint64_t blocksMade = 0;
 
     // current user
     //    Actor<KeyPrivate> currentUser;
@@ -71,13 +94,24 @@ public:
 
 private:
     void removeTransaction(int i);
+    /**
+     * @brief Gossip local tip as liveness heartbeat when there is nothing to pack
+     */
+    void sendHeartbeat();
+    /**
+     * @brief Prove received txs on next event loop pass, txs arrived till then go in one batch
+     */
+    void scheduleProve();
+    void finishProve(Transaction tx, const Blockchain::TxProof &proof, uint64_t made);
+    void setFinished(const std::string &hash, TxState state);
 
 public:
     static std::string convertTxs(const std::vector<Transaction> &txs);
-    BigNumberFloat checkPendingTxsList(const ActorId &sender);
+    Amount checkPendingTxsList(const ActorId &sender);
     QList<Transaction> getReceivedTxList() const;
 
     std::vector<Transaction> getPendingTxs() const;
+    std::optional<TxState> txState(const std::string &hash) const;
 
 public slots:
     /**
@@ -1,8 +1,11 @@
 #ifndef ISOCKETSERVICE_H
 #define ISOCKETSERVICE_H
 
+#include <string_view>
+
 #include "enc/key_private.h"
 #include "enc/key_public.h"
+#include "utils/buffer_pool.h"
 #include "utils/exc_utils.h"
 
 class ExtraChainNode;
@@ -33,6 +36,7 @@ public:
 
 public:
     virtual void sendMessage(const QByteArray &data) = 0;
+    virtual void sendFrame(std::string_view frame) = 0;
 
 protected slots:
     virtual void closeSocket();
@@ -50,6 +54,10 @@ protected:
     QByteArray generateFirstMessage();
     QByteArray prepareSendMessage(const QByteArray &message);
     QByteArray prepareReceiveMessage(const QByteArray &message);
+    /**
+     * @brief Encrypt frame into a pooled buffer, same result as prepareSendMessage
+     */
+    BufferPool::Buffer prepareSendFrame(std::string_view frame);
 
     ExtraChainNode &node;
     QString m_identifier;
@@ -63,6 +71,7 @@ protected:
 
     KeyPrivate priv;
     KeyPublic pub;
+    std::string m_sharedKey; // precomputed for pub
 };
 
 #endif // WEBSOCKETSERVICE_H
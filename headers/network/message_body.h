@@ -27,6 +27,10 @@ enum class MessageType {
     RequestDfsSize = 61,
     ResponseDfsSize = 62,
     DfsState = 63,
+    DfsFindFile = 64,
+    DfsRequestSegment = 65,
+    DfsSegment = 66,
+    DfsManifest = 67,
 
     BlockchainGenesisBlock = 80,
     BlockchainNewBlock = 81,
@@ -34,6 +38,10 @@ enum class MessageType {
     BlockchainCopyScript = 83,
     BlockchainDataMiningRewardTransaction = 84,
     BlockchainCoinReward = 85,
+    BlockchainTip = 86,
+    BlockchainBlockRange = 87,
+    BlockchainHeaders = 88,
+    BlockchainNewHeader = 89,
 
     FragmentDataInfo = 90,
     FragmentsDataListInfo = 91
@@ -0,0 +1,99 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef MESSAGE_FILTER_H
+#define MESSAGE_FILTER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "extrachain_global.h"
+
+/**
+ * @brief Duplicate filter for incoming network messages
+ * Two Bloom filter generations are kept: the current one receives new keys,
+ * the previous one only answers lookups. Generations rotate when the window
+ * expires or when the current one is full, so memory is fixed and keys are
+ * remembered for one to two windows.
+ */
+class EXTRACHAIN_EXPORT MessageFilter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Expected distinct messages per window
+    static const std::size_t DEFAULT_CAPACITY = 100000;
+    // Target false positive rate of one full generation
+    static constexpr double DEFAULT_FALSE_POSITIVE = 0.0001;
+    static constexpr std::chrono::seconds DEFAULT_WINDOW = std::chrono::seconds(60);
+
+private:
+    struct Generation {
+        std::vector<uint64_t> bits;
+        std::size_t inserted = 0;
+    };
+
+    mutable std::mutex m_mutex;
+    Generation m_current;
+    Generation m_previous;
+    std::size_t m_capacity;
+    std::size_t m_bitCount;
+    int m_hashCount;
+    Clock::duration m_window;
+    Clock::time_point m_windowStart;
+    uint64_t m_checked = 0;
+    uint64_t m_duplicates = 0;
+
+public:
+    explicit MessageFilter(std::size_t capacity = DEFAULT_CAPACITY,
+                           double falsePositive = DEFAULT_FALSE_POSITIVE,
+                           Clock::duration window = DEFAULT_WINDOW);
+
+    /**
+     * @brief Check key and remember it
+     * @return true if key was not seen during the last one or two windows
+     */
+    bool insert(std::string_view key);
+    bool contains(std::string_view key) const;
+    void clear();
+
+    /**
+     * @brief Key of message, payload is folded in as 64-bit non-cryptographic digest
+     * Several responses can share one message id, ids of one sender can collide too.
+     */
+    static std::string makeKey(std::string_view sender, std::string_view messageId, int type, int status,
+                               std::string_view data);
+
+    double falsePositiveRate() const;
+    std::size_t memoryUsage() const;
+    std::size_t capacity() const;
+    Clock::duration window() const;
+    uint64_t checked() const;
+    uint64_t duplicates() const;
+
+private:
+    void rotateIfNeeded(Clock::time_point now);
+    bool test(const Generation &generation, uint64_t h1, uint64_t h2) const;
+    static void hash(std::string_view key, uint64_t &h1, uint64_t &h2);
+    static double generationRate(std::size_t inserted, std::size_t bitCount, int hashCount);
+};
+
+#endif // MESSAGE_FILTER_H
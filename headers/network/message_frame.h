@@ -0,0 +1,99 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef MESSAGE_FRAME_H
+#define MESSAGE_FRAME_H
+
+#include <string>
+
+#include <msgpack.hpp>
+
+#include "enc/key_private.h"
+#include "network/message_body.h"
+
+/**
+ * @brief Signed network message written straight into a buffer
+ * Produces the same bytes as NetworkManager::send_message (serialized MessageBody
+ * followed by signature), but the payload is packed in place of MessageBody::data
+ * instead of being serialized into a separate string first. Payloads holding views
+ * (DFSP::SegmentView) are copied only once, into the frame.
+ */
+namespace MessageFrame {
+// base64 of ed25519 signature
+static const std::size_t SIGNATURE_SIZE = 88;
+
+namespace Detail {
+    struct SizeCounter {
+        std::size_t size = 0;
+        void write(const char *, std::size_t length) {
+            size += length;
+        }
+    };
+
+    struct Appender {
+        std::string &buffer;
+        void write(const char *data, std::size_t length) {
+            buffer.append(data, length);
+        }
+    };
+
+    template <class Stream>
+    void packHeader(Stream &stream, const MessageBody &header, std::size_t payloadSize) {
+        msgpack::packer<Stream> packer(stream);
+        packer.pack_array(5);
+        packer.pack(header.message_type);
+        packer.pack(header.status);
+        packer.pack(header.message_id);
+        packer.pack(header.sender_id);
+        packer.pack_str(uint32_t(payloadSize));
+    }
+}
+
+template <class T>
+std::size_t payloadSize(const T &payload) {
+    Detail::SizeCounter counter;
+    msgpack::pack(counter, payload);
+    return counter.size;
+}
+
+/**
+ * @brief Size of frame with signature, to reserve buffer before write
+ */
+template <class T>
+std::size_t size(const MessageBody &header, const T &payload) {
+    const std::size_t dataSize = payloadSize(payload);
+    Detail::SizeCounter counter;
+    Detail::packHeader(counter, header, dataSize);
+    return counter.size + dataSize + SIGNATURE_SIZE;
+}
+
+/**
+ * @param header message without data, data is replaced by payload
+ */
+template <class T>
+void write(std::string &buffer, const MessageBody &header, const T &payload, const KeyPrivate &key) {
+    buffer.clear();
+    Detail::Appender appender { buffer };
+    Detail::packHeader(appender, header, payloadSize(payload));
+    msgpack::pack(appender, payload);
+    buffer += key.sign(buffer);
+}
+}
+
+#endif // MESSAGE_FRAME_H
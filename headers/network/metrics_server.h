@@ -0,0 +1,60 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "extrachain_global.h"
+
+/**
+ * @brief Serves metrics registry as text on GET /metrics
+ * Listens on loopback only, one request per connection.
+ */
+class EXTRACHAIN_EXPORT MetricsServer : public QObject {
+    Q_OBJECT
+
+public:
+    // Longer request headers are dropped
+    static const int MAX_REQUEST_SIZE = 8 * 1024;
+
+private:
+    QTcpServer m_server;
+
+public:
+    explicit MetricsServer(QObject *parent = nullptr);
+
+    /**
+     * @param port 0 for any free port
+     */
+    bool listen(quint16 port);
+    quint16 port() const;
+
+private slots:
+    void newConnection();
+
+private:
+    void answer(QTcpSocket *socket);
+};
+
+#endif // METRICS_SERVER_H
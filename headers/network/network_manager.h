@@ -35,7 +35,10 @@
 #include "datastorage/index/actorindex.h"
 #include "managers/account_controller.h"
 #include "network/message_body.h"
+#include "network/message_filter.h"
+#include "network/message_frame.h"
 #include "network/network_status.h"
+#include "utils/buffer_pool.h"
 #include "utils/dfs_utils.h"
 #include "utils/exc_utils.h"
 
@@ -83,7 +86,8 @@ private:
     bool active = false;
     UPNPConnection *upnpDis;
     UPNPConnection *upnpNet;
-    QMap<std::string, int> msgHashList = {};
+    MessageFilter m_messageFilter;
+    BufferPool m_bufferPool;
 
     ExtraChainNode &node;
     QNetworkAddressEntry *local = nullptr;
@@ -110,6 +114,12 @@ private:
 public:
     const QList<SocketService *> &connections() const;
     bool serverStatus(Network::Protocol protocol) const;
+    const MessageFilter &messageFilter() const;
+    /**
+     * @brief Socket identifier of received request, empty after it was answered
+     */
+    std::string requestSocket(const std::string &messageId) const;
+    BufferPool &bufferPool();
 
 public slots:
     void removeConnection(const QString &identifier);
@@ -124,10 +134,11 @@ protected:
 
     /**
      * @brief NetworkManager::checkMsgCount
-     * @param msg
-     * @return
+     * Check message by sender, id, type and status without hashing of payload
+     * @param message
+     * @return false if message was already received
      */
-    bool checkMsgCount(const std::string &msg);
+    bool checkMsgCount(const MessageBody &message);
 
 private slots:
     void onNewWsConnection();
@@ -153,6 +164,8 @@ public:
 
     void sendMessage(const std::string &serialized_message, Config::Net::TypeSend typeSend,
                      const std::string &receiver_identifier);
+    void sendFrame(std::string_view frame, Config::Net::TypeSend typeSend,
+                   const std::string &receiver_identifier);
     void saveToCache(const std::string &serialized_message, Config::Net::TypeSend typeSend,
                      const std::string &receiver_identifier);
     void sendFromCache();
@@ -160,10 +173,21 @@ public:
 
     void messageReceived(const std::string &message, const std::string &identifier);
 
+    /**
+     * @brief Check if message of typeSend for receiver goes to socket
+     * Focused message with unknown receiver goes to all sockets.
+     */
+    static bool isReceiver(Config::Net::TypeSend typeSend, std::string_view receiver,
+                           std::string_view socket);
+
+    /**
+     * @param receiver socket identifier for Focused message that isn't a response
+     */
     template <class T>
     std::string send_message(T data, MessageType type, MessageStatus status = MessageStatus::NoStatus,
                              std::string to_message_id = "",
-                             Config::Net::TypeSend typeSend = Config::Net::TypeSend::All) {
+                             Config::Net::TypeSend typeSend = Config::Net::TypeSend::All,
+                             const std::string &receiver = std::string()) {
         if (status == MessageStatus::Response && to_message_id.empty()) {
             qFatal("[Network] Send message error: empty message id for response message");
         }
@@ -183,12 +207,14 @@ public:
             make_message(MessagePack::serialize(data), type, status, mainActor.id(), to_message_id);
         auto serialized = message.serialize();
         auto sign = mainActor.key().sign(serialized);
-        std::string receiver_identifier;
+        std::string receiver_identifier = receiver;
         if (!to_message_id.empty()) {
-            receiver_identifier = m_messages[to_message_id];
-            //            if (receiver_identifier.empty())
-            //                qFatal("Network send message error: receiver_identifier is empty");
-            m_messages.erase(to_message_id);
+            // socket of request is dropped after first response
+            auto requester = m_messages.find(to_message_id);
+            if (requester != m_messages.end()) {
+                receiver_identifier = requester->second;
+                m_messages.erase(requester);
+            }
         }
 
 #ifdef QT_DEBUG
@@ -208,6 +234,44 @@ public:
         return message.message_id;
     }
 
+    /**
+     * @brief Same as send_message, but payload is packed straight into a pooled frame
+     * Use for payloads with views (DFSP::SegmentView) to avoid copies of large data.
+     */
+    template <class T>
+    std::string send_frame(const T &data, MessageType type, MessageStatus status = MessageStatus::NoStatus,
+                           std::string to_message_id = "",
+                           Config::Net::TypeSend typeSend = Config::Net::TypeSend::All,
+                           const std::string &receiver = std::string()) {
+        if (status == MessageStatus::Response && to_message_id.empty()) {
+            qFatal("[Network] Send frame error: empty message id for response message");
+        }
+        if (status == MessageStatus::Response && typeSend == Config::Net::TypeSend::All) {
+            typeSend = Config::Net::TypeSend::Focused;
+        }
+
+        if (node.accountController()->count() == 0) {
+            return "";
+        }
+
+        auto &mainActor = node.accountController()->mainActor();
+        MessageBody header = make_message("", type, status, mainActor.id(), to_message_id);
+        auto frame = m_bufferPool.acquire(MessageFrame::size(header, data));
+        MessageFrame::write(frame.data(), header, data, mainActor.key());
+
+        std::string receiver_identifier = receiver;
+        if (!to_message_id.empty()) {
+            auto requester = m_messages.find(to_message_id);
+            if (requester != m_messages.end()) {
+                receiver_identifier = requester->second;
+                m_messages.erase(requester);
+            }
+        }
+
+        this->sendFrame(frame.data(), typeSend, receiver_identifier);
+        return header.message_id;
+    }
+
 signals:
     void newSocket();
     void connectionStatusChanged(bool status);
@@ -34,6 +34,7 @@ public:
 
 public:
     virtual void sendMessage(const QByteArray &data) override;
+    virtual void sendFrame(std::string_view frame) override;
 private slots:
     void onTextMessage(const QString &message);
     void onBinaryMessage(const QByteArray &message);
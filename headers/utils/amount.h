@@ -0,0 +1,134 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef AMOUNT_H
+#define AMOUNT_H
+
+#include <QDebug>
+#include <string>
+#include <string_view>
+
+#include "boost/multiprecision/cpp_int.hpp"
+#include "msgpack.hpp"
+
+#include "extrachain_global.h"
+#include "utils/bignumber.h"
+
+/**
+ * Amount of coins or tokens with DECIMALS decimal places, kept as signed 128-bit count of units
+ * example: 1.5 is 1500000000000000000 units
+ * Arithmetic throws std::overflow_error instead of wrapping around
+ */
+class EXTRACHAIN_EXPORT Amount {
+public:
+    using Units = boost::multiprecision::checked_int128_t;
+    static const int DECIMALS = 18;
+
+    Amount() = default;
+    Amount(int units);
+    Amount(long long units);
+    explicit Amount(const Units &units);
+    explicit Amount(const BigNumber &units);
+
+    /**
+     * @brief Parse units in decimal, float notation of older versions is truncated to units
+     * @return zero if value is incorrect
+     */
+    static Amount fromString(const std::string &units);
+    /**
+     * @brief "1.5" -> 1500000000000000000 units
+     * @return zero if value is incorrect or has more than DECIMALS decimal places
+     */
+    static Amount fromVisible(const std::string &visible);
+    static const Amount &unit(); // 1 in visible form
+
+private:
+    Units m_units = 0;
+
+public:
+    Amount operator+(const Amount &other) const;
+    Amount operator-(const Amount &other) const;
+    Amount operator*(long long factor) const;
+    Amount operator/(long long divisor) const;
+    Amount operator-() const;
+    Amount &operator+=(const Amount &other);
+    Amount &operator-=(const Amount &other);
+    Amount &operator*=(long long factor);
+    Amount &operator/=(long long divisor);
+    /**
+     * @brief Fixed-point product and quotient, result is truncated to units
+     */
+    Amount mul(const Amount &other) const;
+    Amount div(const Amount &other) const;
+
+public:
+    const Units &units() const;
+    bool isEmpty() const;
+    Amount abs() const;
+    BigNumber toBigNumber() const;
+    // Units in decimal
+    std::string toStdString() const;
+    QByteArray toByteArray() const;
+    std::string toVisible() const;
+    // Text of BigNumberFloat with the same value, kept in hashes of transactions
+    std::string toLegacyString() const;
+
+    // Shortest big-endian two's complement
+    std::string toBytes() const;
+    static Amount fromBytes(std::string_view bytes);
+
+    template <typename Packer>
+    void msgpack_pack(Packer &msgpack_pk) const {
+        const std::string bytes = toBytes();
+        msgpack_pk.pack_bin(uint32_t(bytes.size()));
+        msgpack_pk.pack_bin_body(bytes.data(), uint32_t(bytes.size()));
+    }
+
+    void msgpack_unpack(msgpack::object const &msgpack_o);
+};
+
+inline bool operator<(const Amount &l, const Amount &r) {
+    return l.units() < r.units();
+}
+
+inline bool operator>(const Amount &l, const Amount &r) {
+    return l.units() > r.units();
+}
+
+inline bool operator<=(const Amount &l, const Amount &r) {
+    return l.units() <= r.units();
+}
+
+inline bool operator>=(const Amount &l, const Amount &r) {
+    return l.units() >= r.units();
+}
+
+inline bool operator==(const Amount &l, const Amount &r) {
+    return l.units() == r.units();
+}
+
+inline bool operator!=(const Amount &l, const Amount &r) {
+    return l.units() != r.units();
+}
+
+QDebug operator<<(QDebug debug, const Amount &amount);
+std::ostream &operator<<(std::ostream &os, const Amount &amount);
+
+#endif // AMOUNT_H
@@ -28,28 +28,29 @@
 #include <QtCore/QString>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 #include "boost/multiprecision/cpp_int.hpp"
 #include "msgpack.hpp"
 
 #include "extrachain_global.h"
 
-#ifdef QT_DEBUG
-    #define UPDATE_DEBUG()       \
-        qdata = toStdString(16); \
-        qdataDec = toStdString(10);
-#else
-    #define UPDATE_DEBUG()
-#endif
-
 namespace BigNumberUtils {
 const static QList<char> Chars = { 'a', 'b', 'c', 'd', 'e', 'f', '0', '1',
                                    '2', '3', '4', '5', '6', '7', '8', '9' };
 }
 
+// msgpack ext types of binary encoding, older versions pack these values as strings
+namespace MessagePackExt {
+constexpr int8_t BigNumberV1 = 1; // sign byte and big-endian magnitude
+constexpr int8_t ActorIdV1 = 2;   // 20 hex digits as 10 bytes
+}
+
 /**
  * Data type for big hex numbers for addresses
  * example: ab11405c92a05c91c48
+ * Values of long long range are kept inline without allocations,
+ * larger ones are promoted to cpp_int.
  */
 class EXTRACHAIN_EXPORT BigNumber {
 public:
@@ -62,9 +63,12 @@ public:
     ~BigNumber() = default;
 
 private:
-    boost::multiprecision::cpp_int m_data;
+    long long m_small = 0;
+    bool m_isBig = false;
+    boost::multiprecision::cpp_int m_big; // only if value is out of long long
 
 #ifdef QT_DEBUG
+    // text of big values for debugger, small ones are seen in m_small
     std::string qdata;
     std::string qdataDec;
 #endif
@@ -103,7 +107,20 @@ public:
     BigNumber operator-() const;
 
 public:
-    const boost::multiprecision::cpp_int &data() const;
+    boost::multiprecision::cpp_int data() const;
+    // -1, 0, 1 as this is less, equal or greater
+    int compare(const BigNumber &other) const {
+        if (!m_isBig && !other.m_isBig)
+            return (m_small > other.m_small) - (m_small < other.m_small);
+        if (m_isBig != other.m_isBig) // big value is out of small range
+            return m_isBig ? m_big.sign() : -other.m_big.sign();
+        return m_big.compare(other.m_big);
+    }
+    int compare(long long number) const {
+        if (m_isBig)
+            return m_big.sign();
+        return (m_small > number) - (m_small < number);
+    }
     bool isEmpty() const;
     QByteArray toByteArray(int base = 16) const;
     std::string toStdString(int base = 16) const;
@@ -115,65 +132,76 @@ public:
     static BigNumber random(int n, const BigNumber &max, bool zeroAllowed = true);
     static BigNumber random(BigNumber max, bool zeroAllowed = true);
 
+    // Sign byte and big-endian magnitude
+    std::string toBytes() const;
+    static BigNumber fromBytes(std::string_view bytes);
+
+    // integer if it fits, ext otherwise
     template <typename Packer>
     void msgpack_pack(Packer &msgpack_pk) const {
-        std::string num = toStdString();
-        msgpack_pk.pack_str(num.size());
-        msgpack_pk.pack_str_body(num.data(), num.size());
+        if (!m_isBig) {
+            msgpack_pk.pack_int64(m_small);
+            return;
+        }
+        const std::string bytes = toBytes();
+        msgpack_pk.pack_ext(bytes.size(), MessagePackExt::BigNumberV1);
+        msgpack_pk.pack_ext_body(bytes.data(), bytes.size());
     }
 
-    void msgpack_unpack(msgpack::object const &msgpack_o) {
-        std::string num = msgpack_o.as<std::string>();
-        *this = BigNumber(num);
-    }
+    void msgpack_unpack(msgpack::object const &msgpack_o);
+
+private:
+    void setData(const boost::multiprecision::cpp_int &number);
+    bool parseHex(std::string_view text);
+    void updateDebug();
 };
 
 inline bool operator<(const BigNumber &l, const BigNumber &r) {
-    return l.data() < r.data();
+    return l.compare(r) < 0;
 }
 
 inline bool operator>(const BigNumber &l, const BigNumber &r) {
-    return l.data() > r.data();
+    return l.compare(r) > 0;
 }
 
 inline bool operator<=(const BigNumber &l, const BigNumber &r) {
-    return l.data() <= r.data();
+    return l.compare(r) <= 0;
 }
 
 inline bool operator>=(const BigNumber &l, const BigNumber &r) {
-    return l.data() >= r.data();
+    return l.compare(r) >= 0;
 }
 
 inline bool operator==(const BigNumber &l, const BigNumber &r) {
-    return l.data() == r.data();
+    return l.compare(r) == 0;
 }
 
 inline bool operator!=(const BigNumber &l, const BigNumber &r) {
-    return l.data() != r.data();
+    return l.compare(r) != 0;
 }
 
 inline bool operator<(const BigNumber &l, const int &r) {
-    return l.data() < r;
+    return l.compare(r) < 0;
 }
 
 inline bool operator>(const BigNumber &l, const int &r) {
-    return l.data() > r;
+    return l.compare(r) > 0;
 }
 
 inline bool operator<=(const BigNumber &l, const int &r) {
-    return l.data() <= r;
+    return l.compare(r) <= 0;
 }
 
 inline bool operator>=(const BigNumber &l, const int &r) {
-    return l.data() >= r;
+    return l.compare(r) >= 0;
 }
 
 inline bool operator==(const BigNumber &l, const int &r) {
-    return l.data() == r;
+    return l.compare(r) == 0;
 }
 
 inline bool operator!=(const BigNumber &l, const int &r) {
-    return l.data() != r;
+    return l.compare(r) != 0;
 }
 
 inline size_t qHash(const BigNumber &key, size_t seed) {
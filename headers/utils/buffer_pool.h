@@ -0,0 +1,82 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "extrachain_global.h"
+
+/**
+ * @brief Reusable byte buffers for outgoing messages
+ * Buffers keep their capacity between uses, so serving segments of the same
+ * size allocates only until the pool is warm.
+ */
+class EXTRACHAIN_EXPORT BufferPool {
+public:
+    /**
+     * @brief Buffer taken from the pool, returned on destruction
+     */
+    class EXTRACHAIN_EXPORT Buffer {
+        BufferPool *m_pool = nullptr;
+        std::string m_data;
+
+    public:
+        Buffer() = default;
+        Buffer(BufferPool *pool, std::string &&data);
+        Buffer(Buffer &&buffer) noexcept;
+        Buffer &operator=(Buffer &&buffer) noexcept;
+        ~Buffer();
+
+        std::string &data();
+        const std::string &data() const;
+    };
+
+    // Idle buffers kept for reuse
+    static const std::size_t DEFAULT_MAX_IDLE = 16;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::string> m_idle;
+    std::size_t m_maxIdle;
+    uint64_t m_allocations = 0;
+    uint64_t m_acquired = 0;
+
+public:
+    explicit BufferPool(std::size_t maxIdle = DEFAULT_MAX_IDLE);
+
+    /**
+     * @brief Empty buffer with at least capacity bytes reserved
+     */
+    Buffer acquire(std::size_t capacity);
+
+    // Buffers allocated or grown by acquire
+    uint64_t allocations() const;
+    uint64_t acquired() const;
+    std::size_t idle() const;
+
+private:
+    void release(std::string &&data);
+};
+
+#endif // BUFFER_POOL_H
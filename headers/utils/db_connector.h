@@ -76,6 +76,19 @@ public:
     bool update(const std::string &query);
     bool createTable(const std::string &query);
     bool deleteRow(const std::string &tableName, const DBRow &data);
+    /**
+     * @brief Prepare query once and run it for every list of parameters
+     * Parameters are bound as text in order.
+     * @return result rows of all runs
+     */
+    std::vector<DBRow> selectMany(const std::string &query,
+                                  const std::vector<std::vector<std::string>> &params);
+    /**
+     * @brief Prepare statement once and run it for every list of parameters, all in one transaction
+     * Parameters are bound as text in order.
+     * @return false if any run failed, nothing is changed then
+     */
+    bool execMany(const std::string &query, const std::vector<std::vector<std::string>> &params);
     bool deleteTable(const std::string &name);
     bool tableExists(const std::string &table);
     bool dropTable(const std::string &table);
@@ -3,6 +3,7 @@
 
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "utils/bignumber.h"
@@ -57,6 +58,7 @@ namespace Basic {
     static const std::wstring fsActrRootW = L"dfs";
     static const std::string fsMapName = ".dir";
     static const std::string dirsPath = "dfs/.dirs";
+    static const std::string chunksPath = "dfs/.chunks";
     static const uint64_t sectionSize = /*2097152*/ 524228;
     static const uint64_t maxSectionSize = 209715200;
     static const uint64_t historicalChainSectionSize = 209715200;
@@ -98,6 +100,36 @@ namespace Packets {
         MSGPACK_DEFINE(Actor, FileName, FileHash, Path, Offset)
     };
 
+    struct FindFileMessage {
+        std::string Actor;
+        std::string FileName;
+        uint64_t Size; // 0 in request, size of stored file in response
+        MSGPACK_DEFINE(Actor, FileName, Size)
+    };
+
+    struct RequestSegmentMessage {
+        std::string Peer; // only this node responds
+        std::string Actor;
+        std::string FileName;
+        uint64_t Offset;
+        uint64_t Size;
+        MSGPACK_DEFINE(Peer, Actor, FileName, Offset, Size)
+    };
+
+    struct ChunkRef {
+        std::string Hash;
+        uint64_t Size;
+        MSGPACK_DEFINE(Hash, Size)
+    };
+
+    // Chunks of stored file in file order, empty in request
+    struct ManifestMessage {
+        std::string Actor;
+        std::string FileName;
+        std::vector<ChunkRef> Chunks;
+        MSGPACK_DEFINE(Actor, FileName, Chunks)
+    };
+
     struct RemoveFileMessage {
         std::string Actor;
         std::string FileName;
@@ -112,6 +144,16 @@ namespace Packets {
         uint64_t Offset;
         MSGPACK_DEFINE(Actor, FileName, FileHash, Data, Offset)
     };
+
+    // Packed as SegmentMessage, Data points into mapped file
+    struct SegmentView {
+        std::string Actor;
+        std::string FileName;
+        std::string FileHash;
+        std::string_view Data;
+        uint64_t Offset;
+        MSGPACK_DEFINE(Actor, FileName, FileHash, Data, Offset)
+    };
     enum SegmentMessageType {
         add = 0,
         insert = 1,
@@ -227,6 +269,15 @@ namespace Historical {
           "data       BLOB                NOT NULL,"
           "hash       TEXT                NOT NULL "
           ");";
+    // Compressed state of file after log entry num, split into parts of historicalChainSectionSize
+    static const std::string TableNameCheckpoints = "HistoricalCheckpoints";
+    static const std::string CreateTableCheckpoints = "CREATE TABLE IF NOT EXISTS " + TableNameCheckpoints
+        + "("
+          "num        INTEGER             NOT NULL,"
+          "part       INTEGER             NOT NULL,"
+          "data       BLOB                NOT NULL,"
+          "PRIMARY KEY (num, part)"
+          ");";
 }
 namespace Reward {
     static const BigNumber coinProductionAlgorithmTick = BigNumber("100", 10);
@@ -252,7 +303,7 @@ namespace Tables {
         std::vector<DBRow> getFileDataByHash(DBConnector *db, std::string hash);
         std::vector<DBRow> getFileDataByName(DBConnector *db, std::string name);
         std::string getLastName(DBConnector &db);
-        int totalFileSize(const std::string &actorId);
+        uint64_t totalFileSize(const std::string &actorId);
         uint64_t dataAmountStoredSize(const std::string &actorId, const std::string &storjName);
 
         // TODO: optional
@@ -273,6 +324,54 @@ namespace Tables {
               ");";
     }
 
+    namespace DownloadsFile {
+        static const std::string TableName = "Downloads";
+        static const std::string CreateTableQuery = "CREATE TABLE IF NOT EXISTS " + TableName
+            + "("
+              "fileName     TEXT PRIMARY KEY NOT NULL,"
+              "actorId      TEXT             NOT NULL,"
+              "fileHash     TEXT             NOT NULL,"
+              "filePath     TEXT             NOT NULL,"
+              "fileSize     INTEGER          NOT NULL,"
+              "bitmap       BLOB             NOT NULL "
+              ");";
+    }
+
+    namespace SizesFile {
+        static const std::string TableName = "Sizes";
+        static const std::string CreateTableQuery = "CREATE TABLE IF NOT EXISTS " + TableName
+            + "("
+              "actorId      TEXT PRIMARY KEY NOT NULL,"
+              "disk         INTEGER          NOT NULL,"
+              "files        INTEGER          NOT NULL,"
+              "stored       INTEGER          NOT NULL "
+              ");";
+    }
+
+    namespace ChunksFile {
+        static const std::string TableName = "Chunks";
+        // file is actor id and file name separated with '/'
+        static const std::string CreateTableQuery = "CREATE TABLE IF NOT EXISTS " + TableName
+            + "("
+              "hash         TEXT             NOT NULL,"
+              "file         TEXT             NOT NULL,"
+              "offset       INTEGER          NOT NULL,"
+              "size         INTEGER          NOT NULL,"
+              "PRIMARY KEY (file, offset)"
+              ");";
+    }
+
+    namespace ChunkRefsFile {
+        static const std::string TableName = "ChunkRefs";
+        // refs is number of file chunks with this hash, chunk is stored while it's positive
+        static const std::string CreateTableQuery = "CREATE TABLE IF NOT EXISTS " + TableName
+            + "("
+              "hash         TEXT PRIMARY KEY NOT NULL,"
+              "size         INTEGER          NOT NULL,"
+              "refs         INTEGER          NOT NULL "
+              ");";
+    }
+
     static const std::string permissionTable = "PermissionTable";
     static const std::string permissionTableCreate = "CREATE TABLE IF NOT EXISTS " + permissionTable
         + " ("
@@ -179,7 +179,16 @@ namespace DataStorage {
     static const std::string actorsTableCreate = "CREATE TABLE IF NOT EXISTS " + actorsTable
         + " ("
           "id   TEXT PRIMARY KEY NOT NULL, "
-          "type INT              NOT NULL  "
+          "type INT              NOT NULL, "
+          "key  BLOB                       "
+          ");";
+
+    static const std::string headersTable = "Headers";
+    static const std::string headersTableCreate = "CREATE TABLE IF NOT EXISTS " + headersTable
+        + " ("
+          "height INTEGER PRIMARY KEY NOT NULL, "
+          "hash   TEXT                NOT NULL, "
+          "header BLOB                NOT NULL  "
           ");";
 
     // How many files one section folder will store
@@ -193,9 +202,6 @@ namespace DataStorage {
 
     // Max number of saved blocks in mem index
     static const int MEM_INDEX_SIZE_LIMIT = 1000;
-
-    // How often to prove pransactions
-    static const int PROVE_TXS_INTERVAL = 2000;
 } // namespace DataStorage
 
 namespace Net {
@@ -408,6 +414,7 @@ static const QString TMP_GENESIS_BLOCK = "tmp/genesis_block";
 static const QString BLOCKCHAIN_INDEX = "blockchain/index";
 static const QString ACTOR_INDEX_FOLDER_NAME = "actors";
 static const QString BLOCK_INDEX_FOLDER_NAME = "blocks";
+static const QString HEADER_INDEX_FILE_NAME = "headers";
 
 // Dfs
 static const int DATA_OFFSET = 512;
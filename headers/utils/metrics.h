@@ -0,0 +1,151 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "extrachain_global.h"
+
+/**
+ * @brief Process-wide counters, gauges and histograms
+ * Metrics are created once by name and labels and then updated with atomics
+ * only, callers keep references, usually in function statics. Registry
+ * renders everything in Prometheus text format.
+ */
+namespace Metrics {
+
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+// Seconds, from 50 us to 10 s
+EXTRACHAIN_EXPORT const std::vector<double> &latencyBuckets();
+
+class EXTRACHAIN_EXPORT Counter {
+    std::atomic<uint64_t> m_value = 0;
+
+public:
+    void inc(uint64_t value = 1);
+    uint64_t value() const;
+};
+
+class EXTRACHAIN_EXPORT Gauge {
+    std::atomic<int64_t> m_value = 0;
+
+public:
+    void set(int64_t value);
+    void add(int64_t value);
+    int64_t value() const;
+};
+
+class EXTRACHAIN_EXPORT Histogram {
+    std::vector<double> m_bounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_buckets; // not cumulative, last one is +Inf
+    std::atomic<uint64_t> m_count = 0;
+    std::atomic<double> m_sum = 0;
+
+public:
+    explicit Histogram(std::vector<double> bounds = latencyBuckets());
+
+    void observe(double value);
+    uint64_t count() const;
+    double sum() const;
+    const std::vector<double> &bounds() const;
+    /**
+     * @return observations up to every bound and total, cumulative
+     */
+    std::vector<uint64_t> cumulative() const;
+};
+
+/**
+ * @brief Observes seconds from construction to destruction
+ */
+class EXTRACHAIN_EXPORT Timer {
+    Histogram &m_histogram;
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    explicit Timer(Histogram &histogram);
+    Timer(const Timer &) = delete;
+    ~Timer();
+};
+
+class EXTRACHAIN_EXPORT Registry {
+    enum class Type {
+        Counter,
+        Gauge,
+        Histogram
+    };
+
+    struct Family {
+        Type type;
+        std::string help;
+        std::map<std::string, std::unique_ptr<Counter>> counters; // by rendered labels
+        std::map<std::string, std::unique_ptr<Gauge>> gauges;
+        std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    };
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, Family> m_families;
+
+public:
+    static Registry &instance();
+
+    /**
+     * @brief Metric of name and labels, created on first call
+     * Name used with another type is fatal.
+     */
+    Counter &counter(const std::string &name, const std::string &help, const Labels &labels = {});
+    Gauge &gauge(const std::string &name, const std::string &help, const Labels &labels = {});
+    Histogram &histogram(const std::string &name, const std::string &help, const Labels &labels = {},
+                         const std::vector<double> &bounds = latencyBuckets());
+
+    /**
+     * @brief All metrics in Prometheus text exposition format 0.0.4
+     */
+    std::string expose() const;
+
+private:
+    Family &family(const std::string &name, const std::string &help, Type type);
+};
+
+inline Counter &counter(const std::string &name, const std::string &help, const Labels &labels = {}) {
+    return Registry::instance().counter(name, help, labels);
+}
+
+inline Gauge &gauge(const std::string &name, const std::string &help, const Labels &labels = {}) {
+    return Registry::instance().gauge(name, help, labels);
+}
+
+inline Histogram &histogram(const std::string &name, const std::string &help, const Labels &labels = {},
+                            const std::vector<double> &bounds = latencyBuckets()) {
+    return Registry::instance().histogram(name, help, labels, bounds);
+}
+} // namespace Metrics
+
+#endif // METRICS_H
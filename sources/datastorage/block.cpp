@@ -107,13 +107,15 @@ void Block::setType(const std::string &value) {
 
 std::string Block::getDataForHash() const {
     std::string idHash = Utils::calcHash(getIndex().toStdString());
-    auto list = extractTransactions();
-    if (list.empty())
+    if (m_type != Config::DATA_BLOCK_TYPE)
         return idHash;
-    std::string txHash = Utils::calcHash(list[0].serialize());
-    for (int i = 1; i < list.size(); i++) {
-        std::string tmpTxHash = Utils::calcHash(list[i].serialize());
-        txHash = Utils::calcHash(txHash + tmpTxHash);
+    // stored bytes are hashed, encoding them again changes txs packed by older versions
+    std::string txHash;
+    for (const std::string &txData : Serialization::deserialize(data)) {
+        if (txData.empty() || Transaction(txData).isEmpty())
+            continue;
+        const std::string tmpTxHash = Utils::calcHash(txData);
+        txHash = txHash.empty() ? tmpTxHash : Utils::calcHash(txHash + tmpTxHash);
     }
     return idHash + txHash;
 }
@@ -133,6 +135,10 @@ bool Block::verify(const Actor<KeyPublic> &actor) const {
     return signatures.empty() ? false : res;
 }
 
+bool Block::checkHash() const {
+    return !hash.empty() && Utils::calcHash(getDataForHash()) == hash;
+}
+
 bool Block::deserialize(const QByteArray &serialized) {
     *this = MessagePack::deserialize<Block>(serialized);
     return true;
@@ -215,6 +221,10 @@ std::string Block::getDigSig() const {
     return signatures.empty() ? "" : this->signatures.begin()->sign;
 }
 
+const std::vector<Approvers> &Block::getSignatures() const {
+    return signatures;
+}
+
 QByteArrayList Block::getListSignatures() const {
     QByteArrayList res;
 
@@ -0,0 +1,86 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "datastorage/block_header.h"
+
+#include "datastorage/genesis_block.h"
+
+BlockHeader::BlockHeader(const Block &block)
+    : index(block.getIndex())
+    , type(block.getType())
+    , date(block.getDate())
+    , hash(block.getHash())
+    , prevHash(block.getPrevHash())
+    , dataRoot(payloadRoot(block))
+    , signers(block.getSignatures()) {
+}
+
+bool BlockHeader::isEmpty() const {
+    return hash.empty() && prevHash.empty();
+}
+
+ActorId BlockHeader::approver() const {
+    for (auto it = signers.rbegin(); it != signers.rend(); ++it)
+        if (it->isApprove)
+            return it->actorId;
+    return ActorId();
+}
+
+bool BlockHeader::matches(const Block &block) const {
+    return index == block.getIndex() && hash == block.getHash() && prevHash == block.getPrevHash()
+        && dataRoot == payloadRoot(block);
+}
+
+bool BlockHeader::verify(const Actor<KeyPublic> &actor) const {
+    // the same signer approver() reports
+    for (auto it = signers.rbegin(); it != signers.rend(); ++it)
+        if (it->isApprove)
+            return actor.id() == ActorId(it->actorId) && actor.key().verify(hash, it->sign);
+    return false;
+}
+
+std::string BlockHeader::payloadRoot(const Block &block) {
+    const std::string blockType = block.getType();
+    if (blockType != Config::DATA_BLOCK_TYPE && blockType != Config::MERGE_BLOCK)
+        return block.getData().empty() ? "" : Utils::calcHash(block.getData());
+
+    std::vector<std::string> leaves;
+    for (const Transaction &tx : block.extractTransactions())
+        leaves.push_back(Utils::calcHash(tx.serialize()));
+    return merkleRoot(std::move(leaves));
+}
+
+std::string BlockHeader::merkleRoot(std::vector<std::string> leaves) {
+    if (leaves.empty())
+        return "";
+
+    while (leaves.size() > 1) {
+        // odd level duplicates its last node
+        if (leaves.size() % 2 != 0)
+            leaves.push_back(leaves.back());
+
+        std::vector<std::string> level;
+        level.reserve(leaves.size() / 2);
+        for (std::size_t i = 0; i < leaves.size(); i += 2)
+            level.push_back(Utils::calcHash(leaves[i] + leaves[i + 1]));
+        leaves = std::move(level);
+    }
+    return leaves.front();
+}
@@ -0,0 +1,281 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "datastorage/block_sync.h"
+
+#include <algorithm>
+
+#include <QtConcurrent/QtConcurrent>
+
+#include "datastorage/genesis_block.h"
+
+BlockSync::BlockSync(Storage storage, Transport transport)
+    : m_storage(std::move(storage))
+    , m_transport(std::move(transport)) {
+}
+
+BlockSync::~BlockSync() {
+    std::vector<QFuture<void>> resumes;
+    {
+        std::lock_guard lock(m_mutex);
+        resumes.swap(m_resumes);
+    }
+    // continuation takes the lock, so it is awaited without it
+    for (auto &resume : resumes)
+        resume.waitForFinished();
+}
+
+void BlockSync::requestTip() {
+    if (m_transport.requestTip)
+        m_transport.requestTip();
+}
+
+BSP::Tip BlockSync::localTip() const {
+    return m_storage.tip();
+}
+
+BSP::RangeResponse BlockSync::blockRange(const BSP::RangeRequest &request) const {
+    BSP::RangeResponse response { .From = request.From, .Blocks = {} };
+    if (request.From < 0)
+        return response;
+
+    const uint32_t count = std::min(request.Count, MAX_BATCH_SIZE);
+    response.Blocks.reserve(count);
+
+    BigNumber id = request.From;
+    for (uint32_t i = 0; i < count; i++, ++id) {
+        QByteArray data = m_storage.blockData(id);
+        if (data.isEmpty())
+            break;
+        response.Blocks.push_back(data.toStdString());
+    }
+    return response;
+}
+
+void BlockSync::addPeer(const std::string &peer, const BigNumber &tip) {
+    std::lock_guard lock(m_mutex);
+    if (!peer.empty())
+        m_peers[peer] = tip;
+}
+
+void BlockSync::handleTip(const BSP::Tip &tip, const std::string &peer) {
+    std::lock_guard lock(m_mutex);
+    addPeer(peer, tip.Index);
+    if (tip.Index <= m_target)
+        return;
+
+    BSP::Tip local = m_storage.tip();
+    if (tip.Index <= local.Index)
+        return;
+
+    if (!m_syncing) {
+        m_syncing = true;
+        m_nextCommit = local.Index + 1;
+        m_nextRequest = m_nextCommit;
+        m_lastHash = local.Hash;
+        qDebug() << "[BlockSync] Start sync from" << m_nextCommit << "to" << tip.Index;
+    }
+
+    m_target = tip.Index;
+    fillWindow();
+}
+
+void BlockSync::handleRange(const BSP::RangeResponse &response, const std::string &peer) {
+    std::lock_guard lock(m_mutex);
+    auto request = m_inFlight.find(response.From);
+    if (request == m_inFlight.end())
+        return;
+    // range of any peer is taken from the first one that answers
+    if (!request->second.peer.empty() && request->second.peer != peer)
+        return;
+    const uint32_t requested = request->second.count;
+    m_inFlight.erase(request);
+
+    const uint32_t served = response.Blocks.size() > requested ? 0 : uint32_t(response.Blocks.size());
+    if (served < requested) {
+        // peer has less than it advertised, the rest of range goes to another peer
+        BigNumber from = response.From;
+        from += int(served);
+        if (!peer.empty())
+            m_peers[peer] = from - 1;
+        qDebug() << "[BlockSync] Peer has no blocks from" << from;
+        if (!sendRequest(from, requested - served)) {
+            qDebug() << "[BlockSync] No peer has blocks from" << from;
+            stop();
+            return;
+        }
+        if (served == 0)
+            return;
+    }
+
+    Pending pending;
+    pending.serialized = response.Blocks;
+    pending.blocks.reserve(response.Blocks.size());
+    for (const auto &data : response.Blocks)
+        pending.blocks.emplace_back(QByteArray::fromStdString(data));
+
+    auto verify = m_storage.verify;
+    pending.valid = QtConcurrent::mappedReduced<bool>(
+        pending.blocks, [verify](const Block &block) { return block.checkHash() && verify(block); },
+        [](bool &result, bool valid) { result = result && valid; }, true);
+    // network thread isn't blocked by the check, commit continues when it is done
+    std::erase_if(m_resumes, [](const QFuture<void> &resume) { return resume.isFinished(); });
+    m_resumes.push_back(pending.valid.then([this](bool) {
+        auto resume = [this] {
+            std::lock_guard lock(m_mutex);
+            commitReady();
+        };
+        if (m_storage.post)
+            m_storage.post(resume);
+        else
+            resume();
+    }));
+
+    m_pending.emplace(response.From, std::move(pending));
+    commitReady();
+}
+
+bool BlockSync::isSyncing() const {
+    std::lock_guard lock(m_mutex);
+    return m_syncing;
+}
+
+BigNumber BlockSync::target() const {
+    std::lock_guard lock(m_mutex);
+    return m_target;
+}
+
+uint64_t BlockSync::committed() const {
+    std::lock_guard lock(m_mutex);
+    return m_committed;
+}
+
+void BlockSync::fillWindow() {
+    while (m_syncing && int(m_inFlight.size() + m_pending.size()) < WINDOW && m_nextRequest <= m_target) {
+        BigNumber left = m_target - m_nextRequest + 1;
+        uint32_t count = left < int(BATCH_SIZE) ? uint32_t(left.data()) : BATCH_SIZE;
+
+        if (!sendRequest(m_nextRequest, count)) {
+            qDebug() << "[BlockSync] No peer has blocks from" << m_nextRequest;
+            if (m_inFlight.empty() && m_pending.empty())
+                stop();
+            return;
+        }
+        m_nextRequest += count;
+    }
+}
+
+bool BlockSync::sendRequest(const BigNumber &from, uint32_t count) {
+    auto peer = choosePeer(from, count);
+    if (!peer)
+        return false;
+    m_inFlight[from] = { .count = count, .peer = *peer };
+    m_transport.requestRange(*peer, { .From = from, .Count = count });
+    return true;
+}
+
+std::optional<std::string> BlockSync::choosePeer(const BigNumber &from, uint32_t count) const {
+    if (m_peers.empty())
+        return std::string();
+
+    // peers that have whole range first, then the least busy one
+    BigNumber last = from;
+    last += int(count) - 1;
+    std::optional<std::string> best;
+    bool bestCovers = false;
+    std::size_t bestLoad = 0;
+    for (const auto &[peer, tip] : m_peers) {
+        if (tip < from)
+            continue;
+        const bool covers = tip >= last;
+        const auto load = std::size_t(std::count_if(m_inFlight.begin(), m_inFlight.end(),
+                                                    [&peer](const auto &request) {
+                                                        return request.second.peer == peer;
+                                                    }));
+        if (!best || (covers && !bestCovers) || (covers == bestCovers && load < bestLoad)) {
+            best = peer;
+            bestCovers = covers;
+            bestLoad = load;
+        }
+    }
+    return best;
+}
+
+void BlockSync::commitReady() {
+    while (!m_pending.empty() && m_pending.begin()->first == m_nextCommit
+           && m_pending.begin()->second.valid.isFinished()) {
+        Pending pending = std::move(m_pending.begin()->second);
+        m_pending.erase(m_pending.begin());
+
+        // hash chain is sequential, signatures are checked meanwhile in the pool
+        bool chain = checkChain(pending.blocks);
+        bool valid = pending.valid.result();
+        if (!chain || !valid) {
+            qWarning() << "[BlockSync] Invalid range from" << m_nextCommit << "chain:" << chain
+                       << "signatures:" << valid;
+            stop();
+            return;
+        }
+
+        int resultCode = m_storage.commit(pending.serialized);
+        if (resultCode != 0) {
+            qWarning() << "[BlockSync] Can't commit range from" << m_nextCommit << "code:" << resultCode;
+            stop();
+            return;
+        }
+
+        m_nextCommit += int(pending.blocks.size());
+        m_lastHash = pending.blocks.back().getHash();
+        m_committed += pending.blocks.size();
+    }
+
+    if (m_syncing && m_nextCommit > m_target) {
+        qDebug() << "[BlockSync] Synced to" << m_target;
+        m_syncing = false;
+        return;
+    }
+
+    fillWindow();
+}
+
+bool BlockSync::checkChain(const std::vector<Block> &blocks) const {
+    BigNumber expected = m_nextCommit;
+    std::string prevHash = m_lastHash;
+
+    for (const Block &block : blocks) {
+        if (block.getIndex() != expected)
+            return false;
+        if (!prevHash.empty() && block.getPrevHash() != prevHash)
+            return false;
+        prevHash = block.getHash();
+        ++expected;
+    }
+    return true;
+}
+
+void BlockSync::stop() {
+    for (auto &[from, pending] : m_pending)
+        pending.valid.waitForFinished();
+
+    m_syncing = false;
+    m_target = m_nextCommit - 1;
+    m_nextRequest = m_nextCommit;
+    m_inFlight.clear();
+    m_pending.clear();
+}
@@ -18,20 +18,80 @@
  */
 
 #include <QJsonObject>
+#include <map>
 
 #include "datastorage/blockchain.h"
 #include "datastorage/index/actorindex.h"
 #include "managers/data_mining_manager.h"
 #include "managers/tx_manager.h"
+#include "utils/metrics.h"
 
 #undef qCritical // temp
 #define qCritical qDebug
 
+namespace {
+const std::string CacheECTable = "CREATE TABLE IF NOT EXISTS cacheData"
+                                 " ("
+                                 "ActorId  TEXT   NOT NULL, "
+                                 "State     TEXT              NOT NULL, "
+                                 "Token     TEXT              NOT NULL, "
+                                 "Type   TEXT              NOT NULL );";
+const std::string CacheECIndex =
+    "CREATE UNIQUE INDEX IF NOT EXISTS cacheDataKey ON cacheData (ActorId, Token);";
+const std::string CacheSupplyTable = "CREATE TABLE IF NOT EXISTS cacheSupply"
+                                     " ("
+                                     "Token     TEXT PRIMARY KEY  NOT NULL, "
+                                     "Genesis   TEXT              NOT NULL, "
+                                     "Changed   TEXT              NOT NULL );";
+const std::string CacheSupplyUpsert = "INSERT INTO cacheSupply (Token, Genesis, Changed) VALUES (?, ?, ?) "
+                                      "ON CONFLICT (Token) DO UPDATE SET "
+                                      "Genesis = excluded.Genesis, Changed = excluded.Changed;";
+
+// every state of genesis block is counted, only positive ones of cacheEC
+BigNumber genesisSupplied(const Amount &state) {
+    return state.abs().toBigNumber();
+}
+
+BigNumber changedSupplied(const std::string &state) {
+    const Amount amount = Amount::fromString(state);
+    return amount < 0 ? BigNumber(0) : amount.toBigNumber();
+}
+}
+
 Blockchain::Blockchain(ExtraChainNode *node, bool fileMode)
-    : fileMode(fileMode) {
+    : fileMode(fileMode)
+    , headerIndex(fileMode ? HeaderIndex::defaultPath() : std::string())
+    , m_blockSync(
+          { .tip = [this] { return localTip(); },
+            .blockData =
+                [this](const BigNumber &id) {
+                    if (this->fileMode)
+                        return blockIndex.getBlockDataById(id);
+                    return memIndex.contains(id) ? memIndex[id].serialize() : QByteArray();
+                },
+            .verify = [this](const Block &block) { return validateBlock(block); },
+            .commit = [this](const std::vector<std::string> &blocks) { return addSyncedBlocks(blocks); },
+            .post =
+                [this](std::function<void()> function) {
+                    QMetaObject::invokeMethod(this, std::move(function), Qt::QueuedConnection);
+                } },
+          { .requestTip =
+                [this] {
+                    this->node->network()->send_message(m_blockSync.localTip(), MessageType::BlockchainTip,
+                                                        MessageStatus::Request);
+                },
+            .requestRange =
+                [this](const std::string &peer, const BSP::RangeRequest &request) {
+                    this->node->network()->send_message(
+                        request, MessageType::BlockchainBlockRange, MessageStatus::Request, "",
+                        peer.empty() ? Config::Net::TypeSend::All : Config::Net::TypeSend::Focused, peer);
+                } }) {
     this->node = node;
     genBlockData.clear();
 
+    if (headerIndex.tip().isEmpty())
+        rebuildHeaderIndex();
+
     //    setCirculativeSupply(blockIndex.calculateCirculativeBalance());
     //    increaseCirculativeSupply(blockIndex.calculateCirculativeBalanceLastGenesisBlock());
 }
@@ -40,13 +100,16 @@ Blockchain::~Blockchain() {
 }
 
 Block Blockchain::getBlockByIndex(const BigNumber &index) {
+    static auto &readTime = Metrics::histogram("extrachain_block_read_seconds", "Block lookup time",
+                                               { { "by", "index" } });
+    Metrics::Timer timer(readTime);
     Block block = fileMode ? blockIndex.getBlockById(index) : memIndex[index];
     //        Block block2 = validateAndReturnBlock(block);
     return block;
 }
 
 BigNumber Blockchain::checkIntegrity() {
-    if (fileMode) {
+    if (!fileMode) {
         // check in MemIndex: start from second block
         for (int i = 1; i < memIndex.getRecords(); i++) {
             Block prev = memIndex.getByPosition(i - 1);
@@ -89,16 +152,25 @@ QByteArray Blockchain::getBlockDataByIndex(const BigNumber &index) {
 }
 
 Block Blockchain::getBlockByApprover(const BigNumber &approver) {
-    Block block = fileMode ? memIndex.getByApprover(approver) : blockIndex.getBlockByApprover(approver);
+    static auto &readTime = Metrics::histogram("extrachain_block_read_seconds", "Block lookup time",
+                                               { { "by", "approver" } });
+    Metrics::Timer timer(readTime);
+    Block block = fileMode ? blockIndex.getBlockByApprover(approver) : memIndex.getByApprover(approver);
     return validateAndReturnBlock(block);
 }
 
 Block Blockchain::getBlockByData(const QByteArray &data) {
+    static auto &readTime = Metrics::histogram("extrachain_block_read_seconds", "Block lookup time",
+                                               { { "by", "data" } });
+    Metrics::Timer timer(readTime);
     Block block = fileMode ? blockIndex.getBlockByData(data) : memIndex.getByData(data);
     return validateAndReturnBlock(block);
 }
 
 Block Blockchain::getBlockByHash(const QByteArray &hash) {
+    static auto &readTime = Metrics::histogram("extrachain_block_read_seconds", "Block lookup time",
+                                               { { "by", "hash" } });
+    Metrics::Timer timer(readTime);
     Block block = fileMode ? blockIndex.getBlockByHash(hash) : memIndex.getByHash(hash);
     return validateAndReturnBlock(block);
 }
@@ -136,71 +208,101 @@ std::pair<Transaction, QByteArray> Blockchain::getTxByUser(const BigNumber &id,
 }
 
 void Blockchain::saveTxInfoInEC(const std::string &data) const {
-    std::vector<std::string> l = Serialization::deserialize(data);
-    std::vector<DBRow> extractData;
-    DBRow resultData;
+    // block is folded into changes by (actor, token), sender and receiver of many txs are the same
+    std::map<std::pair<std::string, std::string>, Amount> states;
+    for (const auto &serialized : Serialization::deserialize(data)) {
+        const auto tx = MessagePack::deserialize<Transaction>(serialized);
+        const std::string token = tx.getToken().toStdString();
+        states[{ tx.getSender().toStdString(), token }] -= tx.getAmount();
+        states[{ tx.getReceiver().toStdString(), token }] += tx.getAmount();
+    }
+    if (states.empty())
+        return;
 
-    QString typeS = "0"; // sender type
-    QString typeR = "0"; // receiver type
+    std::vector<std::vector<std::string>> keys;
+    keys.reserve(states.size());
+    for (const auto &[key, change] : states)
+        keys.push_back({ key.first, key.second });
+
+    QMutexLocker locker(&m_supplyMutex);
+    auto &tokens = supply();
+    DBConnector &cacheDB = cacheEC();
+    const auto saved = cacheDB.selectMany("SELECT ActorId, Token, State FROM cacheData "
+                                          "WHERE ActorId = ? AND Token = ?;",
+                                          keys);
+    std::map<std::string, BigNumber> supplied;
+    for (const auto &row : saved) {
+        states[{ row.at("ActorId"), row.at("Token") }] += Amount::fromString(row.at("State"));
+        supplied[row.at("Token")] -= changedSupplied(row.at("State"));
+    }
 
-    DBConnector cacheDB("blockchain/cacheEC.db");
-    cacheDB.open();
-    cacheDB.createTable("CREATE TABLE IF NOT EXISTS cacheData"
-                        " ("
-                        "ActorId  TEXT   NOT NULL, "
-                        "State     TEXT              NOT NULL, "
-                        "Token     TEXT              NOT NULL, "
-                        "Type   TEXT              NOT NULL );");
-
-    for (const auto &i : l) {
-        auto q = MessagePack::deserialize<Transaction>(i);
-
-        // modify sender data in db
-        extractData =
-            cacheDB.select("SELECT State FROM cacheData WHERE ActorId ='" + q.getSender().toStdString()
-                           + "' AND Token='" + q.getToken().toStdString() + "';");
-
-        resultData["ActorId"] = q.getSender().toStdString();
-        resultData["Token"] = q.getToken().toStdString();
-        resultData["Type"] = typeS.toStdString();
-
-        if (extractData.empty()) {
-            resultData["State"] = '-' + q.getAmount().toStdString();
-            cacheDB.insert("cacheData", resultData);
-        }
+    std::vector<std::vector<std::string>> rows;
+    rows.reserve(states.size());
+    for (const auto &[key, state] : states) {
+        rows.push_back({ key.first, state.toStdString(), key.second, "0" });
+        supplied[key.second] += changedSupplied(rows.back()[1]);
+    }
 
-        else {
-            resultData["State"] = (BigNumberFloat(extractData[0]["State"]) - q.getAmount()).toStdString();
-            cacheDB.update("UPDATE cacheData "
-                           "SET State ='"
-                           + resultData["State"] + "' WHERE ActorId ='" + resultData["ActorId"]
-                           + "' AND Token='" + resultData["Token"] + "';");
-        }
+    std::vector<std::string> changedTokens;
+    for (const auto &[token, change] : supplied) {
+        tokens[token].changed += change;
+        changedTokens.push_back(token);
+    }
+    const bool written = cacheDB.query("BEGIN TRANSACTION;")
+        && cacheDB.execMany("INSERT INTO cacheData (ActorId, State, Token, Type) VALUES (?, ?, ?, ?) "
+                            "ON CONFLICT (ActorId, Token) DO UPDATE SET State = excluded.State;",
+                            rows)
+        && storeSupply(changedTokens) && cacheDB.query("COMMIT;");
+    if (!written) {
+        qCritical() << "[Blockchain] Can't save balances of block";
+        cacheDB.query("ROLLBACK;");
+        for (const auto &[token, change] : supplied)
+            tokens[token].changed -= change;
+    }
+}
 
-        extractData.clear();
-        resultData.clear();
+DBConnector &Blockchain::cacheEC() const {
+    if (m_cacheEC)
+        return *m_cacheEC;
 
-        // modify receiver data in db
-        extractData =
-            cacheDB.select("SELECT State FROM cacheData WHERE ActorId ='" + q.getReceiver().toStdString()
-                           + "' AND Token='" + q.getToken().toStdString() + "';");
+    auto &cacheDB = m_cacheEC.emplace("blockchain/cacheEC.db");
+    cacheDB.open();
+    cacheDB.createTable(CacheECTable);
+    // rows of older versions are unique too, unless a write was interrupted
+    cacheDB.query("DELETE FROM cacheData WHERE rowid NOT IN "
+                  "(SELECT MAX(rowid) FROM cacheData GROUP BY ActorId, Token);");
+    cacheDB.query(CacheECIndex);
+    return cacheDB;
+}
+
+std::vector<DBRow> Blockchain::switchCacheEC() const {
+    // new table is swapped in, so ended epoch is read and dropped without DELETE and VACUUM
+    QMutexLocker locker(&m_supplyMutex);
+    auto &tokens = supply();
+    auto &cacheDB = cacheEC();
+    cacheDB.query("DROP TABLE IF EXISTS cacheDataEnded;");
+    const bool switched = cacheDB.query("BEGIN TRANSACTION;")
+        && cacheDB.query("ALTER TABLE cacheData RENAME TO cacheDataEnded;")
+        && cacheDB.query("DROP INDEX IF EXISTS cacheDataKey;") && cacheDB.createTable(CacheECTable)
+        && cacheDB.query(CacheECIndex) && cacheDB.query("UPDATE cacheSupply SET Changed = '0';")
+        && cacheDB.query("COMMIT;");
+    if (!switched) {
+        qCritical() << "[Blockchain] Can't start new cacheEC epoch";
+        cacheDB.query("ROLLBACK;");
+        return {};
+    }
+    for (auto &[token, total] : tokens)
+        total.changed = 0;
 
-        resultData["ActorId"] = q.getReceiver().toStdString();
-        resultData["Token"] = q.getToken().toStdString();
-        resultData["Type"] = typeR.toStdString();
-        if (extractData.empty()) {
-            resultData["State"] = q.getAmount().toStdString();
-            cacheDB.insert("cacheData", resultData);
-        }
+    auto states = cacheDB.select("SELECT * FROM cacheDataEnded;");
+    cacheDB.query("DROP TABLE cacheDataEnded;");
+    return states;
+}
 
-        else {
-            resultData["State"] = (BigNumberFloat(extractData[0]["State"]) + q.getAmount()).toStdString();
-            cacheDB.update("UPDATE cacheData "
-                           "SET State ='"
-                           + resultData["State"] + "' WHERE ActorId='" + resultData["ActorId"]
-                           + "' AND Token='" + resultData["Token"] + "';");
-        }
-    }
+std::string Blockchain::lastGenesisHash() const {
+    if (!m_lastGenesisHash)
+        m_lastGenesisHash = blockIndex.getLastGenesisBlock().getHash();
+    return *m_lastGenesisHash;
 }
 
 QList<Transaction> Blockchain::getTxsBySenderOrReceiverInRow(const BigNumber &id, BigNumber from, int count,
@@ -212,56 +314,82 @@ QList<Transaction> Blockchain::getTxsBySenderOrReceiverInRow(const BigNumber &id
 void Blockchain::getBlockZero() {
     Block zero = getBlockByIndex(0);
     if (zero.isEmpty()) {
-        // TODONEW
-        // Messages::GetBlockMessage request;
-        // request.param = SearchEnum::BlockParam::Id;
-        // request.value = QByteArray::number(0);
-        // emit sendMessage(request.serialize(), Messages::GeneralRequest::GetBlock);
+        m_blockSync.requestTip();
     } else
         node->actorIndex()->setFirstId(zero.getApprover());
 }
 
-BigNumber Blockchain::getSupply(const QByteArray &idToken) {
-    GenesisBlock gen = blockIndex.getLastGenesisBlock();
-    BigNumber id = gen.getIndex();
-    std::string path = blockIndex.buildFilePath(id).toStdString();
-    DBConnector cacheDB(path);
-    cacheDB.open();
-    std::vector<DBRow> extractData =
-        cacheDB.select("SELECT * FROM GenesisDataRow WHERE token = '" + idToken.toStdString() + "';");
-    BigNumber res = 0;
-    for (const auto &tmp : extractData) {
-        res += BigNumber(tmp.at("state")).abs();
-    }
-    return res;
+BigNumber Blockchain::getSupply(const QByteArray &idToken) const {
+    QMutexLocker locker(&m_supplyMutex);
+    const auto &tokens = supply();
+    const auto it = tokens.find(idToken.toStdString());
+    return it == tokens.end() ? BigNumber(0) : it->second.genesis;
 }
 
-BigNumber Blockchain::getFullSupply(const QByteArray &idToken) {
-    BigNumber id = blockIndex.getLastGenesisBlock().getIndex();
-    std::string path = blockIndex.buildFilePath(id).toStdString();
-    DBConnector cacheDB(path);
-    cacheDB.open();
-    std::vector<DBRow> extractData =
-        cacheDB.select("SELECT * FROM GenesisDataRow WHERE token = '" + idToken.toStdString() + "' ;");
-    BigNumber res = 0;
-    for (const auto &tmp : extractData) {
-        res += BigNumber(tmp.at("state")).abs();
+BigNumber Blockchain::getFullSupply(const QByteArray &idToken) const {
+    QMutexLocker locker(&m_supplyMutex);
+    const auto &tokens = supply();
+    const auto it = tokens.find(idToken.toStdString());
+    return it == tokens.end() ? BigNumber(0) : it->second.genesis + it->second.changed;
+}
+
+std::map<std::string, Blockchain::TokenSupply> &Blockchain::supply() const {
+    if (m_supply)
+        return *m_supply;
+
+    auto &tokens = m_supply.emplace();
+    DBConnector &cacheDB = cacheEC();
+    if (cacheDB.tableExists("cacheSupply")) {
+        for (auto &row : cacheDB.select("SELECT Token, Genesis, Changed FROM cacheSupply;"))
+            tokens[row["Token"]] = { .genesis = BigNumber(row["Genesis"]),
+                                     .changed = BigNumber(row["Changed"]) };
+        return tokens;
     }
-    DBConnector cacheDB2("blockchain/cacheEC.db");
-    cacheDB2.open();
-    std::vector<DBRow> extractData2 = cacheDB2.select(
-        "SELECT * FROM cacheData WHERE Token = '"
-        + idToken.toStdString()
-        /* + "' AND ActorId != '" + actorIndex->m_firstId->toStdString() + "' AND ActorId != '"
-         + BigNumber(0).toActorId().toStdString()*/
-        + "';");
-    for (const auto &tmp : extractData2) {
-        std::string sum = tmp.at("State");
-        if (sum[0] == '-')
-            continue;
-        res += BigNumber(sum).abs();
+
+    // first start with cacheEC of older version, or totals were dropped
+    qDebug() << "[Blockchain] Rebuilding supply of tokens";
+    for (const auto &row : blockIndex.getLastGenesisBlock().extractDataRows())
+        tokens[row.token.toStdString()].genesis += genesisSupplied(row.state);
+    for (auto &row : cacheDB.select("SELECT Token, State FROM cacheData;"))
+        tokens[row["Token"]].changed += changedSupplied(row["State"]);
+
+    std::vector<std::string> all;
+    for (const auto &[token, total] : tokens)
+        all.push_back(token);
+    cacheDB.createTable(CacheSupplyTable);
+    storeSupply(all);
+    return tokens;
+}
+
+bool Blockchain::storeSupply(const std::vector<std::string> &tokens) const {
+    std::vector<std::vector<std::string>> rows;
+    rows.reserve(tokens.size());
+    for (const auto &token : tokens) {
+        const auto &total = m_supply->at(token);
+        rows.push_back({ token, total.genesis.toStdString(), total.changed.toStdString() });
     }
-    return res;
+    return cacheEC().execMany(CacheSupplyUpsert, rows);
+}
+
+void Blockchain::setGenesisSupply(const GenesisBlock &genesis) {
+    QMutexLocker locker(&m_supplyMutex);
+    auto &tokens = supply();
+    for (auto &[token, total] : tokens)
+        total.genesis = 0;
+    for (const auto &row : genesis.extractDataRows())
+        tokens[row.token.toStdString()].genesis += genesisSupplied(row.state);
+
+    std::vector<std::string> all;
+    for (const auto &[token, total] : tokens)
+        all.push_back(token);
+    if (!storeSupply(all))
+        qCritical() << "[Blockchain] Can't save supply of genesis block";
+}
+
+void Blockchain::resetSupply() {
+    QMutexLocker locker(&m_supplyMutex);
+    m_supply.reset();
+    cacheEC().query("DROP TABLE IF EXISTS cacheSupply;");
 }
 
 Block Blockchain::checkBlock(const Block &block) {
@@ -276,50 +404,6 @@ bool Blockchain::shouldStartGenesisCreation() {
     return Config::DataStorage::CONSTRUCT_GENESIS_EVERY_BLOCKS == this->blocksFromLastGenesis;
 }
 
-void Blockchain::addRecordsIfNew(const GenesisDataRow &row1, const GenesisDataRow &row2) {
-    bool b1 = false;
-    bool b2 = false;
-    for (int i = 0; i < genBlockData.size(); i++) {
-        if (genBlockData[i].actorId == row1.actorId && genBlockData[i].token == row1.token) {
-            b1 = true;
-        }
-        if (genBlockData[i].actorId == row2.actorId && genBlockData[i].token == row2.token) {
-            b2 = true;
-        }
-        if (b1 && b2) {
-            return;
-        } else {
-            if (!b1) {
-                genBlockData.append(row1);
-            }
-            if (!b2) {
-                genBlockData.append(row2);
-            }
-            return;
-        }
-    }
-}
-
-QByteArray Blockchain::findRecordsInBlock(const Block &block) {
-    if (block.getType() == Config::GENESIS_BLOCK_TYPE) {
-        return QByteArray::fromStdString(block.getHash());
-    } else if (!block.isEmpty()) {
-        const auto transactions = block.extractTransactions();
-        for (const Transaction &tx : qAsConst(transactions)) {
-            if (tx.getReceiver() == node->actorIndex()->firstId())
-                break;
-            GenesisDataRow recSender =
-                GenesisDataRow(tx.getSender(), getUserBalance(tx.getSender(), tx.getToken()), tx.getToken(),
-                               DataStorage::typeDataRow::UNIVERSAL);
-            GenesisDataRow recReceiver =
-                GenesisDataRow(tx.getReceiver(), getUserBalance(tx.getReceiver(), tx.getToken()),
-                               tx.getToken(), DataStorage::typeDataRow::UNIVERSAL);
-            addRecordsIfNew(recReceiver, recSender);
-        }
-    }
-    return QByteArray();
-}
-
 bool Blockchain::signCheckAdd(Block &block) {
     if (block.getIndex() == 0)
         return false;
@@ -416,8 +500,8 @@ GenesisBlock Blockchain::createGenesisBlock(const Actor<KeyPrivate> actor, QMap<
         if (blockIndex.getRecords() == 0) {
             if (blockIndex.getFirstSavedId() == 0 && blockIndex.getLastSavedId() == 0) {
                 for (auto i = states.begin(); i != states.end(); i++) {
-                    genBlockData.append(
-                        GenesisDataRow(i.key(), i.value(), ActorId(), DataStorage::typeDataRow::UNIVERSAL));
+                    genBlockData.append(GenesisDataRow(i.key(), Amount(i.value()), ActorId(),
+                                                       DataStorage::typeDataRow::UNIVERSAL));
                 }
 
                 // nb.setApprover(BigNumber(*(actorIndex->m_firstId)));
@@ -426,25 +510,13 @@ GenesisBlock Blockchain::createGenesisBlock(const Actor<KeyPrivate> actor, QMap<
                 qCritical() << "Can't create genesis block, there no blocks in blockIndex";
             return nb;
         } else {
-            Block b;
-            BigNumber i = blockIndex.getLastSavedId();
+            // states are kept by saveTxInfoInEC for every block, so blocks are not read again
             nb = GenesisBlock("", blockIndex.getBlockById(blockIndex.getLastSavedId()), "");
-            while ((blockIndex.getBlockById(i).getType() != Config::GENESIS_BLOCK_TYPE)
-                   && (i >= blockIndex.getFirstSavedId())) {
-                b = blockIndex.getBlockById(i);
-                findRecordsInBlock(b);
-                i--;
-            }
-            DBConnector cacheDB("blockchain/cacheEC.db");
-            cacheDB.open();
-            std::vector<DBRow> extractData = cacheDB.select("SELECT * FROM cacheData;");
-            for (auto i : extractData)
+            for (auto &row : switchCacheEC())
                 nb.addRow(
-                    GenesisDataRow(i["ActorId"], BigNumber(i["State"]), i["Token"],
-                                   DataStorage::typeDataRow(QByteArray::fromStdString(i["Type"]).toInt())));
-            cacheDB.query("DELETE FROM cacheData");
-            cacheDB.query("VACUUM");
-            nb.setPrevGenHash(blockIndex.getBlockById(i).getHash());
+                    GenesisDataRow(row["ActorId"], Amount::fromString(row["State"]), row["Token"],
+                                   DataStorage::typeDataRow(QByteArray::fromStdString(row["Type"]).toInt())));
+            nb.setPrevGenHash(lastGenesisHash());
         }
         qDebug() << "Genesis block created";
         genBlockData.clear();
@@ -458,6 +530,11 @@ GenesisBlock Blockchain::createGenesisBlock(const Actor<KeyPrivate> actor, QMap<
 
 int Blockchain::mergeBlockWithLocal(Block &received) {
     const auto receivedBlockIndex = received.getIndex();
+    if (headerIndex.contains(receivedBlockIndex, received.getHash())) {
+        qDebug() << QString("Blocks are equal ([%1])").arg(Errors::BLOCKS_ARE_EQUAL);
+        return Errors::BLOCKS_ARE_EQUAL;
+    }
+
     Block existed = getBlockByIndex(receivedBlockIndex);
     if (!canMergeBlocks(received, existed)) {
         qWarning() << "Blocks with id" << receivedBlockIndex << "can't be merged";
@@ -647,6 +724,10 @@ Block Blockchain::validateAndReturnBlock(const Block &block) const {
 }
 
 int Blockchain::addBlock(Block &block, bool isGenesis) {
+    static auto &addTime = Metrics::histogram("extrachain_block_add_seconds", "Block adding time");
+    static auto &added = Metrics::counter("extrachain_blocks_added_total", "Blocks added to storage");
+    Metrics::Timer timer(addTime);
+
     if (isGenesis) {
         qDebug() << "Adding a GENESIS block" << block.getIndex() << "to storage";
     } else {
@@ -657,16 +738,14 @@ int Blockchain::addBlock(Block &block, bool isGenesis) {
     if (!GenesisBlock::isGenesisBlock(block.serialize())) {
         if (indexBlock != 0) {
             BigNumber id = block.getIndex() - 1;
-            if (getBlock(SearchEnum::BlockParam::Id, id.toByteArray()).isEmpty()) {
-                // TODONEW
-                // Messages::GetBlockMessage request;
-                // request.param = SearchEnum::BlockParam::Id;
-                // request.value = id.toByteArray();
-                // emit sendMessage(request.serialize(), Messages::GeneralRequest::GetBlock);
+            if (!headerIndex.contains(id)
+                && getBlock(SearchEnum::BlockParam::Id, id.toByteArray()).isEmpty()) {
+                m_blockSync.requestTip();
             }
         }
     }
     if (indexBlock == 0) {
+        QWriteLocker locker(&m_chainLock);
         node->actorIndex()->setFirstId(block.getApprover());
     }
     if (indexBlock < 0)
@@ -676,16 +755,25 @@ int Blockchain::addBlock(Block &block, bool isGenesis) {
     if (check) {
         // TODONEW emit sendMessage(block.serialize(), Messages::ChainMessage::BlockMessage);
     }
+    QWriteLocker chainLocker(&m_chainLock);
     int resultCode = fileMode ? blockIndex.addBlock(block) : memIndex.addBlock(block);
+    chainLocker.unlock();
     const auto blockType = block.getType();
 
     switch (resultCode) {
     case 0: {
+        added.inc();
+        if (blockType == Config::GENESIS_BLOCK_TYPE) {
+            m_lastGenesisHash.reset();
+            setGenesisSupply(GenesisBlock(block.serialize()));
+        }
         emit updateLastTransactionList(); // TODO: ?
         qDebug() << "Block" << indexBlock << "is successfully added to blockchain";
         getSmContractMembers(block);
 
-        // TODONEW emit sendMessage(block.serialize(), Messages::ChainMessage::BlockMessage);
+        BlockHeader header(block);
+        headerIndex.addHeader(header);
+        node->network()->send_message(header, MessageType::BlockchainNewHeader);
         if (blockType == Config::DATA_BLOCK_TYPE) {
             saveTxInfoInEC(block.getData());
         }
@@ -716,9 +804,15 @@ int Blockchain::addBlock(Block &block, bool isGenesis) {
         blocksFromLastGenesis++;
         if (shouldStartGenesisCreation()) {
             GenesisBlock gB = createGenesisBlock(node->accountController()->mainActor());
-            if (blockIndex.addBlock(gB) == 0) {
+            chainLocker.relock();
+            const int genesisCode = blockIndex.addBlock(gB);
+            chainLocker.unlock();
+            if (genesisCode == 0) {
                 qDebug() << "Block" << gB.getIndex() << QByteArray::fromStdString(gB.getType())
                          << "is successfully added to blockchain";
+                headerIndex.addHeader(BlockHeader(gB));
+                m_lastGenesisHash = gB.getHash();
+                setGenesisSupply(gB);
                 // TODONEW emit sendMessage(gB.serialize(),
                 // Messages::ChainMessage::GenesisBlockMessage);
                 blocksFromLastGenesis = 0;
@@ -729,12 +823,162 @@ int Blockchain::addBlock(Block &block, bool isGenesis) {
     return resultCode;
 }
 
+int Blockchain::addSyncedBlocks(const std::vector<std::string> &blocks) {
+    std::vector<BlockHeader> headers;
+    headers.reserve(blocks.size());
+    QWriteLocker locker(&m_chainLock);
+
+    for (const auto &data : blocks) {
+        const QByteArray serialized = QByteArray::fromStdString(data);
+        int resultCode = 0;
+
+        if (GenesisBlock::isGenesisBlock(serialized)) {
+            GenesisBlock block(serialized);
+            resultCode = fileMode ? blockIndex.addBlock(block) : memIndex.addBlock(block);
+            if (resultCode == 0) {
+                // genesis block already contains state of cacheData
+                setGenesisSupply(block);
+                switchCacheEC();
+                m_lastGenesisHash.reset();
+                blocksFromLastGenesis = 0;
+                headers.emplace_back(block);
+            }
+        } else {
+            Block block(serialized);
+            resultCode = fileMode ? blockIndex.addBlock(block) : memIndex.addBlock(block);
+            if (resultCode == 0) {
+                if (block.getIndex() == 0)
+                    node->actorIndex()->setFirstId(block.getApprover());
+                if (block.getType() == Config::DATA_BLOCK_TYPE)
+                    saveTxInfoInEC(block.getData());
+                blocksFromLastGenesis++;
+                headers.emplace_back(block);
+            }
+        }
+
+        if (resultCode != 0) {
+            headerIndex.addHeaders(headers);
+            return resultCode;
+        }
+    }
+
+    headerIndex.addHeaders(headers);
+    locker.unlock();
+    emit updateLastTransactionList();
+    return 0;
+}
+
+BlockSync &Blockchain::blockSync() {
+    return m_blockSync;
+}
+
+const HeaderIndex &Blockchain::getHeaderIndex() const {
+    return headerIndex;
+}
+
+BSP::Tip Blockchain::localTip() const {
+    BlockHeader tip = headerIndex.tip();
+    return { .Index = tip.index, .Hash = tip.hash };
+}
+
+void Blockchain::handleTip(const BSP::Tip &tip, const std::string &peer) {
+    m_blockSync.addPeer(peer, tip.Index);
+    BlockHeader local = headerIndex.tip();
+    if (tip.Index <= local.index) {
+        if (!tip.Hash.empty() && !headerIndex.contains(tip.Index, tip.Hash))
+            qWarning() << "[Blockchain] Remote chain differs at" << tip.Index;
+        return;
+    }
+
+    BigNumber left = tip.Index;
+    left -= local.index;
+    uint32_t count = left < int(BlockSync::MAX_HEADERS) ? uint32_t(left.data()) : BlockSync::MAX_HEADERS;
+    BSP::RangeRequest request { .From = local.index + 1, .Count = count };
+    node->network()->send_message(request, MessageType::BlockchainHeaders, MessageStatus::Request, "",
+                                  peer.empty() ? Config::Net::TypeSend::All : Config::Net::TypeSend::Focused,
+                                  peer);
+}
+
+void Blockchain::handleHeaders(const std::vector<BlockHeader> &headers, const std::string &peer) {
+    if (headers.empty())
+        return;
+
+    for (std::size_t i = 1; i < headers.size(); i++) {
+        BigNumber expected = headers[i - 1].index;
+        if (headers[i].index != ++expected || headers[i].prevHash != headers[i - 1].hash) {
+            qWarning() << "[Blockchain] Received headers are not contiguous at" << headers[i].index;
+            return;
+        }
+    }
+
+    BigNumber fork = headerIndex.findFork(headers);
+    if (fork >= 0) {
+        qWarning() << "[Blockchain] Fork detected at" << fork;
+        return;
+    }
+
+    const BlockHeader &first = headers.front();
+    const BlockHeader &last = headers.back();
+    BlockHeader local = headerIndex.tip();
+    if (last.index <= local.index)
+        return;
+
+    // announced header is ahead of us, fetch missing headers first
+    if (first.index > local.index + 1) {
+        handleTip({ .Index = last.index, .Hash = last.hash }, peer);
+        return;
+    }
+
+    if (first.index == local.index + 1 && !local.isEmpty() && first.prevHash != local.hash) {
+        qWarning() << "[Blockchain] Fork detected at" << first.index;
+        return;
+    }
+
+    m_blockSync.handleTip({ .Index = last.index, .Hash = last.hash }, peer);
+}
+
+void Blockchain::rebuildHeaderIndex() {
+    if (!fileMode || blockIndex.getRecords() == 0)
+        return;
+
+    qDebug() << "[Blockchain] Building header index from" << blockIndex.getFirstSavedId() << "to"
+             << blockIndex.getLastSavedId();
+    std::vector<BlockHeader> headers;
+    for (BigNumber id = blockIndex.getFirstSavedId(); id <= blockIndex.getLastSavedId(); ++id) {
+        QByteArray data = blockIndex.getBlockDataById(id);
+        if (data.isEmpty())
+            continue;
+        if (GenesisBlock::isGenesisBlock(data))
+            headers.emplace_back(GenesisBlock(data));
+        else
+            headers.emplace_back(Block(data));
+
+        if (headers.size() == std::size_t(Config::DataStorage::SECTION_SIZE)) {
+            headerIndex.addHeaders(headers);
+            headers.clear();
+        }
+    }
+    headerIndex.addHeaders(headers);
+}
+
 int Blockchain::removeBlock(const Block &block) {
-    return fileMode ? blockIndex.removeById(block.getIndex()) : memIndex.removeById(block.getIndex());
+    QWriteLocker locker(&m_chainLock);
+    m_lastGenesisHash.reset();
+    if (block.getType() == Config::GENESIS_BLOCK_TYPE)
+        resetSupply();
+    if (!fileMode) {
+        headerIndex.remove(block.getIndex());
+        return memIndex.removeById(block.getIndex());
+    }
+    // file index drops the block and everything above it
+    headerIndex.removeFrom(block.getIndex());
+    return blockIndex.removeById(block.getIndex());
 }
 
 void Blockchain::removeAllDummyBlocks(const Block &block) {
+    QWriteLocker locker(&m_chainLock);
     blockIndex.removeDummyBlocks(block.getIndex());
+    headerIndex.removeFrom(blockIndex.getLastSavedId() + 1);
 }
 
 bool Blockchain::canMergeBlocks(const Block &receivedBlock, const Block &existedBlock) {
@@ -875,8 +1119,8 @@ BigNumber Blockchain::getRecords() const {
     return fileMode ? blockIndex.getRecords() : memIndex.getRecords();
 }
 
-BigNumberFloat Blockchain::getUserBalance(ActorId userId, ActorId tokenId) const {
-    BigNumberFloat balance;
+Amount Blockchain::getUserBalance(ActorId userId, ActorId tokenId) const {
+    Amount balance;
 
     for (BigNumber i = this->blockIndex.getLastSavedId(); i >= blockIndex.getFirstSavedId(); i--) {
         Block currentBlock = blockIndex.getBlockById(i);
@@ -988,26 +1232,26 @@ void Blockchain::process() {
 }
 
 void Blockchain::updateBlockchain() {
-    // TODONEW Messages::BlockCount request;
-    // emit sendMessage(request.serialize(), Messages::GeneralRequest::GetBlockCount);
+    m_blockSync.requestTip();
 }
 
 void Blockchain::checkBlockExistence(Block &block) {
-    Block last = getLastBlock();
+    BlockHeader tip = headerIndex.tip();
 
     /*
      * Blocks in blockchain are stored consistently, so if last block id
      * is greater than the coming block id - the last one is already in
      * blockchain. If ids are equals - trying to merge blocks.
      */
-    if (last.getIndex() < block.getIndex() || last.isEmpty()) {
+    if (tip.index < block.getIndex() || tip.isEmpty()) {
         addBlock(block);
         emit BlockIsMissing(block);
-    } else if (last.getIndex() < block.getIndex()) {
+    } else if (tip.hash == block.getHash()) {
         qDebug() << QString("Block [%1] already exists in local blockchain")
                         .arg(QString(block.getIndex().toByteArray()));
-    } else if (last.getIndex() == block.getIndex()) {
+    } else if (tip.index == block.getIndex()) {
         // blocks id's are equals -> merge blocks
+        Block last = getLastBlock();
         if (canMergeBlocks(last, block)) {
             Block merged = mergeBlocks(last, block);
             if (merged.isEmpty())
@@ -1054,6 +1298,10 @@ void Blockchain::getBlockCount(const QByteArray &requestHash, const std::string
 }
 
 void Blockchain::addBlockToBlockchain(Block &block) {
+    // already stored, payload is not needed
+    if (headerIndex.contains(block.getIndex(), block.getHash()))
+        return;
+
     addBlock(block);
     auto list = block.extractTransactions();
     for (const auto &tmp : qAsConst(list)) {
@@ -1073,12 +1321,9 @@ void Blockchain::addBlockToBlockchain(Block &block) {
 }
 
 void Blockchain::addGenBlockToBlockchain(GenesisBlock block) {
-    QMutex mutex;
-    if (block.getIndex() == 0) {
-        mutex.lock();
+    QWriteLocker locker(&m_chainLock);
+    if (block.getIndex() == 0)
         node->actorIndex()->setFirstId(block.getApprover());
-        mutex.unlock();
-    }
     if (blockIndex.addBlock(block) == 0 || signCheckAdd(block)) {
         // TODONEW emit sendMessage(block.serialize(), Messages::ChainMessage::GenesisBlockMessage);
     }
@@ -1119,7 +1364,9 @@ void Blockchain::VerifyTx(Transaction &tx) {
     emit VerifiedTx(tx);
 }
 
-void Blockchain::proveTx(Transaction &tx) {
+Blockchain::TxProof Blockchain::proveTx(const Transaction &tx) {
+    using Verdict = TxProof::Verdict;
+    QReadLocker locker(&m_chainLock);
     qDebug() << "proveTx: started" << tx.getTypeTx();
 
     ActorId targetSender = tx.getSender();
@@ -1129,10 +1376,8 @@ void Blockchain::proveTx(Transaction &tx) {
         targetSender = tx.getApprover();
         // TODO: add extended check of validity
         auto res = this->blockIndex.getLastTxByData(tx.getData());
-        if (res.second == "-1") {
-            txManager->addProvedTransaction(tx);
-            return;
-        }
+        if (res.second == "-1")
+            return { .verdict = Verdict::Proved };
     }
     Actor<KeyPublic> senderActor;
     if (!targetSender.isEmpty())
@@ -1142,22 +1387,19 @@ void Blockchain::proveTx(Transaction &tx) {
         receiverActor = node->actorIndex()->getActor(targetReceiver);
     if (tx.getAmount() < 0) {
         qDebug() << "Transaction not approved: amount less 0";
-        txManager->removeUnApprovedTransaction(tx);
-        return;
+        return { .verdict = Verdict::Rejected };
     }
     if (targetSender == targetReceiver) {
-        txManager->removeUnApprovedTransaction(tx);
         qDebug() << "Transaction not approved: sender == receiver";
-        return;
+        return { .verdict = Verdict::Rejected };
     }
 
     // if receiver is not exist
 
     if ((receiverActor.empty() && !targetReceiver.isEmpty())
         || (senderActor.empty() && !targetSender.isEmpty())) {
-        txManager->removeUnApprovedTransaction(tx);
         qDebug() << "Transaction not approved: receiver or sender is not exist";
-        return;
+        return { .verdict = Verdict::Rejected };
     }
 
     // special conditions: receiver is null - coins burning
@@ -1167,68 +1409,44 @@ void Blockchain::proveTx(Transaction &tx) {
             producerActor = node->actorIndex()->getActor(tx.getProducer());
         else {
             qDebug() << "Tx" << tx.getHash().c_str() << "producer 0";
-            txManager->removeUnApprovedTransaction(tx);
-            return;
+            return { .verdict = Verdict::Rejected };
         }
         if (!producerActor.key().verify(tx.getDataForDigSig(), tx.getDigSig())) {
             qDebug() << "Tx" << tx.getHash().c_str() << "not approved: bad signature in fee tx";
-            txManager->removeUnApprovedTransaction(tx);
-            return;
+            return { .verdict = Verdict::Rejected };
         }
         if (tx.getAmount() <= 0) {
             qDebug() << "Tx" << tx.getHash().c_str() << "fee amount <= 0";
-            txManager->removeUnApprovedTransaction(tx);
-            return;
+            return { .verdict = Verdict::Rejected };
         }
-        txManager->addProvedTransaction(tx);
-        return;
+        return { .verdict = Verdict::Proved };
     }
 
     //    // if !sig
     //    if (!senderActor.key().verify(tx->getDataForDigSig().toStdString(), tx->getDigSig().toStdString()))
     //    {
     //        qDebug() << "Tx" << tx->getHash() << "not approved: bad signature";
-    //        txManager->removeUnApprovedTransaction(tx);
-    //        return;
+    //        return { .verdict = Verdict::Rejected };
     //    }
 
     // special conditions: receiver is null - coins burning, contract creation
-    if (targetReceiver.isEmpty()) {
-        //
-    } else {
+    if (!targetReceiver.isEmpty()) {
         if (tx.getData() == "InitContract") {
-            return;
+            qDebug() << "Tx" << tx.getHash().c_str() << "contract txs are not proved";
+            return { .verdict = Verdict::Rejected };
         }
-        if (targetSender != node->actorIndex()->firstId()) {
-            BigNumberFloat senderCurrentBalance = getUserBalance(targetSender, tx.getToken());
-            senderCurrentBalance += txManager->checkPendingTxsList(targetSender);
-
-            if (tx.getAmount() <= 0) {
-                txManager->removeUnApprovedTransaction(tx);
-                qDebug() << "Transaction not approved: amount <= 0";
-                return;
-            }
-
-            auto mainActorId = node->accountController()->mainActor().id();
-            ActorId firstId = node->actorIndex()->firstId();
-            if (senderCurrentBalance - tx.getAmount() - tx.getAmount() / 100 < 0 && mainActorId == firstId) {
-                qDebug() << senderCurrentBalance << tx.getAmount();
-                qDebug() << "Transaction "
-                            "not approved: sender's or receiver's balance will be < 0";
-                txManager->removeUnApprovedTransaction(tx);
-                return;
-            }
+        if (targetSender == node->actorIndex()->firstId())
+            return { .verdict = Verdict::Sign };
 
-            txManager->addProvedTransaction(tx);
-        } else {
-            tx.sign(node->accountController()->currentWallet());
-            txManager->addProvedTransaction(tx);
-            return;
+        if (tx.getAmount() <= 0) {
+            qDebug() << "Transaction not approved: amount <= 0";
+            return { .verdict = Verdict::Rejected };
         }
-        return;
+        // pending txs are counted by caller, they change while tx is proved
+        return { .verdict = Verdict::CheckBalance, .balance = getUserBalance(targetSender, tx.getToken()) };
     }
     qDebug() << "Undefine behaviour blockhain.cpp proveTx";
-    txManager->removeUnApprovedTransaction(tx);
+    return { .verdict = Verdict::Rejected };
 }
 
 // Other //
@@ -1246,8 +1464,12 @@ BlockIndex &Blockchain::getBlockIndex() {
 }
 
 void Blockchain::removeAll() {
+    QWriteLocker locker(&m_chainLock);
     // node->actorIndex()->removeAll();
     this->memIndex.removeAll();
     this->blockIndex.removeAll();
+    headerIndex.clear();
+    m_lastGenesisHash.reset();
+    resetSupply();
     QFile(DataStorage::TMP_GENESIS_BLOCK).remove();
 }
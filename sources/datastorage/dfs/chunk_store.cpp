@@ -0,0 +1,247 @@
+#include "datastorage/dfs/chunk_store.h"
+
+#include <fstream>
+#include <map>
+
+#include "datastorage/actor.h"
+#include "datastorage/dfs/mapped_file.h"
+
+double ChunkStore::Stats::dedupRatio() const {
+    return uniqueBytes ? double(referencedBytes) / double(uniqueBytes) : 1.0;
+}
+
+ChunkStore::ChunkStore(const std::string &path, const Chunker &chunker)
+    : m_path(path)
+    , m_chunker(chunker) {
+}
+
+std::vector<DFSP::ChunkRef> ChunkStore::addFile(const std::string &actorId, const std::string &fileName) {
+    MappedFile file(DFS_PATH::filePath(actorId, fileName));
+    if (!file.isOpen())
+        return {};
+
+    // split and hash without lock, only store is serialized
+    const std::string_view data = file.slice(0, file.size());
+    const auto chunks = m_chunker.split(data);
+    std::vector<DFSP::ChunkRef> manifest;
+    manifest.reserve(chunks.size());
+    for (const auto &chunk : chunks) {
+        const auto hash = Chunker::hash(data.substr(chunk.offset, chunk.size));
+        manifest.push_back({ .Hash = hash, .Size = chunk.size });
+    }
+
+    const std::string key = fileKey(actorId, fileName);
+    std::lock_guard lock(m_mutex);
+    if (!reindex(key, manifest, data)) {
+        qDebug() << "[ChunkStore] Can't index" << key.c_str();
+        return {};
+    }
+    return manifest;
+}
+
+std::vector<DFSP::ChunkRef> ChunkStore::manifest(const std::string &actorId, const std::string &fileName) {
+    {
+        std::lock_guard lock(m_mutex);
+        auto db = open();
+        auto rows = db.select("SELECT hash, size FROM " + DFST::ChunksFile::TableName
+                                  + " WHERE file = ? ORDER BY offset;",
+                              DFST::ChunksFile::TableName, { { "file", fileKey(actorId, fileName) } });
+        if (!rows.empty()) {
+            std::vector<DFSP::ChunkRef> manifest;
+            manifest.reserve(rows.size());
+            for (auto &row : rows)
+                manifest.push_back({ .Hash = row["hash"], .Size = std::stoull(row["size"]) });
+            return manifest;
+        }
+    }
+    return addFile(actorId, fileName);
+}
+
+void ChunkStore::removeFile(const std::string &actorId, const std::string &fileName) {
+    std::lock_guard lock(m_mutex);
+    reindex(fileKey(actorId, fileName), {}, {});
+}
+
+bool ChunkStore::restore(const std::string &actorId, const std::string &fileName,
+                         const std::filesystem::path &path) const {
+    std::vector<DBRow> rows;
+    {
+        std::lock_guard lock(m_mutex);
+        auto db = open();
+        rows = db.select("SELECT hash, size FROM " + DFST::ChunksFile::TableName
+                             + " WHERE file = ? ORDER BY offset;",
+                         DFST::ChunksFile::TableName, { { "file", fileKey(actorId, fileName) } });
+    }
+    if (rows.empty())
+        return false;
+
+    std::ofstream target(path, std::ios::binary | std::ios::trunc);
+    for (auto &row : rows) {
+        const std::string data = read(row["hash"]);
+        if (data.size() != std::stoull(row["size"]))
+            return false;
+        target.write(data.data(), std::streamsize(data.size()));
+    }
+    return bool(target.flush());
+}
+
+uint64_t ChunkStore::references(const std::string &hash) const {
+    std::lock_guard lock(m_mutex);
+    auto db = open();
+    auto rows = db.select("SELECT refs FROM " + DFST::ChunkRefsFile::TableName + " WHERE hash = ?;",
+                          DFST::ChunkRefsFile::TableName, { { "hash", hash } });
+    return rows.empty() ? 0 : std::stoull(rows[0]["refs"]);
+}
+
+std::string ChunkStore::read(const std::string &hash) const {
+    // chunks are written once and never changed, so they are read without lock
+    MappedFile file(chunkPath(hash));
+    if (!file.isOpen())
+        return "";
+    return std::string(file.slice(0, file.size()));
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> ChunkStore::copyLocal(const std::vector<DFSP::ChunkRef> &manifest,
+                                                                 const std::filesystem::path &path) const {
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    std::fstream target(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!target)
+        return ranges;
+
+    uint64_t offset = 0;
+    for (const auto &chunk : manifest) {
+        const std::string data = read(chunk.Hash);
+        if (!data.empty() && data.size() == chunk.Size) {
+            target.seekp(std::streamoff(offset));
+            target.write(data.data(), std::streamsize(data.size()));
+            if (!target)
+                break;
+            if (!ranges.empty() && ranges.back().first + ranges.back().second == offset)
+                ranges.back().second += chunk.Size;
+            else
+                ranges.emplace_back(offset, chunk.Size);
+        }
+        offset += chunk.Size;
+    }
+    return ranges;
+}
+
+ChunkStore::Stats ChunkStore::stats() const {
+    std::lock_guard lock(m_mutex);
+    auto db = open();
+    auto toNumber = [](const std::string &value) { return value.empty() ? 0 : std::stoull(value); };
+
+    Stats stats;
+    auto referenced = db.select("SELECT COUNT(DISTINCT file) AS files, SUM(size) AS bytes FROM "
+                                + DFST::ChunksFile::TableName + ";");
+    auto unique = db.select("SELECT COUNT(*) AS chunks, SUM(size) AS bytes FROM "
+                            + DFST::ChunkRefsFile::TableName + ";");
+    if (!referenced.empty()) {
+        stats.files = toNumber(referenced[0]["files"]);
+        stats.referencedBytes = toNumber(referenced[0]["bytes"]);
+    }
+    if (!unique.empty()) {
+        stats.chunks = toNumber(unique[0]["chunks"]);
+        stats.uniqueBytes = toNumber(unique[0]["bytes"]);
+    }
+    return stats;
+}
+
+DBConnector ChunkStore::open() const {
+    std::error_code error;
+    // older versions kept only the index of chunks in files at this path, files are indexed again
+    if (std::filesystem::is_regular_file(m_path, error))
+        std::filesystem::remove(m_path, error);
+    std::filesystem::create_directories(m_path, error);
+    DBConnector db((m_path / "index").string());
+    db.open();
+    db.query(DFST::ChunksFile::CreateTableQuery);
+    db.query(DFST::ChunkRefsFile::CreateTableQuery);
+    return db;
+}
+
+std::filesystem::path ChunkStore::chunkPath(const std::string &hash) const {
+    // first byte of hash is a subdirectory, so directories stay small
+    return m_path / hash.substr(0, 2) / hash;
+}
+
+bool ChunkStore::reindex(const std::string &key, const std::vector<DFSP::ChunkRef> &manifest,
+                         std::string_view data) {
+    auto db = open();
+    // change of references by hash, previous chunks of file are released
+    std::map<std::string, std::pair<int64_t, uint64_t>> changes; // references and size
+    for (auto &row : db.select("SELECT hash, size FROM " + DFST::ChunksFile::TableName + " WHERE file = ?;",
+                               DFST::ChunksFile::TableName, { { "file", key } })) {
+        auto &change = changes[row["hash"]];
+        change.first--;
+        change.second = std::stoull(row["size"]);
+    }
+    std::map<std::string, uint64_t> offsets; // first offset of new chunk in data
+    uint64_t offset = 0;
+    for (const auto &chunk : manifest) {
+        auto &change = changes[chunk.Hash];
+        change.first++;
+        change.second = chunk.Size;
+        offsets.emplace(chunk.Hash, offset);
+        offset += chunk.Size;
+    }
+
+    std::vector<std::string> removed;
+    db.query("BEGIN TRANSACTION;");
+    bool written = db.deleteRow(DFST::ChunksFile::TableName, { { "file", key } });
+    offset = 0;
+    for (const auto &chunk : manifest) {
+        written = written
+            && db.insert(DFST::ChunksFile::TableName,
+                         { { "hash", chunk.Hash },
+                           { "file", key },
+                           { "offset", std::to_string(offset) },
+                           { "size", std::to_string(chunk.Size) } });
+        offset += chunk.Size;
+    }
+    for (const auto &[hash, change] : changes) {
+        if (!written)
+            break;
+        if (change.first == 0)
+            continue;
+        auto rows = db.select("SELECT refs FROM " + DFST::ChunkRefsFile::TableName + " WHERE hash = ?;",
+                              DFST::ChunkRefsFile::TableName, { { "hash", hash } });
+        const int64_t refs = (rows.empty() ? 0 : std::stoll(rows[0]["refs"])) + change.first;
+        if (refs <= 0) {
+            written = db.deleteRow(DFST::ChunkRefsFile::TableName, { { "hash", hash } });
+            removed.push_back(hash);
+            continue;
+        }
+        if (rows.empty()) {
+            // written aside and renamed, so chunk is never read partially
+            const auto path = chunkPath(hash);
+            const auto temp = path.string() + ".part";
+            std::error_code error;
+            std::filesystem::create_directories(path.parent_path(), error);
+            const std::string_view bytes = data.substr(offsets.at(hash), change.second);
+            written = bool(std::ofstream(temp, std::ios::binary | std::ios::trunc)
+                               .write(bytes.data(), std::streamsize(bytes.size())));
+            std::filesystem::rename(temp, path, error);
+            written = written && !error;
+        }
+        written = written
+            && db.replace(DFST::ChunkRefsFile::TableName,
+                          { { "hash", hash },
+                            { "size", std::to_string(change.second) },
+                            { "refs", std::to_string(refs) } });
+    }
+    if (!written) {
+        db.query("ROLLBACK;");
+        return false;
+    }
+    db.query("COMMIT;");
+
+    std::error_code error;
+    for (const auto &hash : removed)
+        std::filesystem::remove(chunkPath(hash), error);
+    return true;
+}
+
+std::string ChunkStore::fileKey(const std::string &actorId, const std::string &fileName) {
+    return actorId + "/" + fileName;
+}
@@ -0,0 +1,86 @@
+#include "datastorage/dfs/chunker.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+#include <sodium.h>
+
+namespace {
+// fixed table, chunk boundaries must be the same on every node
+constexpr std::array<uint64_t, 256> makeGear() {
+    std::array<uint64_t, 256> gear {};
+    uint64_t state = 0x45787472614368; // splitmix64
+    for (auto &value : gear) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        value = z ^ (z >> 31);
+    }
+    return gear;
+}
+
+constexpr std::array<uint64_t, 256> gear = makeGear();
+
+// high bits of gear hash depend on the last 64 bytes, low bits only on the last ones
+constexpr uint64_t highMask(int bits) {
+    return bits <= 0 ? 0 : bits >= 64 ? ~uint64_t(0) : ~uint64_t(0) << (64 - bits);
+}
+}
+
+Chunker::Chunker(uint32_t minSize, uint32_t avgSize, uint32_t maxSize)
+    : m_minSize(std::max<uint32_t>(minSize, 64))
+    , m_avgSize(std::bit_floor(std::max(avgSize, m_minSize)))
+    , m_maxSize(std::max(maxSize, m_avgSize)) {
+    // normalized chunking: sizes are gathered around average
+    const int bits = std::countr_zero(m_avgSize);
+    m_maskSmall = highMask(bits + 2);
+    m_maskLarge = highMask(bits - 2);
+}
+
+uint64_t Chunker::cut(std::string_view data) const {
+    const auto *bytes = reinterpret_cast<const uint8_t *>(data.data());
+    const uint64_t size = std::min<uint64_t>(data.size(), m_maxSize);
+    if (size <= m_minSize)
+        return size;
+
+    const uint64_t normal = std::min<uint64_t>(size, m_avgSize);
+    uint64_t hash = 0;
+    uint64_t i = m_minSize;
+    for (; i < normal; i++) {
+        hash = (hash << 1) + gear[bytes[i]];
+        if (!(hash & m_maskSmall))
+            return i + 1;
+    }
+    for (; i < size; i++) {
+        hash = (hash << 1) + gear[bytes[i]];
+        if (!(hash & m_maskLarge))
+            return i + 1;
+    }
+    return size;
+}
+
+std::vector<Chunker::Chunk> Chunker::split(std::string_view data) const {
+    std::vector<Chunk> chunks;
+    chunks.reserve(data.size() / m_avgSize + 1);
+    uint64_t offset = 0;
+    while (offset < data.size()) {
+        const uint64_t size = cut(data.substr(offset));
+        chunks.push_back({ .offset = offset, .size = size });
+        offset += size;
+    }
+    return chunks;
+}
+
+uint32_t Chunker::maxSize() const {
+    return m_maxSize;
+}
+
+std::string Chunker::hash(std::string_view data) {
+    unsigned char hash[crypto_generichash_BYTES];
+    crypto_generichash(hash, sizeof(hash), reinterpret_cast<const unsigned char *>(data.data()),
+                       data.size(), nullptr, 0);
+    char hex[sizeof(hash) * 2 + 1];
+    sodium_bin2hex(hex, sizeof(hex), hash, sizeof(hash));
+    return std::string(hex, sizeof(hash) * 2);
+}
@@ -1,5 +1,30 @@
 #include "datastorage/dfs/dfs_controller.h"
 
+#include "utils/metrics.h"
+
+namespace {
+Metrics::Counter &sentBytes() {
+    static auto &counter = Metrics::counter("extrachain_dfs_sent_bytes_total", "File data sent to peers");
+    return counter;
+}
+
+Metrics::Counter &receivedBytes() {
+    static auto &counter =
+        Metrics::counter("extrachain_dfs_received_bytes_total", "File data received from peers");
+    return counter;
+}
+
+Metrics::Gauge &fragmentQueue() {
+    static auto &gauge = Metrics::gauge("extrachain_dfs_fragment_queue", "Fragments waiting to be written");
+    return gauge;
+}
+
+Metrics::Gauge &downloads() {
+    static auto &gauge = Metrics::gauge("extrachain_dfs_downloads", "Downloads in progress");
+    return gauge;
+}
+}
+
 DfsController::DfsController(ExtraChainNode &node, QObject *parent)
     : QObject(parent)
     , node(node) {
@@ -8,14 +33,44 @@ DfsController::DfsController(ExtraChainNode &node, QObject *parent)
     DBConnector dirsFile(DFSB::dirsPath);
     dirsFile.open();
     dirsFile.query(DFST::DirsFile::CreateTableQuery);
+    dirsFile.query(DFST::DownloadsFile::CreateTableQuery);
+    dirsFile.close();
 
-    m_sizeTaken = calculateSizeTaken();
-    m_totalDfsSize = calculateFilesSize();
-    qDebug() << fmt::format("[Dfs] Started. Current size: {}, available: {}", m_sizeTaken, bytesAvailable())
+    if (!m_counters.load()) {
+        qDebug() << "[Dfs] Calculate sizes of stored files";
+        m_counters.reset(calculateSizes());
+    }
+    qDebug() << fmt::format("[Dfs] Started. Current size: {}, available: {}", sizeTaken(), bytesAvailable())
                     .c_str();
+
+    m_ingestion = new DfsIngestion(
+        { [this](DfsIngestion::Item &item) { return ingestCopy(item); },
+          [this](DfsIngestion::Item &item) { return ingestEncrypt(item); },
+          [this](DfsIngestion::Item &item) { return ingestHash(item); },
+          [this](DfsIngestion::Item &item) { return ingestIndex(item); },
+          [this](DfsIngestion::Item &item) { return ingestAnnounce(item); } },
+        &ThreadPool::instance(), this);
+    connect(m_ingestion, &DfsIngestion::added, this, [this](const DfsIngestion::Item &item) {
+        emit added(item.actorId, item.fileName, item.virtualPath, item.size);
+        emit resultAddFile("", QString::fromStdWString(item.source.wstring()));
+    });
+    connect(m_ingestion, &DfsIngestion::failed, this, [this](const DfsIngestion::Item &item) {
+        qDebug() << "[Dfs] Can't add file" << item.source.string().c_str() << ":" << item.error.c_str();
+        emit resultAddFile(QString::fromStdString(item.error),
+                           QString::fromStdWString(item.source.wstring()));
+    });
+
+    m_downloadTimer = new QTimer(this);
+    connect(m_downloadTimer, &QTimer::timeout, this, &DfsController::checkDownloads);
+    m_downloadTimer->start(1000);
+    QTimer::singleShot(0, this, &DfsController::resumeDownloads);
 }
 
 DfsController::~DfsController() {
+    // stages use members of controller
+    delete m_ingestion;
+    for (auto &[key, download] : m_downloads)
+        download->flushBitmap();
 }
 
 void DfsController::initializeActor(const ActorId &actorId) {
@@ -28,121 +83,139 @@ void DfsController::initializeActor(const ActorId &actorId) {
     requestDirData(actorId);
 }
 
+QFuture<DfsIngestion::Item> DfsController::ingest(const Actor<KeyPrivate> &actor,
+                                                  const std::filesystem::path &filePath,
+                                                  const std::string &targetVirtualFilePath,
+                                                  DFS::Encryption securityLevel) {
+    return m_ingestion->add({ .actorId = actor.id().toStdString(),
+                              .source = filePath,
+                              .virtualPath = targetVirtualFilePath,
+                              .encryption = securityLevel,
+                              .key = actor.key() });
+}
+
 std::string DfsController::addLocalFile(const Actor<KeyPrivate> &actor, const std::filesystem::path &filePath,
                                         std::string targetVirtualFilePath, DFS::Encryption securityLevel) {
-    std::filesystem::path fpath = DFS_PATH::convertPathToPlatform(filePath);
-    std::filesystem::path newFilePath = fpath;
-    std::string newTargetVirtualFilePath = targetVirtualFilePath;
+    const auto item = ingest(actor, filePath, targetVirtualFilePath, securityLevel).result();
+    return item.error.empty() ? item.fileName : item.error;
+}
 
+std::string DfsController::ingestCopy(DfsIngestion::Item &item) {
+    std::filesystem::path source = DFS_PATH::convertPathToPlatform(item.source);
 #ifdef ANDROID
-    auto tempPath = "dfs/temp"
-        + QString::number(QRandomGenerator::global()->bounded(1000) + QDateTime::currentMSecsSinceEpoch());
-    QFile::copy(newFilePath.string().c_str(), tempPath);
-    fpath = tempPath.toStdString();
-    newFilePath = fpath;
+    // content uris are readable only with QFile
+    const auto tempPath = "dfs/temp" + std::to_string(item.id) + "-"
+        + std::to_string(QDateTime::currentMSecsSinceEpoch());
+    QFile::copy(QString::fromStdString(source.string()), QString::fromStdString(tempPath));
+    source = tempPath;
 #endif
 
-    if (!std::filesystem::exists(newFilePath)) {
-        qInfo() << "[Dfs] Can't load file";
+    if (!std::filesystem::exists(source))
         return "ErrorNotExists";
-    }
-
-    if (!std::filesystem::is_regular_file(newFilePath)) {
-        qInfo() << "[Dfs] This is not a file";
+    if (!std::filesystem::is_regular_file(source))
         return "ErrorNotFile";
-    }
-
-    std::ifstream my_file(newFilePath);
-    if (!my_file) {
-        qDebug() << "Can't read";
+    if (!std::ifstream(source))
         return "ErrorNotReadable";
-    }
-    my_file.close();
 
-    auto fileSize = std::filesystem::file_size(newFilePath);
-    if (!writeAvailable(fileSize)) {
+    item.source = source;
+    item.size = std::filesystem::file_size(source);
+    if (!writeAvailable(item.size))
         return "ErrorStorageFull";
-    }
 
-    if (securityLevel == DFS::Encryption::Encrypted) {
-        std::wstring fname = std::filesystem::path(fpath).stem().wstring();
-        newFilePath = L"temp";
-        std::filesystem::create_directories(newFilePath);
-        newFilePath = newFilePath.wstring() + DFSB::separator + fname;
-        if (!std::filesystem::exists(newFilePath)) {
-            std::filesystem::copy(filePath, newFilePath);
-        }
-        actor.key().encryptFile(fpath, newFilePath);
-
-        std::filesystem::path nvp = targetVirtualFilePath;
-        std::filesystem::path nfn = nvp.filename();
-        nvp.remove_filename();
-        nvp /= "secured";
-        nvp /= nfn;
-        newTargetVirtualFilePath = nvp.string();
-    }
+    item.fileName = createFileName(item.source);
+    if (item.encryption == DFS::Encryption::Encrypted)
+        return ""; // file is written by encryption
 
-    std::string fileName = createFileName(filePath);
-    std::string fileHash = Utils::calcHashForFile(newFilePath);
-    std::filesystem::path placeInDFS =
-        DFSB::fsActrRootW + DFSB::separator + actor.id().toString().toStdWString() + DFSB::separator;
-    std::filesystem::path dfsPath = DFS_PATH::filePath(actor.id(), fileName);
-
-    if (std::filesystem::exists(dfsPath) && std::filesystem::file_size(dfsPath) == fileSize) {
-        std::string dfsFileHash = Utils::calcHashForFile(dfsPath);
-        if (fileHash == dfsFileHash) {
-            qDebug() << "[DFS] File already in DFS";
-            return "ErrorAlreadyExists";
-        }
-    }
-
-    try {
-        std::filesystem::create_directories(placeInDFS.c_str());
+    const auto dfsPath = DFS_PATH::filePath(item.actorId, item.fileName);
+    auto change = m_counters.change(item.actorId, { dfsPath });
+    std::error_code error;
+    std::filesystem::create_directories(dfsPath.parent_path(), error);
 #ifdef ANDROID
-        std::filesystem::rename(newFilePath, dfsPath);
+    std::filesystem::rename(item.source, dfsPath, error);
 #else
-        std::filesystem::copy(newFilePath, dfsPath);
+    std::filesystem::copy_file(item.source, dfsPath, error);
 #endif
-    } catch (std::filesystem::filesystem_error const &err) {
-        qDebug() << "[Dfs] Copy error:" << err.what();
+    if (error) {
+        qDebug() << "[Dfs] Copy error:" << error.message().c_str();
+        return "ErrorCopy";
     }
+    return "";
+}
 
-    if (std::filesystem::exists(newFilePath) && securityLevel == DFS::Encryption::Encrypted)
-        std::filesystem::remove(newFilePath);
+std::string DfsController::ingestEncrypt(DfsIngestion::Item &item) {
+    if (item.encryption != DFS::Encryption::Encrypted)
+        return "";
 
-    FragmentStorage fs(actor.id(), fileName, fileHash);
-    fs.initLocalFile(fileSize);
+    const auto dfsPath = DFS_PATH::filePath(item.actorId, item.fileName);
+    auto change = m_counters.change(item.actorId, { dfsPath });
+    std::error_code error;
+    std::filesystem::create_directories(dfsPath.parent_path(), error);
+    const bool encrypted = item.key.encryptFile(item.source, dfsPath);
+#ifdef ANDROID
+    std::filesystem::remove(item.source, error);
+#endif
+    if (!encrypted)
+        return "ErrorEncryption";
 
-    const auto actorId = actor.id().toStdString();
-    DFSP::AddFileMessage msg = { .Actor = actorId,
-                                 .FileName = fileName,
-                                 .FileHash = fileHash,
-                                 .Path = newTargetVirtualFilePath,
-                                 .Size = fileSize };
-    qDebug() << "AddFileMessage" << actor.id().toString() << fileName.c_str()
-             << newTargetVirtualFilePath.c_str() << fileSize;
+    std::filesystem::path virtualPath = item.virtualPath;
+    const auto fileName = virtualPath.filename();
+    virtualPath.remove_filename();
+    item.virtualPath = (virtualPath / "secured" / fileName).string();
+    return "";
+}
 
-    auto actrDirFile = DFST::ActorDirFile::actorDbConnector(actorId);
-    auto lastFileName = DFST::ActorDirFile::getLastName(actrDirFile);
-    const DBRow rowData = makeActrDirDBRow(msg.FileName, lastFileName, msg.FileHash, msg.Path, msg.Size);
+std::string DfsController::ingestHash(DfsIngestion::Item &item) {
+    const auto dfsPath = DFS_PATH::filePath(item.actorId, item.fileName);
+    item.size = std::filesystem::file_size(dfsPath);
+    item.fileHash = Utils::calcHashForFile(dfsPath);
+    if (item.fileHash.empty())
+        return "ErrorNotReadable";
+    m_chunks.addFile(item.actorId, item.fileName);
+    return "";
+}
 
+std::string DfsController::ingestIndex(DfsIngestion::Item &item) {
+    auto change = fileChange(item.actorId, item.fileName);
+    auto actrDirFile = DFST::ActorDirFile::actorDbConnector(item.actorId);
+    auto lastFileName = DFST::ActorDirFile::getLastName(actrDirFile);
+    const DBRow rowData =
+        makeActrDirDBRow(item.fileName, lastFileName, item.fileHash, item.virtualPath, item.size);
     if (!actrDirFile.insert(DFST::ActorDirFile::TableName, rowData)) {
         qDebug() << "[Dfs] addFile: insert failed:" << actrDirFile.file().c_str() << " :"
                  << DFST::ActorDirFile::TableName.c_str();
-        qFatal("Insert failed");
         return "ErrorDirError";
     }
-
     actrDirFile.close();
-    m_sizeTaken += fileSize;
-    m_totalDfsSize += fileSize;
+    change.add({ .files = int64_t(item.size) });
+
     DBConnector dirsFile(DFSB::dirsPath);
     dirsFile.open();
     dirsFile.replace(DFST::DirsFile::TableName,
-                     { { "actorId", actorId }, { "lastModified", rowData.at("lastModified") } });
+                     { { "actorId", item.actorId }, { "lastModified", rowData.at("lastModified") } });
+    dirsFile.close();
+
+    FragmentStorage fs(item.actorId, item.fileName, item.fileHash);
+    fs.initLocalFile(item.size);
+    fs.initHistoricalChain();
+    change.add({ .stored = fs.storedChange() });
+    return "";
+}
 
-    sendFile(actor.id(), fileName);
-    return addFile(msg, false);
+std::string DfsController::ingestAnnounce(DfsIngestion::Item &item) {
+    DFSP::AddFileMessage msg = { .Actor = item.actorId,
+                                 .FileName = item.fileName,
+                                 .FileHash = item.fileHash,
+                                 .Path = item.virtualPath,
+                                 .Size = item.size };
+    // network is used from the controller thread
+    QMetaObject::invokeMethod(
+        this,
+        [this, msg] {
+            node.network()->send_message(msg, MessageType::DfsAddFile);
+            insertToFiles(msg);
+        },
+        Qt::QueuedConnection);
+    return "";
 }
 
 bool DfsController::removeLocalFile(const Actor<KeyPrivate> &actor, const std::string &filePath) {
@@ -152,9 +225,13 @@ bool DfsController::removeLocalFile(const Actor<KeyPrivate> &actor, const std::s
                                     .FileName = std::filesystem::path(filePath).filename().string() };
     node.network()->send_message(msg, MessageType::DfsRemoveFile);
 
+    auto change = fileChange(actorId, fileHash);
+    const auto stored = DFST::ActorDirFile::dataAmountStoredSize(actorId, fileHash + DFSF::Extension);
+    change.add({ .stored = -int64_t(stored) });
     HistoricalChain hc((DFS_PATH::filePath(actorId, fileHash).string() + DFSF::Extension), filePath);
     const bool databaseFileRemoved = hc.remove(actorId, fileHash);
     const bool fileRemoved = std::filesystem::remove(DFS_PATH::filePath(actorId, fileHash).string());
+    m_chunks.removeFile(actorId, fileHash);
     return databaseFileRemoved && fileRemoved;
 }
 
@@ -175,12 +252,7 @@ std::string DfsController::addFile(const DFSP::AddFileMessage &msg, bool loadByt
         }
     }
 
-    if (loadBytes && !std::filesystem::exists(realFilePath)) {
-        std::fstream fs;
-        fs.open(realFilePath, std::ios::out | std::ios::binary);
-        fs.close();
-    }
-
+    auto change = fileChange(msg.Actor, msg.FileName);
     DBConnector actrDirFile(actrDirFilePath);
 
     if (!actrDirFile.open()) {
@@ -200,6 +272,7 @@ std::string DfsController::addFile(const DFSP::AddFileMessage &msg, bool loadByt
         return "";
     }
     actrDirFile.close();
+    change.add({ .files = int64_t(msg.Size) });
 
     DBConnector dirsFile(DFSB::dirsPath);
     dirsFile.open();
@@ -207,16 +280,10 @@ std::string DfsController::addFile(const DFSP::AddFileMessage &msg, bool loadByt
                      { { "actorId", msg.Actor }, { "lastModified", rowData.at("lastModified") } });
 
     if (loadBytes) {
-        if (msg.Size >= m_bytesLimit - m_sizeTaken) {
+        if (msg.Size >= m_bytesLimit - sizeTaken()) {
             return msg.FileName;
         } else {
-            DFSP::RequestFileSegmentMessage reqMessage = { .Actor = msg.Actor,
-                                                           .FileName = msg.FileName,
-                                                           .FileHash = msg.FileHash,
-                                                           .Path = msg.Path,
-                                                           .Offset = 0 };
-            node.network()->send_message(reqMessage, MessageType::DfsRequestFileSegment,
-                                         MessageStatus::Request);
+            startDownload(msg);
         }
     }
 
@@ -261,6 +328,7 @@ bool DfsController::removeFile(const DFSP::RemoveFileMessage &msg) {
     std::string pathDelim = Utils::platformDelimeter();
     std::string actrDirFilePath = DFSB::fsActrRoot + pathDelim + msg.Actor + pathDelim + DFSB::fsMapName;
     std::filesystem::path realFilePath = DFSB::fsActrRoot + pathDelim + msg.Actor + pathDelim + msg.FileName;
+    auto change = fileChange(msg.Actor, msg.FileName);
     DBConnector actrDirFile(actrDirFilePath);
     if (!actrDirFile.open()) {
         exit(EXIT_FAILURE);
@@ -270,7 +338,9 @@ bool DfsController::removeFile(const DFSP::RemoveFileMessage &msg) {
     for (auto it = actrDirData.begin(); it < actrDirData.end(); it++) {
         if (it->at("fileHash") == msg.FileName) {
             prevHash = it->at("fileHashPrev");
-            actrDirFile.deleteRow(DFST::ActorDirFile::TableName, *it);
+            if (actrDirFile.deleteRow(DFST::ActorDirFile::TableName, *it))
+                change.add({ .files = -int64_t(std::stoull(it->at("fileSize"))) });
+            m_chunks.removeFile(msg.Actor, msg.FileName);
             if (!std::filesystem::remove(realFilePath)) {
                 qDebug() << "File removal by path " << realFilePath.c_str() << " failed";
                 return false;
@@ -302,6 +372,7 @@ bool DfsController::renameFile(const ActorId &actor, const std::string &fileHash
     const std::string actorId = actor.toStdString();
     std::string pathDelim = Utils::platformDelimeter();
     std::filesystem::path path = DFSB::fsActrRoot + pathDelim + actorId + pathDelim;
+    m_fileCache.invalidate(path / std::string(fileHash));
     std::filesystem::rename(path / std::string(fileHash), path / std::string(newFileHash));
     return std::filesystem::exists(path / std::string(newFileHash));
 }
@@ -329,41 +400,18 @@ std::string DfsController::insertFragment(const DFSP::SegmentMessage &msg) {
         qFatal("Error 4");
         return "";
     }
+    auto change = fileChange(msg.Actor, msg.FileName);
+    m_chunks.removeFile(msg.Actor, msg.FileName);
     insertDataChunk(msg.Data, msg.Offset, realFilePath);
     actrDirFile.close();
     return Utils::calcHashForFile(realFilePath.string());
 }
 
 void DfsController::addListFiles(const QStringList &files) {
-    qDebug() << "Files add in thread id: [" << QThread::currentThreadId() << "]" << files.size();
+    qDebug() << "[Dfs] Add files:" << files.size();
     const auto actor = node.accountController()->mainActor();
-    ThreadAddFiles addFilesThread(this, actor, files);
-    connect(&addFilesThread, &ThreadAddFiles::added, this,
-            [&](DFSP::AddFileMessage msg, std::string filePath, std::string scriptPath) {
-                insertToFiles(msg);
-                emit added(msg.Actor, msg.FileName, msg.Path, msg.Size);
-                emit resultAddFile("", QString::fromStdString(filePath));
-                if (!scriptPath.empty()) {
-                    //                    Transaction transaction;
-                    //                    transaction.setData(MessagePack::serialize(
-                    //                        TransactionData { .hash = transaction.getHash(), .path =
-                    //                        msg.FileHash }));
-                    //                    node.network()->send_message(transaction,
-                    //                    MessageType::BlockchainTransaction);
-                }
-            });
-
-    connect(&addFilesThread, &ThreadAddFiles::sendMessage, this,
-            [&](DFSP::AddFileMessage msg, MessageType messageType) {
-                qDebug() << "send file: " << msg.FileName.c_str();
-                node.network()->send_message(msg, MessageType::DfsAddFile);
-            });
-    connect(&addFilesThread, &ThreadAddFiles::error, this, [&](std::string error, std::string fileName) {
-        qDebug() << error.c_str();
-        emit resultAddFile(QString::fromStdString(error), QString::fromStdString(fileName));
-    });
-    addFilesThread.start();
-    addFilesThread.wait();
+    for (const auto &file : files)
+        ingest(actor, file.toStdWString(), QFileInfo(file).fileName().toStdString());
 }
 
 bool DfsController::insertDataChunk(std::string data, uint64_t position, std::filesystem::path file) {
@@ -477,15 +525,55 @@ DBRow DfsController::makeActrDirDBRow(std::string fileName, std::string fileName
 }
 
 uint64_t DfsController::sizeTaken() const {
-    return m_sizeTaken;
+    return uint64_t(std::max<int64_t>(m_counters.total().disk, 0));
 }
 
 uint64_t DfsController::totalDfsSize() const {
-    return m_totalDfsSize;
+    return uint64_t(std::max<int64_t>(m_counters.total().files, 0));
 }
 
-void DfsController::increaseSizeTaken(uintmax_t value) {
-    m_sizeTaken += value;
+uint64_t DfsController::dataAmountStored() const {
+    return uint64_t(std::max<int64_t>(m_counters.total().stored, 0));
+}
+
+DfsCounters &DfsController::counters() {
+    return m_counters;
+}
+
+ChunkStore &DfsController::chunks() {
+    return m_chunks;
+}
+
+MappedFileCache &DfsController::fileCache() {
+    return m_fileCache;
+}
+
+std::vector<std::filesystem::path> DfsController::filePaths(const std::string &actorId,
+                                                           const std::string &fileName) const {
+    const std::string filePath = DFS_PATH::filePath(actorId, fileName).string();
+    return { filePath, filePath + DFSF::Extension, filePath + ".part",
+             DFSB::fsActrRoot + Utils::platformDelimeter() + actorId + Utils::platformDelimeter()
+                 + DFSB::fsMapName };
+}
+
+DfsCounters::Change DfsController::fileChange(const std::string &actorId, const std::string &fileName) {
+    // every write goes through change, mapping must be dropped before file is truncated
+    m_fileCache.invalidate(DFS_PATH::filePath(actorId, fileName));
+    return m_counters.change(actorId, filePaths(actorId, fileName));
+}
+
+std::shared_ptr<const MappedFile> DfsController::mapFile(const std::string &actorId,
+                                                        const std::string &fileName) {
+    const auto path = DFS_PATH::filePath(actorId, fileName);
+    if (!std::filesystem::exists(path)) {
+        auto change = fileChange(actorId, fileName);
+        const auto temp = path.string() + ".restore";
+        std::error_code error;
+        if (m_chunks.restore(actorId, fileName, temp))
+            std::filesystem::rename(temp, path, error);
+        std::filesystem::remove(temp, error);
+    }
+    return m_fileCache.get(path);
 }
 
 void DfsController::insertToFiles(DFS::Packets::AddFileMessage msg) {
@@ -563,6 +651,19 @@ void DfsController::exportFile(const std::string &pathTo, const std::string &pat
     }
 }
 
+std::map<std::string, DfsCounters::Sizes> DfsController::calculateSizes() const {
+    std::map<std::string, DfsCounters::Sizes> sizes;
+    for (const auto &entry : std::filesystem::directory_iterator(DFSB::fsActrRoot)) {
+        if (!entry.is_directory())
+            continue;
+        const std::string folder = entry.path().string();
+        sizes[entry.path().filename().string()] = { .disk = int64_t(calculateSizeTaken(folder)),
+                                                    .files = int64_t(calculateFilesSize(folder)),
+                                                    .stored = int64_t(calculateDataAmountStored(folder)) };
+    }
+    return sizes;
+}
+
 uint64_t DfsController::calculateSizeTaken(const std::string &folder) const {
     uint64_t size = 0;
 
@@ -606,20 +707,6 @@ uint64_t DfsController::calculateDataAmountStored(const std::string &folder) con
     return size;
 }
 
-std::string DfsController::extractFragment(boost::interprocess::file_mapping &fmapTarget, uint64_t offset,
-                                           uint64_t fragmentSize) {
-    boost::interprocess::mapped_region rightRegion(fmapTarget, boost::interprocess::read_only, offset,
-                                                   fragmentSize);
-    char *rr_ptr = static_cast<char *>(rightRegion.get_address());
-    return std::string(rr_ptr, fragmentSize);
-}
-
-std::string DfsController::extractFragment(boost::interprocess::file_mapping &fmapTarget, uint64_t offset) {
-    boost::interprocess::mapped_region rightRegion(fmapTarget, boost::interprocess::read_only, offset);
-    char *rr_ptr = static_cast<char *>(rightRegion.get_address());
-    return std::string(rr_ptr, rightRegion.get_size());
-}
-
 void DfsController::sendSizeRequestMsg(const ActorId &actorId) const {
     DFSP::RequestDfsSize msg { actorId.toStdString() };
     node.network()->send_message(msg, MessageType::RequestDfsSize, MessageStatus::Request);
@@ -627,7 +714,7 @@ void DfsController::sendSizeRequestMsg(const ActorId &actorId) const {
 
 void DfsController::sendSizeReponseMsg(const DFS::Packets::RequestDfsSize &msg,
                                        const std::string &messageId) const {
-    const auto dfsSize = calculateSizeTaken();
+    const auto dfsSize = sizeTaken();
     DFSP::ResponseDfsSize response { .Actor = msg.Actor, .Size = dfsSize };
     node.network()->send_message(response, MessageType::ResponseDfsSize, MessageStatus::Response, messageId);
 }
@@ -674,6 +761,7 @@ void DfsController::addDirData(const ActorId &actorId, const std::vector<DFSP::D
 
 void DfsController::requestFile(const ActorId &actorId, const std::string &fileName) {
     qDebug() << fileName.c_str();
+    m_fileCache.invalidate(DFS_PATH::filePath(actorId, fileName));
     std::filesystem::remove(DFS_PATH::filePath(actorId, fileName));
     node.network()->send_message(std::pair { actorId, fileName }, MessageType::DfsRequestFile,
                                  MessageStatus::Request);
@@ -702,85 +790,62 @@ void DfsController::sendFile(const ActorId &actorId, const std::string &fileName
 
 std::string DfsController::sendFragment(const DFSP::RequestFileSegmentMessage &msg,
                                         const std::string &messageId) {
-    std::filesystem::path realFilePath = DFS_PATH::filePath(msg.Actor, msg.FileName);
-    if (!std::filesystem::exists(realFilePath)) {
+    const auto mapped = mapFile(msg.Actor, msg.FileName);
+    const MappedFile &file = *mapped;
+    if (!file.isOpen()) {
         return "";
-        qFatal("[Dfs] No file");
-    }
-
-    boost::interprocess::file_mapping fmapTarget(realFilePath.c_str(), boost::interprocess::read_only);
-    std::string data;
-    auto fileSize = std::filesystem::file_size(realFilePath);
-    if (fileSize - msg.Offset > DFSB::sectionSize) {
-        data = extractFragment(fmapTarget, msg.Offset, DFSB::sectionSize);
-    } else {
-        data = extractFragment(fmapTarget, msg.Offset);
     }
 
-    DFSP::SegmentMessage fragment = { .Actor = msg.Actor,
-                                      .FileName = msg.FileName,
-                                      .FileHash = msg.FileHash,
-                                      .Data = std::move(data),
-                                      .Offset = msg.Offset };
+    DFSP::SegmentView fragment = { .Actor = msg.Actor,
+                                   .FileName = msg.FileName,
+                                   .FileHash = msg.FileHash,
+                                   .Data = file.slice(msg.Offset, DFSB::sectionSize),
+                                   .Offset = msg.Offset };
 
-    node.network()->send_message(fragment, MessageType::DfsAddSegment, MessageStatus::Response, messageId,
-                                 Config::Net::TypeSend::Focused);
-    if (msg.Offset + DFSB::sectionSize >= fileSize) {
+    node.network()->send_frame(fragment, MessageType::DfsAddSegment, MessageStatus::Response, messageId,
+                               Config::Net::TypeSend::Focused);
+    sentBytes().inc(fragment.Data.size());
+    if (msg.Offset + DFSB::sectionSize >= file.size()) {
         emit uploaded(msg.Actor, msg.FileName);
         return "";
     }
-    emit uploadProgress(msg.Actor, msg.FileName, double(msg.Offset) / double(fileSize) * 100);
+    emit uploadProgress(msg.Actor, msg.FileName, double(msg.Offset) / double(file.size()) * 100);
     return "";
 }
 
 void DfsController::fetchFragments(DFS::Packets::RequestFileSegmentMessage &msg, std::string &messageId) {
-    std::filesystem::path realFilePath = DFS_PATH::filePath(msg.Actor, msg.FileName);
-    if (!std::filesystem::exists(realFilePath)) {
+    const auto mapped = mapFile(msg.Actor, msg.FileName);
+    const MappedFile &file = *mapped;
+    if (!file.isOpen() || file.size() == 0) {
         return;
     }
 
-    auto fileSize = std::filesystem::file_size(realFilePath);
-    if (fileSize == 0) {
+    // one response per section straight from the mapping, all of them go to the requester,
+    // receiver tells sections of one message id apart by payload
+    const std::string requester = node.network()->requestSocket(messageId);
+    if (requester.empty())
         return;
-    }
-    boost::interprocess::file_mapping fmapTarget(realFilePath.c_str(), boost::interprocess::read_only);
-    std::string data;
-    uint64_t totalOffset = 0;
-    bool lastFragment = false;
-    do {
-        uint64_t limitSectionSize = 0;
-        while (limitSectionSize <= DFSB::maxSectionSize && !lastFragment) {
-            if (fileSize - totalOffset > DFSB::sectionSize) {
-                data += extractFragment(fmapTarget, totalOffset, DFSB::sectionSize);
-                totalOffset += DFSB::sectionSize;
-                limitSectionSize += DFSB::sectionSize;
-                qDebug() << "progress: [" << (double(totalOffset) / double(fileSize) * 100) << "%]";
-                emit uploadProgress(msg.Actor, msg.FileName, double(totalOffset) / double(fileSize) * 100);
-            } else {
-                lastFragment = true;
-                data += extractFragment(fmapTarget, totalOffset);
-            }
-        }
-
-        DFSP::SegmentMessage fragment = { .Actor = msg.Actor,
-                                          .FileName = msg.FileName,
-                                          .FileHash = msg.FileHash,
-                                          .Data = std::move(data),
-                                          .Offset = totalOffset };
-
-        messageId =
-            node.network()->send_message(fragment, MessageType::DfsAddSegment, MessageStatus::Response,
-                                         messageId, Config::Net::TypeSend::Focused);
-
-        if (lastFragment) {
+    for (uint64_t offset = 0; offset < file.size(); offset += DFSB::sectionSize) {
+        DFSP::SegmentView fragment = { .Actor = msg.Actor,
+                                       .FileName = msg.FileName,
+                                       .FileHash = msg.FileHash,
+                                       .Data = file.slice(offset, DFSB::sectionSize),
+                                       .Offset = offset };
+        node.network()->send_frame(fragment, MessageType::DfsAddSegment, MessageStatus::Response, messageId,
+                                   Config::Net::TypeSend::Focused, requester);
+        sentBytes().inc(fragment.Data.size());
+
+        const uint64_t sent = offset + fragment.Data.size();
+        if (sent == file.size()) {
             emit uploaded(msg.Actor, msg.FileName);
             if (std::filesystem::exists(Scripts::folder + "/" + msg.FileName)) {
-                node.network()->send_message(fragment, MessageType::BlockchainCopyScript);
+                // receivers copy the script from their stored file, only names are needed
+                node.network()->send_message(msg, MessageType::BlockchainCopyScript);
             }
         } else {
-            emit uploadProgress(msg.Actor, msg.FileName, double(totalOffset) / double(fileSize) * 100);
+            emit uploadProgress(msg.Actor, msg.FileName, double(sent) / double(file.size()) * 100);
         }
-    } while (!lastFragment);
+    }
 }
 
 void DfsController::verifyFiles(std::vector<DFS::Packets::VerifyFileMessage> &fileList,
@@ -814,6 +879,264 @@ float DfsController::percentVerified(std::vector<DFS::Packets::VerifyFileMessage
     return result;
 }
 
+void DfsController::startDownload(const DFSP::AddFileMessage &msg, const std::string &bitmap) {
+    const std::string key = msg.Actor + msg.FileName;
+    if (m_downloads.count(key))
+        return;
+
+    const std::filesystem::path partPath = DFS_PATH::filePath(msg.Actor, msg.FileName).string() + ".part";
+    {
+        auto change = fileChange(msg.Actor, msg.FileName);
+        if (bitmap.empty() || !std::filesystem::exists(partPath)) {
+            std::ofstream part(partPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        }
+        std::filesystem::resize_file(partPath, msg.Size);
+    }
+
+    auto saveBitmap = [msg](const std::string &bitmap) {
+        DBConnector dirsFile(DFSB::dirsPath);
+        dirsFile.open();
+        dirsFile.replace(DFST::DownloadsFile::TableName,
+                         { { "fileName", msg.FileName },
+                           { "actorId", msg.Actor },
+                           { "fileHash", msg.FileHash },
+                           { "filePath", msg.Path },
+                           { "fileSize", std::to_string(msg.Size) },
+                           { "bitmap", bitmap } });
+    };
+
+    auto download = std::make_unique<DfsDownload>(
+        msg, bitmap,
+        DfsDownload::Storage {
+            .write =
+                [partPath](uint64_t offset, const std::string &data) {
+                    std::fstream part(partPath, std::ios::in | std::ios::out | std::ios::binary);
+                    part.seekp(std::streamoff(offset));
+                    part.write(data.data(), std::streamsize(data.size()));
+                    return bool(part);
+                },
+            .saveBitmap = saveBitmap },
+        DfsDownload::Transport {
+            .requestSegment =
+                [this](const std::string &peer, const DFSP::RequestSegmentMessage &request) {
+                    // without known socket request is broadcast, other nodes skip it by Peer field
+                    auto socket = m_peerSockets.find(peer);
+                    if (socket == m_peerSockets.end())
+                        node.network()->send_message(request, MessageType::DfsRequestSegment,
+                                                     MessageStatus::Request);
+                    else
+                        node.network()->send_message(request, MessageType::DfsRequestSegment,
+                                                     MessageStatus::Request, "",
+                                                     Config::Net::TypeSend::Focused, socket->second);
+                } });
+    saveBitmap(download->bitmap());
+
+    const bool complete = download->isComplete();
+    m_downloads[key] = std::move(download);
+    downloads().set(int64_t(m_downloads.size()));
+    if (complete) {
+        finishDownload(key);
+        return;
+    }
+
+    DFSP::FindFileMessage find = { .Actor = msg.Actor, .FileName = msg.FileName, .Size = 0 };
+    node.network()->send_message(find, MessageType::DfsFindFile, MessageStatus::Request);
+    node.network()->send_message(find, MessageType::DfsManifest, MessageStatus::Request);
+}
+
+void DfsController::sendFileSource(const DFSP::FindFileMessage &msg, const std::string &messageId) {
+    if (m_downloads.count(msg.Actor + msg.FileName))
+        return;
+
+    const std::filesystem::path realFilePath = DFS_PATH::filePath(msg.Actor, msg.FileName);
+    if (!std::filesystem::exists(realFilePath))
+        return;
+
+    const auto dirRow = DFST::ActorDirFile::getDirRow(msg.Actor, msg.FileName);
+    const auto fileSize = std::filesystem::file_size(realFilePath);
+    if (fileSize != dirRow.fileSize)
+        return;
+
+    DFSP::FindFileMessage response = { .Actor = msg.Actor, .FileName = msg.FileName, .Size = fileSize };
+    node.network()->send_message(response, MessageType::DfsFindFile, MessageStatus::Response, messageId,
+                                 Config::Net::TypeSend::Focused);
+}
+
+void DfsController::addDownloadPeer(const ActorId &peer, const DFSP::FindFileMessage &msg,
+                                    const std::string &identifier) {
+    auto download = m_downloads.find(msg.Actor + msg.FileName);
+    if (download == m_downloads.end() || download->second->file().Size != msg.Size)
+        return;
+    qDebug() << "[Dfs] Peer" << peer << "has file" << msg.FileName.c_str();
+    if (!identifier.empty())
+        m_peerSockets[peer.toStdString()] = identifier;
+    download->second->addPeer(peer.toStdString());
+}
+
+void DfsController::sendManifest(const DFSP::FindFileMessage &msg, const std::string &messageId) {
+    if (m_downloads.count(msg.Actor + msg.FileName))
+        return;
+
+    const std::filesystem::path realFilePath = DFS_PATH::filePath(msg.Actor, msg.FileName);
+    if (!std::filesystem::exists(realFilePath))
+        return;
+    const auto dirRow = DFST::ActorDirFile::getDirRow(msg.Actor, msg.FileName);
+    if (std::filesystem::file_size(realFilePath) != dirRow.fileSize
+        || dirRow.fileSize > ChunkStore::MAX_MANIFEST_CHUNKS * Chunker::AVG_SIZE)
+        return;
+
+    DFSP::ManifestMessage response = { .Actor = msg.Actor,
+                                       .FileName = msg.FileName,
+                                       .Chunks = m_chunks.manifest(msg.Actor, msg.FileName) };
+    if (response.Chunks.empty() || response.Chunks.size() > ChunkStore::MAX_MANIFEST_CHUNKS)
+        return;
+    node.network()->send_message(response, MessageType::DfsManifest, MessageStatus::Response, messageId,
+                                 Config::Net::TypeSend::Focused);
+}
+
+void DfsController::applyManifest(const DFSP::ManifestMessage &msg) {
+    const std::string key = msg.Actor + msg.FileName;
+    auto download = m_downloads.find(key);
+    if (download == m_downloads.end() || m_manifests.count(key)
+        || msg.Chunks.size() > ChunkStore::MAX_MANIFEST_CHUNKS)
+        return;
+
+    uint64_t size = 0;
+    for (const auto &chunk : msg.Chunks)
+        size += chunk.Size;
+    if (size != download->second->file().Size)
+        return;
+    m_manifests.insert(key);
+
+    // wrong manifest only costs a download restart, whole file hash is checked at the end
+    const std::filesystem::path partPath = DFS_PATH::filePath(msg.Actor, msg.FileName).string() + ".part";
+    const auto ranges = m_chunks.copyLocal(msg.Chunks, partPath);
+    uint64_t local = 0;
+    for (const auto &[offset, length] : ranges)
+        local += length;
+    const uint64_t segments = download->second->addLocalRanges(ranges);
+    qDebug() << "[Dfs] Manifest of" << msg.FileName.c_str() << ":" << local << "of" << size
+             << "bytes are local," << segments << "segments skipped";
+
+    if (segments == 0)
+        return;
+    emit downloadProgress(msg.Actor, msg.FileName, download->second->progress());
+    if (download->second->isComplete())
+        finishDownload(key);
+}
+
+void DfsController::sendSegment(const DFSP::RequestSegmentMessage &msg, const std::string &messageId) {
+    if (msg.Peer != node.accountController()->mainActor().id().toStdString())
+        return;
+    if (msg.Size == 0 || msg.Size > DFSB::sectionSize)
+        return;
+
+    const auto mapped = mapFile(msg.Actor, msg.FileName);
+    const MappedFile &file = *mapped;
+    if (!file.isOpen() || msg.Offset >= file.size())
+        return;
+
+    DFSP::SegmentView segment = { .Actor = msg.Actor,
+                                  .FileName = msg.FileName,
+                                  .FileHash = "",
+                                  .Data = file.slice(msg.Offset, msg.Size),
+                                  .Offset = msg.Offset };
+    node.network()->send_frame(segment, MessageType::DfsSegment, MessageStatus::Response, messageId,
+                               Config::Net::TypeSend::Focused);
+    sentBytes().inc(segment.Data.size());
+}
+
+void DfsController::handleSegment(const ActorId &peer, const DFSP::SegmentMessage &msg) {
+    receivedBytes().inc(msg.Data.size());
+    const std::string key = msg.Actor + msg.FileName;
+    auto download = m_downloads.find(key);
+    if (download == m_downloads.end())
+        return;
+
+    if (!download->second->handleSegment(peer.toStdString(), msg))
+        return;
+
+    emit downloadProgress(msg.Actor, msg.FileName, download->second->progress());
+    if (download->second->isComplete())
+        finishDownload(key);
+}
+
+void DfsController::resumeDownloads() {
+    DBConnector dirsFile(DFSB::dirsPath);
+    dirsFile.open();
+    auto rows = dirsFile.select("SELECT * FROM " + DFST::DownloadsFile::TableName + ";");
+    dirsFile.close();
+
+    for (auto &row : rows) {
+        DFSP::AddFileMessage msg = { .Actor = row["actorId"],
+                                     .FileName = row["fileName"],
+                                     .FileHash = row["fileHash"],
+                                     .Path = row["filePath"],
+                                     .Size = std::stoull(row["fileSize"]) };
+        qDebug() << "[Dfs] Resume download" << msg.FileName.c_str();
+        startDownload(msg, row["bitmap"]);
+    }
+}
+
+void DfsController::finishDownload(const std::string &key) {
+    auto download = m_downloads.find(key);
+    if (download == m_downloads.end() || !m_verifying.insert(key).second)
+        return;
+    const DFSP::AddFileMessage &msg = download->second->file();
+    const std::filesystem::path partPath = DFS_PATH::filePath(msg.Actor, msg.FileName).string() + ".part";
+    // hashing large file would stall the controller thread
+    ThreadPool::instance().submit(
+        [partPath] { return Utils::calcHashForFile(partPath); }, this,
+        [this, key](const std::string &fileHash) { completeDownload(key, fileHash); });
+}
+
+void DfsController::completeDownload(const std::string &key, const std::string &fileHash) {
+    m_verifying.erase(key);
+    auto download = m_downloads.find(key);
+    if (download == m_downloads.end())
+        return;
+    const DFSP::AddFileMessage msg = download->second->file();
+    m_downloads.erase(download);
+    m_manifests.erase(key);
+    downloads().set(int64_t(m_downloads.size()));
+
+    DBConnector dirsFile(DFSB::dirsPath);
+    dirsFile.open();
+    dirsFile.deleteRow(DFST::DownloadsFile::TableName, { { "fileName", msg.FileName } });
+    dirsFile.close();
+
+    const std::filesystem::path realFilePath = DFS_PATH::filePath(msg.Actor, msg.FileName);
+    const std::filesystem::path partPath = realFilePath.string() + ".part";
+    if (fileHash != msg.FileHash) {
+        qWarning() << "[Dfs] Incorrect hash of downloaded file" << msg.FileName.c_str() << ", restart";
+        auto change = fileChange(msg.Actor, msg.FileName);
+        std::filesystem::remove(partPath);
+        if (msg.Size > 0)
+            startDownload(msg);
+        return;
+    }
+
+    {
+        auto change = fileChange(msg.Actor, msg.FileName);
+        std::filesystem::rename(partPath, realFilePath);
+        m_chunks.addFile(msg.Actor, msg.FileName);
+        FragmentStorage fs(msg.Actor, msg.FileName, msg.FileHash);
+        fs.initLocalFile(msg.Size);
+        fs.initHistoricalChain();
+        change.add({ .stored = fs.storedChange() });
+    }
+    files.erase(key);
+
+    qDebug() << "[Dfs] File" << realFilePath.c_str() << "done";
+    emit downloaded(msg.Actor, msg.FileName);
+    sendFile(msg.Actor, msg.FileName); // temp
+}
+
+void DfsController::checkDownloads() {
+    for (auto &[key, download] : m_downloads)
+        download->checkTimeouts();
+}
+
 std::string DfsController::addFragment(const DFSP::SegmentMessage &msg) {
     auto fileName = DFS_PATH::filePath(msg.Actor, msg.FileName);
     if (!std::filesystem::exists(fileName)
@@ -838,8 +1161,10 @@ std::string DfsController::addFragment(const DFSP::SegmentMessage &msg) {
         return "";
     }
 
+    auto change = fileChange(msg.Actor, msg.FileName);
     FragmentStorage fs(msg);
     fs.insertFragment(msg);
+    change.add({ .stored = fs.storedChange() });
     currentFileSize = std::filesystem::file_size(fileName);
     //    emit downloadProgress(msg.Actor, msg.FileName, double(msg.Offset) / double(fileSize) * 100);
     if (fileSize == currentFileSize) {
@@ -860,21 +1185,45 @@ std::string DfsController::addFragment(const DFSP::SegmentMessage &msg) {
 }
 
 void DfsController::threadAddFragment(const DFS::Packets::SegmentMessage &msg) {
-    qDebug() << "add segment. Thread: [" << QThread::currentThreadId() << "]";
-    FragmentWriter fw(msg, m_compliteFiles);
-
-    connect(&fw, &FragmentWriter::downloadProgress, this, &DfsController::downloadProgress);
-    connect(&fw, &FragmentWriter::eraseFromFiles, this,
-            [=](DFSP::SegmentMessage msg) { files.erase(msg.Actor + msg.FileName); });
-    connect(&fw, &FragmentWriter::requestFile, this, &DfsController::requestFile);
-    connect(&fw, &FragmentWriter::sendFile, this,
-            [&](const std::string &actorId, const std::string &fileName) { sendFile(actorId, fileName); });
-    connect(&fw, &FragmentWriter::downloadedFile, this, &DfsController::downloaded);
-    connect(&fw, &FragmentWriter::compliteFile, this,
-            [&](const std::string &fileName) { m_compliteFiles.push_back(fileName); });
+    // fragments of one file are written in order, different files in parallel
+    const std::string key = msg.Actor + msg.FileName;
+    receivedBytes().inc(msg.Data.size());
+    fragmentQueue().add(1);
+    auto &queue = m_fragmentQueues[key];
+    queue.push_back(msg);
+    if (queue.size() == 1)
+        startFragmentWriter(key);
+}
 
-    fw.start();
-    fw.wait();
+void DfsController::startFragmentWriter(const std::string &key) {
+    const DFSP::SegmentMessage msg = m_fragmentQueues[key].front();
+    auto *fw = new FragmentWriter(msg, m_compliteFiles);
+    m_fileCache.invalidate(DFS_PATH::filePath(msg.Actor, msg.FileName));
+    auto change =
+        std::make_shared<DfsCounters::Change>(m_counters, msg.Actor, filePaths(msg.Actor, msg.FileName));
+
+    connect(fw, &FragmentWriter::downloadProgress, this, &DfsController::downloadProgress);
+    connect(fw, &FragmentWriter::eraseFromFiles, this,
+            [this](DFSP::SegmentMessage msg) { files.erase(msg.Actor + msg.FileName); });
+    connect(fw, &FragmentWriter::requestFile, this, &DfsController::requestFile);
+    connect(fw, &FragmentWriter::sendFile, this,
+            [this](const std::string &actorId, const std::string &fileName) { sendFile(actorId, fileName); });
+    connect(fw, &FragmentWriter::downloadedFile, this, &DfsController::downloaded);
+    connect(fw, &FragmentWriter::compliteFile, this,
+            [this](const std::string &fileName) { m_compliteFiles.push_back(fileName); });
+    ThreadPool::instance().submit([fw] { fw->run(); }, this, [this, fw, key, change] {
+        change->add({ .stored = fw->storedChange() });
+        change->apply();
+        fw->deleteLater();
+
+        auto &queue = m_fragmentQueues[key];
+        queue.pop_front();
+        fragmentQueue().add(-1);
+        if (queue.empty())
+            m_fragmentQueues.erase(key);
+        else
+            startFragmentWriter(key);
+    });
 }
 
 std::string DfsController::deleteFragment(const DFSP::DeleteSegmentMessage &msg) {
@@ -899,6 +1248,10 @@ std::string DfsController::deleteFragment(const DFSP::DeleteSegmentMessage &msg)
         qFatal("Error 1");
         return "";
     }
+    m_fileCache.invalidate(realFilePath);
+    auto change = m_counters.change(
+        msg.Actor, { realFilePath, DFS_PATH::filePath(msg.Actor, msg.FileName).string() + DFSF::Extension });
+    m_chunks.removeFile(msg.Actor, msg.FileHash);
     removeDataChunk(msg.Offset, msg.Size, realFilePath);
     std::string newFileHash = Utils::calcHashForFile(realFilePath.string());
     // uint64_t newFileSize = std::filesystem::file_size(realFilePath);
@@ -923,6 +1276,7 @@ std::string DfsController::deleteFragment(const DFSP::DeleteSegmentMessage &msg)
 
     FragmentStorage fragmentStorage(msg.Actor, msg.FileName, msg.FileHash);
     fragmentStorage.removeFragment(msg);
+    change.add({ .stored = fragmentStorage.storedChange() });
 
     return newFileHash;
 }
@@ -957,7 +1311,8 @@ DFSP::AddFileMessage DfsController::getFileHeader(const ActorId actor, const std
 }
 
 uint64_t DfsController::bytesAvailable() {
-    auto freeDfs = m_bytesLimit <= m_sizeTaken ? 0 : m_bytesLimit - m_sizeTaken;
+    const auto taken = sizeTaken();
+    auto freeDfs = m_bytesLimit <= taken ? 0 : m_bytesLimit - taken;
     uint64_t freeDisk = Utils::diskFreeMemory();
     auto min = m_bytesLimit == 0 ? freeDisk : std::min(freeDfs, freeDisk);
     return min;
@@ -966,156 +1321,3 @@ uint64_t DfsController::bytesAvailable() {
 bool DfsController::writeAvailable(uint64_t size) {
     return bytesAvailable() > size + 10000;
 }
-
-ThreadAddFiles::ThreadAddFiles(DfsController *dfsController, const Actor<KeyPrivate> &actor,
-                               const QStringList &files, QObject *parent)
-    : QThread(parent)
-    , m_dfsController(dfsController)
-    , m_actor(actor)
-    , m_files(files) {
-    connect(this, &ThreadAddFiles::finished, this, &ThreadAddFiles::deleteLater);
-}
-
-ThreadAddFiles::~ThreadAddFiles() {
-    qDebug() << "run destructor for thread add files";
-}
-
-void ThreadAddFiles::run() {
-    qDebug() << "Run function in thread: " << QThread::currentThreadId();
-    for (const auto &fileName : m_files) {
-        addFile(m_actor, fileName.toStdWString(), QFileInfo(fileName).fileName().toStdString());
-    }
-}
-
-void ThreadAddFiles::addFile(const Actor<KeyPrivate> &actor, const std::filesystem::path &filePath,
-                             std::string targetVirtualFilePath) {
-    std::filesystem::path fpath = DFS_PATH::convertPathToPlatform(filePath);
-    std::filesystem::path newFilePath = fpath;
-    std::string newTargetVirtualFilePath = targetVirtualFilePath;
-
-#ifdef ANDROID
-    auto tempPath = "dfs/temp"
-        + QString::number(QRandomGenerator::global()->bounded(1000) + QDateTime::currentMSecsSinceEpoch());
-    QFile::copy(newFilePath.string().c_str(), tempPath);
-    fpath = tempPath.toStdString();
-    newFilePath = fpath;
-#endif
-
-    if (!std::filesystem::exists(newFilePath)) {
-        qInfo() << "[Dfs] Can't load file";
-        emit error("ErrorNotExists", filePath.string());
-        return;
-    }
-
-    if (!std::filesystem::is_regular_file(newFilePath)) {
-        qInfo() << "[Dfs] This is not a file";
-        emit error("ErrorNotFile", filePath.string());
-        return;
-    }
-
-    std::ifstream my_file(newFilePath);
-    if (!my_file) {
-        qDebug() << "Can't read";
-        emit error("ErrorNotReadable", filePath.string());
-        return;
-    }
-    my_file.close();
-
-    auto fileSize = std::filesystem::file_size(newFilePath);
-    if (!m_dfsController->writeAvailable(fileSize)) {
-        emit error("ErrorStorageFull", filePath.string());
-        return;
-    }
-
-    std::string fileName = m_dfsController->createFileName(filePath);
-    std::string fileHash = Utils::calcHashForFile(newFilePath);
-    std::filesystem::path placeInDFS =
-        DFSB::fsActrRootW + DFSB::separator + actor.id().toString().toStdWString() + DFSB::separator;
-    std::filesystem::path dfsPath = DFS_PATH::filePath(actor.id(), fileName);
-
-    if (std::filesystem::exists(dfsPath) && std::filesystem::file_size(dfsPath) == fileSize) {
-        std::string dfsFileHash = Utils::calcHashForFile(dfsPath);
-        if (fileHash == dfsFileHash) {
-            qDebug() << "[DFS] File already in DFS";
-            emit error("ErrorAlreadyExists", filePath.string());
-            return;
-        }
-    }
-
-    try {
-        std::filesystem::create_directories(placeInDFS.c_str());
-#ifdef ANDROID
-        std::filesystem::rename(newFilePath, dfsPath);
-#else
-        std::filesystem::copy(newFilePath, dfsPath);
-#endif
-    } catch (std::filesystem::filesystem_error const &err) {
-        qDebug() << "[Dfs] Copy error:" << err.what();
-    }
-
-    const auto actorId = actor.id().toStdString();
-    DFSP::AddFileMessage msg = { .Actor = actorId,
-                                 .FileName = fileName,
-                                 .FileHash = fileHash,
-                                 .Path = newTargetVirtualFilePath,
-                                 .Size = fileSize };
-
-    auto actrDirFile = DFST::ActorDirFile::actorDbConnector(actorId);
-    auto lastFileName = DFST::ActorDirFile::getLastName(actrDirFile);
-    const DBRow rowData =
-        m_dfsController->makeActrDirDBRow(msg.FileName, lastFileName, msg.FileHash, msg.Path, msg.Size);
-
-    if (!actrDirFile.insert(DFST::ActorDirFile::TableName, rowData)) {
-        qDebug() << "[Dfs] addFile: insert failed:" << actrDirFile.file().c_str() << " :"
-                 << DFST::ActorDirFile::TableName.c_str();
-        qFatal("Insert failed");
-        emit error("ErrorDirError", filePath.string());
-        return;
-    }
-
-    actrDirFile.close();
-    m_dfsController->increaseSizeTaken(fileSize);
-    DBConnector dirsFile(DFSB::dirsPath);
-    dirsFile.open();
-    dirsFile.replace(DFST::DirsFile::TableName,
-                     { { "actorId", actorId }, { "lastModified", rowData.at("lastModified") } });
-    dirsFile.close();
-    auto dirRow = DFST::ActorDirFile::getDirRow(actorId, fileName);
-
-    emit sendMessage(msg, MessageType::DfsAddFile);
-
-    std::string pathDelim = Utils::platformDelimeter();
-    std::string actrDirFilePath = DFSB::fsActrRoot + pathDelim + msg.Actor + pathDelim + DFSB::fsMapName;
-    std::string realFilePath = DFSB::fsActrRoot + pathDelim + msg.Actor + pathDelim + msg.FileName;
-
-    DBConnector actrDirPathFile(actrDirFilePath);
-
-    if (!actrDirPathFile.open()) {
-        exit(EXIT_FAILURE);
-    }
-
-    auto result = actrDirPathFile.select(DFST::filesTableLast);
-
-    if (!actrDirPathFile.insert(DFST::ActorDirFile::TableName, rowData)) {
-        qDebug() << "[Dfs] addFile: insert failed:" << actrDirPathFile.file().c_str() << " :"
-                 << DFST::ActorDirFile::TableName.c_str();
-        qFatal("Error 2");
-        return;
-    }
-    actrDirPathFile.close();
-    dirsFile.open();
-    dirsFile.replace(DFST::DirsFile::TableName,
-                     { { "actorId", msg.Actor }, { "lastModified", rowData.at("lastModified") } });
-
-    FragmentStorage fs(actor.id(), fileName, fileHash);
-    fs.initLocalFile(fileSize);
-    fs.initHistoricalChain();
-
-    //    const bool isScript = filePath.extension() == Scripts::wasmExtention;
-    //    std::string scriptPath = "";
-    //    if (isScript) {
-    //        scriptPath = Scripts::folder + "/" + fileName;
-    //        std::filesystem::copy(filePath, scriptPath);
-    //    };
-    emit added(msg, filePath.string());
-}
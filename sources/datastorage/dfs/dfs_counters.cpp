@@ -0,0 +1,114 @@
+#include "datastorage/dfs/dfs_counters.h"
+
+DfsCounters::Sizes &DfsCounters::Sizes::operator+=(const Sizes &sizes) {
+    disk += sizes.disk;
+    files += sizes.files;
+    stored += sizes.stored;
+    return *this;
+}
+
+DfsCounters::Change::Change(DfsCounters &counters, const std::string &actorId,
+                            const std::vector<std::filesystem::path> &paths)
+    : m_counters(counters)
+    , m_actorId(actorId) {
+    for (const auto &path : paths)
+        m_paths.emplace_back(path, diskSize(path));
+}
+
+DfsCounters::Change::~Change() {
+    apply();
+}
+
+void DfsCounters::Change::add(const Sizes &delta) {
+    m_delta += delta;
+}
+
+void DfsCounters::Change::apply() {
+    for (const auto &[path, size] : m_paths)
+        m_delta.disk += diskSize(path) - size;
+    if (m_delta != Sizes())
+        m_counters.add(m_actorId, m_delta);
+    m_paths.clear();
+    m_delta = Sizes();
+}
+
+DfsCounters::DfsCounters(const std::string &dbPath)
+    : m_dbPath(dbPath) {
+}
+
+bool DfsCounters::load() {
+    std::lock_guard lock(m_mutex);
+    DBConnector db(m_dbPath);
+    db.open();
+    if (!db.tableExists(DFST::SizesFile::TableName)) {
+        db.query(DFST::SizesFile::CreateTableQuery);
+        return false;
+    }
+
+    m_actors.clear();
+    m_total = Sizes();
+    for (auto &row : db.select("SELECT * FROM " + DFST::SizesFile::TableName + ";")) {
+        Sizes sizes = { .disk = std::stoll(row["disk"]),
+                        .files = std::stoll(row["files"]),
+                        .stored = std::stoll(row["stored"]) };
+        m_actors[row["actorId"]] = sizes;
+        m_total += sizes;
+    }
+    return true;
+}
+
+void DfsCounters::reset(const std::map<std::string, Sizes> &actors) {
+    std::lock_guard lock(m_mutex);
+    DBConnector db(m_dbPath);
+    db.open();
+    db.query(DFST::SizesFile::CreateTableQuery);
+    db.query("DELETE FROM " + DFST::SizesFile::TableName + ";");
+
+    m_actors = actors;
+    m_total = Sizes();
+    for (const auto &[actorId, sizes] : m_actors) {
+        m_total += sizes;
+        save(db, actorId, sizes);
+    }
+}
+
+void DfsCounters::add(const std::string &actorId, const Sizes &delta) {
+    std::lock_guard lock(m_mutex);
+    auto &sizes = m_actors[actorId];
+    sizes += delta;
+    m_total += delta;
+
+    DBConnector db(m_dbPath);
+    db.open();
+    save(db, actorId, sizes);
+}
+
+DfsCounters::Change DfsCounters::change(const std::string &actorId,
+                                        const std::vector<std::filesystem::path> &paths) {
+    return Change(*this, actorId, paths);
+}
+
+DfsCounters::Sizes DfsCounters::actor(const std::string &actorId) const {
+    std::lock_guard lock(m_mutex);
+    auto it = m_actors.find(actorId);
+    return it == m_actors.end() ? Sizes() : it->second;
+}
+
+DfsCounters::Sizes DfsCounters::total() const {
+    std::lock_guard lock(m_mutex);
+    return m_total;
+}
+
+int64_t DfsCounters::diskSize(const std::filesystem::path &path) {
+    std::error_code error;
+    const auto size = std::filesystem::file_size(path, error);
+    return error ? 0 : int64_t(size);
+}
+
+void DfsCounters::save(DBConnector &db, const std::string &actorId, const Sizes &sizes) {
+    db.replace(DFST::SizesFile::TableName,
+               { { "actorId", actorId },
+                 { "disk", std::to_string(sizes.disk) },
+                 { "files", std::to_string(sizes.files) },
+                 { "stored", std::to_string(sizes.stored) } });
+}
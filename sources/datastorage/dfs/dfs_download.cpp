@@ -0,0 +1,278 @@
+#include "datastorage/dfs/dfs_download.h"
+
+#include <algorithm>
+#include <tuple>
+
+DfsDownload::DfsDownload(const DFSP::AddFileMessage &file, const std::string &bitmap, Storage storage,
+                         Transport transport, uint64_t segmentSize)
+    : m_file(file)
+    , m_segmentSize(std::max<uint64_t>(segmentSize, 1))
+    , m_storage(std::move(storage))
+    , m_transport(std::move(transport)) {
+    const uint64_t count = (m_file.Size + m_segmentSize - 1) / m_segmentSize;
+    m_done.assign(count, false);
+
+    if (bitmap.size() == (count + 7) / 8) {
+        for (uint64_t i = 0; i < count; i++) {
+            if (uint8_t(bitmap[i / 8]) & (1 << (i % 8))) {
+                m_done[i] = true;
+                m_doneCount++;
+            }
+        }
+    }
+}
+
+void DfsDownload::addPeer(const std::string &peer, Clock::time_point now) {
+    std::lock_guard lock(m_mutex);
+    if (m_peers.count(peer))
+        return;
+    m_peers[peer] = Peer();
+    schedule(now);
+}
+
+void DfsDownload::removePeer(const std::string &peer, Clock::time_point now) {
+    std::lock_guard lock(m_mutex);
+    for (auto it = m_inFlight.begin(); it != m_inFlight.end();) {
+        auto &requests = it->second;
+        std::erase_if(requests, [&peer](const Request &request) { return request.peer == peer; });
+        if (requests.empty()) {
+            m_cursor = std::min(m_cursor, it->first);
+            it = m_inFlight.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_peers.erase(peer);
+    schedule(now);
+}
+
+bool DfsDownload::handleSegment(const std::string &peer, const DFSP::SegmentMessage &segment,
+                                Clock::time_point now) {
+    std::lock_guard lock(m_mutex);
+    if (segment.Actor != m_file.Actor || segment.FileName != m_file.FileName
+        || segment.Offset % m_segmentSize != 0)
+        return false;
+
+    const uint64_t index = segment.Offset / m_segmentSize;
+    auto inFlight = m_inFlight.find(index);
+    if (index >= m_done.size() || inFlight == m_inFlight.end())
+        return false;
+
+    auto &requests = inFlight->second;
+    auto request = std::find_if(requests.begin(), requests.end(),
+                                [&peer](const Request &request) { return request.peer == peer; });
+    if (request == requests.end())
+        return false;
+    const bool inTime = now - request->sent < SEGMENT_TIMEOUT;
+    requests.erase(request);
+    m_peers[peer].inFlight--;
+
+    if (segment.Data.size() != segmentLength(index) || !m_storage.write(segment.Offset, segment.Data)) {
+        qDebug() << "[DfsDownload] Bad segment" << index << "from" << peer.c_str();
+        m_peers[peer].timeouts++;
+        shrink(m_peers[peer]);
+        if (requests.empty()) {
+            m_inFlight.erase(inFlight);
+            m_cursor = std::min(m_cursor, index);
+        }
+        schedule(now);
+        return false;
+    }
+
+    m_done[index] = true;
+    m_doneCount++;
+    m_peers[peer].received++;
+    if (inTime)
+        grow(m_peers[peer]);
+    releaseRequests(index);
+    if (++m_unsaved >= BITMAP_BATCH)
+        flushBitmap();
+
+    schedule(now);
+    return true;
+}
+
+void DfsDownload::checkTimeouts(Clock::time_point now) {
+    std::lock_guard lock(m_mutex);
+    for (auto it = m_inFlight.begin(); it != m_inFlight.end();) {
+        auto &requests = it->second;
+        std::erase_if(requests, [this, now](const Request &request) {
+            if (now - request.sent < SEGMENT_TIMEOUT)
+                return false;
+            auto &peer = m_peers[request.peer];
+            peer.inFlight--;
+            peer.timeouts++;
+            shrink(peer);
+            return true;
+        });
+
+        if (requests.empty()) {
+            m_cursor = std::min(m_cursor, it->first);
+            m_retried++;
+            it = m_inFlight.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    flushBitmap();
+    schedule(now);
+}
+
+void DfsDownload::flushBitmap() {
+    std::lock_guard lock(m_mutex);
+    if (m_unsaved == 0 || !m_storage.saveBitmap)
+        return;
+    m_storage.saveBitmap(bitmap());
+    m_unsaved = 0;
+}
+
+uint64_t DfsDownload::addLocalRanges(const std::vector<std::pair<uint64_t, uint64_t>> &ranges) {
+    std::lock_guard lock(m_mutex);
+    uint64_t marked = 0;
+    for (const auto &[offset, size] : ranges) {
+        const uint64_t end = std::min(offset + size, m_file.Size);
+        for (uint64_t index = (offset + m_segmentSize - 1) / m_segmentSize;
+             index < m_done.size() && index * m_segmentSize + segmentLength(index) <= end; index++) {
+            if (m_done[index])
+                continue;
+            m_done[index] = true;
+            m_doneCount++;
+            releaseRequests(index);
+            marked++;
+        }
+    }
+    m_unsaved += marked;
+    flushBitmap();
+    // windows of peers could be freed
+    schedule(Clock::now());
+    return marked;
+}
+
+const DFSP::AddFileMessage &DfsDownload::file() const {
+    return m_file;
+}
+
+bool DfsDownload::isComplete() const {
+    std::lock_guard lock(m_mutex);
+    return m_doneCount == m_done.size();
+}
+
+int DfsDownload::progress() const {
+    std::lock_guard lock(m_mutex);
+    return m_done.empty() ? 100 : int(m_doneCount * 100 / m_done.size());
+}
+
+uint64_t DfsDownload::segmentCount() const {
+    return m_done.size();
+}
+
+uint64_t DfsDownload::segmentsDone() const {
+    std::lock_guard lock(m_mutex);
+    return m_doneCount;
+}
+
+uint64_t DfsDownload::retried() const {
+    std::lock_guard lock(m_mutex);
+    return m_retried;
+}
+
+uint32_t DfsDownload::window(const std::string &peer) const {
+    std::lock_guard lock(m_mutex);
+    auto it = m_peers.find(peer);
+    return it == m_peers.end() ? 0 : it->second.window;
+}
+
+std::string DfsDownload::bitmap() const {
+    std::lock_guard lock(m_mutex);
+    std::string bitmap((m_done.size() + 7) / 8, '\0');
+    for (uint64_t i = 0; i < m_done.size(); i++)
+        if (m_done[i])
+            bitmap[i / 8] = char(uint8_t(bitmap[i / 8]) | (1 << (i % 8)));
+    return bitmap;
+}
+
+void DfsDownload::schedule(Clock::time_point now) {
+    if (m_peers.empty() || m_doneCount == m_done.size())
+        return;
+
+    // healthy and less loaded peers take segments first
+    std::vector<std::string> peers;
+    for (const auto &[id, peer] : m_peers)
+        peers.push_back(id);
+    std::sort(peers.begin(), peers.end(), [this](const std::string &a, const std::string &b) {
+        const Peer &l = m_peers[a], &r = m_peers[b];
+        return std::tie(l.timeouts, l.inFlight) < std::tie(r.timeouts, r.inFlight);
+    });
+
+    bool requested = true;
+    while (requested) {
+        requested = false;
+        for (const auto &id : peers) {
+            if (m_peers[id].inFlight >= m_peers[id].window)
+                continue;
+            if (auto segment = nextSegment(id)) {
+                sendRequest(*segment, id, now);
+                requested = true;
+            }
+        }
+    }
+}
+
+std::optional<uint64_t> DfsDownload::nextSegment(const std::string &peer) {
+    while (m_cursor < m_done.size() && (m_done[m_cursor] || m_inFlight.count(m_cursor)))
+        m_cursor++;
+    if (m_cursor < m_done.size())
+        return m_cursor;
+
+    // end of file: duplicate the oldest single request to another peer
+    std::optional<uint64_t> oldest;
+    Clock::time_point oldestSent = Clock::time_point::max();
+    for (const auto &[segment, requests] : m_inFlight) {
+        if (requests.size() == 1 && requests.front().peer != peer && requests.front().sent < oldestSent) {
+            oldest = segment;
+            oldestSent = requests.front().sent;
+        }
+    }
+    if (oldest)
+        m_retried++;
+    return oldest;
+}
+
+void DfsDownload::sendRequest(uint64_t segment, const std::string &peer, Clock::time_point now) {
+    m_inFlight[segment].push_back({ .peer = peer, .sent = now });
+    m_peers[peer].inFlight++;
+
+    DFSP::RequestSegmentMessage request = { .Peer = peer,
+                                            .Actor = m_file.Actor,
+                                            .FileName = m_file.FileName,
+                                            .Offset = segment * m_segmentSize,
+                                            .Size = segmentLength(segment) };
+    m_transport.requestSegment(peer, request);
+}
+
+void DfsDownload::releaseRequests(uint64_t segment) {
+    auto it = m_inFlight.find(segment);
+    if (it == m_inFlight.end())
+        return;
+    for (const auto &request : it->second)
+        m_peers[request.peer].inFlight--;
+    m_inFlight.erase(it);
+}
+
+void DfsDownload::grow(Peer &peer) {
+    // one more segment after a whole window is received in time
+    if (++peer.inTime < peer.window)
+        return;
+    if (peer.window < MAX_PEER_WINDOW)
+        peer.window++;
+    peer.inTime = 0;
+}
+
+void DfsDownload::shrink(Peer &peer) {
+    peer.window = std::max<uint32_t>(1, peer.window / 2);
+    peer.inTime = 0;
+}
+
+uint64_t DfsDownload::segmentLength(uint64_t segment) const {
+    return std::min(m_segmentSize, m_file.Size - segment * m_segmentSize);
+}
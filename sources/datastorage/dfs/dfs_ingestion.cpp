@@ -0,0 +1,120 @@
+#include "datastorage/dfs/dfs_ingestion.h"
+
+#include "utils/metrics.h"
+
+namespace {
+Metrics::Gauge &inProgressGauge() {
+    static auto &gauge = Metrics::gauge("extrachain_dfs_ingestion_in_progress", "Files being ingested");
+    return gauge;
+}
+}
+
+DfsIngestion::DfsIngestion(Handlers handlers, ThreadPool *pool, QObject *parent)
+    : QObject(parent)
+    , m_handlers(std::move(handlers))
+    , m_pool(pool) {
+    const int threads = int(m_pool->size());
+    m_limits = { threads, threads, threads, 1, 1 };
+}
+
+DfsIngestion::~DfsIngestion() {
+    std::deque<Entry> cancelled;
+    {
+        std::lock_guard lock(m_mutex);
+        cancelled.swap(m_queues[Copy]);
+        m_inProgress -= cancelled.size();
+        inProgressGauge().add(-int64_t(cancelled.size()));
+    }
+    for (auto &entry : cancelled) {
+        entry.item.error = "ErrorCancelled";
+        entry.promise->addResult(entry.item);
+        entry.promise->finish();
+    }
+
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this] { return m_inProgress == 0; });
+}
+
+QFuture<DfsIngestion::Item> DfsIngestion::add(Item item) {
+    Entry entry = { .item = std::move(item), .promise = std::make_shared<QPromise<Item>>() };
+    entry.promise->start();
+    auto future = entry.promise->future();
+    {
+        std::lock_guard lock(m_mutex);
+        entry.item.id = m_nextId++;
+        m_inProgress++;
+        inProgressGauge().add(1);
+        m_queues[Copy].push_back(std::move(entry));
+    }
+    schedule();
+    return future;
+}
+
+void DfsIngestion::waitForDone() {
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this] { return m_inProgress == 0; });
+}
+
+uint64_t DfsIngestion::inProgress() const {
+    std::lock_guard lock(m_mutex);
+    return m_inProgress;
+}
+
+std::size_t DfsIngestion::peakQueued() const {
+    std::lock_guard lock(m_mutex);
+    return m_peakQueued;
+}
+
+void DfsIngestion::schedule() {
+    std::lock_guard lock(m_mutex);
+    // later stages first, they free space in queues
+    for (int stage = StageCount - 1; stage >= 0; stage--) {
+        auto &queue = m_queues[stage];
+        while (!queue.empty() && m_running[stage] < m_limits[stage]) {
+            if (stage + 1 < StageCount && m_queues[stage + 1].size() + m_running[stage] >= QUEUE_SIZE)
+                break;
+
+            m_running[stage]++;
+            auto entry = std::make_shared<Entry>(std::move(queue.front()));
+            queue.pop_front();
+            m_pool->post([this, stage, entry] { run(Stage(stage), std::move(*entry)); });
+        }
+    }
+}
+
+void DfsIngestion::run(Stage stage, Entry entry) {
+    const auto &handler = m_handlers[stage];
+    entry.item.error = handler ? handler(entry.item) : "";
+
+    const bool done = !entry.item.error.empty() || stage + 1 == StageCount;
+    {
+        std::lock_guard lock(m_mutex);
+        m_running[stage]--;
+        if (!done) {
+            auto &next = m_queues[stage + 1];
+            next.push_back(std::move(entry));
+            m_peakQueued = std::max(m_peakQueued, next.size());
+        }
+    }
+    if (done)
+        finish(entry);
+    schedule();
+
+    if (done) {
+        // last access to this, destructor can continue after it
+        std::lock_guard lock(m_mutex);
+        m_inProgress--;
+        inProgressGauge().add(-1);
+        if (m_inProgress == 0)
+            m_done.notify_all();
+    }
+}
+
+void DfsIngestion::finish(Entry &entry) {
+    if (entry.item.error.empty())
+        emit added(entry.item);
+    else
+        emit failed(entry.item);
+    entry.promise->addResult(entry.item);
+    entry.promise->finish();
+}
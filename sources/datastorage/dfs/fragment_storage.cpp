@@ -25,7 +25,10 @@ FragmentStorage::FragmentStorage(DFS::Packets::SegmentMessage segmentMessage)
 
 bool FragmentStorage::initLocalFile(uint64_t filesize) {
     DBRow row = makeFragmentRow(0, 0, filesize);
-    return storageFile.insert(DFSF::TableNameFragments, row);
+    const bool inserted = storageFile.insert(DFSF::TableNameFragments, row);
+    if (inserted)
+        m_storedChange += int64_t(filesize);
+    return inserted;
 }
 
 bool FragmentStorage::initHistoricalChain() {
@@ -37,6 +40,8 @@ bool FragmentStorage::insertFragment(DFSP::SegmentMessage msg) {
     uint64_t pos = writeFragment(msg);
     DBRow row = makeFragmentRow(msg, pos);
     const auto inserted = storageFile.insert(DFSF::TableNameFragments, row);
+    if (inserted)
+        m_storedChange += int64_t(msg.Data.size());
     moveRows(row, msg.Data.size());
     return inserted;
 }
@@ -89,7 +94,8 @@ bool FragmentStorage::removeFragment(DFSP::DeleteSegmentMessage msg) {
     std::vector<DBRow> array = storageFile.select(GetStartFragmentQuery);
     if (!array.empty()) {
         DBRow frag = array[0];
-        storageFile.deleteRow(DFSF::TableNameFragments, frag);
+        if (storageFile.deleteRow(DFSF::TableNameFragments, frag))
+            m_storedChange -= int64_t(std::stoull(frag.at("size")));
         std::filesystem::path filePath = DFS_PATH::filePath(actor, fileName);
 
         HistoricalChain historicalChain(storageFile.file(), filePath.string());
@@ -171,6 +177,10 @@ bool FragmentStorage::applyChanges(const std::string &data, uint64_t pos) {
     return true;
 }
 
+int64_t FragmentStorage::storedChange() const {
+    return m_storedChange;
+}
+
 DBRow FragmentStorage::getPreviousFragment(uint64_t number) {
     DBRow ret;
     std::string GetPrevFragmentQuery = "SELECT * FROM " + DFSF::TableNameFragments + " WHERE pos < "
@@ -412,7 +422,7 @@ bool FragmentStorage::checkRenameFile(const DFS::Packets::EditSegmentMessage &ms
 
 FragmentWriter::FragmentWriter(const DFS::Packets::SegmentMessage &msg,
                                std::vector<std::string> compliteFiles, QObject *parent)
-    : QThread(parent)
+    : QObject(parent)
     , m_msg(msg)
     , m_compliteFiles(compliteFiles) {
 }
@@ -444,6 +454,7 @@ void FragmentWriter::run() {
 
     FragmentStorage fs(m_msg);
     fs.insertFragment(m_msg);
+    m_storedChange += fs.storedChange();
     currentFileSize = std::filesystem::file_size(fileName);
     emit downloadProgress(m_msg.Actor, m_msg.FileName, double(m_msg.Offset) / double(fileSize) * 100);
     if (fileSize == currentFileSize) {
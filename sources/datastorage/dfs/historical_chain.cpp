@@ -1,5 +1,7 @@
 #include "datastorage/dfs/historical_chain.h"
-#include <fstream>
+#include "datastorage/dfs/mapped_file.h"
+
+#include <QByteArray>
 
 HistoricalChain::HistoricalChain(std::string chainFilePath, std::string objectFilePath)
     : chainFile(chainFilePath) {
@@ -8,7 +10,7 @@ HistoricalChain::HistoricalChain(std::string chainFilePath, std::string objectFi
     }
     objectPath = objectFilePath;
     chainFile.query(DFS::Historical::CreateTableHistoricalChain);
-    chainFile.close();
+    chainFile.query(DFS::Historical::CreateTableCheckpoints);
 }
 
 HistoricalChain::~HistoricalChain() {
@@ -16,7 +18,6 @@ HistoricalChain::~HistoricalChain() {
 }
 
 bool HistoricalChain::apply(DFSP::EditSegmentMessage msg) {
-    chainFile.open();
     DBRow lastRow = getLastRow();
     uint64_t num;
     uint64_t prevNum;
@@ -28,39 +29,32 @@ bool HistoricalChain::apply(DFSP::EditSegmentMessage msg) {
         num = prevNum + 1;
     }
     if (STDFS::is_directory(objectPath) && msg.Offset == 0) {
-        if (chainFile.insert(DFSHC::TableNameHC, makeDBRow(num, prevNum, msg.ActionType, msg.Data))) {
-            chainFile.close();
-            return true;
-        } else {
-            chainFile.close();
-            return false;
-        }
+        return chainFile.insert(DFSHC::TableNameHC, makeDBRow(num, prevNum, msg.ActionType, msg.Data));
     } else if (STDFS::is_regular_file(objectPath)) {
         DFSHC::FileChange fc;
         fc.pos = msg.Offset;
         fc.data = msg.Data;
-        if (chainFile.insert(DFSHC::TableNameHC, makeDBRow(num, prevNum, msg.ActionType, fc.toStdString()))) {
-            chainFile.close();
-            return true;
-        } else {
-            chainFile.close();
+        if (!chainFile.insert(DFSHC::TableNameHC, makeDBRow(num, prevNum, msg.ActionType, fc.toStdString())))
             return false;
+        if (num > 0 && num % CHECKPOINT_INTERVAL == 0) {
+            checkpoint(num);
+            compact();
         }
+        return true;
     } else {
-        chainFile.close();
         return false;
     }
 }
 
 bool HistoricalChain::remove(DFSP::EditSegmentMessage msg) {
     bool removed = false;
-    chainFile.open();
     const auto lastSegment = getLastEditSegmentMessage();
 
     if (msg.Data == lastSegment.Data) {
         DBRow lastRow = getLastRow();
         uint64_t prevNum = std::stoull(lastRow.at("prevNum"));
         uint64_t num = std::stoull(lastRow.at("num"));
+        dropCheckpoints(num);
         removed = chainFile.deleteRow(DFSHC::TableNameHC, makeDBRow(num, prevNum, msg.ActionType, msg.Data));
     } else {
         DBRow dbRow = getRow(msg.Data);
@@ -69,21 +63,20 @@ bool HistoricalChain::remove(DFSP::EditSegmentMessage msg) {
                                               + dbRow.at("prevNum") + "WHERE hash=" + nextRow.at("hash"));
 
         if (!updated) {
-            chainFile.close();
             return false;
         }
 
+        dropCheckpoints(std::stoull(dbRow.at("num")));
         removed = chainFile.deleteRow(DFSHC::TableNameHC, dbRow);
     }
-    chainFile.close();
     return removed;
 }
 
 bool HistoricalChain::revert(DFSP::EditSegmentMessage msg) {
     bool reverted = true;
-    chainFile.open();
 
     DBRow row = getRow(msg.Data);
+    dropCheckpoints(std::stoull(row.at("num")));
     std::string queryGetListEditSegment =
         "SELECT * FROM " + DFSHC::TableNameHC + " WHERE num >=" + row.at("num");
     std::vector<DBRow> editSegmentMessageList = chainFile.select(queryGetListEditSegment, DFSHC::TableNameHC);
@@ -94,25 +87,21 @@ bool HistoricalChain::revert(DFSP::EditSegmentMessage msg) {
             break;
         }
     }
-    chainFile.close();
     return reverted;
 }
 
 bool HistoricalChain::update(DFSP::EditSegmentMessage msg, const int &num) {
     bool updated = false;
-    chainFile.open();
     DFSP::EditSegmentMessage editableSegmentMessage = getEditSegmentMessage(num);
+    dropCheckpoints(uint64_t(num));
     updated = chainFile.update("UPDATE " + DFSHC::TableNameHC + " SET "
                                + " type = " + std::to_string(msg.ActionType) + " data = " + msg.Data
                                + " hash = " + msg.FileHash + " WHERE data=" + editableSegmentMessage.Data);
-    chainFile.close();
     return updated;
 }
 
 DFSP::EditSegmentMessage HistoricalChain::getEditSegmentMessage(const int &num) {
-    chainFile.open();
     DBRow dbRow = getRow(num);
-    chainFile.close();
 
     if (dbRow.empty()) {
         return DFSP::EditSegmentMessage();
@@ -121,9 +110,7 @@ DFSP::EditSegmentMessage HistoricalChain::getEditSegmentMessage(const int &num)
 }
 
 DFSP::EditSegmentMessage HistoricalChain::getLastEditSegmentMessage() {
-    chainFile.open();
     DBRow lastRow = getLastRow();
-    chainFile.close();
 
     if (lastRow.empty()) {
         return DFSP::EditSegmentMessage();
@@ -148,7 +135,7 @@ DFSP::EditSegmentMessage HistoricalChain::makeEditSegmentMessage(const DFSP::Del
         .Actor = msg.Actor,
         .FileName = msg.FileName,
         .FileHash = msg.FileHash,
-        .Data = "",
+        .Data = Tools::typeToStdStringBytes<uint64_t>(msg.Size), // size of removed range
         .Offset = msg.Offset,
         .ActionType = smType,
     };
@@ -161,24 +148,24 @@ bool HistoricalChain::initLocal(const std::string &actor, const std::string &fil
         return false;
         qFatal("[Dfs] No file");
     }
+    if (!getLastRow().empty())
+        return true;
 
-    std::ifstream ifs(filePath, std::ios::binary);
-    ifs.seekg(0, std::ios::beg);
-    std::vector<char> buffer(DFS::Basic::historicalChainSectionSize);
+    MappedFile file(filePath);
+    if (!file.isOpen())
+        return false;
 
-    do {
-        apply(DFSP::EditSegmentMessage { .Actor = actor,
-                                         .FileHash = fileHash,
-                                         .Data = std::string(buffer.data(), buffer.size()),
-                                         .Offset = 0,
-                                         .ActionType = DFSP::SegmentMessageType::insert });
-    } while (ifs.read(buffer.data(), DFS::Basic::historicalChainSectionSize));
-    ifs.close();
-    return true;
+    // version 0 is an empty entry, content of file is its checkpoint
+    DFSHC::FileChange fc = { .pos = 0, .data = "" };
+    const DBRow row = makeDBRow(0, 0, DFSP::SegmentMessageType::add, fc.toStdString());
+    if (!chainFile.insert(DFSHC::TableNameHC, row))
+        return false;
+    return saveCheckpoint(0, file.slice(0, file.size()));
 }
 
 bool HistoricalChain::remove(const std::string &actor, const std::string &fileHash) {
     std::filesystem::path filePath = DFS_PATH::filePath(actor, fileHash);
+    chainFile.close();
     if (std::filesystem::exists(chainFile.file()))
         return std::filesystem::remove(chainFile.file());
     return false;
@@ -258,3 +245,126 @@ DFSP::EditSegmentMessage HistoricalChain::segmentMessageFromDBRow(const DBRow &d
     result.Actor = "";
     return result;
 }
+
+std::optional<std::string> HistoricalChain::version(uint64_t num) {
+    m_replayed = 0;
+    const auto last = lastVersion();
+    if (!STDFS::is_regular_file(objectPath) || !last || num > *last)
+        return {};
+
+    std::string state;
+    uint64_t from = 0;
+    auto checkpoints = chainFile.select("SELECT MAX(num) AS num FROM " + DFSHC::TableNameCheckpoints
+                                        + " WHERE num <= " + std::to_string(num));
+    if (!checkpoints.empty() && !checkpoints[0]["num"].empty()) {
+        const std::string base = checkpoints[0]["num"];
+        auto parts = chainFile.select("SELECT data FROM " + DFSHC::TableNameCheckpoints
+                                      + " WHERE num = " + base + " ORDER BY part");
+        for (auto &part : parts) {
+            const std::string &data = part["data"];
+            const QByteArray uncompressed =
+                qUncompress(reinterpret_cast<const uchar *>(data.data()), qsizetype(data.size()));
+            state.append(uncompressed.constData(), std::size_t(uncompressed.size()));
+        }
+        from = std::stoull(base) + 1;
+    } else if (getRow(0).empty()) {
+        // entries before the oldest checkpoint were compacted
+        return {};
+    }
+
+    auto rows = chainFile.select("SELECT * FROM " + DFSHC::TableNameHC + " WHERE num >= "
+                                 + std::to_string(from) + " AND num <= " + std::to_string(num)
+                                 + " ORDER BY num");
+    for (const auto &row : rows) {
+        replay(state, row);
+        m_replayed++;
+    }
+    return state;
+}
+
+std::optional<uint64_t> HistoricalChain::lastVersion() {
+    DBRow lastRow = getLastRow();
+    if (lastRow.empty())
+        return {};
+    return std::stoull(lastRow.at("num"));
+}
+
+bool HistoricalChain::compact(uint64_t retention) {
+    const auto last = lastVersion();
+    if (!last || *last < retention)
+        return true;
+
+    // the newest checkpoint before the window is the base of kept versions
+    auto checkpoints = chainFile.select("SELECT MAX(num) AS num FROM " + DFSHC::TableNameCheckpoints
+                                        + " WHERE num <= " + std::to_string(*last - retention));
+    if (checkpoints.empty() || checkpoints[0]["num"].empty())
+        return true;
+    const std::string base = checkpoints[0]["num"];
+
+    chainFile.query("BEGIN TRANSACTION;");
+    const bool compacted =
+        chainFile.query("DELETE FROM " + DFSHC::TableNameHC + " WHERE num < " + base + ";")
+        && chainFile.query("DELETE FROM " + DFSHC::TableNameCheckpoints + " WHERE num < " + base + ";");
+    chainFile.query(compacted ? "COMMIT;" : "ROLLBACK;");
+    return compacted;
+}
+
+uint64_t HistoricalChain::replayed() const {
+    return m_replayed;
+}
+
+bool HistoricalChain::checkpoint(uint64_t num) {
+    const auto state = version(num);
+    return state && saveCheckpoint(num, *state);
+}
+
+bool HistoricalChain::saveCheckpoint(uint64_t num, std::string_view state) {
+    chainFile.query("BEGIN TRANSACTION;");
+    dropCheckpoints(num);
+    uint64_t offset = 0, part = 0;
+    do {
+        const auto section = state.substr(offset, DFSB::historicalChainSectionSize);
+        const QByteArray compressed =
+            qCompress(reinterpret_cast<const uchar *>(section.data()), qsizetype(section.size()));
+        const DBRow row = { { "num", std::to_string(num) },
+                            { "part", std::to_string(part) },
+                            { "data", compressed.toStdString() } };
+        if (!chainFile.insert(DFSHC::TableNameCheckpoints, row)) {
+            qDebug() << "[HistoricalChain] Can't save checkpoint" << num << "of" << objectPath.c_str();
+            chainFile.query("ROLLBACK;");
+            return false;
+        }
+        offset += section.size();
+        part++;
+    } while (offset < state.size());
+    chainFile.query("COMMIT;");
+    return true;
+}
+
+void HistoricalChain::dropCheckpoints(uint64_t fromNum) {
+    chainFile.query("DELETE FROM " + DFSHC::TableNameCheckpoints + " WHERE num >= " + std::to_string(fromNum)
+                    + ";");
+}
+
+void HistoricalChain::replay(std::string &state, const DBRow &dbRow) {
+    DFSHC::FileChange fc;
+    fc.fromStdString(dbRow.at("data"));
+    const uint64_t pos = std::min<uint64_t>(fc.pos, state.size());
+
+    switch (static_cast<DFSP::SegmentMessageType>(std::stoi(dbRow.at("type")))) {
+    case DFSP::SegmentMessageType::add:
+    case DFSP::SegmentMessageType::insert:
+        state.insert(pos, fc.data);
+        break;
+    case DFSP::SegmentMessageType::replace:
+        state.replace(pos, fc.data.size(), fc.data);
+        break;
+    case DFSP::SegmentMessageType::remove: {
+        const uint64_t size = fc.data.size() >= sizeof(uint64_t)
+            ? Tools::stdStringBytesToType<uint64_t>(fc.data.substr(0, sizeof(uint64_t)))
+            : 0;
+        state.erase(pos, size);
+        break;
+    }
+    }
+}
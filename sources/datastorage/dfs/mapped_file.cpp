@@ -0,0 +1,41 @@
+#include "datastorage/dfs/mapped_file.h"
+
+#include <algorithm>
+
+#include <QDebug>
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+    std::error_code error;
+    const auto size = std::filesystem::file_size(path, error);
+    if (error)
+        return;
+    m_size = size;
+    m_open = true;
+    if (m_size == 0) // empty file can't be mapped
+        return;
+
+    try {
+        m_mapping = boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+        m_region = boost::interprocess::mapped_region(m_mapping, boost::interprocess::read_only);
+        m_region.advise(boost::interprocess::mapped_region::advice_sequential);
+    } catch (const boost::interprocess::interprocess_exception &e) {
+        qDebug() << "[Dfs] Can't map" << path.c_str() << e.what();
+        m_size = 0;
+        m_open = false;
+    }
+}
+
+bool MappedFile::isOpen() const {
+    return m_open;
+}
+
+uint64_t MappedFile::size() const {
+    return m_size;
+}
+
+std::string_view MappedFile::slice(uint64_t offset, uint64_t size) const {
+    if (offset >= m_size)
+        return {};
+    const char *data = static_cast<const char *>(m_region.get_address());
+    return std::string_view(data + offset, std::min(size, m_size - offset));
+}
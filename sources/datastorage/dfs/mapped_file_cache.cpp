@@ -0,0 +1,74 @@
+#include "datastorage/dfs/mapped_file_cache.h"
+
+double MappedFileCache::Stats::hitRate() const {
+    const uint64_t requests = hits + misses;
+    return requests ? double(hits) / double(requests) : 0.0;
+}
+
+MappedFileCache::MappedFileCache(uint64_t capacity)
+    : m_capacity(capacity) {
+}
+
+std::shared_ptr<const MappedFile> MappedFileCache::get(const std::filesystem::path &path) {
+    const std::string key = path.string();
+    std::error_code error;
+    const auto modified = std::filesystem::last_write_time(path, error);
+
+    std::lock_guard lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        const auto size = std::filesystem::file_size(path, error);
+        if (!error && it->second.modified == modified && it->second.file->size() == size) {
+            m_stats.hits++;
+            m_order.splice(m_order.begin(), m_order, it->second.order);
+            return it->second.file;
+        }
+        erase(it); // changed without invalidation
+    }
+
+    m_stats.misses++;
+    auto file = std::make_shared<const MappedFile>(path);
+    if (error || !file->isOpen() || m_capacity == 0 || file->size() > m_capacity)
+        return file;
+
+    m_order.push_front(key);
+    m_entries.emplace(key, Entry { .file = file, .modified = modified, .order = m_order.begin() });
+    m_stats.files++;
+    m_stats.bytes += file->size();
+    while (m_stats.bytes > m_capacity) {
+        erase(m_entries.find(m_order.back()));
+        m_stats.evictions++;
+    }
+    return file;
+}
+
+void MappedFileCache::invalidate(const std::filesystem::path &path) {
+    std::lock_guard lock(m_mutex);
+    auto it = m_entries.find(path.string());
+    if (it != m_entries.end())
+        erase(it);
+}
+
+void MappedFileCache::clear() {
+    std::lock_guard lock(m_mutex);
+    m_entries.clear();
+    m_order.clear();
+    m_stats.files = 0;
+    m_stats.bytes = 0;
+}
+
+uint64_t MappedFileCache::capacity() const {
+    return m_capacity;
+}
+
+MappedFileCache::Stats MappedFileCache::stats() const {
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+void MappedFileCache::erase(std::unordered_map<std::string, Entry>::iterator it) {
+    m_stats.files--;
+    m_stats.bytes -= it->second.file->size();
+    m_order.erase(it->second.order);
+    m_entries.erase(it);
+}
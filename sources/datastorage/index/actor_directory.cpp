@@ -0,0 +1,182 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "datastorage/index/actor_directory.h"
+
+#include <algorithm>
+
+#include <QFile>
+
+namespace {
+// json files of older versions are in folders named by last digits of id
+const std::size_t SECTION_NAME_SIZE = 2;
+}
+
+double ActorDirectory::Stats::hitRate() const {
+    const uint64_t requests = hits + misses;
+    return requests ? double(hits) / double(requests) : 0.0;
+}
+
+ActorDirectory::ActorDirectory(const std::string &folderPath, std::size_t capacity)
+    : m_folderPath(folderPath)
+    , m_capacity(capacity) {
+    DBConnector db = open();
+    bool isDbOpen = db.isOpen();
+    bool isDbCreate = db.createTable(Config::DataStorage::actorsTableCreate);
+    if (!isDbOpen || !isDbCreate)
+        qFatal("%s",
+               QString("db for actors (open: %1, create: %2)").arg(isDbOpen, isDbCreate).toLatin1().data());
+
+    // table of older versions has no keys
+    const auto columns = db.tableColumns(Config::DataStorage::actorsTable);
+    auto isKey = [](const DBColumn &column) { return column.name == "key"; };
+    if (std::none_of(columns.begin(), columns.end(), isKey))
+        db.query("ALTER TABLE " + Config::DataStorage::actorsTable + " ADD COLUMN key BLOB;");
+}
+
+std::optional<Actor<KeyPublic>> ActorDirectory::get(const ActorId &id) {
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_entries.find(id.toStdString());
+        if (it != m_entries.end()) {
+            m_stats.hits++;
+            m_order.splice(m_order.begin(), m_order, it->second.order);
+            return it->second.actor;
+        }
+        m_stats.misses++;
+    }
+
+    auto actor = load(id);
+    if (actor)
+        remember(*actor);
+    return actor;
+}
+
+bool ActorDirectory::contains(const ActorId &id) {
+    return get(id).has_value();
+}
+
+int ActorDirectory::add(const Actor<KeyPublic> &actor) {
+    if (contains(actor.id())) {
+        qDebug() << "[ActorDirectory] Actor" << actor.id() << "already exists";
+        return Errors::FILE_ALREADY_EXISTS;
+    }
+
+    DBConnector db = open();
+    const DBRow row = { { "id", actor.id().toStdString() },
+                        { "type", std::to_string(int(actor.type())) },
+                        { "key", actor.key().publicKey() } };
+    // row of older versions may be there without key
+    if (!db.replace(Config::DataStorage::actorsTable, row)) {
+        qDebug() << "[ActorDirectory] Can't save actor" << actor.id();
+        return Errors::FILE_IS_NOT_OPENED;
+    }
+
+    remember(actor);
+    return 0;
+}
+
+uint64_t ActorDirectory::count() const {
+    DBConnector db = open();
+    return uint64_t(db.count(Config::DataStorage::actorsTable));
+}
+
+std::vector<std::string> ActorDirectory::ids() const {
+    DBConnector db = open();
+    std::vector<std::string> result;
+    for (auto &row : db.select("SELECT id FROM " + Config::DataStorage::actorsTable + ";"))
+        result.push_back(row["id"]);
+    return result;
+}
+
+ActorDirectory::Stats ActorDirectory::stats() const {
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+DBConnector ActorDirectory::open() const {
+    DBConnector db(m_folderPath + "actors");
+    db.open();
+    return db;
+}
+
+std::optional<Actor<KeyPublic>> ActorDirectory::load(const ActorId &id) {
+    DBConnector db = open();
+    auto rows = db.selectMany("SELECT type, key FROM " + Config::DataStorage::actorsTable + " WHERE id = ?;",
+                              { { id.toStdString() } });
+    if (!rows.empty() && !rows[0]["key"].empty()) {
+        Actor<KeyPublic> actor;
+        actor.setId(id);
+        actor.setType(ActorType(std::stoi(rows[0]["type"])));
+        actor.setPublicKey(rows[0]["key"]);
+        return actor;
+    }
+
+    auto actor = loadLegacy(id);
+    if (!actor)
+        return std::nullopt;
+
+    const DBRow row = { { "id", id.toStdString() },
+                        { "type", std::to_string(int(actor->type())) },
+                        { "key", actor->key().publicKey() } };
+    if (db.replace(Config::DataStorage::actorsTable, row))
+        QFile::remove(legacyPath(id));
+    return actor;
+}
+
+std::optional<Actor<KeyPublic>> ActorDirectory::loadLegacy(const ActorId &id) const {
+    QFile file(legacyPath(id));
+    if (!file.open(QIODevice::ReadOnly))
+        return std::nullopt;
+
+    const QByteArray data = file.readAll();
+    if (data.isEmpty())
+        return std::nullopt;
+    auto actor = Actor<KeyPublic>::fromJson(data);
+    if (actor.empty() || actor.id() != id)
+        return std::nullopt;
+    qDebug() << "[ActorDirectory] Moving actor" << id << "from json file";
+    return actor;
+}
+
+QString ActorDirectory::legacyPath(const ActorId &id) const {
+    const std::string &idStd = id.toStdString();
+    const std::string section = idStd.substr(idStd.size() - SECTION_NAME_SIZE);
+    return QString::fromStdString(m_folderPath + section + '/' + idStd);
+}
+
+void ActorDirectory::remember(const Actor<KeyPublic> &actor) {
+    if (m_capacity == 0)
+        return;
+
+    const std::string &id = actor.id().toStdString();
+    std::lock_guard lock(m_mutex);
+    if (m_entries.contains(id))
+        return;
+    m_order.push_front(id);
+    m_entries.emplace(id, Entry { .actor = actor, .order = m_order.begin() });
+    m_stats.actors++;
+    while (m_entries.size() > m_capacity) {
+        m_entries.erase(m_order.back());
+        m_order.pop_back();
+        m_stats.evictions++;
+        m_stats.actors--;
+    }
+}
@@ -26,16 +26,9 @@ ActorId ActorIndex::firstId() {
 }
 
 ActorIndex::ActorIndex(ExtraChainNode &node)
-    : node(node) {
-    DBConnector db(folderPath + "actors");
-    bool isDbOpen = db.open();
-    bool isDbCreate = db.createTable(Config::DataStorage::actorsTableCreate);
-
-    if (!isDbOpen || !isDbCreate)
-        qFatal("%s",
-               QString("db for actors (open: %1, create: %2)").arg(isDbOpen, isDbCreate).toLatin1().data());
-
-    records = db.count("Actors");
+    : node(node)
+    , m_directory(folderPath) {
+    records = m_directory.count();
     qDebug() << "[ActorIndex] Count:" << records;
 }
 Actor<KeyPublic> ActorIndex::getActor(const ActorId &id) {
@@ -44,10 +37,9 @@ Actor<KeyPublic> ActorIndex::getActor(const ActorId &id) {
         return Actor<KeyPublic>();
     }
 
-    QByteArray serializedActor = this->getById(id);
-    if (!serializedActor.isEmpty()) {
-        auto actor = Actor<KeyPublic>::fromJson(serializedActor);
-        return actor;
+    auto actor = m_directory.get(id);
+    if (actor) {
+        return *actor;
     } else {
         sendGetActorMessage(id);
         qDebug() << "[ActorIndex] There no actor with id:" << id;
@@ -143,34 +135,13 @@ void ActorIndex::getActorCount(const QByteArray &requestHash, const std::string
 }
 
 bool ActorIndex::actorExist(const ActorId &actorId) {
-    return !getById(actorId).isEmpty();
+    return m_directory.contains(actorId);
 }
 
 std::string ActorIndex::getFolderPath() const {
     return folderPath;
 }
 
-QString ActorIndex::buildFilePath(const ActorId &id) const {
-    QByteArray Id = id.toByteArray();
-
-    QByteArray section = Id.right(SECTION_NAME_SIZE);
-    QString pathToFolder = QString::fromStdString(folderPath) + section;
-
-    QDir dir(pathToFolder);
-    if (!dir.exists()) {
-        qDebug() << "[ActorIndex] Creating dir:" << pathToFolder;
-        dir = QDir();
-        dir.mkpath(pathToFolder);
-    }
-
-    return pathToFolder + "/" + Id;
-}
-
-std::string ActorIndex::actorPath(const ActorId &id) const {
-    const std::string &idStd = id.toStdString();
-    return folderPath + idStd.substr(idStd.length() - SECTION_NAME_SIZE) + '/' + idStd;
-}
-
 void ActorIndex::setFirstId(const ActorId &value) {
     if (!m_firstId.isEmpty()) {
         if (firstId() != value)
@@ -186,31 +157,6 @@ qint64 ActorIndex::getRecords() const {
     return records;
 }
 
-int ActorIndex::add(const ActorId &id, const QByteArray &data) {
-    // if (id <= 1000)
-    //     qFatal("Try to add actor with id %s", id.toByteArray().constData());
-
-    QString path = buildFilePath(id);
-    QFile file(path);
-    qDebug() << "[ActorIndex] Saving the file:" << path;
-
-    if (file.exists()) {
-        qDebug() << "[ActorIndex] Can't save the file" << path << "(file already exits)";
-        return Errors::FILE_ALREADY_EXISTS;
-    }
-
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(data);
-        file.flush();
-        file.close();
-
-        return 0;
-    }
-
-    qDebug() << "[ActorIndex] Can't save the file" << path << "(file is not opened)";
-    return Errors::FILE_IS_NOT_OPENED;
-}
-
 void ActorIndex::sendGetActorMessage(const ActorId &actorId) {
     if (actorId.isEmpty()) {
         qFatal("Can't get actor by empty id");
@@ -219,32 +165,20 @@ void ActorIndex::sendGetActorMessage(const ActorId &actorId) {
     node.network()->send_message(actorId.toStdString(), MessageType::Actor, MessageStatus::Request);
 }
 
-QByteArray ActorIndex::getById(const ActorId &id) const {
-    QString filePath = QString::fromStdString(actorPath(id));
-    QFile file(filePath);
-    if (!file.exists()) {
-        qDebug() << "[ActorIndex] File with path" << filePath << "not found";
+QByteArray ActorIndex::getById(const ActorId &id) {
+    auto actor = m_directory.get(id);
+    if (!actor) {
+        qDebug() << "[ActorIndex] Actor" << id << "not found";
         return QByteArray();
     }
-    file.open(QIODevice::ReadOnly);
-    QByteArray data = file.readAll();
-    file.close();
-    return data;
+    return actor->toJson();
 }
 
 int ActorIndex::addActor(const Actor<KeyPublic> &actor) {
-    int result = this->add(actor.id(), actor.toJson());
-    auto actorId = actor.id().toStdString();
+    int result = m_directory.add(actor);
 
-    if (result != Errors::FILE_ALREADY_EXISTS && result != Errors::FILE_IS_NOT_OPENED) {
+    if (result == 0) {
         this->records++;
-        DBConnector db(folderPath + "actors");
-        db.open();
-        bool dbInsert = db.insert(Config::DataStorage::actorsTable,
-                                  { { "id", actorId }, { "type", std::to_string(int(actor.type())) } });
-        if (!dbInsert)
-            qFatal("db actor insert error");
-
         node.dfs()->initializeActor(actor.id());
 
         qDebug() << "[ActorIndex] Actor" << actor.id() << "was added";
@@ -256,26 +190,11 @@ int ActorIndex::addActor(const Actor<KeyPublic> &actor) {
 
 QByteArrayList ActorIndex::allActors() {
     QByteArrayList result;
-
-    DBConnector db(folderPath + "actors");
-    db.open();
-    auto actors = db.select("SELECT id FROM Actors");
-    for (auto &actor : actors) {
-        result << actor["id"].data();
-    }
-
+    for (const auto &id : m_directory.ids())
+        result << QByteArray::fromStdString(id);
     return result;
 }
 
 std::vector<std::string> ActorIndex::allActorsStd() {
-    std::vector<std::string> result;
-
-    DBConnector db(folderPath + "actors");
-    db.open();
-    auto actors = db.select("SELECT id FROM Actors");
-    for (auto &actor : actors) {
-        result.push_back(actor["id"]);
-    }
-
-    return result;
+    return m_directory.ids();
 }
@@ -408,8 +408,8 @@ QString BlockIndex::buildFilePath(const BigNumber &id) const {
     return pathToFolder + "/" + id.toByteArray();
 }
 
-BigNumberFloat BlockIndex::calculateCirculativeBalance() const {
-    BigNumberFloat circulativeBalance = 0;
+Amount BlockIndex::calculateCirculativeBalance() const {
+    Amount circulativeBalance = 0;
     bool isGenesisBlockFounde = false;
     auto lastId = lastSavedId;
     while (!isGenesisBlockFounde) {
@@ -424,12 +424,12 @@ BigNumberFloat BlockIndex::calculateCirculativeBalance() const {
     return circulativeBalance;
 }
 
-BigNumberFloat BlockIndex::calculateCirculativeBalanceBlock(const Block &block) const {
-    BigNumberFloat circulativeBalanceBlock(0);
+Amount BlockIndex::calculateCirculativeBalanceBlock(const Block &block) const {
+    Amount circulativeBalanceBlock(0);
 
     const auto allTx = block.extractTransactions();
     if (allTx.empty())
-        return BigNumberFloat(0);
+        return Amount(0);
 
     for (int numberTx = 0; numberTx < allTx.size(); numberTx++) {
         if (allTx[numberTx].isRewardTransaction()) {
@@ -439,8 +439,8 @@ BigNumberFloat BlockIndex::calculateCirculativeBalanceBlock(const Block &block)
     return circulativeBalanceBlock;
 }
 
-BigNumberFloat BlockIndex::calculateCirculativeBalanceLastGenesisBlock() const {
-    BigNumberFloat circulativeBalanceGenesisBlock(0);
+Amount BlockIndex::calculateCirculativeBalanceLastGenesisBlock() const {
+    Amount circulativeBalanceGenesisBlock(0);
     const auto genesisBlock = getLastGenesisBlock();
 
     const auto dataRows = genesisBlock.extractDataRows();
@@ -706,7 +706,7 @@ QByteArray BlockIndex::getById(const BigNumber &id) const {
         for (const auto &tmp : rows) {
             GenesisDataRow dRow;
             dRow.type = DataStorage::typeDataRow(QByteArray(tmp.at("type").c_str()).toInt());
-            dRow.state = BigNumber(tmp.at("state"));
+            dRow.state = Amount::fromString(tmp.at("state"));
             dRow.token = tmp.at("token");
             dRow.actorId = tmp.at("actorId");
             b.addRow(dRow);
@@ -748,7 +748,7 @@ QByteArray BlockIndex::getById(const BigNumber &id) const {
             Transaction tx;
             tx.setSender(ActorId(tmp.at("sender")));
             tx.setReceiver(ActorId(tmp.at("receiver")));
-            tx.setAmount(BigNumber(tmp.at("amount")));
+            tx.setAmount(Amount::fromString(tmp.at("amount")));
             tx.setDate(std::stoll(tmp.at("date")));
             tx.setData(tmp.at("data"));
             tx.setToken(ActorId(tmp.at("token")));
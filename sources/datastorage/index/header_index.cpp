@@ -0,0 +1,235 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "datastorage/index/header_index.h"
+
+#include <optional>
+
+HeaderIndex::HeaderIndex()
+    : HeaderIndex(defaultPath()) {
+}
+
+HeaderIndex::HeaderIndex(const std::string &filePath)
+    : filePath(filePath) {
+    if (inMemory())
+        return;
+
+    DBConnector db(filePath);
+    bool isDbOpen = db.open();
+    bool isDbCreate = db.createTable(Config::DataStorage::headersTableCreate);
+
+    if (!isDbOpen || !isDbCreate)
+        qFatal("%s",
+               QString("db for headers (open: %1, create: %2)").arg(isDbOpen, isDbCreate).toLatin1().data());
+
+    m_tip = loadTip(db);
+    qDebug() << "[HeaderIndex] Tip:" << m_tip.index;
+}
+
+int HeaderIndex::addHeader(const BlockHeader &header) {
+    return addHeaders({ header });
+}
+
+int HeaderIndex::addHeaders(const std::vector<BlockHeader> &headers) {
+    if (headers.empty())
+        return 0;
+
+    std::lock_guard lock(m_mutex);
+    const BlockHeader *highest = &headers.front();
+    if (inMemory()) {
+        for (const auto &header : headers) {
+            if (header.isEmpty() || header.index < 0)
+                return Errors::BLOCK_IS_NOT_VALID;
+        }
+        for (const auto &header : headers) {
+            m_headers[header.index] = header;
+            if (header.index >= highest->index)
+                highest = &header;
+        }
+        if (highest->index >= m_tip.index || m_tip.isEmpty())
+            m_tip = *highest;
+        return 0;
+    }
+
+    DBConnector db(filePath);
+    db.open();
+    db.query("BEGIN TRANSACTION;");
+    for (const auto &header : headers) {
+        if (header.isEmpty() || header.index < 0) {
+            db.query("ROLLBACK;");
+            return Errors::BLOCK_IS_NOT_VALID;
+        }
+
+        DBRow row = { { "height", height(header.index) },
+                      { "hash", header.hash },
+                      { "header", MessagePack::serialize(header) } };
+        if (!db.replace(Config::DataStorage::headersTable, row)) {
+            db.query("ROLLBACK;");
+            return Errors::FILE_IS_NOT_OPENED;
+        }
+        if (header.index >= highest->index)
+            highest = &header;
+    }
+    db.query("COMMIT;");
+
+    if (highest->index >= m_tip.index || m_tip.isEmpty())
+        m_tip = *highest;
+    return 0;
+}
+
+int HeaderIndex::remove(const BigNumber &index) {
+    std::lock_guard lock(m_mutex);
+    if (inMemory()) {
+        m_headers.erase(index);
+        m_tip = m_headers.empty() ? BlockHeader() : m_headers.rbegin()->second;
+        return 0;
+    }
+
+    DBConnector db(filePath);
+    db.open();
+    bool removed = db.deleteRow(Config::DataStorage::headersTable, { { "height", height(index) } });
+    if (index == m_tip.index)
+        m_tip = loadTip(db);
+    return removed ? 0 : Errors::FILE_IS_NOT_OPENED;
+}
+
+int HeaderIndex::removeFrom(const BigNumber &index) {
+    std::lock_guard lock(m_mutex);
+    if (inMemory()) {
+        m_headers.erase(m_headers.lower_bound(index), m_headers.end());
+        m_tip = m_headers.empty() ? BlockHeader() : m_headers.rbegin()->second;
+        return 0;
+    }
+
+    DBConnector db(filePath);
+    db.open();
+    bool removed = db.query("DELETE FROM " + Config::DataStorage::headersTable
+                            + " WHERE height >= " + height(index) + ";");
+    m_tip = loadTip(db);
+    return removed ? 0 : Errors::FILE_IS_NOT_OPENED;
+}
+
+void HeaderIndex::clear() {
+    std::lock_guard lock(m_mutex);
+    m_tip = BlockHeader();
+    if (inMemory()) {
+        m_headers.clear();
+        return;
+    }
+
+    DBConnector db(filePath);
+    db.open();
+    db.query("DELETE FROM " + Config::DataStorage::headersTable + ";");
+}
+
+BlockHeader HeaderIndex::getHeader(const BigNumber &index) const {
+    auto headers = getHeaders(index, 1);
+    return headers.empty() ? BlockHeader() : headers.front();
+}
+
+std::vector<BlockHeader> HeaderIndex::getHeaders(const BigNumber &from, uint32_t count) const {
+    if (from < 0 || count == 0)
+        return {};
+
+    if (inMemory()) {
+        std::lock_guard lock(m_mutex);
+        std::vector<BlockHeader> headers;
+        for (auto it = m_headers.lower_bound(from); it != m_headers.end() && headers.size() < count; ++it)
+            headers.push_back(it->second);
+        return headers;
+    }
+
+    DBConnector db(filePath);
+    db.open();
+    auto rows = db.select("SELECT header FROM " + Config::DataStorage::headersTable + " WHERE height >= "
+                          + height(from) + " ORDER BY height LIMIT " + std::to_string(count) + ";");
+
+    std::vector<BlockHeader> headers;
+    headers.reserve(rows.size());
+    for (const auto &row : rows)
+        headers.push_back(MessagePack::deserialize<BlockHeader>(row.at("header")));
+    return headers;
+}
+
+BlockHeader HeaderIndex::tip() const {
+    std::lock_guard lock(m_mutex);
+    return m_tip;
+}
+
+bool HeaderIndex::contains(const BigNumber &index) const {
+    return !hashAt(index).empty();
+}
+
+bool HeaderIndex::contains(const BigNumber &index, const std::string &hash) const {
+    return !hash.empty() && hashAt(index) == hash;
+}
+
+BigNumber HeaderIndex::findFork(const std::vector<BlockHeader> &headers) const {
+    std::optional<DBConnector> db;
+    if (!inMemory()) {
+        db.emplace(filePath);
+        db->open();
+    }
+    for (const auto &header : headers) {
+        std::string local = db ? hashAt(*db, header.index) : hashAt(header.index);
+        if (!local.empty() && local != header.hash)
+            return header.index;
+    }
+    return BigNumber(-1);
+}
+
+std::string HeaderIndex::defaultPath() {
+    return DataStorage::BLOCKCHAIN_INDEX.toStdString() + "/"
+        + DataStorage::HEADER_INDEX_FILE_NAME.toStdString();
+}
+
+bool HeaderIndex::inMemory() const {
+    return filePath.empty();
+}
+
+std::string HeaderIndex::hashAt(const BigNumber &index) const {
+    if (inMemory()) {
+        std::lock_guard lock(m_mutex);
+        auto it = m_headers.find(index);
+        return it == m_headers.end() ? "" : it->second.hash;
+    }
+
+    DBConnector db(filePath);
+    db.open();
+    return hashAt(db, index);
+}
+
+std::string HeaderIndex::hashAt(DBConnector &db, const BigNumber &index) const {
+    if (index < 0)
+        return "";
+    auto rows = db.select("SELECT hash FROM " + Config::DataStorage::headersTable
+                          + " WHERE height = " + height(index) + ";");
+    return rows.empty() ? "" : rows.front().at("hash");
+}
+
+BlockHeader HeaderIndex::loadTip(DBConnector &db) const {
+    auto rows = db.select("SELECT header FROM " + Config::DataStorage::headersTable
+                          + " ORDER BY height DESC LIMIT 1;");
+    return rows.empty() ? BlockHeader() : MessagePack::deserialize<BlockHeader>(rows.front().at("header"));
+}
+
+std::string HeaderIndex::height(const BigNumber &index) {
+    return index.data().str();
+}
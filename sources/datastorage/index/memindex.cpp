@@ -19,10 +19,10 @@
 
 #include "datastorage/index/memindex.h"
 
-using std::begin, std::end, std::find_if, std::remove_if;
+#include <climits>
 
-MemIndex::MemIndex() {
-    //
+MemIndex::MemIndex(int capacity)
+    : slots(std::size_t(std::max(capacity, 1))) {
 }
 
 MemIndex::~MemIndex() {
@@ -30,108 +30,117 @@ MemIndex::~MemIndex() {
 }
 
 int MemIndex::addBlock(const Block &block) {
-    if (blocks.contains(block)) {
+    const auto blockHeight = height(block.getIndex());
+    if (!blockHeight || block.isEmpty()) {
+        qDebug() << "Block [" << block.toString() << "] can't be kept in memory";
+        return 2;
+    }
+    const long long h = *blockHeight;
+    const auto capacity = static_cast<long long>(slots.size());
+
+    if (records > 0 && h >= firstHeight && h < endHeight && !slot(h).isEmpty()) {
         qDebug() << "Block [" << block.toString() << "] already exists";
         return 1;
     }
 
-    if (Config::DataStorage::MEM_INDEX_SIZE_LIMIT <= blocks.size()) {
-        qWarning() << "MemBlock is filled";
-        // todo: enable FILE mode
-        return 2;
+    if (records == 0) {
+        firstHeight = h;
+        endHeight = h + 1;
+    } else if (h < firstHeight) {
+        if (endHeight - h > capacity) {
+            qDebug() << "Block [" << block.toString() << "] is older than blocks in memory";
+            return 2;
+        }
+        firstHeight = h;
+    } else if (h >= endHeight) {
+        // drop oldest blocks to make room
+        while (records > 0 && h - firstHeight >= capacity)
+            remove(firstHeight);
+        if (records == 0)
+            firstHeight = h;
+        endHeight = h + 1;
     }
-    blocks.append(block);
+
+    slot(h) = block;
+    records++;
+    byHash[block.getHash()] = h;
+    byApprover[approverKey(BigNumber(block.getApprover().toStdString()))].insert(h);
     return 0;
 }
 
 int MemIndex::removeById(const BigNumber &blockId) {
-    const int sizeWas = blocks.size();
-    blocks.erase(remove_if(begin(blocks), end(blocks),
-                           [&](const Block &block) { return block.getIndex() == blockId; }));
-    if (sizeWas == blocks.size()) {
+    if (!contains(blockId)) {
         qDebug() << "There no record with id:" << blockId;
         return 1;
     }
+    remove(*height(blockId));
     return 0;
 }
 
 int MemIndex::getRecords() const {
-    return blocks.size();
+    return records;
 }
 
 bool MemIndex::contains(const BigNumber &blockId) const {
-    Block block = this->operator[](blockId);
-    return !block.isEmpty();
+    const auto h = height(blockId);
+    return h && records > 0 && *h >= firstHeight && *h < endHeight && !slot(*h).isEmpty();
 }
 
 Block MemIndex::operator[](const BigNumber &blockId) const {
-    if (contains(blockId)) {
-        QList<Block>::const_iterator it = find_if(
-            begin(blocks), end(blocks), [&](const Block &block) { return block.getIndex() == blockId; });
-        if (it != end(blocks)) {
-            return *it;
-        }
-    }
+    if (contains(blockId))
+        return slot(*height(blockId));
     qDebug() << "There no record with id:" << blockId;
     return Block();
 }
 
 Block MemIndex::getByPosition(int pos) const {
-    return blocks.at(pos);
+    if (pos < 0 || pos >= records)
+        return Block();
+    // ring has no gaps unless blocks were removed from the middle
+    if (endHeight - firstHeight == records)
+        return slot(firstHeight + pos);
+    for (long long h = firstHeight; h < endHeight; h++)
+        if (!slot(h).isEmpty() && pos-- == 0)
+            return slot(h);
+    return Block();
 }
 
 Block MemIndex::getLastBlock() const {
-    if (blocks.size() > 0) {
-        return blocks.at(blocks.size() - 1);
-    }
-    return Block();
+    return records > 0 ? slot(endHeight - 1) : Block();
 }
 
 Block MemIndex::getBlockByParam(const BigNumber &id, SearchEnum::BlockParam param) const {
-    int index = getRecords() - 1;
-
-    // iteration from the last to the first Block
-    while (index >= 0) {
-        Block byPosition = getByPosition(index);
-        switch (param) {
-        case SearchEnum::BlockParam::Approver: {
-            if (BigNumber(byPosition.getApprover().toStdString()) == id)
-                return byPosition;
-            break;
-        }
-        case SearchEnum::BlockParam::Data: {
-            if (byPosition.getData() == id.toStdString())
-                return byPosition;
-            break;
-        }
-        case SearchEnum::BlockParam::Hash: {
-            if (byPosition.getHash() == id.toStdString())
-                return byPosition;
-            break;
-        }
-        case SearchEnum::BlockParam::Id: {
-            if (byPosition.getIndex() == id)
-                return byPosition;
-            break;
-        }
-        default:
-            break;
-        }
-        --index;
+    switch (param) {
+    case SearchEnum::BlockParam::Approver:
+        return getByApprover(id);
+    case SearchEnum::BlockParam::Data:
+        return getByData(QByteArray::fromStdString(id.toStdString()));
+    case SearchEnum::BlockParam::Hash:
+        return getByHash(QByteArray::fromStdString(id.toStdString()));
+    case SearchEnum::BlockParam::Id:
+        return contains(id) ? slot(*height(id)) : Block();
+    default:
+        return Block();
     }
-    return Block();
 }
 
 Block MemIndex::getByApprover(const BigNumber &approver) const {
-    return getBlockByParam(approver, SearchEnum::BlockParam::Approver);
+    auto it = byApprover.find(approverKey(approver));
+    return it != byApprover.end() ? slot(*it->second.rbegin()) : Block();
 }
 
 Block MemIndex::getByData(const QByteArray &data) const {
-    return getBlockByParam(data.toStdString(), SearchEnum::BlockParam::Data);
+    // data is not indexed, search from the last block
+    const std::string value = data.toStdString();
+    for (long long h = endHeight - 1; records > 0 && h >= firstHeight; h--)
+        if (!slot(h).isEmpty() && slot(h).getData() == value)
+            return slot(h);
+    return Block();
 }
 
 Block MemIndex::getByHash(const QByteArray &hash) const {
-    return getBlockByParam(hash.toStdString(), SearchEnum::BlockParam::Hash);
+    auto it = byHash.find(hash.toStdString());
+    return it != byHash.end() ? slot(it->second) : Block();
 }
 
 std::pair<Transaction, QByteArray> MemIndex::getLastTxByHash(const QByteArray &hash,
@@ -165,7 +174,12 @@ std::pair<Transaction, QByteArray> MemIndex::getLastTxByApprover(const BigNumber
 }
 
 void MemIndex::removeAll() {
-    this->blocks.clear();
+    for (long long h = firstHeight; records > 0 && h < endHeight; h++)
+        slot(h) = Block();
+    records = 0;
+    firstHeight = endHeight = 0;
+    byHash.clear();
+    byApprover.clear();
 }
 
 std::pair<Transaction, QByteArray> MemIndex::getLastTxByParam(const BigNumber &id, SearchEnum::TxParam param,
@@ -249,3 +263,44 @@ std::pair<Transaction, QByteArray> MemIndex::getLastTxByParam(const BigNumber &i
 
     return { Transaction(), "-1" };
 }
+
+const Block &MemIndex::slot(long long height) const {
+    return slots[std::size_t(height % static_cast<long long>(slots.size()))];
+}
+
+Block &MemIndex::slot(long long height) {
+    return slots[std::size_t(height % static_cast<long long>(slots.size()))];
+}
+
+void MemIndex::remove(long long height) {
+    Block &block = slot(height);
+    auto approver = byApprover.find(approverKey(BigNumber(block.getApprover().toStdString())));
+    if (approver != byApprover.end()) {
+        approver->second.erase(height);
+        if (approver->second.empty())
+            byApprover.erase(approver);
+    }
+    auto hash = byHash.find(block.getHash());
+    if (hash != byHash.end() && hash->second == height)
+        byHash.erase(hash);
+    block = Block();
+    records--;
+
+    // ends of ring always hold blocks
+    while (records > 0 && slot(firstHeight).isEmpty())
+        firstHeight++;
+    while (records > 0 && slot(endHeight - 1).isEmpty())
+        endHeight--;
+    if (records == 0)
+        firstHeight = endHeight = 0;
+}
+
+std::optional<long long> MemIndex::height(const BigNumber &blockId) {
+    if (blockId < 0 || blockId > BigNumber(LLONG_MAX - 1))
+        return std::nullopt;
+    return blockId.data().convert_to<long long>();
+}
+
+std::string MemIndex::approverKey(const BigNumber &approver) {
+    return approver.toStdString();
+}
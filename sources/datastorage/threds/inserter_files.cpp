@@ -3,17 +3,31 @@
 #include <QFileInfo>
 
 InserterFiles::InserterFiles(ExtraChainNode &xNode, const QStringList &files, QObject *parent)
-    : QThread(parent)
-    , node(xNode)
-    , fList(files) {
+    : QObject(parent)
+    , fList(files)
+    , node(xNode) {
 }
 
-void InserterFiles::run() {
-    for (const auto &filePath : fList) {
-        qDebug() << "Files add in thread id: [" << QThread::currentThreadId() << "]";
-        const std::string result =
-            node.dfs()->addLocalFile(node.accountController()->mainActor(), filePath.toStdWString(),
-                                     QFileInfo(filePath).fileName().toStdString(), DFS::Encryption::Public);
-        emit resultAddFile(QString::fromStdString(result), filePath);
+void InserterFiles::start() {
+    // files go through the ingestion pipeline together, results are reported in order
+    const auto actor = node.accountController()->mainActor();
+    m_results.assign(fList.size(), std::nullopt);
+    m_reported = 0;
+    if (fList.isEmpty()) {
+        emit finished();
+        return;
+    }
+
+    for (int i = 0; i < fList.size(); i++) {
+        const QString &filePath = fList[i];
+        node.dfs()
+            ->ingest(actor, filePath.toStdWString(), QFileInfo(filePath).fileName().toStdString())
+            .then(this, [this, i](const DfsIngestion::Item &item) {
+                m_results[i] = item.error.empty() ? item.fileName : item.error;
+                for (; m_reported < fList.size() && m_results[m_reported]; m_reported++)
+                    emit resultAddFile(QString::fromStdString(*m_results[m_reported]), fList[m_reported]);
+                if (m_reported == fList.size())
+                    emit finished();
+            });
     }
 }
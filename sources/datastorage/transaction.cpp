@@ -20,7 +20,7 @@
 #include "datastorage/transaction.h"
 
 Transaction::Transaction() {
-    this->amount = BigNumberFloat(0);
+    this->amount = Amount();
     this->date = QDateTime::currentMSecsSinceEpoch();
     this->data = std::string();
     this->prevBlock = BigNumber(0);
@@ -42,7 +42,7 @@ Transaction::Transaction(const std::string &serialized) {
     calcHash();
 }
 
-Transaction::Transaction(const ActorId &sender, const ActorId &receiver, const BigNumberFloat &amount) {
+Transaction::Transaction(const ActorId &sender, const ActorId &receiver, const Amount &amount) {
     this->sender = sender;
     this->receiver = receiver;
     this->amount = amount;
@@ -57,7 +57,7 @@ Transaction::Transaction(const ActorId &sender, const ActorId &receiver, const B
     calcHash();
 }
 
-Transaction::Transaction(const ActorId &sender, const ActorId &receiver, const BigNumberFloat &amount,
+Transaction::Transaction(const ActorId &sender, const ActorId &receiver, const Amount &amount,
                          const std::string &data)
     : Transaction(sender, receiver, amount) {
     this->data = data;
@@ -80,6 +80,7 @@ Transaction::Transaction(const Transaction &other) {
     this->digSig = other.digSig;
     this->producer = other.producer;
     this->typeTx = other.typeTx;
+    this->legacyAmount = other.legacyAmount;
     calcHash();
 }
 
@@ -115,7 +116,7 @@ ActorId Transaction::getProducer() const {
     return producer;
 }
 
-void Transaction::setAmount(const BigNumberFloat &value) {
+void Transaction::setAmount(const Amount &value) {
     amount = value;
 }
 
@@ -150,8 +151,22 @@ void Transaction::setTypeTx(TypeTx newTypeTx) {
     typeTx = newTypeTx;
 }
 
+bool Transaction::hasLegacyAmount() const {
+    return legacyAmount;
+}
+
+void Transaction::msgpack_unpack(msgpack::object const &msgpack_o) {
+    msgpack::type::make_define_array(sender, receiver, amount, date, data, token, prevBlock, gas, hop, hash,
+                                     approver, producer, digSig, typeTx)
+        .msgpack_unpack(msgpack_o);
+    legacyAmount = msgpack_o.type == msgpack::type::ARRAY && msgpack_o.via.array.size > 2
+        && msgpack_o.via.array.ptr[2].type == msgpack::type::STR;
+}
+
 std::string Transaction::getDataForHash() const {
-    return (sender.toStdString() + receiver.toStdString() + amount.toStdString() + std::to_string(date) + data
+    // text of older versions keeps only 6 significant digits, so exact units are hashed for new txs
+    const std::string amountData = legacyAmount ? amount.toLegacyString() : amount.toStdString();
+    return (sender.toStdString() + receiver.toStdString() + amountData + std::to_string(date) + data
             + token.toStdString() + prevBlock.toStdString() + std::to_string(gas) + approver.toStdString()
             + producer.toStdString());
 }
@@ -200,7 +215,7 @@ void Transaction::decrementHop() {
 void Transaction::clear() {
     this->sender = "0";
     this->receiver = "0";
-    this->amount = BigNumberFloat(0);
+    this->amount = Amount();
     this->date = QDateTime::currentMSecsSinceEpoch();
     this->data = std::string();
     this->token = "0";
@@ -211,6 +226,7 @@ void Transaction::clear() {
     this->approver = "0";
     this->digSig = std::string();
     this->producer = "0";
+    this->legacyAmount = false;
     calcHash();
 }
 
@@ -226,7 +242,7 @@ ActorId Transaction::getReceiver() const {
     return this->receiver;
 }
 
-BigNumberFloat Transaction::getAmount() const {
+Amount Transaction::getAmount() const {
     return this->amount;
 }
 
@@ -311,6 +327,7 @@ void Transaction::operator=(const Transaction &other) {
     this->digSig = other.digSig;
     this->producer = other.producer;
     this->typeTx = other.typeTx;
+    this->legacyAmount = other.legacyAmount;
 }
 
 std::string Transaction::serialize() const {
@@ -326,81 +343,25 @@ QString Transaction::toString() const {
         + ", approver:" + approver.toByteArray() + ", digitalSignature:" + QString::fromStdString(digSig);
 }
 
-BigNumberFloat Transaction::visibleToAmount(std::string amount) {
-    if (amount.empty())
-        return 0;
-
-    amount += amount.find(".") == -1 ? "." : "";
-    std::vector<std::string> amountList;
-    boost::algorithm::split(amountList, amount, boost::algorithm::is_any_of("."));
-    int secondLength = amountList[1].length();
-    amount.append(18 - secondLength, '0');
-    amount = std::regex_replace(amount, std::regex("."), "");
-
-    return BigNumberFloat(amount, 10);
+Amount Transaction::visibleToAmount(std::string amount) {
+    return amount.empty() ? Amount() : Amount::fromVisible(amount);
 }
 
-QString Transaction::amountToVisible(const BigNumberFloat &number) {
-    if (number == 0)
-        return "0";
-
-    QByteArray numberArr = number.toByteArray(10);
-    bool minus = false;
-
-    if (numberArr[0] == '-') {
-        numberArr = numberArr.remove(0, 1);
-        minus = true;
-    }
-
-    QString second = numberArr.right(18); // TODO
-    second = QString("0").repeated(18 - second.length()).toLatin1() + second;
-    second = second.remove(QRegularExpression("[0]*$"));
-    QByteArray first = numberArr.left(numberArr.length() - 18);
-
-    QByteArray numberDec = (first.isEmpty() ? QByteArray("0") : first)
-        + (second.toLatin1() == QByteArray("0") || second.isEmpty() ? QByteArray("")
-                                                                    : QByteArray(".") + second.toLatin1());
-
-    return (minus ? "-" : "") + numberDec;
+QString Transaction::amountToVisible(const Amount &number) {
+    return QString::fromStdString(number.toVisible());
 }
 
-BigNumberFloat Transaction::amountNormalizeMul(const BigNumberFloat &number) {
-    QByteArray n = number.toByteArray(10);
-    if (n.length() < 36)
-        return number;
-    return BigNumberFloat(n.chopped(18).toStdString(), 10);
+Amount Transaction::amountMul(const Amount &number1, const Amount &number2) {
+    return number1.mul(number2);
 }
 
-BigNumberFloat Transaction::amountMul(const BigNumberFloat &number1, const BigNumberFloat &number2) {
-    QByteArray one = Transaction::amountToVisible(number1).toLatin1();
-    QByteArray two = Transaction::amountToVisible(number1).toLatin1();
-    int index1 = one.indexOf(".");
-    int index2 = two.indexOf(".");
-    int div1 = one.size() - index1 - 1;
-    int div2 = two.size() - index2 - 1;
-    BigNumberFloat returned1 = index1 == -1 ? 1 : BigNumberFloat(10).pow(div1);
-    BigNumberFloat returned2 = index2 == -1 ? 1 : BigNumberFloat(10).pow(div2);
-
-    BigNumberFloat number = (number1 * returned1) * (number2 * returned2);
-
-    return amountNormalizeMul(number) / returned1 / returned2;
-}
-
-BigNumberFloat Transaction::amountDiv(const BigNumberFloat &number1, const BigNumberFloat &number2) {
-    QByteArray two = Transaction::amountToVisible(number2).toLatin1();
-    int index = two.indexOf(".");
-    int div = two.size() - index - 1;
-    QByteArray newTwoByte = two.remove(index, 1);
-
-    BigNumberFloat returned = index == -1 ? 1 : BigNumberFloat(10).pow(div);
-    auto second = BigNumberFloat(newTwoByte.toStdString(), 10);
-    if (second == 0)
+Amount Transaction::amountDiv(const Amount &number1, const Amount &number2) {
+    if (number2.isEmpty())
         return 0;
-
-    return number1 * returned / second;
+    return number1.div(number2);
 }
 
-BigNumberFloat Transaction::amountPercent(BigNumberFloat number, uint percent) {
+Amount Transaction::amountPercent(Amount number, uint percent) {
     if (percent > 100)
         percent = 100;
     return number * percent / 100;
@@ -31,13 +31,12 @@ string SecretKey::getKeyFromPass(const string &pass, const string &salt) {
     return skey;
 }
 
-std::string SecretKey::sign(const std::string &data, const std::string &secret_key) {
-    std::vector<unsigned char> sk(secret_key.begin(), secret_key.end());
-    std::vector<unsigned char> vmsg(data.begin(), data.end());
-    std::vector<unsigned char> vsig(crypto_sign_BYTES);
-    crypto_sign_detached(vsig.data(), NULL, vmsg.data(), vmsg.size(), sk.data());
-    std::string sig = std::string(vsig.begin(), vsig.end());
-    return base64_encode(sig);
+std::string SecretKey::sign(std::string_view data, const std::string &secret_key) {
+    auto *sk = reinterpret_cast<const unsigned char *>(secret_key.data());
+    auto *msg = reinterpret_cast<const unsigned char *>(data.data());
+    unsigned char sig[crypto_sign_BYTES];
+    crypto_sign_detached(sig, NULL, msg, data.size(), sk);
+    return base64_encode(sig, crypto_sign_BYTES);
 }
 
 bool SecretKey::verify(const std::string &data, const std::string &public_key, const std::string &signature) {
@@ -220,3 +219,39 @@ std::string SecretKey::decryptAsymmetric(const std::string &data, const std::str
 
     return res;
 }
+
+std::string SecretKey::asymmetricSharedKey(const std::string &secret_key, const std::string &public_key) {
+    if (secret_key.empty() || public_key.empty())
+        qFatal("[SecretKey::asymmetricSharedKey] secret or public is empty");
+
+    auto *sk = reinterpret_cast<const unsigned char *>(secret_key.data());
+    auto *pk = reinterpret_cast<const unsigned char *>(public_key.data());
+    vector<unsigned char> xsk(crypto_scalarmult_curve25519_BYTES);
+    crypto_sign_ed25519_sk_to_curve25519(xsk.data(), sk);
+    vector<unsigned char> xpk(crypto_scalarmult_curve25519_BYTES);
+    if (crypto_sign_ed25519_pk_to_curve25519(xpk.data(), pk) != 0)
+        return "";
+
+    vector<unsigned char> shared(crypto_box_BEFORENMBYTES);
+    if (crypto_box_beforenm(shared.data(), xpk.data(), xsk.data()) != 0)
+        return "";
+    return string(shared.begin(), shared.end());
+}
+
+bool SecretKey::encryptAsymmetricTo(std::string &result, std::string_view data, const std::string &shared_key) {
+    if (data.empty() || shared_key.size() != crypto_box_BEFORENMBYTES)
+        return false;
+
+    static_assert(asymmetricOverhead == crypto_box_NONCEBYTES + crypto_box_MACBYTES);
+    result.resize(asymmetricOverhead + data.size());
+    auto *out = reinterpret_cast<unsigned char *>(result.data());
+    auto *msg = reinterpret_cast<const unsigned char *>(data.data());
+    auto *key = reinterpret_cast<const unsigned char *>(shared_key.data());
+    randombytes_buf(out, crypto_box_NONCEBYTES);
+    int r = crypto_box_easy_afternm(out + crypto_box_NONCEBYTES, msg, data.size(), out, key);
+    if (r != 0) {
+        result.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,219 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "enc/file_cipher.h"
+
+#include <QDebug>
+
+#include <sodium.h>
+
+namespace {
+void putLittle(std::string &data, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++)
+        data.push_back(char((value >> (8 * i)) & 0xff));
+}
+
+uint64_t getLittle(std::string_view data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+        value |= uint64_t(uint8_t(data[i])) << (8 * i);
+    return value;
+}
+}
+
+const std::string FileCipher::MAGIC = "XCEF";
+
+std::string FileCipher::Header::serialize() const {
+    std::string data = MAGIC;
+    data.push_back(char(version));
+    data.append(3, '\0');
+    putLittle(data, chunkSize, 4);
+    putLittle(data, size, 8);
+    data += fileId;
+    return data;
+}
+
+std::optional<FileCipher::Header> FileCipher::Header::parse(std::string_view data) {
+    if (data.size() < HEADER_SIZE || data.substr(0, MAGIC.size()) != MAGIC)
+        return {};
+
+    Header header;
+    header.version = uint8_t(data[4]);
+    header.chunkSize = uint32_t(getLittle(data.substr(8), 4));
+    header.size = getLittle(data.substr(12), 8);
+    header.fileId = std::string(data.substr(20, FILE_ID_SIZE));
+    if (header.version != VERSION || header.chunkSize == 0 || header.chunkSize > MAX_CHUNK_SIZE)
+        return {};
+    return header;
+}
+
+FileCipher::FileCipher(const std::string &secretKey)
+    : m_secretKey(secretKey) {
+    static_assert(CHUNK_OVERHEAD
+                  == crypto_secretstream_xchacha20poly1305_HEADERBYTES
+                      + crypto_secretstream_xchacha20poly1305_ABYTES);
+}
+
+bool FileCipher::encryptFile(const std::filesystem::path &file, const std::filesystem::path &resultFile,
+                             uint32_t chunkSize) {
+    std::ifstream source(file, std::ios::binary);
+    std::ofstream result(resultFile, std::ios::binary | std::ios::trunc);
+    if (!source || !result || chunkSize == 0 || chunkSize > MAX_CHUNK_SIZE) {
+        qDebug() << "[FileCipher] Can't encrypt" << file.string().c_str();
+        return false;
+    }
+
+    Header header { .version = VERSION,
+                    .chunkSize = chunkSize,
+                    .size = std::filesystem::file_size(file),
+                    .fileId = std::string(FILE_ID_SIZE, '\0') };
+    randombytes_buf(header.fileId.data(), header.fileId.size());
+    m_header = header;
+    m_headerData = header.serialize();
+    m_key = fileKey(header.fileId);
+    result.write(m_headerData.data(), std::streamsize(m_headerData.size()));
+
+    std::string chunk(chunkSize, '\0');
+    std::string encrypted;
+    const uint64_t count = chunkCount();
+    for (uint64_t index = 0; index < count; index++) {
+        source.read(chunk.data(), chunkSize);
+        const auto read = std::size_t(source.gcount());
+        if (!encryptChunk(encrypted, std::string_view(chunk.data(), read), index, index + 1 == count))
+            return false;
+        result.write(encrypted.data(), std::streamsize(encrypted.size()));
+    }
+    return bool(result);
+}
+
+bool FileCipher::decryptFile(const std::filesystem::path &file, const std::filesystem::path &resultFile) {
+    if (!open(file))
+        return false;
+
+    std::ofstream result(resultFile, std::ios::binary | std::ios::trunc);
+    std::string chunk;
+    for (uint64_t index = 0; index < chunkCount(); index++) {
+        if (!readChunk(index, chunk)) {
+            qDebug() << "[FileCipher] Corrupted chunk" << index << "of" << file.string().c_str();
+            return false;
+        }
+        result.write(chunk.data(), std::streamsize(chunk.size()));
+    }
+    return bool(result);
+}
+
+bool FileCipher::open(const std::filesystem::path &file) {
+    m_file = std::ifstream(file, std::ios::binary);
+    std::string data(HEADER_SIZE, '\0');
+    if (!m_file.read(data.data(), std::streamsize(data.size())))
+        return false;
+
+    auto header = Header::parse(data);
+    if (!header)
+        return false;
+    m_header = *header;
+    m_headerData = data;
+    m_key = fileKey(m_header.fileId);
+    return true;
+}
+
+uint64_t FileCipher::size() const {
+    return m_header.size;
+}
+
+uint32_t FileCipher::chunkSize() const {
+    return m_header.chunkSize;
+}
+
+uint64_t FileCipher::chunkCount() const {
+    // empty file has one empty chunk, it authenticates the header
+    return std::max<uint64_t>(1, (m_header.size + m_header.chunkSize - 1) / m_header.chunkSize);
+}
+
+bool FileCipher::readChunk(uint64_t index, std::string &data) {
+    if (m_key.empty() || index >= chunkCount())
+        return false;
+
+    const uint64_t offset = index * m_header.chunkSize;
+    const uint64_t plainSize = std::min<uint64_t>(m_header.chunkSize, m_header.size - offset);
+    m_buffer.resize(plainSize + CHUNK_OVERHEAD);
+    m_file.clear();
+    m_file.seekg(std::streamoff(HEADER_SIZE + index * (m_header.chunkSize + CHUNK_OVERHEAD)));
+    if (!m_file.read(m_buffer.data(), std::streamsize(m_buffer.size())))
+        return false;
+
+    crypto_secretstream_xchacha20poly1305_state state;
+    auto *in = reinterpret_cast<const unsigned char *>(m_buffer.data());
+    auto *key = reinterpret_cast<const unsigned char *>(m_key.data());
+    if (crypto_secretstream_xchacha20poly1305_init_pull(&state, in, key) != 0)
+        return false;
+
+    std::string ad = m_headerData;
+    putLittle(ad, index, 8);
+    data.resize(plainSize);
+    unsigned char tag = 0;
+    int r = crypto_secretstream_xchacha20poly1305_pull(
+        &state, reinterpret_cast<unsigned char *>(data.data()), nullptr, &tag,
+        in + crypto_secretstream_xchacha20poly1305_HEADERBYTES,
+        m_buffer.size() - crypto_secretstream_xchacha20poly1305_HEADERBYTES,
+        reinterpret_cast<const unsigned char *>(ad.data()), ad.size());
+
+    const bool last = index + 1 == chunkCount();
+    const unsigned char expectedTag = last ? crypto_secretstream_xchacha20poly1305_TAG_FINAL
+                                           : crypto_secretstream_xchacha20poly1305_TAG_MESSAGE;
+    return r == 0 && tag == expectedTag;
+}
+
+bool FileCipher::isEncrypted(const std::filesystem::path &file) {
+    std::ifstream stream(file, std::ios::binary);
+    std::string data(HEADER_SIZE, '\0');
+    return stream.read(data.data(), std::streamsize(data.size())) && Header::parse(data).has_value();
+}
+
+std::string FileCipher::fileKey(const std::string &fileId) const {
+    static const std::string context = "ExtraChain file key";
+    const std::string input = context + fileId;
+    std::string key(crypto_secretstream_xchacha20poly1305_KEYBYTES, '\0');
+    const std::size_t keySize = std::min<std::size_t>(m_secretKey.size(), crypto_generichash_KEYBYTES_MAX);
+    crypto_generichash(reinterpret_cast<unsigned char *>(key.data()), key.size(),
+                       reinterpret_cast<const unsigned char *>(input.data()), input.size(),
+                       reinterpret_cast<const unsigned char *>(m_secretKey.data()), keySize);
+    return key;
+}
+
+bool FileCipher::encryptChunk(std::string &result, std::string_view data, uint64_t index, bool last) const {
+    result.resize(data.size() + CHUNK_OVERHEAD);
+    auto *out = reinterpret_cast<unsigned char *>(result.data());
+    auto *key = reinterpret_cast<const unsigned char *>(m_key.data());
+
+    crypto_secretstream_xchacha20poly1305_state state;
+    if (crypto_secretstream_xchacha20poly1305_init_push(&state, out, key) != 0)
+        return false;
+
+    std::string ad = m_headerData;
+    putLittle(ad, index, 8);
+    const unsigned char tag = last ? crypto_secretstream_xchacha20poly1305_TAG_FINAL
+                                   : crypto_secretstream_xchacha20poly1305_TAG_MESSAGE;
+    return crypto_secretstream_xchacha20poly1305_push(
+               &state, out + crypto_secretstream_xchacha20poly1305_HEADERBYTES, nullptr,
+               reinterpret_cast<const unsigned char *>(data.data()), data.size(),
+               reinterpret_cast<const unsigned char *>(ad.data()), ad.size(), tag)
+        == 0;
+}
@@ -19,6 +19,7 @@
 
 #include "enc/key_private.h"
 #include "enc/enc_tools.h"
+#include "enc/file_cipher.h"
 #include "utils/dfs_utils.h"
 #include "utils/exc_utils.h"
 
@@ -62,42 +63,48 @@ std::string KeyPrivate::decryptSelf(const std::string &data) const {
     return this->decrypt(data, this->m_publicKey, pnonce);
 }
 
-void KeyPrivate::encryptFile(const std::filesystem::path &file,
+bool KeyPrivate::encryptFile(const std::filesystem::path &file,
                              const std::filesystem::path &resultFile) const {
-    std::ifstream sfile(file.string(), std::ios::binary);
-    std::ofstream efile(resultFile.string(), std::ios::binary | std::ios::app);
-    if (sfile && efile) {
-        std::string buf;
-        while (sfile.readsome(buf.data(), DFSB::encSectionSize)) {
-            std::string wstring = encryptSelf(buf);
-            wstring = Tools::typeToStdStringBytes<int>(wstring.size()) + wstring;
-            efile << wstring;
-        }
-        return;
+    FileCipher cipher(m_secretKey);
+    if (!cipher.encryptFile(file, resultFile)) {
+        qDebug() << "file encryption error";
+        return false;
     }
-    qDebug() << "file encryption error";
+    return true;
 }
 
-void KeyPrivate::decryptFile(const std::filesystem::path &file,
+bool KeyPrivate::decryptFile(const std::filesystem::path &file,
                              const std::filesystem::path &resultFile) const {
+    if (FileCipher::isEncrypted(file)) {
+        FileCipher cipher(m_secretKey);
+        if (!cipher.decryptFile(file, resultFile)) {
+            qDebug() << "file decryption error";
+            return false;
+        }
+        return true;
+    }
+
+    // old format: int size and encryptSelf of every encSectionSize bytes
     std::ifstream efile(file.string(), std::ios::binary);
-    std::ofstream sfile(resultFile.string(), std::ios::binary | std::ios::app);
+    std::ofstream sfile(resultFile.string(), std::ios::binary | std::ios::trunc);
     if (efile && sfile) {
-        std::string buf;
-        std::string sizebuf;
-        int size;
-        while (efile.readsome(sizebuf.data(), sizeof(int))) {
-            size = Tools::stdStringBytesToType<int>(sizebuf);
-            efile.readsome(buf.data(), size);
-            std::string wstring = decryptSelf(buf);
-            sfile << wstring;
+        std::string sizebuf(sizeof(int), '\0');
+        while (efile.read(sizebuf.data(), std::streamsize(sizebuf.size()))) {
+            const int size = Tools::stdStringBytesToType<int>(sizebuf);
+            if (size <= 0)
+                return false;
+            std::string buf(std::size_t(size), '\0');
+            if (!efile.read(buf.data(), size))
+                return false;
+            sfile << decryptSelf(buf);
         }
-        return;
+        return true;
     }
     qDebug() << "file decryption error";
+    return false;
 }
 
-std::string KeyPrivate::sign(const std::string &data) const {
+std::string KeyPrivate::sign(std::string_view data) const {
     return SecretKey::sign(data, m_secretKey);
 }
 
@@ -63,7 +63,7 @@ Transaction DataMiningManager::makeRewardTx(const MessageBody &mb) {
     qDebug() << "result: " << result;
 
     Transaction rewardTx;
-    rewardTx.setAmount(result);
+    rewardTx.setAmount(Amount::fromString(result.toStdString(10)));
     rewardTx.setReceiver(mb.sender_id);
     rewardTx.setSender(node->actorIndex()->firstId());
     rewardTx.setTypeTx(TypeTx::RewardTransaction);
@@ -79,7 +79,7 @@ void DataMiningManager::coinRewardRequest(const BigNumber &blockIndex) {
     if (blockIndex % CoinProductionRate == 0) {
         qDebug() << "Make reward request" << std::stoi(blockIndex.toStdString(10));
         DFSP::StateMessage stateMessage;
-        stateMessage.DataAmountStored = node->dfs()->calculateDataAmountStored();
+        stateMessage.DataAmountStored = node->dfs()->dataAmountStored();
         node->network()->send_message(stateMessage, MessageType::DfsState, MessageStatus::Response,
                                       "234234234312345", Config::Net::TypeSend::All);
     }
@@ -34,6 +34,7 @@
 #include "managers/data_mining_manager.h"
 #include "managers/thread_pool.h"
 #include "managers/tx_manager.h"
+#include "network/metrics_server.h"
 #include "network/network_manager.h"
 
 ExtraChainNode::ExtraChainNode() {
@@ -69,6 +70,9 @@ ExtraChainNode::ExtraChainNode() {
     connect(&getAllActorsTimer, &QTimer::timeout, this, &ExtraChainNode::getAllActorsTimerCall);
     getAllActorsTimer.start(30000);
 
+    if (qEnvironmentVariableIsSet("EXTRACHAIN_METRICS_PORT"))
+        startMetrics(quint16(qEnvironmentVariableIntValue("EXTRACHAIN_METRICS_PORT")));
+
     // ThreadPool::addThread(m_blockchain);
     // ThreadPool::addThread(m_txManager);
 }
@@ -212,7 +216,7 @@ Transaction ExtraChainNode::createTransaction(Transaction tx) {
     return tx;
 }
 
-Transaction ExtraChainNode::createTransaction(ActorId receiver, BigNumberFloat amount, ActorId token) {
+Transaction ExtraChainNode::createTransaction(ActorId receiver, Amount amount, ActorId token) {
     if (receiver.isEmpty() || amount.isEmpty()) {
         qDebug() << QString("Warning: can not create tx without receiver or amount");
         return Transaction();
@@ -287,7 +291,7 @@ bool ExtraChainNode::importUser(const std::string &data, const std::string &logi
     return true;
 }
 
-Transaction ExtraChainNode::createTransactionFrom(ActorId sender, ActorId receiver, BigNumberFloat amount,
+Transaction ExtraChainNode::createTransactionFrom(ActorId sender, ActorId receiver, Amount amount,
                                                   ActorId token) {
     if (receiver.isEmpty() || amount.isEmpty()) {
         qDebug() << QString("Warning: can not create tx without receiver or amount");
@@ -330,6 +334,12 @@ void ExtraChainNode::createNetworkIdentifier() {
     file.close();
 }
 
+bool ExtraChainNode::startMetrics(quint16 port) {
+    if (m_metrics == nullptr)
+        m_metrics = new MetricsServer(this);
+    return m_metrics->listen(port);
+}
+
 void ExtraChainNode::notificationToken(QString os, QString actorId, QString token) {
     if (os.isEmpty() || actorId.isEmpty() || token.isEmpty())
         return;
@@ -0,0 +1,172 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "managers/log_writer.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+std::atomic<uint64_t> nextWriterId = 1;
+}
+
+LogWriter::Ring::Ring(std::size_t size)
+    : slots(size) {
+}
+
+LogWriter::LogWriter(Sink sink, std::size_t ringSize)
+    : m_sink(std::move(sink))
+    , m_ringSize(std::max<std::size_t>(ringSize, 2))
+    , m_id(nextWriterId++) {
+    m_thread = std::thread([this] { run(); });
+}
+
+LogWriter::~LogWriter() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+bool LogWriter::push(Record record) {
+    Ring &ring = this->ring();
+    const uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    uint64_t used = tail - ring.head.load(std::memory_order_acquire);
+    if (used >= ring.slots.size()) {
+        // short burst is waited out, writer needs only a moment to drain
+        m_urgent = true;
+        m_wake.notify_one();
+        for (int i = 0; i < FULL_RETRIES && used >= ring.slots.size(); i++) {
+            std::this_thread::yield();
+            used = tail - ring.head.load(std::memory_order_acquire);
+        }
+        if (used >= ring.slots.size()) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    record.seq = m_seq.fetch_add(1, std::memory_order_relaxed);
+    ring.slots[tail % ring.slots.size()] = std::move(record);
+    ring.tail.store(tail + 1, std::memory_order_release);
+    // don't wait for interval when ring fills up
+    if (used + 1 == ring.slots.size() / 2) {
+        m_urgent = true;
+        m_wake.notify_one();
+    }
+    return true;
+}
+
+void LogWriter::flush() {
+    if (std::this_thread::get_id() == m_thread.get_id())
+        return;
+    std::unique_lock lock(m_mutex);
+    if (m_stop)
+        return;
+    const uint64_t target = ++m_flushRequested;
+    m_wake.notify_one();
+    m_flushed.wait(lock, [&] { return m_flushDone >= target; });
+}
+
+LogWriter::Stats LogWriter::stats() const {
+    return { .records = m_records, .dropped = m_dropped, .batches = m_batches };
+}
+
+LogWriter::Ring &LogWriter::ring() {
+    // id instead of address, writer could be destroyed and another one created at the same place
+    thread_local uint64_t cachedWriter = 0;
+    thread_local std::shared_ptr<Ring> cached;
+    if (cachedWriter == m_id)
+        return *cached;
+
+    std::lock_guard lock(m_mutex);
+    auto &ring = m_rings[std::this_thread::get_id()];
+    if (!ring)
+        ring = std::make_shared<Ring>(m_ringSize);
+    cachedWriter = m_id;
+    cached = ring;
+    return *ring;
+}
+
+void LogWriter::run() {
+    std::vector<Record> batch;
+    while (true) {
+        uint64_t requested = 0;
+        bool stop = false;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL),
+                            [this] { return m_stop || m_urgent || m_flushRequested > m_flushDone; });
+            m_urgent = false;
+            requested = m_flushRequested;
+            stop = m_stop;
+        }
+
+        drain(batch);
+        m_records += batch.size();
+        if (!batch.empty())
+            m_batches++;
+        m_sink(batch);
+        batch.clear();
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_flushDone = requested;
+        }
+        m_flushed.notify_all();
+        if (stop)
+            return;
+    }
+}
+
+void LogWriter::drain(std::vector<Record> &batch) {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard lock(m_mutex);
+        // ring is only held here after its thread is finished
+        std::erase_if(m_rings, [](const auto &item) {
+            const auto &ring = item.second;
+            return ring.use_count() == 1 && ring->head == ring->tail;
+        });
+        rings.reserve(m_rings.size());
+        for (const auto &[id, ring] : m_rings)
+            rings.push_back(ring);
+    }
+
+    for (const auto &ring : rings) {
+        const uint64_t head = ring->head.load(std::memory_order_relaxed);
+        const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        for (uint64_t i = head; i < tail; i++)
+            batch.push_back(std::move(ring->slots[i % ring->slots.size()]));
+        ring->head.store(tail, std::memory_order_release);
+    }
+    std::sort(batch.begin(), batch.end(), [](const Record &a, const Record &b) { return a.seq < b.seq; });
+
+    const uint64_t dropped = m_dropped;
+    if (dropped != m_reportedDropped) {
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        batch.push_back({ .seq = m_seq++,
+                          .time = std::chrono::duration_cast<std::chrono::milliseconds>(now).count(),
+                          .message = QString("[Logs] %1 messages dropped").arg(dropped - m_reportedDropped) });
+        m_reportedDropped = dropped;
+    }
+}
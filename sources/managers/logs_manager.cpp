@@ -26,6 +26,7 @@
 #include <fmt/core.h>
 
 #include <QJsonObject>
+#include <QMetaObject>
 #include <QMutex>
 
 #ifdef Q_OS_ANDROID
@@ -49,6 +50,28 @@ VariantModel LogsManager::logs = VariantModel(nullptr, { "text", "date", "file",
 QStringList LogsManager::filesFilter;
 bool LogsManager::antiFilter = false;
 bool LogsManager::debugLogs = false;
+QString LogsManager::logsPath = "logs";
+qint64 LogsManager::maxFileSize = 64 * 1024 * 1024;
+int LogsManager::maxFiles = 16;
+
+namespace {
+QMutex fileMutex;
+QFile logFile;
+qint64 logFileSize = 0;
+// used by writer thread only
+QVariantList modelRows;
+qint64 modelUpdated = 0;
+
+struct AsyncLog {
+    std::unique_ptr<LogWriter> writer; // kept when logging is switched off, handler can still use it
+    std::atomic<LogWriter *> active = nullptr;
+
+    ~AsyncLog() {
+        active = nullptr;
+        writer.reset();
+    }
+} asyncLog;
+}
 
 LogsManager::LogsManager() {
     // connect(this, &LogsManager::makeLogSignal, this, &LogsManager::makeLog);
@@ -57,17 +80,20 @@ LogsManager::LogsManager() {
 void LogsManager::messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg) {
     // static LogsManager logsManager;
     // emit logsManager.makeLogSignal(context.file, context.line, context.function, msg);
+    QString message;
     switch (type) {
     case QtInfoMsg:
-        makeLog(context.file, context.line, context.function, msg);
+        message = msg;
         break;
     case QtCriticalMsg:
-        makeLog(context.file, context.line, context.function, "[Critical] " + msg);
+        message = "[Critical] " + msg;
         break;
     case QtFatalMsg: {
+        // process is aborted after handler, queued messages go first
+        flush();
         makeLog(context.file, context.line, context.function, "[Fatal Error] " + msg);
 
-        QFile file("logs/extrachain-fatal.log");
+        QFile file(logsPath + "/extrachain-fatal.log");
         if (file.open(QFile::Append)) {
             QJsonObject json;
             json["time"] = QDateTime::currentDateTime().toString("yyyy.MM.dd hh:mm:ss ap");
@@ -80,27 +106,53 @@ void LogsManager::messageHandler(QtMsgType type, const QMessageLogContext& conte
             file.write(QJsonDocument(json).toJson(QJsonDocument::Compact) + "\n");
             file.close();
         }
-        break;
+        return;
     }
     default:
-        if (debugLogs)
-            makeLog(context.file, context.line, context.function, msg);
+        if (!debugLogs)
+            return;
+        message = msg;
         break;
     }
+
+    if (auto writer = asyncLog.active.load()) {
+        writer->push({ .time = QDateTime::currentMSecsSinceEpoch(),
+                       .message = std::move(message),
+                       .file = context.file ? context.file : "",
+                       .function = context.function ? context.function : "",
+                       .line = context.line });
+        return;
+    }
+    makeLog(context.file, context.line, context.function, message);
 }
 
 void LogsManager::makeLog(const QString& file, int line, const QString& function, const QString& msg) {
+    QString logStr;
+    QVariantMap row;
+    const auto dateTime = QDateTime::currentDateTime();
+    if (!formatLog(file, line, function, msg, dateTime, logStr, row))
+        return;
+
+    if (LogsManager::toConsole)
+        print(logStr.toStdString());
+
+    if (LogsManager::toModel) {
+        static QMutex mutex;
+        mutex.lock();
+        logs.append(row);
+        mutex.unlock();
+    }
+
+    if (LogsManager::toFile)
+        writeFile(QString("%1 %2\n").arg(dateTime.toString("yyyy-MM-dd"), logStr).toUtf8());
+}
+
+bool LogsManager::formatLog(const QString& file, int line, const QString& function, const QString& msg,
+                            const QDateTime& dateTime, QString& logStr, QVariantMap& row) {
     Q_UNUSED(file)
     Q_UNUSED(line)
     Q_UNUSED(function)
-    static QFile logFile("logs/extrachain" + QDateTime::currentDateTime().toString("-MM-dd-hh.mm.ss")
-                         + ".log");
-
-    if (LogsManager::toFile && !logFile.isOpen())
-        logFile.open(QFile::Append | QFile::Text);
-
     QString message = msg;
-    QDateTime currentDateTime = QDateTime::currentDateTime();
 
 #ifdef LOG_FILENAME
     // TODO: to std::string
@@ -117,7 +169,7 @@ void LogsManager::makeLog(const QString& file, int line, const QString& function
     }
 
     if (!isPrint)
-        return;
+        return false;
 
     QString fileNameQrc, lineRow;
     if (fileName.right(3) == "qml") {
@@ -146,7 +198,7 @@ void LogsManager::makeLog(const QString& file, int line, const QString& function
         fileNameStd = "global";
 #endif
 
-    const QString logStr = currentDateTime.toString("hh:mm:ss ")
+    logStr = dateTime.toString("hh:mm:ss ")
 #ifdef LOG_FILENAME
         + "["
         + (fileNameQrc.length() ? fileNameQrc
@@ -155,34 +207,81 @@ void LogsManager::makeLog(const QString& file, int line, const QString& function
 #endif
         + message;
 
-    if (LogsManager::toConsole) {
+    if (LogsManager::toModel) {
+        row = { { "text", msg },
+                { "date", dateTime.toMSecsSinceEpoch() }
 #ifdef LOG_FILENAME
-        if (isPrint)
+                ,
+                { "file", fileName },
+                { "line", line },
+                { "func", function }
 #endif
-            print(logStr.toStdString());
+        };
+    }
+    return true;
+}
+
+void LogsManager::writeFile(const QByteArray& data) {
+    QMutexLocker locker(&fileMutex);
+    if (!logFile.isOpen()) {
+        QDir dir(logsPath);
+        dir.mkpath(".");
+        if (maxFiles > 0) {
+            // new file is one of maxFiles
+            auto files = dir.entryInfoList({ "extrachain-*.log" }, QDir::Files, QDir::Time);
+            files.removeIf([](const QFileInfo& info) { return info.fileName() == "extrachain-fatal.log"; });
+            for (qsizetype i = maxFiles - 1; i < files.size(); i++)
+                QFile::remove(files[i].filePath());
+        }
+
+        const QString name = "extrachain" + QDateTime::currentDateTime().toString("-MM-dd-hh.mm.ss");
+        QString path = dir.filePath(name + ".log");
+        for (int i = 1; QFile::exists(path); i++)
+            path = dir.filePath(QString("%1-%2.log").arg(name).arg(i));
+        logFile.setFileName(path);
+        if (!logFile.open(QFile::Append | QFile::Text))
+            return;
+        logFileSize = 0;
     }
 
-    if (LogsManager::toModel) {
-        static QMutex mutex;
-        mutex.lock();
-        logs.append({ { "text", msg },
-                      { "date", currentDateTime.toMSecsSinceEpoch() }
-#ifdef LOG_FILENAME
-                      ,
-                      { "file", fileName },
-                      { "line", line },
-                      { "func", function }
-#endif
-        });
-        mutex.unlock();
+    logFile.write(data);
+    logFile.flush();
+    logFileSize += data.size();
+    if (maxFileSize > 0 && logFileSize >= maxFileSize)
+        logFile.close(); // next write opens new file
+}
+
+void LogsManager::writeBatch(std::vector<LogWriter::Record>& batch) {
+    QByteArray console, file;
+    for (const auto& record : batch) {
+        QString logStr;
+        QVariantMap row;
+        const auto dateTime = QDateTime::fromMSecsSinceEpoch(record.time);
+        if (!formatLog(QString::fromStdString(record.file), record.line,
+                       QString::fromStdString(record.function), record.message, dateTime, logStr, row))
+            continue;
+
+        const QByteArray line = logStr.toUtf8();
+        if (toConsole)
+            console += (console.isEmpty() ? "" : "\n") + line;
+        if (toFile)
+            file += dateTime.toString("yyyy-MM-dd ").toUtf8() + line + "\n";
+        if (toModel)
+            modelRows.append(row);
     }
 
-    if (LogsManager::toFile && logFile.isWritable()) {
-        static QMutex mutex;
-        mutex.lock();
-        logFile.write(QString("%1 %2\n").arg(currentDateTime.toString("yyyy-MM-dd"), logStr).toUtf8());
-        logFile.flush();
-        mutex.unlock();
+    if (!console.isEmpty())
+        print(console.toStdString());
+    if (!file.isEmpty())
+        writeFile(file);
+
+    // model belongs to main thread, rows are added there in one insert
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (!modelRows.isEmpty() && now - modelUpdated >= MODEL_INTERVAL) {
+        QMetaObject::invokeMethod(
+            &logs, [rows = std::move(modelRows)] { logs.inserts(logs.count(), rows); }, Qt::QueuedConnection);
+        modelRows = {};
+        modelUpdated = now;
     }
 }
 
@@ -225,7 +324,7 @@ void LogsManager::offConsole() {
 }
 
 void LogsManager::onFile() {
-    QDir().mkpath("logs");
+    QDir().mkpath(logsPath);
     LogsManager::toFile = true;
 }
 
@@ -243,6 +342,7 @@ void LogsManager::offQml() {
 
 void LogsManager::etHandler() {
     std::ios_base::sync_with_stdio(false);
+    setAsync(true);
     qInstallMessageHandler(LogsManager::messageHandler);
 
 #ifdef Q_OS_WIN
@@ -252,6 +352,7 @@ void LogsManager::etHandler() {
 
 void LogsManager::qtHandler() {
     qInstallMessageHandler(nullptr);
+    setAsync(false);
 }
 
 void LogsManager::emptyHandler() {
@@ -260,6 +361,7 @@ void LogsManager::emptyHandler() {
         Q_UNUSED(context)
         Q_UNUSED(msg)
     });
+    setAsync(false);
 }
 
 void LogsManager::print(const std::string& log) {
@@ -281,6 +383,28 @@ void LogsManager::setDebugLogs(bool debugLogs) {
     LogsManager::debugLogs = debugLogs;
 }
 
+void LogsManager::setAsync(bool async) {
+    if (!async) {
+        asyncLog.active = nullptr;
+        flush();
+        return;
+    }
+    if (!asyncLog.writer)
+        asyncLog.writer = std::make_unique<LogWriter>(&LogsManager::writeBatch);
+    asyncLog.active = asyncLog.writer.get();
+}
+
+void LogsManager::flush() {
+    if (asyncLog.writer)
+        asyncLog.writer->flush();
+}
+
+void LogsManager::setRotation(qint64 maxFileSize, int maxFiles) {
+    QMutexLocker locker(&fileMutex);
+    LogsManager::maxFileSize = maxFileSize;
+    LogsManager::maxFiles = maxFiles;
+}
+
 void LogsManager::setAntiFilter(bool value) {
     antiFilter = value;
 }
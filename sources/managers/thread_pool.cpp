@@ -17,7 +17,158 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  */
 
+
 #include "managers/thread_pool.h"
 
-bool ThreadPool::isFirst = true;
-QList<QThread *> ThreadPool::threads = {};
+#include <algorithm>
+
+#include <QDebug>
+
+namespace {
+// pool and index of worker running on this thread
+thread_local ThreadPool *currentPool = nullptr;
+thread_local std::size_t currentIndex = 0;
+}
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 0; i < threads; i++)
+        m_workers.push_back(std::make_unique<Worker>());
+    for (std::size_t i = 0; i < threads; i++)
+        m_threads.emplace_back([this, i] { work(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &thread : m_threads)
+        thread.join();
+}
+
+ThreadPool &ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::post(Task task, Priority priority) {
+    const auto level = std::size_t(priority);
+    const std::size_t index = currentPool == this ? currentIndex : m_next++ % m_workers.size();
+    m_pending++;
+    {
+        auto &worker = *m_workers[index];
+        std::lock_guard lock(worker.mutex);
+        worker.queues[level].push_back(std::move(task));
+    }
+    m_queued[level]++;
+    {
+        std::lock_guard lock(m_mutex); // worker can't miss the wake between its check and wait
+    }
+    m_wake.notify_one();
+    if (m_helping > 0)
+        m_idle.notify_all();
+}
+
+void ThreadPool::waitForDone() {
+    if (currentPool != this) {
+        std::unique_lock lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_pending == 0; });
+        return;
+    }
+
+    // worker can't wait for its own task, it runs queued tasks until only waiting ones are left
+    m_helping++;
+    Task task;
+    while (m_pending > m_helping) {
+        if (take(currentIndex, task)) {
+            run(task);
+            continue;
+        }
+        std::unique_lock lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_pending <= m_helping || queued(); });
+    }
+    m_helping--;
+}
+
+std::size_t ThreadPool::size() const {
+    return m_workers.size();
+}
+
+uint64_t ThreadPool::pending() const {
+    return m_pending;
+}
+
+ThreadPool::Stats ThreadPool::stats() const {
+    return { .executed = m_executed, .stolen = m_stolen };
+}
+
+void ThreadPool::work(std::size_t index) {
+    currentPool = this;
+    currentIndex = index;
+
+    Task task;
+    while (true) {
+        if (!take(index, task)) {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || queued(); });
+            if (m_stop && !queued())
+                return;
+            continue;
+        }
+        run(task);
+    }
+}
+
+void ThreadPool::run(Task &task) {
+    try {
+        task();
+    } catch (const std::exception &e) {
+        qDebug() << "[ThreadPool] Task failed:" << e.what();
+    } catch (...) {
+        qDebug() << "[ThreadPool] Task failed";
+    }
+    task = nullptr;
+    m_executed++;
+
+    if (--m_pending <= m_helping) {
+        std::lock_guard lock(m_mutex);
+        m_idle.notify_all();
+    }
+}
+
+bool ThreadPool::queued() const {
+    return std::any_of(m_queued.begin(), m_queued.end(), [](const auto &count) { return count > 0; });
+}
+
+bool ThreadPool::take(std::size_t index, Task &task) {
+    const std::size_t count = m_workers.size();
+    for (std::size_t level = 0; level < PRIORITIES; level++) {
+        if (m_queued[level] == 0)
+            continue;
+
+        for (std::size_t i = 0; i < count; i++) {
+            const std::size_t victim = (index + i) % count;
+            auto &worker = *m_workers[victim];
+            std::lock_guard lock(worker.mutex);
+            auto &queue = worker.queues[level];
+            if (queue.empty())
+                continue;
+
+            // own tasks newest first while their data is warm, stolen ones oldest first
+            if (victim == index) {
+                task = std::move(queue.back());
+                queue.pop_back();
+            } else {
+                task = std::move(queue.front());
+                queue.pop_front();
+                m_stolen++;
+            }
+            m_queued[level]--;
+            return true;
+        }
+    }
+    return false;
+}
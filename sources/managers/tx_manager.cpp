@@ -19,7 +19,12 @@
 
 #include "managers/tx_manager.h"
 
+#include "datastorage/index/actorindex.h"
+#include "managers/account_controller.h"
 #include "managers/extrachain_node.h"
+#include "managers/thread_pool.h"
+#include "network/network_manager.h"
+#include "utils/metrics.h"
 
 QList<Transaction> TransactionManager::getReceivedTxList() const {
     return receivedTxList;
@@ -29,6 +34,13 @@ std::vector<Transaction> TransactionManager::getPendingTxs() const {
     return pendingTxs;
 }
 
+std::optional<TransactionManager::TxState> TransactionManager::txState(const std::string &hash) const {
+    auto it = txStates.find(hash);
+    if (it == txStates.end())
+        return std::nullopt;
+    return it->second;
+}
+
 TransactionManager::TransactionManager(AccountController *accountController, Blockchain *blockchain,
                                        ExtraChainNode *extraChainNode) {
     this->accountController = accountController;
@@ -39,13 +51,6 @@ TransactionManager::TransactionManager(AccountController *accountController, Blo
     blockCreationTimer.setInterval(Config::DataStorage::BLOCK_CREATION_PERIOD);
     connect(&blockCreationTimer, &QTimer::timeout, this, &TransactionManager::makeBlock);
     blockCreationTimer.start();
-
-    // prove timer
-    proveTimer.setInterval(Config::DataStorage::PROVE_TXS_INTERVAL);
-    connect(&proveTimer, &QTimer::timeout, this, &TransactionManager::proveTransactions);
-
-    qDebug() << "start timer:";
-    proveTimer.start();
 }
 
 void TransactionManager::removeTransaction(int i) {
@@ -57,19 +62,26 @@ void TransactionManager::addTransaction(Transaction tx) {
 
     if (tx.isEmpty())
         return;
+    if (!txStates.try_emplace(tx.getHash(), TxState::Received).second) {
+        qDebug() << "TRANSACTION MANAGER: tx is already known" << tx.getHash().c_str();
+        return;
+    }
     receivedTxList.append(tx);
+    scheduleProve();
 }
 
 void TransactionManager::addProvedTransaction(Transaction tx) {
     qDebug() << "addProvedTransaction";
-    if (std::find(pendingTxs.begin(), pendingTxs.end(), tx) != pendingTxs.end())
+    if (std::find(pendingTxs.begin(), pendingTxs.end(), tx) == pendingTxs.end())
         pendingTxs.push_back(tx);
 
+    txStates[tx.getHash()] = TxState::Proved;
     receivedTxList.removeOne(tx);
 }
 
 void TransactionManager::removeUnApprovedTransaction(Transaction tx) {
     receivedTxList.removeOne(tx);
+    setFinished(tx.getHash(), TxState::Rejected);
 }
 
 // Tx hashes (for network)
@@ -99,21 +111,15 @@ void TransactionManager::addVerifiedTx(Transaction tx) {
 
 void TransactionManager::makeBlock() {
     qDebug() << "trying makeBlock";
-    Block lastBlock = blockchain->getLastBlock();
     if (pendingTxs.empty()) {
-        Block lastRealBlock = blockchain->getBlockIndex().getLastRealBlockById();
-        qDebug() << lastRealBlock.getIndex() << lastRealBlock.getType().c_str();
-        // creating dummy block in as ordinary block
-        Block dummyBlock(lastRealBlock.getIndex().toStdString(), lastBlock);
-        dummyBlock.setType(Config::DUMMY_BLOCK_TYPE);
-        blockchain->signBlock(dummyBlock);
-        blockchain->addBlock(dummyBlock);
-
+        sendHeartbeat();
         return;
     }
 
-    // remove all dummy blocks
-    blockchain->removeAllDummyBlocks(lastBlock);
+    // remove dummy blocks left by older versions
+    Block lastBlock = blockchain->getLastBlock();
+    if (lastBlock.getType() == Config::DUMMY_BLOCK_TYPE)
+        blockchain->removeAllDummyBlocks(lastBlock);
     std::string data = convertTxs(pendingTxs);
     qDebug() << "convertTxs" << data.c_str();
     lastBlock = blockchain->getLastRealBlock();
@@ -122,12 +128,126 @@ void TransactionManager::makeBlock() {
     blockchain->signBlock(block);
     qDebug() << "Created block:" << block.getIndex() << block.getDigSig().c_str();
     blockchain->addBlock(block);
+    for (const auto &tx : pendingTxs)
+        setFinished(tx.getHash(), TxState::Included);
     this->pendingTxs.clear();
+    blocksMade++;
+}
+
+void TransactionManager::sendHeartbeat() {
+    static auto &heartbeats = Metrics::counter("extrachain_heartbeats_sent_total", "Tips sent by idle node");
+
+    // idle node announces its tip instead of writing dummy block,
+    // peers behind it start sync, nothing is stored
+    // header index has headers of stored blocks only, tip is read without loading block
+    const BSP::Tip tip = blockchain->localTip();
+    if (tip.Hash.empty())
+        return;
+    extraChainNode->network()->send_message(tip, MessageType::BlockchainTip);
+    heartbeats.inc();
 }
 
 void TransactionManager::proveTransactions() {
-    for (auto tx : receivedTxList) {
-        blockchain->proveTx(tx);
+    static auto &proveTime = Metrics::histogram("extrachain_tx_prove_seconds", "Proving of received txs");
+    static auto &proved = Metrics::counter("extrachain_txs_proved_total", "Received txs sent to prove");
+    static auto &received = Metrics::gauge("extrachain_txs_received", "Received txs waiting for prove");
+    static auto &pending = Metrics::gauge("extrachain_txs_pending", "Proved txs waiting for block");
+    proveScheduled = false;
+    received.set(receivedTxList.size());
+    pending.set(int64_t(pendingTxs.size()));
+
+    std::vector<Transaction> batch;
+    auto submit = [&] {
+        proved.inc(uint64_t(batch.size()));
+        ThreadPool::instance().submit(
+            [blockchain = blockchain, txs = batch] {
+                Metrics::Timer timer(proveTime);
+                std::vector<Blockchain::TxProof> proofs;
+                proofs.reserve(txs.size());
+                for (const auto &tx : txs)
+                    proofs.push_back(blockchain->proveTx(tx));
+                return proofs;
+            },
+            this,
+            [this, txs = batch, made = blocksMade](std::vector<Blockchain::TxProof> proofs) {
+                for (std::size_t i = 0; i < txs.size(); i++)
+                    finishProve(txs[i], proofs[i], made);
+            });
+        batch.clear();
+    };
+
+    // only new txs are proved, others are done or on the way
+    for (const auto &tx : qAsConst(receivedTxList)) {
+        auto &state = txStates[tx.getHash()];
+        if (state != TxState::Received)
+            continue;
+        state = TxState::Verifying;
+        batch.push_back(tx);
+        if (batch.size() == PROVE_BATCH_SIZE)
+            submit();
+    }
+    if (!batch.empty())
+        submit();
+}
+
+void TransactionManager::scheduleProve() {
+    if (proveScheduled)
+        return;
+    proveScheduled = true;
+    QMetaObject::invokeMethod(this, &TransactionManager::proveTransactions, Qt::QueuedConnection);
+}
+
+void TransactionManager::finishProve(Transaction tx, const Blockchain::TxProof &proof, uint64_t made) {
+    using Verdict = Blockchain::TxProof::Verdict;
+    auto it = txStates.find(tx.getHash());
+    if (it == txStates.end() || it->second != TxState::Verifying)
+        return;
+
+    switch (proof.verdict) {
+    case Verdict::Proved:
+        addProvedTransaction(tx);
+        break;
+    case Verdict::Rejected:
+        removeUnApprovedTransaction(tx);
+        break;
+    case Verdict::Sign: {
+        // signature changes hash, tx is tracked by both
+        Transaction signedTx = tx;
+        signedTx.sign(accountController->currentWallet());
+        addProvedTransaction(signedTx);
+        receivedTxList.removeOne(tx);
+        setFinished(tx.getHash(), TxState::Proved);
+        break;
+    }
+    case Verdict::CheckBalance: {
+        // block was made meanwhile, pending txs that balance missed are gone
+        if (made != blocksMade) {
+            it->second = TxState::Received;
+            scheduleProve();
+            break;
+        }
+
+        const Amount balance = proof.balance + checkPendingTxsList(tx.getSender());
+        auto mainActorId = accountController->mainActor().id();
+        const bool firstActor = mainActorId == extraChainNode->actorIndex()->firstId();
+        if (balance - tx.getAmount() - tx.getAmount() / 100 < 0 && firstActor) {
+            qDebug() << balance << tx.getAmount();
+            qDebug() << "Transaction "
+                        "not approved: sender's or receiver's balance will be < 0";
+            removeUnApprovedTransaction(tx);
+        } else
+            addProvedTransaction(tx);
+        break;
+    }
+    }
+}
+
+void TransactionManager::setFinished(const std::string &hash, TxState state) {
+    txStates[hash] = state;
+    finishedTxs.push_back(hash);
+    while (finishedTxs.size() > MAX_FINISHED_TXS) {
+        txStates.erase(finishedTxs.front());
+        finishedTxs.pop_front();
     }
 }
 
@@ -139,8 +259,8 @@ std::string TransactionManager::convertTxs(const std::vector<Transaction> &txs)
     return Serialization::serialize(l);
 }
 
-BigNumberFloat TransactionManager::checkPendingTxsList(const ActorId &sender) {
-    BigNumberFloat res = 0;
+Amount TransactionManager::checkPendingTxsList(const ActorId &sender) {
+    Amount res = 0;
     if (!pendingTxs.empty()) {
         for (const Transaction &tmp : qAsConst(pendingTxs)) {
             if (tmp.getSender() == sender) {
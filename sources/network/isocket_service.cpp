@@ -144,6 +144,19 @@ QByteArray SocketService::prepareSendMessage(const QByteArray &message) {
     return result;
 }
 
+BufferPool::Buffer SocketService::prepareSendFrame(std::string_view frame) {
+    if (pub.empty())
+        qFatal("Socket encrypt error");
+    if (m_sharedKey.empty())
+        m_sharedKey = SecretKey::asymmetricSharedKey(priv.secretKey(), pub.publicKey());
+
+    auto result = node.network()->bufferPool().acquire(frame.size() + SecretKey::asymmetricOverhead);
+    if (!SecretKey::encryptAsymmetricTo(result.data(), frame, m_sharedKey))
+        qFatal("Socket encrypt error");
+    m_bytesOutgoing += int(result.data().size());
+    return result;
+}
+
 QByteArray SocketService::prepareReceiveMessage(const QByteArray &message) {
     if (pub.empty())
         qFatal("Socket decrypt error");
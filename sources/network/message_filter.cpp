@@ -0,0 +1,168 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "network/message_filter.h"
+
+#include <cmath>
+#include <functional>
+#include <string>
+
+MessageFilter::MessageFilter(std::size_t capacity, double falsePositive, Clock::duration window)
+    : m_capacity(std::max<std::size_t>(capacity, 1))
+    , m_window(window) {
+    if (falsePositive <= 0 || falsePositive >= 1)
+        falsePositive = DEFAULT_FALSE_POSITIVE;
+
+    const double ln2 = std::log(2.0);
+    const double bits = -double(m_capacity) * std::log(falsePositive) / (ln2 * ln2);
+    const std::size_t words = std::max<std::size_t>(1, std::size_t(std::ceil(bits / 64)));
+    m_bitCount = words * 64;
+    m_hashCount = std::max(1, int(std::round(double(m_bitCount) / m_capacity * ln2)));
+
+    m_current.bits.assign(words, 0);
+    m_previous.bits.assign(words, 0);
+    m_windowStart = Clock::now();
+}
+
+bool MessageFilter::insert(std::string_view key) {
+    uint64_t h1, h2;
+    hash(key, h1, h2);
+
+    std::lock_guard lock(m_mutex);
+    rotateIfNeeded(Clock::now());
+    m_checked++;
+
+    if (test(m_current, h1, h2) || test(m_previous, h1, h2)) {
+        m_duplicates++;
+        return false;
+    }
+
+    for (int i = 0; i < m_hashCount; i++) {
+        const uint64_t bit = (h1 + uint64_t(i) * h2) % m_bitCount;
+        m_current.bits[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    m_current.inserted++;
+    return true;
+}
+
+bool MessageFilter::contains(std::string_view key) const {
+    uint64_t h1, h2;
+    hash(key, h1, h2);
+
+    std::lock_guard lock(m_mutex);
+    return test(m_current, h1, h2) || test(m_previous, h1, h2);
+}
+
+void MessageFilter::clear() {
+    std::lock_guard lock(m_mutex);
+    std::fill(m_current.bits.begin(), m_current.bits.end(), 0);
+    std::fill(m_previous.bits.begin(), m_previous.bits.end(), 0);
+    m_current.inserted = 0;
+    m_previous.inserted = 0;
+    m_windowStart = Clock::now();
+}
+
+std::string MessageFilter::makeKey(std::string_view sender, std::string_view messageId, int type, int status,
+                                   std::string_view data) {
+    const uint64_t digest = std::hash<std::string_view> {}(data);
+    std::string key;
+    key.reserve(sender.size() + messageId.size() + 3 + sizeof(digest));
+    key.append(sender);
+    key.push_back('\0');
+    key.append(messageId);
+    key.push_back(char(type));
+    key.push_back(char(status));
+    key.append(reinterpret_cast<const char *>(&digest), sizeof(digest));
+    return key;
+}
+
+double MessageFilter::falsePositiveRate() const {
+    std::lock_guard lock(m_mutex);
+    const double current = generationRate(m_current.inserted, m_bitCount, m_hashCount);
+    const double previous = generationRate(m_previous.inserted, m_bitCount, m_hashCount);
+    return 1 - (1 - current) * (1 - previous);
+}
+
+std::size_t MessageFilter::memoryUsage() const {
+    std::lock_guard lock(m_mutex);
+    return (m_current.bits.capacity() + m_previous.bits.capacity()) * sizeof(uint64_t);
+}
+
+std::size_t MessageFilter::capacity() const {
+    return m_capacity;
+}
+
+MessageFilter::Clock::duration MessageFilter::window() const {
+    return m_window;
+}
+
+uint64_t MessageFilter::checked() const {
+    std::lock_guard lock(m_mutex);
+    return m_checked;
+}
+
+uint64_t MessageFilter::duplicates() const {
+    std::lock_guard lock(m_mutex);
+    return m_duplicates;
+}
+
+void MessageFilter::rotateIfNeeded(Clock::time_point now) {
+    const auto elapsed = now - m_windowStart;
+    if (elapsed < m_window && m_current.inserted < m_capacity)
+        return;
+
+    std::swap(m_previous, m_current);
+    std::fill(m_current.bits.begin(), m_current.bits.end(), 0);
+    m_current.inserted = 0;
+    m_windowStart = now;
+
+    // both generations are stale after two idle windows
+    if (elapsed >= 2 * m_window) {
+        std::fill(m_previous.bits.begin(), m_previous.bits.end(), 0);
+        m_previous.inserted = 0;
+    }
+}
+
+bool MessageFilter::test(const Generation &generation, uint64_t h1, uint64_t h2) const {
+    if (generation.inserted == 0)
+        return false;
+
+    for (int i = 0; i < m_hashCount; i++) {
+        const uint64_t bit = (h1 + uint64_t(i) * h2) % m_bitCount;
+        if ((generation.bits[bit / 64] & (uint64_t(1) << (bit % 64))) == 0)
+            return false;
+    }
+    return true;
+}
+
+void MessageFilter::hash(std::string_view key, uint64_t &h1, uint64_t &h2) {
+    h1 = std::hash<std::string_view> {}(key);
+
+    // splitmix64 finalizer gives the second independent hash
+    uint64_t z = h1 + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    h2 = (z ^ (z >> 31)) | 1;
+}
+
+double MessageFilter::generationRate(std::size_t inserted, std::size_t bitCount, int hashCount) {
+    if (inserted == 0)
+        return 0;
+    return std::pow(1 - std::exp(-double(hashCount) * inserted / bitCount), hashCount);
+}
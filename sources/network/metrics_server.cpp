@@ -0,0 +1,72 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "network/metrics_server.h"
+
+#include "utils/metrics.h"
+
+MetricsServer::MetricsServer(QObject *parent)
+    : QObject(parent) {
+    connect(&m_server, &QTcpServer::newConnection, this, &MetricsServer::newConnection);
+}
+
+bool MetricsServer::listen(quint16 port) {
+    if (!m_server.listen(QHostAddress::LocalHost, port)) {
+        qDebug() << "[Metrics] Can't listen on port" << port << m_server.errorString();
+        return false;
+    }
+    qDebug() << "[Metrics] Listening on" << m_server.serverAddress().toString() << m_server.serverPort();
+    return true;
+}
+
+quint16 MetricsServer::port() const {
+    return m_server.serverPort();
+}
+
+void MetricsServer::newConnection() {
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket] { answer(socket); });
+    }
+}
+
+void MetricsServer::answer(QTcpSocket *socket) {
+    if (socket->bytesAvailable() > MAX_REQUEST_SIZE) {
+        socket->abort();
+        return;
+    }
+    if (!socket->peek(MAX_REQUEST_SIZE).contains("\r\n\r\n"))
+        return;
+
+    const QList<QByteArray> request = socket->readLine().trimmed().split(' ');
+    socket->readAll();
+    disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+
+    QByteArray status = "404 Not Found";
+    QByteArray body = "Not Found\n";
+    if (request.size() == 3 && request[0] == "GET" && request[1] == "/metrics") {
+        status = "200 OK";
+        body = QByteArray::fromStdString(Metrics::Registry::instance().expose());
+    }
+    socket->write("HTTP/1.1 " + status
+                  + "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+                  + QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+    socket->disconnectFromHost();
+}
@@ -25,15 +25,73 @@
 #include "network/upnpconnection.h"
 #include "network/websocket_service.h"
 #include "utils/bignumber_float.h"
+#include "utils/metrics.h"
+#include <array>
 #include <filesystem>
 
 #include <fstream>
+#include <map>
 #include <vector>
 
+namespace {
+struct MessageMetrics {
+    Metrics::Counter &received;
+    Metrics::Histogram &handling;
+};
+
+// registry lookups take its lock and build labels, so metrics of all types are made once
+class MessageMetricsTable {
+    static constexpr std::size_t TYPES = std::size_t(magic_enum::enum_values<MessageType>().back()) + 1;
+
+    std::vector<MessageMetrics> m_metrics; // last one is for unknown types
+    std::array<std::size_t, TYPES> m_index;
+
+    static MessageMetrics make(const std::string &name) {
+        const Metrics::Labels labels = { { "type", name } };
+        return { Metrics::counter("extrachain_messages_received_total", "Handled messages by type", labels),
+                 Metrics::histogram("extrachain_message_handling_seconds", "Message handling time by type",
+                                    labels) };
+    }
+
+public:
+    MessageMetricsTable() {
+        constexpr auto types = magic_enum::enum_entries<MessageType>();
+        m_metrics.reserve(types.size() + 1);
+        for (const auto &[type, name] : types)
+            m_metrics.push_back(make(std::string(name)));
+        m_metrics.push_back(make("Unknown"));
+
+        m_index.fill(types.size());
+        for (std::size_t i = 0; i < types.size(); i++)
+            m_index[std::size_t(types[i].first)] = i;
+    }
+
+    const MessageMetrics &operator[](MessageType type) const {
+        const auto value = std::size_t(type);
+        return m_metrics[value < TYPES ? m_index[value] : m_metrics.size() - 1];
+    }
+};
+
+const MessageMetricsTable &messageMetrics() {
+    static const MessageMetricsTable table;
+    return table;
+}
+
+Metrics::Counter &sentBytes() {
+    static auto &counter = Metrics::counter("extrachain_network_sent_bytes_total", "Bytes sent to sockets");
+    return counter;
+}
+}
+
 const QList<SocketService *> &NetworkManager::connections() const {
     return m_connections;
 }
 
+std::string NetworkManager::requestSocket(const std::string &messageId) const {
+    auto requester = m_messages.find(messageId);
+    return requester == m_messages.end() ? std::string() : requester->second;
+}
+
 bool NetworkManager::serverStatus(Network::Protocol protocol) const {
     switch (protocol) {
     case Network::Protocol::Udp:
@@ -48,6 +106,7 @@ bool NetworkManager::serverStatus(Network::Protocol protocol) const {
 
 NetworkManager::NetworkManager(ExtraChainNode &node)
     : node(node) {
+    messageMetrics(); // registered before first message, handling only indexes it
     connect(&m_networkStatus, &NetworkStatus::statusChanged,
             [](NetworkStatus::Status status) { qDebug() << "[NetworkStatus]" << status; });
 
@@ -234,6 +293,21 @@ void NetworkManager::connectToWebSocket(const QString &ip, quint16 port) {
     connectWsService(service);
 }
 
+bool NetworkManager::isReceiver(Config::Net::TypeSend typeSend, std::string_view receiver,
+                                std::string_view socket) {
+    switch (typeSend) {
+    case Config::Net::TypeSend::Except:
+        return socket != receiver;
+    case Config::Net::TypeSend::Focused:
+        // receiver is unknown if request was already answered
+        return receiver.empty() || socket == receiver;
+    case Config::Net::TypeSend::All:
+        return true;
+    default:
+        return false;
+    }
+}
+
 void NetworkManager::sendMessage(const std::string &serialized_message, Config::Net::TypeSend typeSend,
                                  const std::string &receiver_identifier) {
     if (!isActiveConnectionExists()) {
@@ -241,23 +315,29 @@ void NetworkManager::sendMessage(const std::string &serialized_message, Config::
         saveToCache(serialized_message, typeSend, receiver_identifier);
         return;
     }
+    sentBytes().inc(serialized_message.size());
 
-    auto isSendCheck = [typeSend, receiver_identifier](std::string_view socket_identifier) {
-        switch (typeSend) {
-        case Config::Net::TypeSend::Except:
-            return socket_identifier != receiver_identifier;
-        case Config::Net::TypeSend::Focused:
-            return socket_identifier == receiver_identifier;
-        case Config::Net::TypeSend::All:
-            return true;
-        default:
-            return false;
+    for (const auto &service : qAsConst(m_connections)) {
+        if (service->isActive() && service->sendType() == SocketService::SendType::All
+            && isReceiver(typeSend, receiver_identifier, service->identifier().toStdString())) {
+            service->sendMessage(QByteArray::fromStdString(serialized_message));
         }
-    };
+    }
+}
+
+void NetworkManager::sendFrame(std::string_view frame, Config::Net::TypeSend typeSend,
+                               const std::string &receiver_identifier) {
+    if (!isActiveConnectionExists()) {
+        qDebug() << "[NetworkManager] Save frame to cache";
+        saveToCache(std::string(frame), typeSend, receiver_identifier);
+        return;
+    }
+    sentBytes().inc(frame.size());
 
     for (const auto &service : qAsConst(m_connections)) {
-        if (service->isActive() && service->sendType() == SocketService::SendType::All) {
-            service->sendMessage(QByteArray::fromStdString(serialized_message));
+        if (service->isActive() && service->sendType() == SocketService::SendType::All
+            && isReceiver(typeSend, receiver_identifier, service->identifier().toStdString())) {
+            service->sendFrame(frame);
         }
     }
 }
@@ -356,36 +436,25 @@ bool NetworkManager::isActiveConnectionExists() {
     return false;
 }
 
-bool NetworkManager::checkMsgCount(const std::string &msg) {
-    bool flag_result = true;
-    bool value = 0;
-    std::string hashMsg = Utils::calcHash(msg);
-    QMap<std::string, int>::iterator it = msgHashList.find(hashMsg);
-
-    if (it == msgHashList.end())
-        msgHashList.insert(hashMsg, value);
-    else {
-        if (msgHashList.find(hashMsg).value() == m_connections.length() - 1) {
-            msgHashList.remove(hashMsg);
-            flag_result = false;
-        } else {
-            msgHashList.find(hashMsg).value()++;
-            flag_result = true;
-        }
-    }
-
-    return flag_result;
+const MessageFilter &NetworkManager::messageFilter() const {
+    return m_messageFilter;
 }
 
-void NetworkManager::messageReceived(const std::string &message, const std::string &identifier) {
-    if (!checkMsgCount(message)) {
-        qDebug()
-            << "[Network Manager] checkMsgCount have returned false: such message has been already added";
-        return;
-    }
+BufferPool &NetworkManager::bufferPool() {
+    return m_bufferPool;
+}
 
-    m_messages[identifier] = message;
+bool NetworkManager::checkMsgCount(const MessageBody &message) {
+    const std::string key =
+        MessageFilter::makeKey(message.sender_id.toStdString(), message.message_id, int(message.message_type),
+                               int(message.status), message.data);
+    return m_messageFilter.insert(key);
+}
 
+void NetworkManager::messageReceived(const std::string &message, const std::string &identifier) {
+    static auto &receivedBytes =
+        Metrics::counter("extrachain_network_received_bytes_total", "Bytes received from sockets");
+    receivedBytes.inc(message.size());
     std::string_view msg = std::string_view(message).substr(0, message.size() - 64);
     std::string_view sign = std::string_view(message).substr(message.size() - 64, 64);
 
@@ -403,6 +472,14 @@ void NetworkManager::messageReceived(const std::string &message, const std::stri
     //        }
     //    }
     MessageBody mb = MessagePack::deserialize<MessageBody>(msg);
+    if (!checkMsgCount(mb)) {
+        qDebug()
+            << "[Network Manager] checkMsgCount have returned false: such message has been already added";
+        return;
+    }
+
+    m_messages[identifier] = message;
+
     MessageType type = mb.message_type;
     MessageStatus status = mb.status;
     std::string serialized = mb.data;
@@ -413,6 +490,10 @@ void NetworkManager::messageReceived(const std::string &message, const std::stri
     //    auto messId = msg.substr(4, 15);
     std::string messageId(messId.begin(), messId.end());
 
+    const auto &metrics = messageMetrics()[type];
+    metrics.received.inc();
+    Metrics::Timer timer(metrics.handling);
+
     if (status == MessageStatus::Request) {
         m_messages[messageId] = identifier;
     }
@@ -506,6 +587,34 @@ void NetworkManager::messageReceived(const std::string &message, const std::stri
         emit addFragSignal(msg);
         break;
     }
+    case MessageType::DfsFindFile: {
+        auto msg = MessagePack::deserialize<DFSP::FindFileMessage>(serialized);
+        if (status == MessageStatus::Request)
+            node.dfs()->sendFileSource(msg, messageId);
+        else if (status == MessageStatus::Response)
+            node.dfs()->addDownloadPeer(mb.sender_id, msg, identifier);
+        break;
+    }
+    case MessageType::DfsRequestSegment: {
+        auto msg = MessagePack::deserialize<DFSP::RequestSegmentMessage>(serialized);
+        node.dfs()->sendSegment(msg, messageId);
+        break;
+    }
+    case MessageType::DfsSegment: {
+        auto msg = MessagePack::deserialize<DFSP::SegmentMessage>(serialized);
+        node.dfs()->handleSegment(mb.sender_id, msg);
+        break;
+    }
+    case MessageType::DfsManifest: {
+        if (status == MessageStatus::Request) {
+            auto msg = MessagePack::deserialize<DFSP::FindFileMessage>(serialized);
+            node.dfs()->sendManifest(msg, messageId);
+        } else if (status == MessageStatus::Response) {
+            auto msg = MessagePack::deserialize<DFSP::ManifestMessage>(serialized);
+            node.dfs()->applyManifest(msg);
+        }
+        break;
+    }
     case MessageType::DfsEditSegment: {
         auto msg = MessagePack::deserialize<DFSP::SegmentMessage>(serialized);
         node.dfs()->insertFragment(msg);
@@ -592,6 +701,65 @@ void NetworkManager::messageReceived(const std::string &message, const std::stri
         break;
     }
 
+    case MessageType::BlockchainTip: {
+        auto tip = MessagePack::deserialize<BSP::Tip>(serialized);
+        if (status == MessageStatus::Request)
+            this->send_message(node.blockchain()->localTip(), MessageType::BlockchainTip,
+                               MessageStatus::Response, messageId, Config::Net::TypeSend::Focused);
+        node.blockchain()->handleTip(tip, identifier);
+        break;
+    }
+
+    case MessageType::BlockchainBlockRange: {
+        auto &blockSync = node.blockchain()->blockSync();
+        switch (status) {
+        case MessageStatus::Request: {
+            auto request = MessagePack::deserialize<BSP::RangeRequest>(serialized);
+            this->send_message(blockSync.blockRange(request), MessageType::BlockchainBlockRange,
+                               MessageStatus::Response, messageId, Config::Net::TypeSend::Focused);
+            break;
+        }
+        case MessageStatus::Response: {
+            auto response = MessagePack::deserialize<BSP::RangeResponse>(serialized);
+            blockSync.handleRange(response, identifier);
+            break;
+        }
+        default:
+            break;
+        }
+        break;
+    }
+
+    case MessageType::BlockchainHeaders: {
+        switch (status) {
+        case MessageStatus::Request: {
+            auto request = MessagePack::deserialize<BSP::RangeRequest>(serialized);
+            BSP::HeaderRange response {
+                .From = request.From,
+                .Headers = node.blockchain()->getHeaderIndex().getHeaders(
+                    request.From, std::min(request.Count, BlockSync::MAX_HEADERS))
+            };
+            this->send_message(response, MessageType::BlockchainHeaders, MessageStatus::Response, messageId,
+                               Config::Net::TypeSend::Focused);
+            break;
+        }
+        case MessageStatus::Response: {
+            auto response = MessagePack::deserialize<BSP::HeaderRange>(serialized);
+            node.blockchain()->handleHeaders(response.Headers, identifier);
+            break;
+        }
+        default:
+            break;
+        }
+        break;
+    }
+
+    case MessageType::BlockchainNewHeader: {
+        auto header = MessagePack::deserialize<BlockHeader>(serialized);
+        node.blockchain()->handleHeaders({ header }, identifier);
+        break;
+    }
+
     case MessageType::FragmentDataInfo: {
         auto msg = MessagePack::deserialize<DFSF::FragmentsInfo>(serialized);
         msg.print();
@@ -109,6 +109,20 @@ void WebSocketService::sendMessage(const QByteArray &data) {
     // m_ws->flush();
 }
 
+void WebSocketService::sendFrame(std::string_view frame) {
+    if (!isActive()) {
+        qDebug() << "[WS] Try to send frame without activation";
+        return;
+    }
+    if (frame.empty())
+        qFatal("[WS] Error send size");
+
+    // socket copies message into its write buffer, so pooled buffer is free after the call
+    auto encrypted = prepareSendFrame(frame);
+    const auto &data = encrypted.data();
+    m_ws->sendBinaryMessage(QByteArray::fromRawData(data.data(), qsizetype(data.size())));
+}
+
 void WebSocketService::onConnected() {
     this->m_ip = m_ws->peerAddress().toString().replace("::ffff:", "");
     handshake();
@@ -0,0 +1,272 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "utils/amount.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "boost/multiprecision/cpp_bin_float.hpp"
+
+using boost::multiprecision::cpp_bin_float_50;
+using boost::multiprecision::cpp_int;
+
+namespace {
+const Amount::Units &scale() {
+    static const Amount::Units value = boost::multiprecision::pow(Amount::Units(10), Amount::DECIMALS);
+    return value;
+}
+
+Amount::Units toUnits(const cpp_int &value) {
+    if (value > cpp_int(std::numeric_limits<Amount::Units>::max())
+        || value < cpp_int(std::numeric_limits<Amount::Units>::min()))
+        throw std::overflow_error("Amount is out of range");
+    return Amount::Units(value);
+}
+
+bool isDigits(std::string_view text) {
+    return !text.empty()
+        && std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+}
+
+Amount::Amount(int units)
+    : m_units(units) {
+}
+
+Amount::Amount(long long units)
+    : m_units(units) {
+}
+
+Amount::Amount(const Units &units)
+    : m_units(units) {
+}
+
+Amount::Amount(const BigNumber &units)
+    : m_units(toUnits(units.data())) {
+}
+
+Amount Amount::fromString(const std::string &units) {
+    if (units.empty())
+        return Amount();
+    try {
+        const std::string_view digits = units[0] == '-' ? std::string_view(units).substr(1) : units;
+        if (isDigits(digits))
+            return Amount(toUnits(cpp_int(units)));
+
+        // BigNumberFloat text, for example 1.5e+18
+        std::stringstream ss(units);
+        cpp_bin_float_50 value;
+        if (ss >> value && ss.peek() == EOF)
+            return Amount(toUnits(value.convert_to<cpp_int>()));
+    } catch (std::exception &) {
+    }
+    qDebug() << "Incorrect Amount value:" << units.c_str();
+    return Amount();
+}
+
+Amount Amount::fromVisible(const std::string &visible) {
+    std::string_view text = visible;
+    const bool negative = !text.empty() && text[0] == '-';
+    if (negative)
+        text.remove_prefix(1);
+
+    const auto point = text.find('.');
+    const std::string_view whole = text.substr(0, point);
+    const std::string_view fraction = point == std::string_view::npos ? "" : text.substr(point + 1);
+    if ((!whole.empty() && !isDigits(whole)) || (!fraction.empty() && !isDigits(fraction))
+        || (whole.empty() && fraction.empty()) || fraction.size() > std::size_t(DECIMALS)) {
+        qDebug() << "Incorrect visible amount:" << visible.c_str();
+        return Amount();
+    }
+
+    std::string units(whole);
+    units += fraction;
+    units.append(DECIMALS - fraction.size(), '0');
+    try {
+        const Amount amount(toUnits(cpp_int(units)));
+        return negative ? -amount : amount;
+    } catch (std::exception &) {
+        qDebug() << "Incorrect visible amount:" << visible.c_str();
+        return Amount();
+    }
+}
+
+const Amount &Amount::unit() {
+    static const Amount value(scale());
+    return value;
+}
+
+Amount Amount::operator+(const Amount &other) const {
+    return Amount(Units(m_units + other.m_units));
+}
+
+Amount Amount::operator-(const Amount &other) const {
+    return Amount(Units(m_units - other.m_units));
+}
+
+Amount Amount::operator*(long long factor) const {
+    return Amount(Units(m_units * factor));
+}
+
+Amount Amount::operator/(long long divisor) const {
+    return Amount(Units(m_units / divisor));
+}
+
+Amount Amount::operator-() const {
+    return Amount(Units(-m_units));
+}
+
+Amount &Amount::operator+=(const Amount &other) {
+    m_units += other.m_units;
+    return *this;
+}
+
+Amount &Amount::operator-=(const Amount &other) {
+    m_units -= other.m_units;
+    return *this;
+}
+
+Amount &Amount::operator*=(long long factor) {
+    m_units *= factor;
+    return *this;
+}
+
+Amount &Amount::operator/=(long long divisor) {
+    m_units /= divisor;
+    return *this;
+}
+
+Amount Amount::mul(const Amount &other) const {
+    return Amount(toUnits(cpp_int(m_units) * cpp_int(other.m_units) / cpp_int(scale())));
+}
+
+Amount Amount::div(const Amount &other) const {
+    if (other.m_units == 0)
+        throw std::overflow_error("Amount division by zero");
+    return Amount(toUnits(cpp_int(m_units) * cpp_int(scale()) / cpp_int(other.m_units)));
+}
+
+const Amount::Units &Amount::units() const {
+    return m_units;
+}
+
+bool Amount::isEmpty() const {
+    return m_units == 0;
+}
+
+Amount Amount::abs() const {
+    return Amount(Units(boost::multiprecision::abs(m_units)));
+}
+
+BigNumber Amount::toBigNumber() const {
+    return BigNumber(cpp_int(m_units));
+}
+
+std::string Amount::toStdString() const {
+    return m_units.str();
+}
+
+QByteArray Amount::toByteArray() const {
+    return QByteArray::fromStdString(toStdString());
+}
+
+std::string Amount::toVisible() const {
+    if (m_units == 0)
+        return "0";
+
+    const Units magnitude = boost::multiprecision::abs(m_units);
+    std::string fraction = Units(magnitude % scale()).str();
+    fraction.insert(0, DECIMALS - fraction.size(), '0');
+    fraction.erase(fraction.find_last_not_of('0') + 1);
+
+    std::string visible = m_units < 0 ? "-" : "";
+    visible += Units(magnitude / scale()).str();
+    if (!fraction.empty())
+        visible += "." + fraction;
+    return visible;
+}
+
+std::string Amount::toLegacyString() const {
+    const cpp_bin_float_50 value(cpp_int(boost::multiprecision::abs(m_units)));
+    std::stringstream ss;
+    ss << std::hex << value;
+    return m_units < 0 ? "-" + ss.str() : ss.str();
+}
+
+std::string Amount::toBytes() const {
+    if (m_units == 0)
+        return "";
+
+    // Units have 128 bits of magnitude, with the sign that is up to 17 bytes
+    const cpp_int value(m_units);
+    std::size_t size = 1;
+    while (value >= (cpp_int(1) << (8 * size - 1)) || value < -(cpp_int(1) << (8 * size - 1)))
+        size++;
+    cpp_int raw = value < 0 ? value + (cpp_int(1) << (8 * size)) : value;
+    std::string bytes(size, '\0');
+    for (auto it = bytes.rbegin(); it != bytes.rend(); ++it, raw >>= 8)
+        *it = char(uint8_t(raw & 0xff));
+    return bytes;
+}
+
+Amount Amount::fromBytes(std::string_view bytes) {
+    if (bytes.size() > 17)
+        throw std::overflow_error("Amount is out of range");
+
+    cpp_int raw = 0;
+    for (char byte : bytes)
+        raw = (raw << 8) | uint8_t(byte);
+    if (!bytes.empty() && (bytes[0] & 0x80))
+        raw -= cpp_int(1) << (8 * bytes.size());
+    return Amount(toUnits(raw));
+}
+
+void Amount::msgpack_unpack(msgpack::object const &msgpack_o) {
+    switch (msgpack_o.type) {
+    case msgpack::type::BIN:
+        try {
+            *this = fromBytes({ msgpack_o.via.bin.ptr, msgpack_o.via.bin.size });
+        } catch (std::overflow_error &) {
+            throw msgpack::type_error();
+        }
+        break;
+    case msgpack::type::STR: // older versions
+        *this = fromString(msgpack_o.as<std::string>());
+        break;
+    case msgpack::type::POSITIVE_INTEGER:
+    case msgpack::type::NEGATIVE_INTEGER:
+        *this = Amount(msgpack_o.as<long long>());
+        break;
+    default:
+        throw msgpack::type_error();
+    }
+}
+
+QDebug operator<<(QDebug debug, const Amount &amount) {
+    QDebugStateSaver saver(debug);
+    debug.nospace().noquote() << amount.toByteArray();
+    return debug;
+}
+
+std::ostream &operator<<(std::ostream &os, const Amount &amount) {
+    os << amount.toStdString();
+    return os;
+}
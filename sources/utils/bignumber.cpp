@@ -18,224 +18,299 @@
  */
 
 #include "utils/bignumber.h"
+#include <charconv>
+#include <climits>
 #include <exception>
+#include <iterator>
+#include <utility>
 
 using boost::multiprecision::cpp_int;
 
-BigNumber::BigNumber()
-    : m_data(0) {
+namespace {
+// small operations, false if result needs cpp_int
+bool add(long long l, long long r, long long &result) {
+    return !__builtin_add_overflow(l, r, &result);
+}
+
+bool sub(long long l, long long r, long long &result) {
+    return !__builtin_sub_overflow(l, r, &result);
+}
+
+bool mul(long long l, long long r, long long &result) {
+    return !__builtin_mul_overflow(l, r, &result);
+}
+
+// division by zero is left to cpp_int, it throws
+bool div(long long l, long long r, long long &result) {
+    if (r == 0 || (l == LLONG_MIN && r == -1))
+        return false;
+    result = l / r;
+    return true;
+}
+
+bool mod(long long l, long long r, long long &result) {
+    if (r == 0 || (l == LLONG_MIN && r == -1))
+        return false;
+    result = l % r;
+    return true;
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+const char HexDigits[] = "0123456789abcdef";
+}
+
+BigNumber::BigNumber() {
 }
 
 BigNumber::BigNumber(const std::string &bigNumber, int base) {
     try {
         if (bigNumber.empty()) {
-            this->m_data = cpp_int(0);
-        } else {
-            if (base == 10) {
-                this->m_data = cpp_int(bigNumber);
-            } else {
-                std::stringstream ss;
-                ss << std::hex << bigNumber;
-                ss >> m_data;
-            }
+            m_small = 0;
+        } else if (base == 10) {
+            const char *end = bigNumber.data() + bigNumber.size();
+            long long number;
+            const auto result = std::from_chars(bigNumber.data(), end, number);
+            if (result.ec == std::errc() && result.ptr == end)
+                m_small = number;
+            else
+                setData(cpp_int(bigNumber));
+        } else if (!parseHex(bigNumber)) {
+            // prefixes, spaces and errors are handled as before
+            cpp_int number;
+            std::stringstream ss;
+            ss << std::hex << bigNumber;
+            ss >> number;
+            setData(number);
         }
     } catch (std::exception &) {
         qDebug() << "Incorrect BigNumber value:" << bigNumber.c_str();
         assert(false);
     }
 
-    UPDATE_DEBUG()
+    updateDebug();
 }
 
-BigNumber::BigNumber(const BigNumber &other) {
-    this->m_data = other.data();
-    UPDATE_DEBUG()
+BigNumber::BigNumber(const BigNumber &other)
+    : m_small(other.m_small)
+    , m_isBig(other.m_isBig) {
+    if (m_isBig)
+        m_big = other.m_big;
+    updateDebug();
 }
 
 BigNumber::BigNumber(const cpp_int &number) {
-    this->m_data = number;
-    UPDATE_DEBUG()
+    setData(number);
+    updateDebug();
 }
 
-BigNumber::BigNumber(int number) {
-    this->m_data = cpp_int(number);
-    UPDATE_DEBUG()
+BigNumber::BigNumber(int number)
+    : m_small(number) {
 }
 
-BigNumber::BigNumber(long long number) {
-    this->m_data = cpp_int(number);
-    UPDATE_DEBUG()
+BigNumber::BigNumber(long long number)
+    : m_small(number) {
 }
 
 BigNumber BigNumber::operator&(const BigNumber &value) {
-    BigNumber da(m_data & value.data());
-    return da;
+    if (!m_isBig && !value.m_isBig && m_small >= 0 && value.m_small >= 0)
+        return BigNumber(m_small & value.m_small);
+    return BigNumber(data() & value.data());
 }
 
 BigNumber BigNumber::operator>>(const uint &value) {
-    BigNumber ret(m_data >> value);
-    return ret;
+    if (!m_isBig && m_small >= 0)
+        return BigNumber(value < 64 ? m_small >> value : 0LL);
+    return BigNumber(data() >> value);
 }
 
 BigNumber BigNumber::operator>>=(const uint &value) {
-    BigNumber ret(m_data >> value);
-    m_data = ret.data();
-    UPDATE_DEBUG()
+    *this = *this >> value;
     return *this;
 }
 
 BigNumber BigNumber::operator+(const BigNumber &bigNumber) {
-    return BigNumber(m_data + bigNumber.data());
+    long long result;
+    if (!m_isBig && !bigNumber.m_isBig && add(m_small, bigNumber.m_small, result))
+        return BigNumber(result);
+    return BigNumber(data() + bigNumber.data());
 }
 
 BigNumber BigNumber::operator+(long long number) {
-    return BigNumber(m_data + number);
+    return *this + BigNumber(number);
 }
 
 BigNumber BigNumber::operator-(const BigNumber &bigNumber) {
-    return BigNumber(m_data - bigNumber.data());
+    long long result;
+    if (!m_isBig && !bigNumber.m_isBig && sub(m_small, bigNumber.m_small, result))
+        return BigNumber(result);
+    return BigNumber(data() - bigNumber.data());
 }
 
 BigNumber BigNumber::operator-(long long number) {
-    return BigNumber(m_data - number);
+    return *this - BigNumber(number);
 }
 
 BigNumber BigNumber::operator*(const BigNumber &bigNumber) const {
-    return BigNumber(m_data * bigNumber.data());
+    long long result;
+    if (!m_isBig && !bigNumber.m_isBig && mul(m_small, bigNumber.m_small, result))
+        return BigNumber(result);
+    return BigNumber(data() * bigNumber.data());
 }
 
 BigNumber BigNumber::operator*(long long number) {
-    return BigNumber(m_data * number);
+    return *this * BigNumber(number);
 }
 
 BigNumber BigNumber::operator/(const BigNumber &bigNumber) {
-    return BigNumber(m_data / bigNumber.data());
+    long long result;
+    if (!m_isBig && !bigNumber.m_isBig && div(m_small, bigNumber.m_small, result))
+        return BigNumber(result);
+    return BigNumber(data() / bigNumber.data());
 }
 
 BigNumber BigNumber::operator/(long long number) {
-    return BigNumber(m_data / number);
+    return *this / BigNumber(number);
 }
 
 BigNumber BigNumber::operator%(const BigNumber &bigNumber) {
-    return BigNumber(m_data % bigNumber.data());
+    return std::as_const(*this) % bigNumber;
 }
 
 BigNumber BigNumber::operator%(const BigNumber &bigNumber) const {
-    return BigNumber(m_data % bigNumber.data());
+    long long result;
+    if (!m_isBig && !bigNumber.m_isBig && mod(m_small, bigNumber.m_small, result))
+        return BigNumber(result);
+    return BigNumber(data() % bigNumber.data());
 }
 
 BigNumber BigNumber::operator%(long long number) {
-    return BigNumber(m_data % number);
+    return *this % BigNumber(number);
 }
 
 BigNumber &BigNumber::operator=(const BigNumber &bigNumber) {
-    m_data = bigNumber.data();
-    UPDATE_DEBUG()
+    m_small = bigNumber.m_small;
+    m_isBig = bigNumber.m_isBig;
+    if (m_isBig)
+        m_big = bigNumber.m_big;
+    updateDebug();
     return *this;
 }
 
 BigNumber &BigNumber::operator=(long long number) {
-    m_data = number;
-    UPDATE_DEBUG()
+    m_small = number;
+    m_isBig = false;
+    updateDebug();
     return *this;
 }
 
 BigNumber &BigNumber::operator++() {
-    *this = *this + 1;
-    UPDATE_DEBUG()
-    return *this;
+    return *this += 1;
 }
 
 BigNumber BigNumber::operator++(int) {
-    ++m_data;
-    UPDATE_DEBUG()
-    return m_data;
+    return ++*this;
 }
 
 BigNumber &BigNumber::operator--() {
-    m_data--;
-    UPDATE_DEBUG()
-    return *this;
+    return *this -= 1;
 }
 
 BigNumber BigNumber::operator--(int) {
-    --m_data;
-    UPDATE_DEBUG()
-    return m_data;
+    return --*this;
 }
 
 BigNumber &BigNumber::operator+=(const BigNumber &bigNumber) {
-    this->m_data += bigNumber.m_data;
-    UPDATE_DEBUG()
+    long long result;
+    if (!m_isBig && !bigNumber.m_isBig && add(m_small, bigNumber.m_small, result))
+        m_small = result;
+    else
+        setData(data() + bigNumber.data());
+    updateDebug();
     return *this;
 }
 
 BigNumber &BigNumber::operator+=(long long number) {
-    this->m_data += number;
-    UPDATE_DEBUG()
-    return *this;
+    return *this += BigNumber(number);
 }
 
 BigNumber &BigNumber::operator-=(const BigNumber &bigNumber) {
-    this->m_data -= bigNumber.data();
-    UPDATE_DEBUG()
+    long long result;
+    if (!m_isBig && !bigNumber.m_isBig && sub(m_small, bigNumber.m_small, result))
+        m_small = result;
+    else
+        setData(data() - bigNumber.data());
+    updateDebug();
     return *this;
 }
 
 BigNumber &BigNumber::operator-=(long long number) {
-    this->m_data -= number;
-    UPDATE_DEBUG()
-    return *this;
+    return *this -= BigNumber(number);
 }
 
 BigNumber &BigNumber::operator*=(const BigNumber &bigNumber) {
-    this->m_data *= bigNumber.m_data;
-    UPDATE_DEBUG()
+    long long result;
+    if (!m_isBig && !bigNumber.m_isBig && mul(m_small, bigNumber.m_small, result))
+        m_small = result;
+    else
+        setData(data() * bigNumber.data());
+    updateDebug();
     return *this;
 }
 
 BigNumber &BigNumber::operator*=(long long number) {
-    this->m_data *= number;
-    UPDATE_DEBUG()
-    return *this;
+    return *this *= BigNumber(number);
 }
 
 BigNumber &BigNumber::operator/=(const BigNumber &bigNumber) {
-    this->m_data /= bigNumber.m_data;
-    UPDATE_DEBUG()
+    long long result;
+    if (!m_isBig && !bigNumber.m_isBig && div(m_small, bigNumber.m_small, result))
+        m_small = result;
+    else
+        setData(data() / bigNumber.data());
+    updateDebug();
     return *this;
 }
 
 BigNumber &BigNumber::operator/=(long long number) {
-    this->m_data /= number;
-
-    UPDATE_DEBUG()
-    return *this;
+    return *this /= BigNumber(number);
 }
 
 BigNumber &BigNumber::operator%=(const BigNumber &bigNumber) {
-    this->m_data %= bigNumber.m_data;
-    UPDATE_DEBUG()
+    long long result;
+    if (!m_isBig && !bigNumber.m_isBig && mod(m_small, bigNumber.m_small, result))
+        m_small = result;
+    else
+        setData(data() % bigNumber.data());
+    updateDebug();
     return *this;
 }
 
 BigNumber &BigNumber::operator%=(long long number) {
-    this->m_data %= number;
-    UPDATE_DEBUG()
-    return *this;
+    return *this %= BigNumber(number);
 }
 
 BigNumber BigNumber::operator-() const {
-    return BigNumber(-m_data);
+    if (!m_isBig && m_small != LLONG_MIN)
+        return BigNumber(-m_small);
+    return BigNumber(cpp_int(-data()));
 }
 
-const cpp_int &BigNumber::data() const {
-    return m_data;
+cpp_int BigNumber::data() const {
+    return m_isBig ? m_big : cpp_int(m_small);
 }
 
 bool BigNumber::isEmpty() const // TODO
 {
-    return m_data == -1;
+    return !m_isBig && m_small == -1;
 }
 
 QByteArray BigNumber::toByteArray(int base) const {
@@ -245,17 +320,40 @@ QByteArray BigNumber::toByteArray(int base) const {
 
 std::string BigNumber::toStdString(int base) const {
     if (base == 10) {
-        return m_data.str();
-    } else {
-        std::stringstream ss;
-        if (m_data >= 0) {
-            ss << std::hex << m_data;
-            return ss.str();
-        } else {
-            ss << std::hex << boost::multiprecision::abs(m_data);
-            return "-" + ss.str();
+        if (m_isBig)
+            return m_big.str();
+        char buffer[24];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), m_small);
+        return std::string(buffer, result.ptr);
+    }
+
+    std::string hex;
+    if (m_isBig) {
+        const std::string bytes = toBytes();
+        hex.reserve(bytes.size() * 2);
+        if (bytes[0])
+            hex += '-';
+        for (std::size_t i = 1; i < bytes.size(); i++) {
+            const auto byte = uint8_t(bytes[i]);
+            if (i > 1 || byte >> 4) // no leading zero
+                hex += HexDigits[byte >> 4];
+            hex += HexDigits[byte & 0xf];
         }
+        return hex;
     }
+
+    char buffer[17];
+    char *begin = buffer + sizeof(buffer);
+    auto magnitude = m_small < 0 ? 0ULL - static_cast<unsigned long long>(m_small)
+                                 : static_cast<unsigned long long>(m_small);
+    do {
+        *--begin = HexDigits[magnitude & 0xf];
+        magnitude >>= 4;
+    } while (magnitude);
+    if (m_small < 0)
+        hex += '-';
+    hex.append(begin, buffer + sizeof(buffer));
+    return hex;
 }
 
 std::string BigNumber::toZeroStdString(int size) const {
@@ -267,13 +365,46 @@ std::string BigNumber::toZeroStdString(int size) const {
 }
 
 BigNumber BigNumber::pow(unsigned long number) {
-    auto res = boost::multiprecision::pow(m_data, number);
+    auto res = boost::multiprecision::pow(data(), number);
     return BigNumber(res);
 }
 
+std::string BigNumber::toBytes() const {
+    std::string bytes(1, compare(0) < 0 ? '\1' : '\0');
+    if (compare(0) != 0)
+        boost::multiprecision::export_bits(data(), std::back_inserter(bytes), 8); // magnitude only
+    return bytes;
+}
+
+BigNumber BigNumber::fromBytes(std::string_view bytes) {
+    if (bytes.empty() || uint8_t(bytes[0]) > 1)
+        throw msgpack::type_error();
+    cpp_int value;
+    if (bytes.size() > 1)
+        boost::multiprecision::import_bits(value, bytes.begin() + 1, bytes.end(), 8);
+    return BigNumber(bytes[0] ? cpp_int(-value) : value);
+}
+
+void BigNumber::msgpack_unpack(msgpack::object const &msgpack_o) {
+    switch (msgpack_o.type) {
+    case msgpack::type::POSITIVE_INTEGER:
+        *this = BigNumber(cpp_int(msgpack_o.via.u64));
+        break;
+    case msgpack::type::NEGATIVE_INTEGER:
+        *this = BigNumber(static_cast<long long>(msgpack_o.via.i64));
+        break;
+    case msgpack::type::EXT:
+        if (msgpack_o.via.ext.type() != MessagePackExt::BigNumberV1)
+            throw msgpack::type_error();
+        *this = fromBytes({ msgpack_o.via.ext.data(), msgpack_o.via.ext.size });
+        break;
+    default: // older versions
+        *this = BigNumber(msgpack_o.as<std::string>());
+    }
+}
+
 BigNumber BigNumber::abs() const {
-    auto res = boost::multiprecision::abs(m_data);
-    return BigNumber(res);
+    return compare(0) < 0 ? -*this : *this;
 }
 
 BigNumber BigNumber::random(int n, bool zeroAllowed) {
@@ -342,3 +473,61 @@ std::ostream &operator<<(std::ostream &os, const BigNumber &bigNumber) {
     os << bigNumber.toStdString();
     return os;
 }
+
+void BigNumber::setData(const cpp_int &number) {
+    m_isBig = number < LLONG_MIN || number > LLONG_MAX;
+    if (m_isBig)
+        m_big = number;
+    else
+        m_small = number.convert_to<long long>();
+}
+
+bool BigNumber::parseHex(std::string_view text) {
+    const bool negative = !text.empty() && text[0] == '-';
+    if (negative)
+        text.remove_prefix(1);
+    if (text.empty())
+        return false;
+
+    // digits are gathered by 16 into chunk, full chunks are moved to cpp_int
+    unsigned long long chunk = 0;
+    std::size_t digits = 0;
+    cpp_int big;
+    bool isBig = false;
+    for (char c : text) {
+        const int digit = hexDigit(c);
+        if (digit < 0)
+            return false;
+        if (digits == 16) {
+            big = isBig ? cpp_int(big << 64 | chunk) : cpp_int(chunk);
+            isBig = true;
+            chunk = 0;
+            digits = 0;
+        }
+        chunk = chunk << 4 | unsigned(digit);
+        digits++;
+    }
+
+    if (isBig) {
+        big = big << (4 * digits) | chunk;
+        setData(negative ? cpp_int(-big) : big);
+    } else if (chunk <= (negative ? 0ULL - static_cast<unsigned long long>(LLONG_MIN) : LLONG_MAX)) {
+        m_small = negative ? static_cast<long long>(0ULL - chunk) : static_cast<long long>(chunk);
+        m_isBig = false;
+    } else {
+        setData(negative ? cpp_int(-cpp_int(chunk)) : cpp_int(chunk));
+    }
+    return true;
+}
+
+void BigNumber::updateDebug() {
+#ifdef QT_DEBUG
+    if (m_isBig) {
+        qdata = toStdString(16);
+        qdataDec = toStdString(10);
+    } else {
+        qdata.clear();
+        qdataDec.clear();
+    }
+#endif
+}
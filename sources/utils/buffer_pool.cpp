@@ -0,0 +1,109 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "utils/buffer_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+BufferPool::Buffer::Buffer(BufferPool *pool, std::string &&data)
+    : m_pool(pool)
+    , m_data(std::move(data)) {
+}
+
+BufferPool::Buffer::Buffer(Buffer &&buffer) noexcept
+    : m_pool(std::exchange(buffer.m_pool, nullptr))
+    , m_data(std::move(buffer.m_data)) {
+}
+
+BufferPool::Buffer &BufferPool::Buffer::operator=(Buffer &&buffer) noexcept {
+    if (this != &buffer) {
+        if (m_pool)
+            m_pool->release(std::move(m_data));
+        m_pool = std::exchange(buffer.m_pool, nullptr);
+        m_data = std::move(buffer.m_data);
+    }
+    return *this;
+}
+
+BufferPool::Buffer::~Buffer() {
+    if (m_pool)
+        m_pool->release(std::move(m_data));
+}
+
+std::string &BufferPool::Buffer::data() {
+    return m_data;
+}
+
+const std::string &BufferPool::Buffer::data() const {
+    return m_data;
+}
+
+BufferPool::BufferPool(std::size_t maxIdle)
+    : m_maxIdle(maxIdle) {
+}
+
+BufferPool::Buffer BufferPool::acquire(std::size_t capacity) {
+    std::string data;
+    {
+        std::lock_guard lock(m_mutex);
+        m_acquired++;
+        // smallest idle buffer that fits, otherwise the largest one to grow
+        auto fits = m_idle.end();
+        for (auto it = m_idle.begin(); it != m_idle.end(); ++it) {
+            if (it->capacity() >= capacity && (fits == m_idle.end() || it->capacity() < fits->capacity()))
+                fits = it;
+        }
+        if (fits == m_idle.end() && !m_idle.empty())
+            fits = std::max_element(m_idle.begin(), m_idle.end(), [](const auto &a, const auto &b) {
+                return a.capacity() < b.capacity();
+            });
+        if (fits != m_idle.end()) {
+            data = std::move(*fits);
+            m_idle.erase(fits);
+        }
+        if (data.capacity() < capacity)
+            m_allocations++;
+    }
+
+    data.clear();
+    data.reserve(capacity);
+    return Buffer(this, std::move(data));
+}
+
+uint64_t BufferPool::allocations() const {
+    std::lock_guard lock(m_mutex);
+    return m_allocations;
+}
+
+uint64_t BufferPool::acquired() const {
+    std::lock_guard lock(m_mutex);
+    return m_acquired;
+}
+
+std::size_t BufferPool::idle() const {
+    std::lock_guard lock(m_mutex);
+    return m_idle.size();
+}
+
+void BufferPool::release(std::string &&data) {
+    std::lock_guard lock(m_mutex);
+    if (m_idle.size() < m_maxIdle)
+        m_idle.push_back(std::move(data));
+}
@@ -19,6 +19,8 @@
 
 #include "utils/db_connector.h"
 
+#include "utils/metrics.h"
+
 #include "sqlite3.h"
 #include <QDir>
 #include <QJsonArray>
@@ -27,6 +29,51 @@
 
 // #define ENABLE_SQLITE_TRUE_LOGS
 
+namespace {
+DBRow readRow(sqlite3_stmt *stmt) {
+    DBRow row;
+    int colNum = sqlite3_column_count(stmt);
+
+    for (int i = 0; i < colNum; i++) {
+        std::string n = sqlite3_column_name(stmt, i);
+        std::string t;
+        switch (sqlite3_column_type(stmt, i)) {
+        case SQLITE_BLOB: {
+            int size = sqlite3_column_bytes(stmt, i);
+            t = std::string(reinterpret_cast<const char *>(sqlite3_column_blob(stmt, i)), size);
+            break;
+        }
+        case SQLITE3_TEXT: {
+            t = (reinterpret_cast<const char *>(sqlite3_column_text(stmt, i)));
+            break;
+        }
+        case SQLITE_INTEGER:
+            t = std::to_string(sqlite3_column_int64(stmt, i));
+            break;
+        case SQLITE_FLOAT:
+            t = std::to_string(sqlite3_column_double(stmt, i));
+            break;
+        default:
+            break;
+        }
+
+        row.insert({ n, t });
+    }
+    return row;
+}
+
+bool bindParams(sqlite3_stmt *stmt, const std::vector<std::string> &params) {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    for (std::size_t i = 0; i < params.size(); i++) {
+        if (sqlite3_bind_text(stmt, int(i + 1), params[i].data(), int(params[i].size()), SQLITE_STATIC)
+            != SQLITE_OK)
+            return false;
+    }
+    return true;
+}
+}
+
 DBConnector::DBConnector(const std::string &filePath) {
     if (filePath.empty()) {
         qFatal("[DBConnector] Empty file name");
@@ -97,6 +144,9 @@ std::vector<DBRow> DBConnector::select(std::string query, std::string tableName,
     if (!isOpen()) {
         qFatal("[DBConnector] Database not open");
     }
+    static auto &queryTime = Metrics::histogram("extrachain_db_query_seconds", "SQLite statement time",
+                                                { { "op", "select" } });
+    Metrics::Timer timer(queryTime);
 
     dbmutex.lock();
     sqlite3_stmt *stmt;
@@ -119,36 +169,7 @@ std::vector<DBRow> DBConnector::select(std::string query, std::string tableName,
             break;
         }
 
-        DBRow row;
-        int colNum = sqlite3_column_count(stmt);
-
-        for (int i = 0; i < colNum; i++) {
-            std::string n = sqlite3_column_name(stmt, i);
-            std::string t;
-            switch (sqlite3_column_type(stmt, i)) {
-            case SQLITE_BLOB: {
-                int size = sqlite3_column_bytes(stmt, i);
-                t = std::string(reinterpret_cast<const char *>(sqlite3_column_blob(stmt, i)), size);
-                break;
-            }
-            case SQLITE3_TEXT: {
-                t = (reinterpret_cast<const char *>(sqlite3_column_text(stmt, i)));
-                break;
-            }
-            case SQLITE_INTEGER:
-                t = std::to_string(sqlite3_column_int64(stmt, i));
-                break;
-            case SQLITE_FLOAT:
-                t = std::to_string(sqlite3_column_double(stmt, i));
-                break;
-            default:
-                break;
-            }
-
-            row.insert({ n, t });
-        }
-
-        res.push_back(row);
+        res.push_back(readRow(stmt));
 
         rs = sqlite3_step(stmt);
     }
@@ -196,6 +217,9 @@ bool DBConnector::deleteRow(const std::string &tableName, const DBRow &data) {
     if (!isOpen()) {
         qFatal("[DBConnector] Database not open");
     }
+    static auto &queryTime = Metrics::histogram("extrachain_db_query_seconds", "SQLite statement time",
+                                                { { "op", "delete" } });
+    Metrics::Timer timer(queryTime);
 
     if (data.size() == 0) {
         qDebug() << "[DBConnector]" << file().c_str() << "(false): [ImplementationInsert] DBRow is empty";
@@ -250,6 +274,66 @@ bool DBConnector::deleteRow(const std::string &tableName, const DBRow &data) {
     return true;
 }
 
+std::vector<DBRow> DBConnector::selectMany(const std::string &query,
+                                           const std::vector<std::vector<std::string>> &params) {
+    if (!isOpen()) {
+        qFatal("[DBConnector] Database not open");
+    }
+    static auto &queryTime = Metrics::histogram("extrachain_db_query_seconds", "SQLite statement time",
+                                                { { "op", "select" } });
+    Metrics::Timer timer(queryTime);
+
+    QMutexLocker locker(&dbmutex);
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        qDebug() << "[DBConnector] SelectMany: prepare failed:" << sqlite3_errmsg(db) << query.c_str();
+        return {};
+    }
+
+    std::vector<DBRow> res;
+    for (const auto &row : params) {
+        int rc = bindParams(stmt, row) ? sqlite3_step(stmt) : SQLITE_MISUSE;
+        for (; rc == SQLITE_ROW; rc = sqlite3_step(stmt))
+            res.push_back(readRow(stmt));
+        if (rc != SQLITE_DONE) {
+            qDebug() << "[DBConnector]" << file().c_str() << "SelectMany error:" << sqlite3_errmsg(db);
+            sqlite3_finalize(stmt);
+            return {};
+        }
+    }
+    sqlite3_finalize(stmt);
+    return res;
+}
+
+bool DBConnector::execMany(const std::string &query, const std::vector<std::vector<std::string>> &params) {
+    if (!isOpen()) {
+        qFatal("[DBConnector] Database not open");
+    }
+    static auto &queryTime = Metrics::histogram("extrachain_db_query_seconds", "SQLite statement time",
+                                                { { "op", "batch" } });
+    Metrics::Timer timer(queryTime);
+
+    QMutexLocker locker(&dbmutex);
+    // savepoint works inside of a transaction too
+    if (sqlite3_exec(db, "SAVEPOINT execMany;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        qDebug() << "[DBConnector] ExecMany: can't start transaction:" << sqlite3_errmsg(db);
+        return false;
+    }
+    sqlite3_stmt *stmt = nullptr;
+    bool done = sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK;
+    for (auto row = params.begin(); done && row != params.end(); ++row)
+        done = bindParams(stmt, *row) && sqlite3_step(stmt) == SQLITE_DONE;
+    if (!done)
+        qDebug() << "[DBConnector]" << file().c_str() << "ExecMany error:" << sqlite3_errmsg(db)
+                 << query.c_str();
+    sqlite3_finalize(stmt);
+
+    if (!done)
+        sqlite3_exec(db, "ROLLBACK TO execMany;", nullptr, nullptr, nullptr);
+    sqlite3_exec(db, "RELEASE execMany;", nullptr, nullptr, nullptr);
+    return done;
+}
+
 bool DBConnector::deleteTable(const std::string &name) {
     std::string query = "DROP TABLE " + name + ";";
     return this->query(query);
@@ -312,6 +396,9 @@ bool DBConnector::query(std::string query) {
     if (!isOpen()) {
         qFatal("[DBConnector] Database not open");
     }
+    static auto &queryTime = Metrics::histogram("extrachain_db_query_seconds", "SQLite statement time",
+                                                { { "op", "query" } });
+    Metrics::Timer timer(queryTime);
 
     dbmutex.lock();
     sqlite3_stmt *stmt;
@@ -416,6 +503,9 @@ bool DBConnector::implementationInsert(const std::string &tableName, const DBRow
     if (!isOpen()) {
         qFatal("[DBConnector] Database not open");
     }
+    static auto &queryTime = Metrics::histogram("extrachain_db_query_seconds", "SQLite statement time",
+                                                { { "op", "insert" } });
+    Metrics::Timer timer(queryTime);
 
     if (data.size() == 0) {
         qDebug() << "[DBConnector]" << file().c_str() << "(false): [ImplementationInsert] DBRow is empty";
@@ -126,7 +126,7 @@ std::filesystem::path DFS::Path::filePath(const ActorId &actorId, const std::str
         + fileName;
 }
 
-int DFS::Tables::ActorDirFile::totalFileSize(const std::string &actorId) {
+uint64_t DFS::Tables::ActorDirFile::totalFileSize(const std::string &actorId) {
     auto db = actorDbConnector(actorId);
     if (!db.isOpen()) {
         qFatal("DB Error");
@@ -140,7 +140,7 @@ int DFS::Tables::ActorDirFile::totalFileSize(const std::string &actorId) {
 
     auto row = db.select(fmt::format("SELECT SUM(fileSize) from {}", TableName)).at(0);
 
-    return std::stoi(row["SUM(fileSize)"]);
+    return std::stoull(row["SUM(fileSize)"]);
 }
 
 uint64_t DFS::Tables::ActorDirFile::dataAmountStoredSize(const std::string &actorId,
@@ -0,0 +1,190 @@
+/*
+ * ExtraChain Core
+ * Copyright (C) 2020 ExtraChain Foundation <extrachain@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+
+#include "utils/metrics.h"
+
+#include <algorithm>
+
+#include <fmt/core.h>
+
+#include <QtGlobal>
+
+namespace Metrics {
+
+namespace {
+std::string renderLabels(const Labels &labels) {
+    if (labels.empty())
+        return "";
+    std::string text = "{";
+    for (const auto &[name, value] : labels) {
+        if (text.size() > 1)
+            text += ",";
+        text += name + "=\"";
+        for (char c : value) {
+            if (c == '\\' || c == '"')
+                text += '\\';
+            text += c == '\n' ? std::string("\\n") : std::string(1, c);
+        }
+        text += "\"";
+    }
+    return text + "}";
+}
+
+// labels of histogram sample with le added
+std::string withBound(const std::string &labels, const std::string &bound) {
+    const std::string le = "le=\"" + bound + "\"";
+    return labels.empty() ? "{" + le + "}" : labels.substr(0, labels.size() - 1) + "," + le + "}";
+}
+}
+
+const std::vector<double> &latencyBuckets() {
+    static const std::vector<double> buckets = { 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+                                                 0.01,    0.025,  0.05,    0.1,    0.25,  0.5,    1,
+                                                 2.5,     5,      10 };
+    return buckets;
+}
+
+void Counter::inc(uint64_t value) {
+    m_value.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t Counter::value() const {
+    return m_value.load(std::memory_order_relaxed);
+}
+
+void Gauge::set(int64_t value) {
+    m_value.store(value, std::memory_order_relaxed);
+}
+
+void Gauge::add(int64_t value) {
+    m_value.fetch_add(value, std::memory_order_relaxed);
+}
+
+int64_t Gauge::value() const {
+    return m_value.load(std::memory_order_relaxed);
+}
+
+Histogram::Histogram(std::vector<double> bounds)
+    : m_bounds(std::move(bounds))
+    , m_buckets(new std::atomic<uint64_t>[m_bounds.size() + 1]) {
+    std::sort(m_bounds.begin(), m_bounds.end());
+    for (std::size_t i = 0; i <= m_bounds.size(); i++)
+        m_buckets[i] = 0;
+}
+
+void Histogram::observe(double value) {
+    const auto bucket = std::lower_bound(m_bounds.begin(), m_bounds.end(), value) - m_bounds.begin();
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::count() const {
+    return m_count.load(std::memory_order_relaxed);
+}
+
+double Histogram::sum() const {
+    return m_sum.load(std::memory_order_relaxed);
+}
+
+const std::vector<double> &Histogram::bounds() const {
+    return m_bounds;
+}
+
+std::vector<uint64_t> Histogram::cumulative() const {
+    std::vector<uint64_t> counts(m_bounds.size() + 1);
+    uint64_t total = 0;
+    for (std::size_t i = 0; i < counts.size(); i++)
+        counts[i] = total += m_buckets[i].load(std::memory_order_relaxed);
+    return counts;
+}
+
+Timer::Timer(Histogram &histogram)
+    : m_histogram(histogram)
+    , m_start(std::chrono::steady_clock::now()) {
+}
+
+Timer::~Timer() {
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+    m_histogram.observe(elapsed.count());
+}
+
+Registry &Registry::instance() {
+    static Registry registry;
+    return registry;
+}
+
+Counter &Registry::counter(const std::string &name, const std::string &help, const Labels &labels) {
+    std::lock_guard lock(m_mutex);
+    auto &metric = family(name, help, Type::Counter).counters[renderLabels(labels)];
+    if (!metric)
+        metric = std::make_unique<Counter>();
+    return *metric;
+}
+
+Gauge &Registry::gauge(const std::string &name, const std::string &help, const Labels &labels) {
+    std::lock_guard lock(m_mutex);
+    auto &metric = family(name, help, Type::Gauge).gauges[renderLabels(labels)];
+    if (!metric)
+        metric = std::make_unique<Gauge>();
+    return *metric;
+}
+
+Histogram &Registry::histogram(const std::string &name, const std::string &help, const Labels &labels,
+                               const std::vector<double> &bounds) {
+    std::lock_guard lock(m_mutex);
+    auto &metric = family(name, help, Type::Histogram).histograms[renderLabels(labels)];
+    if (!metric)
+        metric = std::make_unique<Histogram>(bounds);
+    return *metric;
+}
+
+std::string Registry::expose() const {
+    std::lock_guard lock(m_mutex);
+    std::string text;
+    for (const auto &[name, family] : m_families) {
+        static const char *types[] = { "counter", "gauge", "histogram" };
+        text += "# HELP " + name + " " + family.help + "\n";
+        text += "# TYPE " + name + " " + types[int(family.type)] + "\n";
+        for (const auto &[labels, counter] : family.counters)
+            text += fmt::format("{}{} {}\n", name, labels, counter->value());
+        for (const auto &[labels, gauge] : family.gauges)
+            text += fmt::format("{}{} {}\n", name, labels, gauge->value());
+        for (const auto &[labels, histogram] : family.histograms) {
+            const auto counts = histogram->cumulative();
+            const auto &bounds = histogram->bounds();
+            for (std::size_t i = 0; i < bounds.size(); i++)
+                text += fmt::format("{}_bucket{} {}\n", name, withBound(labels, fmt::format("{}", bounds[i])),
+                                    counts[i]);
+            text += fmt::format("{}_bucket{} {}\n", name, withBound(labels, "+Inf"), counts.back());
+            text += fmt::format("{}_sum{} {}\n", name, labels, histogram->sum());
+            text += fmt::format("{}_count{} {}\n", name, labels, histogram->count());
+        }
+    }
+    return text;
+}
+
+Registry::Family &Registry::family(const std::string &name, const std::string &help, Type type) {
+    auto [it, added] = m_families.try_emplace(name, Family { .type = type, .help = help });
+    if (!added && it->second.type != type)
+        qFatal("[Metrics] %s is registered with another type", name.c_str());
+    return it->second;
+}
+} // namespace Metrics
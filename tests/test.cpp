@@ -1,6 +1,38 @@
+#include "datastorage/block_sync.h"
+#include "datastorage/dfs/chunk_store.h"
+#include "datastorage/dfs/dfs_counters.h"
+#include "datastorage/dfs/dfs_download.h"
+#include "datastorage/dfs/dfs_ingestion.h"
+#include "datastorage/dfs/historical_chain.h"
+#include "datastorage/dfs/mapped_file.h"
+#include "datastorage/dfs/mapped_file_cache.h"
+#include "datastorage/index/actor_directory.h"
+#include "datastorage/index/header_index.h"
+#include "datastorage/index/memindex.h"
+#include "enc/enc_tools.h"
+#include "enc/file_cipher.h"
+#include "managers/account_controller.h"
 #include "managers/extrachain_node.h"
+#include "managers/log_writer.h"
 #include "managers/logs_manager.h"
+#include "managers/thread_pool.h"
+#include "managers/tx_manager.h"
+#include "network/message_filter.h"
+#include "network/message_frame.h"
+#include "network/metrics_server.h"
+#include "network/network_manager.h"
+#include "utils/amount.h"
+#include "utils/buffer_pool.h"
+#include "utils/db_connector.h"
+#include "utils/metrics.h"
 #include <QtTest/QtTest>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <random>
+#include <set>
+#include <thread>
 
 class Test : public QObject {
     Q_OBJECT
@@ -104,6 +136,1305 @@ private slots:
 //    return 0;
     }
 
+    void messageFilter() {
+        MessageFilter filter(1000, 0.001);
+        for (int i = 0; i < 1000; i++) {
+            auto key = MessageFilter::makeKey("sender", std::to_string(i),
+                                              int(MessageType::BlockchainNewBlock), int(MessageStatus::NoStatus),
+                                              "block");
+            filter.insert(key);
+        }
+
+        for (int i = 0; i < 1000; i++) {
+            auto key = MessageFilter::makeKey("sender", std::to_string(i),
+                                              int(MessageType::BlockchainNewBlock), int(MessageStatus::NoStatus),
+                                              "block");
+            QVERIFY(!filter.insert(key));
+        }
+
+        auto response = MessageFilter::makeKey("sender", "1", int(MessageType::BlockchainNewBlock),
+                                               int(MessageStatus::Response), "block");
+        QVERIFY(filter.insert(response));
+
+        // responses sharing message id differ by payload
+        auto part = [](const std::string &data) {
+            return MessageFilter::makeKey("sender", "sync", int(MessageType::DfsDirData),
+                                          int(MessageStatus::Response), data);
+        };
+        QVERIFY(filter.insert(part("first dir")));
+        QVERIFY(filter.insert(part("second dir")));
+        QVERIFY(!filter.insert(part("second dir")));
+        QVERIFY(filter.falsePositiveRate() < 0.01);
+        QVERIFY(filter.memoryUsage() < 8 * 1024);
+        qDebug() << "[MessageFilter] fp rate:" << filter.falsePositiveRate()
+                 << "memory:" << filter.memoryUsage();
+    }
+
+    void sendRouting() {
+        using Config::Net::TypeSend;
+        QVERIFY(NetworkManager::isReceiver(TypeSend::All, "", "socket"));
+        QVERIFY(NetworkManager::isReceiver(TypeSend::All, "other", "socket"));
+        QVERIFY(NetworkManager::isReceiver(TypeSend::Focused, "socket", "socket"));
+        QVERIFY(!NetworkManager::isReceiver(TypeSend::Focused, "other", "socket"));
+        QVERIFY(NetworkManager::isReceiver(TypeSend::Focused, "", "socket"));
+        QVERIFY(!NetworkManager::isReceiver(TypeSend::Except, "socket", "socket"));
+        QVERIFY(NetworkManager::isReceiver(TypeSend::Except, "other", "socket"));
+    }
+
+    void blockSync() {
+        const int count = 100000;
+        Actor<KeyPrivate> approver;
+        approver.create(ActorType::User);
+        const auto approverPublic = approver.convertToPublic();
+
+        std::vector<std::string> remoteChain, localChain;
+        remoteChain.reserve(count);
+        Block prev;
+        for (int i = 0; i < count; i++) {
+            Block block(std::string("data ") + std::to_string(i), prev);
+            block.sign(approver);
+            remoteChain.push_back(block.serialize().toStdString());
+            prev = block;
+        }
+
+        auto storage = [&approverPublic](std::vector<std::string> &chain) {
+            return BlockSync::Storage {
+                .tip =
+                    [&chain] {
+                        if (chain.empty())
+                            return BSP::Tip { .Index = BigNumber(-1), .Hash = "" };
+                        Block last(QByteArray::fromStdString(chain.back()));
+                        return BSP::Tip { .Index = last.getIndex(), .Hash = last.getHash() };
+                    },
+                .blockData =
+                    [&chain](const BigNumber &id) {
+                        auto index = std::size_t(id.data());
+                        return index < chain.size() ? QByteArray::fromStdString(chain[index]) : QByteArray();
+                    },
+                .verify = [&approverPublic](const Block &block) { return block.verify(approverPublic); },
+                .commit =
+                    [&chain](const std::vector<std::string> &blocks) {
+                        chain.insert(chain.end(), blocks.begin(), blocks.end());
+                        return 0;
+                    }
+            };
+        };
+
+        // lagging peer advertises the full tip but stores only half of the chain
+        std::vector<std::string> laggingChain(remoteChain.begin(), remoteChain.begin() + count / 2);
+        BlockSync fullA(storage(remoteChain), {});
+        BlockSync fullB(storage(remoteChain), {});
+        BlockSync lagging(storage(laggingChain), {});
+        const std::map<std::string, BlockSync *> peers { { "fullA", &fullA },
+                                                         { "fullB", &fullB },
+                                                         { "lagging", &lagging } };
+
+        // messages are queued as with the network, local requests, one remote responds,
+        // checked ranges are posted back from the pool
+        std::mutex queueMutex;
+        std::deque<std::function<void()>> queue;
+        auto push = [&](std::function<void()> message) {
+            std::lock_guard lock(queueMutex);
+            queue.push_back(std::move(message));
+        };
+        std::map<std::string, int> requests;
+        int broadcasts = 0, shortReplies = 0;
+        BlockSync *localPtr = nullptr;
+        auto localStorage = storage(localChain);
+        localStorage.post = push;
+        BlockSync local(
+            localStorage,
+            { .requestTip =
+                  [&] {
+                      for (const auto &[name, peer] : peers)
+                          push([&, name] { localPtr->handleTip(fullA.localTip(), name); });
+                  },
+              .requestRange =
+                  [&](const std::string &name, const BSP::RangeRequest &request) {
+                      if (name.empty()) {
+                          broadcasts++;
+                          return;
+                      }
+                      requests[name]++;
+                      push([&, name, request] {
+                          auto response = peers.at(name)->blockRange(request);
+                          if (response.Blocks.size() < request.Count)
+                              shortReplies++;
+                          push([&, name, response] { localPtr->handleRange(response, name); });
+                      });
+                  } });
+        localPtr = &local;
+
+        QElapsedTimer timer;
+        timer.start();
+        local.requestTip();
+        while (true) {
+            std::function<void()> message;
+            {
+                std::lock_guard lock(queueMutex);
+                if (!queue.empty()) {
+                    message = std::move(queue.front());
+                    queue.pop_front();
+                }
+            }
+            if (message)
+                message();
+            else if (local.isSyncing())
+                std::this_thread::yield(); // ranges are checked in the pool
+            else
+                break;
+        }
+        const qint64 elapsed = std::max<qint64>(timer.elapsed(), 1);
+
+        QCOMPARE(broadcasts, 0);
+        QVERIFY(requests["fullA"] > 0 && requests["fullB"] > 0 && requests["lagging"] > 0);
+        QVERIFY(shortReplies > 0);
+        QVERIFY(!local.isSyncing());
+        QCOMPARE(localChain.size(), remoteChain.size());
+        QCOMPARE(localChain.back(), remoteChain.back());
+        qDebug() << "[BlockSync]" << count << "blocks in" << elapsed << "ms," << count * 1000 / elapsed
+                 << "blocks/s";
+    }
+
+    void blockHeader() {
+        QCOMPARE(BlockHeader::merkleRoot({}), std::string());
+        QCOMPARE(BlockHeader::merkleRoot({ "a" }), std::string("a"));
+        QCOMPARE(BlockHeader::merkleRoot({ "a", "b", "c" }),
+                 Utils::calcHash(Utils::calcHash("ab") + Utils::calcHash("cc")));
+
+        Actor<KeyPrivate> approver;
+        approver.create(ActorType::User);
+        Block block(std::string(), Block());
+        block.sign(approver);
+
+        BlockHeader header(block);
+        auto received = MessagePack::deserialize<BlockHeader>(MessagePack::serialize(header));
+        QVERIFY(received == header);
+        QVERIFY(received.matches(block));
+        QVERIFY(received.verify(approver.convertToPublic()));
+        QCOMPARE(received.approver(), block.getApprover());
+
+        // signature of the last approver is checked, as approver() reports
+        Actor<KeyPrivate> second;
+        second.create(ActorType::User);
+        block.sign(second);
+        BlockHeader signedTwice(block);
+        QCOMPARE(signedTwice.approver(), second.id());
+        QVERIFY(signedTwice.verify(second.convertToPublic()));
+        QVERIFY(!signedTwice.verify(approver.convertToPublic()));
+    }
+
+    void headerIndex() {
+        const std::string path = "header-index.db";
+        std::filesystem::remove(path);
+        // file and memory mode
+        for (const std::string &filePath : { path, std::string() }) {
+            HeaderIndex index(filePath);
+            QCOMPARE(index.inMemory(), filePath.empty());
+            std::vector<BlockHeader> headers;
+            for (int i = 0; i < 10; i++) {
+                BlockHeader header;
+                header.index = BigNumber(i);
+                header.hash = "hash-" + std::to_string(i);
+                headers.push_back(header);
+            }
+            QCOMPARE(index.addHeaders(headers), 0);
+            QCOMPARE(index.tip().index, BigNumber(9));
+            QCOMPARE(index.getHeaders(BigNumber(8), 5).size(), std::size_t(2));
+
+            // tip follows removal of the top of chain
+            QCOMPARE(index.removeFrom(BigNumber(6)), 0);
+            QCOMPARE(index.tip().index, BigNumber(5));
+            QVERIFY(!index.contains(BigNumber(7), "hash-7"));
+            QVERIFY(index.contains(BigNumber(5), "hash-5"));
+            QCOMPARE(index.addHeader(headers[2]), 0);
+            QCOMPARE(index.tip().index, BigNumber(5));
+
+            index.clear();
+            QVERIFY(index.tip().isEmpty());
+            QVERIFY(!index.contains(BigNumber(0)));
+        }
+        std::filesystem::remove(path);
+    }
+
+    void dfsDownload() {
+        const uint64_t segmentSize = 1024;
+        std::string source(37 * segmentSize + 100, '\0');
+        for (std::size_t i = 0; i < source.size(); i++)
+            source[i] = char(i * 31 + 7);
+        DFSP::AddFileMessage file = {
+            .Actor = "actor", .FileName = "file", .FileHash = "", .Path = "", .Size = source.size()
+        };
+
+        std::string target(source.size(), '\0');
+        std::string halfBitmap, savedBitmap;
+        int saves = 0;
+        using Item = std::pair<std::string, DFSP::RequestSegmentMessage>;
+        std::deque<Item> queue, slowQueue;
+        std::set<uint64_t> requested;
+
+        auto makeDownload = [&](const std::string &bitmap) {
+            DfsDownload::Storage storage = { .write =
+                                                 [&](uint64_t offset, const std::string &data) {
+                                                     target.replace(offset, data.size(), data);
+                                                     return true;
+                                                 },
+                                             .saveBitmap =
+                                                 [&](const std::string &bitmap) {
+                                                     savedBitmap = bitmap;
+                                                     saves++;
+                                                 } };
+            DfsDownload::Transport transport = {
+                .requestSegment =
+                    [&](const std::string &peer, const DFSP::RequestSegmentMessage &request) {
+                        requested.insert(request.Offset / segmentSize);
+                        (peer == "slow" ? slowQueue : queue).push_back({ peer, request });
+                    }
+            };
+            return std::make_unique<DfsDownload>(file, bitmap, storage, transport, segmentSize);
+        };
+        auto respond = [&](DfsDownload &download, const Item &item, DfsDownload::Clock::time_point now) {
+            const auto &[peer, request] = item;
+            DFSP::SegmentMessage segment = { .Actor = request.Actor,
+                                             .FileName = request.FileName,
+                                             .FileHash = "",
+                                             .Data = source.substr(request.Offset, request.Size),
+                                             .Offset = request.Offset };
+            download.handleSegment(peer, segment, now);
+        };
+
+        // two fast peers and one peer that never answers in time
+        auto now = DfsDownload::Clock::now();
+        auto download = makeDownload("");
+        for (const auto &peer : { "fast1", "fast2", "slow" })
+            download->addPeer(peer, now);
+        while (!download->isComplete()) {
+            if (queue.empty()) {
+                now += DfsDownload::SEGMENT_TIMEOUT + std::chrono::seconds(1);
+                download->checkTimeouts(now);
+                continue;
+            }
+            auto item = queue.front();
+            queue.pop_front();
+            respond(*download, item, now);
+            if (download->segmentsDone() == download->segmentCount() / 2 && halfBitmap.empty())
+                halfBitmap = download->bitmap();
+        }
+        for (const auto &item : slowQueue)
+            respond(*download, item, now);
+
+        QCOMPARE(target, source);
+        QVERIFY(download->retried() > 0);
+
+        // resume after restart requests only missing segments
+        target.assign(source.size(), '\0');
+        queue.clear();
+        requested.clear();
+        saves = 0;
+        auto resumed = makeDownload(halfBitmap);
+        QCOMPARE(resumed->segmentsDone(), resumed->segmentCount() / 2);
+        resumed->addPeer("fast1", now);
+        resumed->addPeer("fast2", now);
+        while (!queue.empty()) {
+            auto item = queue.front();
+            queue.pop_front();
+            respond(*resumed, item, now);
+        }
+        QVERIFY(resumed->isComplete());
+        QCOMPARE(requested.size(), resumed->segmentCount() - resumed->segmentCount() / 2);
+
+        // bitmap is saved in batches, the rest when timeouts are checked
+        QCOMPARE(saves, int(requested.size() / DfsDownload::BITMAP_BATCH));
+        resumed->checkTimeouts(now);
+        QCOMPARE(saves, int(requested.size() / DfsDownload::BITMAP_BATCH) + 1);
+        QCOMPARE(savedBitmap, resumed->bitmap());
+        resumed->flushBitmap();
+        QCOMPARE(saves, int(requested.size() / DfsDownload::BITMAP_BATCH) + 1);
+        for (uint64_t segment : requested)
+            QVERIFY(!(uint8_t(halfBitmap[segment / 8]) & (1 << (segment % 8))));
+
+        // window is halved by a timeout and grows back while segments come in time
+        queue.clear();
+        auto recovering = makeDownload("");
+        recovering->addPeer("fast1", now);
+        QCOMPARE(queue.size(), std::size_t(DfsDownload::PEER_WINDOW));
+        queue.clear();
+        now += DfsDownload::SEGMENT_TIMEOUT + std::chrono::seconds(1);
+        recovering->checkTimeouts(now);
+        QCOMPARE(recovering->window("fast1"), uint32_t(1));
+        std::size_t maxInFlight = 0;
+        while (!queue.empty()) {
+            maxInFlight = std::max(maxInFlight, queue.size());
+            auto item = queue.front();
+            queue.pop_front();
+            respond(*recovering, item, now);
+        }
+        QVERIFY(recovering->isComplete());
+        QVERIFY(recovering->window("fast1") > DfsDownload::PEER_WINDOW);
+        QVERIFY(maxInFlight > DfsDownload::PEER_WINDOW);
+    }
+
+    void dfsServing() {
+        const uint64_t fileSize = 64 * 1024 * 1024;
+        const std::string path = "dfs-serving.bin";
+        {
+            std::string section(DFSB::sectionSize, '\0');
+            for (std::size_t i = 0; i < section.size(); i++)
+                section[i] = char(i * 31 + 7);
+            std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+            for (uint64_t written = 0; written < fileSize; written += section.size())
+                stream.write(section.data(),
+                             std::streamsize(std::min<uint64_t>(section.size(), fileSize - written)));
+        }
+        MappedFile file(path);
+        QVERIFY(file.isOpen());
+        QCOMPARE(file.size(), fileSize);
+
+        KeyPrivate sender, receiver;
+        sender.generate();
+        receiver.generate();
+        const std::string sharedKey =
+            SecretKey::asymmetricSharedKey(sender.secretKey(), receiver.publicKey());
+        const MessageBody header = { .message_type = MessageType::DfsSegment,
+                                     .status = MessageStatus::Response,
+                                     .message_id = std::string(15, 'a'),
+                                     .sender_id = ActorId(),
+                                     .data = "" };
+        auto view = [&](uint64_t offset) {
+            return DFSP::SegmentView { .Actor = "actor",
+                                       .FileName = "file",
+                                       .FileHash = "",
+                                       .Data = file.slice(offset, DFSB::sectionSize),
+                                       .Offset = offset };
+        };
+
+        // previous path: section copied to string, payload and body serialized, signature appended
+        auto copyServe = [&](uint64_t offset) {
+            DFSP::SegmentMessage segment = { .Actor = "actor",
+                                             .FileName = "file",
+                                             .FileHash = "",
+                                             .Data = std::string(file.slice(offset, DFSB::sectionSize)),
+                                             .Offset = offset };
+            MessageBody body = header;
+            body.data = MessagePack::serialize(segment);
+            const std::string serialized = body.serialize();
+            return sender.encrypt(serialized + sender.sign(serialized), receiver.publicKey());
+        };
+
+        BufferPool pool;
+        auto frameServe = [&](uint64_t offset) {
+            const auto segment = view(offset);
+            auto frame = pool.acquire(MessageFrame::size(header, segment));
+            MessageFrame::write(frame.data(), header, segment, sender);
+            auto encrypted = pool.acquire(frame.data().size() + SecretKey::asymmetricOverhead);
+            SecretKey::encryptAsymmetricTo(encrypted.data(), frame.data(), sharedKey);
+            return encrypted;
+        };
+
+        // same bytes on the wire
+        const uint64_t lastOffset = (fileSize - 1) / DFSB::sectionSize * DFSB::sectionSize;
+        for (uint64_t offset : { uint64_t(0), lastOffset }) {
+            std::string frame;
+            MessageFrame::write(frame, header, view(offset), sender);
+            QCOMPARE(frame.size(), MessageFrame::size(header, view(offset)));
+            QCOMPARE(receiver.decrypt(frameServe(offset).data(), sender.publicKey()), frame);
+            QCOMPARE(receiver.decrypt(copyServe(offset), sender.publicKey()), frame);
+        }
+
+        auto measure = [&](const char *name, auto serve) {
+            uint64_t segments = 0;
+            QElapsedTimer timer;
+            timer.start();
+            for (uint64_t offset = 0; offset < fileSize; offset += DFSB::sectionSize, segments++)
+                serve(offset);
+            const qint64 elapsed = std::max<qint64>(timer.elapsed(), 1);
+            qDebug() << "[DfsServing]" << name << ":" << segments << "segments in" << elapsed << "ms,"
+                     << double(fileSize) / (1024 * 1024) * 1000 / elapsed << "MB/s";
+            return segments;
+        };
+        measure("copy", copyServe);
+        const uint64_t allocations = pool.allocations();
+        const uint64_t segments = measure("frame", frameServe);
+        qDebug() << "[DfsServing] pooled allocations per segment after warm up:"
+                 << double(pool.allocations() - allocations) / double(segments);
+        QCOMPARE(pool.allocations(), allocations);
+
+        std::filesystem::remove(path);
+    }
+
+    void dfsCounters() {
+        const std::string dbPath = "dfs-counters.db";
+        const std::string filePath = "dfs-counters.bin";
+        std::filesystem::remove(dbPath);
+        std::filesystem::remove(filePath);
+
+        DfsCounters counters(dbPath);
+        QVERIFY(!counters.load());
+        counters.reset({ { "a", { .disk = 100, .files = 50, .stored = 50 } },
+                         { "b", { .disk = 10, .files = 0, .stored = 0 } } });
+        QCOMPARE(counters.total().disk, 110);
+
+        counters.add("b", { .files = 20 });
+        {
+            auto change = counters.change("a", { filePath });
+            std::ofstream(filePath, std::ios::binary) << std::string(1000, 'x');
+            change.add({ .stored = 1000 });
+        }
+        const DfsCounters::Sizes a = { .disk = 1100, .files = 50, .stored = 1050 };
+        QVERIFY(counters.actor("a") == a);
+        QCOMPARE(counters.total().files, 70);
+
+        {
+            auto change = counters.change("a", { filePath });
+            std::filesystem::remove(filePath);
+            change.add({ .stored = -1000 });
+        }
+        QCOMPARE(counters.actor("a").disk, 100);
+
+        DfsCounters loaded(dbPath);
+        QVERIFY(loaded.load());
+        QVERIFY(loaded.actor("a") == counters.actor("a"));
+        QVERIFY(loaded.actor("b") == counters.actor("b"));
+        QVERIFY(loaded.total() == counters.total());
+
+        std::filesystem::remove(dbPath);
+    }
+
+    void dfsIngestion() {
+        ThreadPool pool(4);
+        QSemaphore gate;
+        std::atomic<int> hashing = 0, peakHashing = 0, indexing = 0, peakIndexing = 0, announced = 0;
+        auto enter = [](std::atomic<int> &running, std::atomic<int> &peak) {
+            const int now = ++running;
+            int previous = peak;
+            while (previous < now && !peak.compare_exchange_weak(previous, now)) { }
+        };
+
+        DfsIngestion::Handlers handlers = {
+            [&gate](DfsIngestion::Item &item) {
+                gate.acquire();
+                gate.release();
+                item.fileName = item.source.string();
+                return std::string();
+            },
+            [](DfsIngestion::Item &) { return std::string(); },
+            [&](DfsIngestion::Item &item) {
+                enter(hashing, peakHashing);
+                QThread::msleep(5);
+                item.fileHash = "hash " + item.fileName;
+                hashing--;
+                return item.fileName == "bad" ? std::string("ErrorNotReadable") : std::string();
+            },
+            [&](DfsIngestion::Item &) {
+                enter(indexing, peakIndexing);
+                QThread::msleep(1);
+                indexing--;
+                return std::string();
+            },
+            [&announced](DfsIngestion::Item &) {
+                announced++;
+                return std::string();
+            }
+        };
+        DfsIngestion ingestion(handlers, &pool);
+
+        // stages are blocked, add returns at once
+        std::vector<QFuture<DfsIngestion::Item>> results;
+        for (int i = 0; i < 200; i++)
+            results.push_back(ingestion.add({ .source = i == 5 ? "bad" : "file-" + std::to_string(i) }));
+        QCOMPARE(ingestion.inProgress(), 200);
+        QVERIFY(!results.front().isFinished());
+
+        gate.release();
+        ingestion.waitForDone();
+        QCOMPARE(ingestion.inProgress(), 0);
+        for (int i = 0; i < 200; i++) {
+            const auto item = results[i].result();
+            QCOMPARE(item.error, std::string(i == 5 ? "ErrorNotReadable" : ""));
+            QCOMPARE(item.fileHash, "hash " + item.fileName);
+        }
+        QCOMPARE(announced.load(), 199);
+        QVERIFY(peakHashing > 1);
+        QCOMPARE(peakIndexing.load(), 1);
+        QVERIFY(ingestion.peakQueued() <= DfsIngestion::QUEUE_SIZE);
+        qDebug() << "[DfsIngestion] parallel hashing:" << peakHashing.load()
+                 << "peak queue:" << ingestion.peakQueued();
+    }
+
+    void fileCipher() {
+        // 1 GB with EXTRACHAIN_BENCHMARK set, old format is measured on a prefix, it is too slow
+        const uint64_t fileSize =
+            qEnvironmentVariableIsSet("EXTRACHAIN_BENCHMARK") ? 1024ull * 1024 * 1024 : 64 * 1024 * 1024;
+        const uint64_t oldFormatSize = std::min<uint64_t>(fileSize, 8 * 1024 * 1024);
+        const std::string path = "file-cipher.bin";
+        const std::string encrypted = "file-cipher.enc", decrypted = "file-cipher.dec";
+        {
+            std::string section(1024 * 1024, '\0');
+            for (std::size_t i = 0; i < section.size(); i++)
+                section[i] = char(i * 13 + 5);
+            std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+            for (uint64_t written = 0; written < fileSize; written += section.size())
+                stream.write(section.data(), std::streamsize(section.size()));
+        }
+        KeyPrivate key;
+        key.generate();
+        auto speed = [fileSize](qint64 elapsed, uint64_t size = 0) {
+            return double(size ? size : fileSize) / (1024 * 1024) * 1000 / std::max<qint64>(elapsed, 1);
+        };
+
+        QElapsedTimer timer;
+        timer.start();
+        QVERIFY(key.encryptFile(path, encrypted));
+        const qint64 encryptTime = timer.restart();
+        QVERIFY(key.decryptFile(encrypted, decrypted));
+        const qint64 decryptTime = timer.restart();
+        {
+            MappedFile plain(path), result(decrypted);
+            QCOMPARE(result.size(), fileSize);
+            QVERIFY(plain.slice(0, fileSize) == result.slice(0, fileSize));
+        }
+        const auto overhead = std::filesystem::file_size(encrypted) - fileSize;
+        qDebug() << "[FileCipher] new format: encrypt" << speed(encryptTime) << "MB/s, decrypt"
+                 << speed(decryptTime) << "MB/s, overhead" << double(overhead) * 100 / fileSize << "%";
+
+        // random access to chunks, modified and truncated files
+        FileCipher cipher(key.secretKey());
+        QVERIFY(cipher.open(encrypted));
+        QCOMPARE(cipher.size(), fileSize);
+        const uint64_t lastChunk = cipher.chunkCount() - 1;
+        std::string chunk;
+        QVERIFY(cipher.readChunk(lastChunk, chunk));
+        QCOMPARE(chunk.size(), std::size_t(fileSize - lastChunk * cipher.chunkSize()));
+        {
+            MappedFile plain(path);
+            QVERIFY(plain.slice(lastChunk * cipher.chunkSize(), chunk.size()) == chunk);
+        }
+        {
+            std::fstream stream(encrypted, std::ios::in | std::ios::out | std::ios::binary);
+            const auto position = std::streamoff(FileCipher::HEADER_SIZE + cipher.chunkSize()
+                                                 + FileCipher::CHUNK_OVERHEAD + 100);
+            stream.seekg(position);
+            const char byte = char(stream.get());
+            stream.seekp(position);
+            stream.put(char(~byte));
+        }
+        QVERIFY(cipher.open(encrypted));
+        QVERIFY(cipher.readChunk(0, chunk));
+        QVERIFY(!cipher.readChunk(1, chunk));
+        std::filesystem::resize_file(encrypted, std::filesystem::file_size(encrypted) - 1);
+        QVERIFY(!key.decryptFile(encrypted, decrypted));
+
+        // old format: asymmetric encryption of every encSectionSize bytes
+        {
+            MappedFile plain(path);
+            std::ofstream stream(encrypted, std::ios::binary | std::ios::trunc);
+            timer.restart();
+            for (uint64_t offset = 0; offset < oldFormatSize; offset += DFSB::encSectionSize) {
+                const std::string block =
+                    key.encryptSelf(std::string(plain.slice(offset, DFSB::encSectionSize)));
+                stream << Tools::typeToStdStringBytes<int>(int(block.size())) << block;
+            }
+        }
+        const qint64 oldEncryptTime = timer.restart();
+        QVERIFY(key.decryptFile(encrypted, decrypted));
+        const qint64 oldDecryptTime = timer.restart();
+        QCOMPARE(std::filesystem::file_size(decrypted), oldFormatSize);
+        const auto oldOverhead = std::filesystem::file_size(encrypted) - oldFormatSize;
+        qDebug() << "[FileCipher] old format: encrypt" << speed(oldEncryptTime, oldFormatSize)
+                 << "MB/s, decrypt" << speed(oldDecryptTime, oldFormatSize) << "MB/s, overhead"
+                 << double(oldOverhead) * 100 / oldFormatSize << "%";
+
+        for (const auto &file : { path, encrypted, decrypted })
+            std::filesystem::remove(file);
+    }
+
+    void dfsChunking() {
+        // synthetic corpus: every base file is stored by two actors, third actor stores edited copies
+        const int baseFiles = qEnvironmentVariableIsSet("EXTRACHAIN_BENCHMARK") ? 32 : 8;
+        const uint64_t fileSize = 4 * 1024 * 1024;
+        const std::string storePath = "dfs-chunks";
+        const std::vector<std::string> actors = { "0000000000000chunk-a", "0000000000000chunk-b",
+                                                  "0000000000000chunk-c" };
+        std::filesystem::remove_all(storePath);
+
+        std::mt19937_64 random(42);
+        std::vector<std::string> bases;
+        auto store = [](const std::string &actorId, const std::string &fileName, const std::string &data) {
+            std::filesystem::create_directories(DFS_PATH::filePath(actorId, "").parent_path());
+            std::ofstream(DFS_PATH::filePath(actorId, fileName), std::ios::binary | std::ios::trunc) << data;
+        };
+        for (int i = 0; i < baseFiles; i++) {
+            std::string data(fileSize, '\0');
+            for (auto &byte : data)
+                byte = char(random());
+            std::string edited = data;
+            edited.insert(fileSize / 3, "inserted bytes");
+            edited.erase(2 * fileSize / 3, 100);
+            store(actors[0], "file-" + std::to_string(i), data);
+            store(actors[1], "copy-" + std::to_string(i), data);
+            store(actors[2], "edit-" + std::to_string(i), edited);
+            bases.push_back(std::move(data));
+        }
+
+        ChunkStore chunks(storePath);
+        QElapsedTimer timer;
+        timer.start();
+        std::vector<std::vector<DFSP::ChunkRef>> manifests;
+        for (int i = 0; i < baseFiles; i++) {
+            manifests.push_back(chunks.addFile(actors[0], "file-" + std::to_string(i)));
+            chunks.addFile(actors[1], "copy-" + std::to_string(i));
+            manifests.push_back(chunks.addFile(actors[2], "edit-" + std::to_string(i)));
+        }
+        const qint64 elapsed = std::max<qint64>(timer.elapsed(), 1);
+
+        const auto stats = chunks.stats();
+        QCOMPARE(stats.files, uint64_t(3 * baseFiles));
+        QVERIFY(stats.dedupRatio() > 2.9);
+        qDebug() << "[DfsChunking] ingest" << double(stats.referencedBytes) / (1024 * 1024) * 1000 / elapsed
+                 << "MB/s," << stats.chunks << "unique chunks, average"
+                 << stats.uniqueBytes / std::max<uint64_t>(stats.chunks, 1) << "bytes, dedup ratio"
+                 << stats.dedupRatio();
+
+        // edits change only chunks around them
+        for (int i = 0; i < baseFiles; i++) {
+            const auto &original = manifests[2 * i], &edited = manifests[2 * i + 1];
+            std::set<std::string> hashes;
+            for (const auto &chunk : original) {
+                QVERIFY((chunk.Size >= Chunker::MIN_SIZE && chunk.Size <= Chunker::MAX_SIZE)
+                        || &chunk == &original.back());
+                hashes.insert(chunk.Hash);
+            }
+            const auto changed = std::count_if(edited.begin(), edited.end(), [&hashes](const auto &chunk) {
+                return !hashes.count(chunk.Hash);
+            });
+            // two edits, each changes its chunk and up to three after it until cuts
+            // skipped by minimum size realign (at most 7 over 400 random files)
+            QVERIFY(changed <= 8);
+        }
+        QCOMPARE(chunks.manifest(actors[0], "file-0").size(), manifests[0].size());
+        const auto &second = manifests[0][1];
+        QCOMPARE(chunks.read(second.Hash), bases[0].substr(manifests[0][0].Size, second.Size));
+
+        // every chunk is stored once, copy of file is rebuilt from chunks
+        uint64_t storedBytes = 0;
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(storePath))
+            if (entry.is_regular_file() && entry.path().filename() != "index")
+                storedBytes += entry.file_size();
+        QCOMPARE(storedBytes, stats.uniqueBytes);
+        QVERIFY(storedBytes < 2 * baseFiles * fileSize);
+        const auto copyPath = DFS_PATH::filePath(actors[1], "copy-0");
+        std::filesystem::remove(copyPath);
+        QVERIFY(chunks.restore(actors[1], "copy-0", copyPath));
+        std::ifstream restored(copyPath, std::ios::binary);
+        QVERIFY(std::string(std::istreambuf_iterator<char>(restored), {}) == bases[0]);
+
+        // receiver of edited file needs only missing chunks
+        chunks.removeFile(actors[2], "edit-0");
+        const std::string partPath = "dfs-chunks.part";
+        std::ofstream(partPath, std::ios::binary | std::ios::trunc);
+        std::filesystem::resize_file(partPath, fileSize - 100 + 14);
+        const auto ranges = chunks.copyLocal(manifests[1], partPath);
+        uint64_t local = 0;
+        for (const auto &[offset, size] : ranges)
+            local += size;
+        QVERIFY(local > fileSize * 9 / 10 && local < fileSize);
+        qDebug() << "[DfsChunking] edited file:" << fileSize - local << "bytes to transfer of" << fileSize;
+
+        // chunks live while any file references them
+        const std::string shared = manifests[0][0].Hash;
+        QCOMPARE(chunks.references(shared), uint64_t(2));
+        chunks.removeFile(actors[0], "file-0");
+        QCOMPARE(chunks.references(shared), uint64_t(1));
+        chunks.removeFile(actors[1], "copy-0");
+        QCOMPARE(chunks.references(shared), uint64_t(0));
+        QVERIFY(chunks.read(shared).empty());
+
+        for (const auto &actorId : actors)
+            std::filesystem::remove_all(DFS_PATH::filePath(actorId, "").parent_path());
+        std::filesystem::remove(partPath);
+        std::filesystem::remove_all(storePath);
+    }
+
+    void historicalChain() {
+        const std::string actorId = "000000000000hc-actor";
+        const auto path = DFS_PATH::filePath(actorId, "file");
+        std::filesystem::create_directories(path.parent_path());
+        std::mt19937_64 random(7);
+        std::string state(256 * 1024, '\0');
+        for (auto &byte : state)
+            byte = char('a' + random() % 26);
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << state;
+
+        const uint64_t edits = 1000;
+        std::vector<std::string> versions = { state };
+        {
+            HistoricalChain chain(path.string() + DFSF::Extension, path.string());
+            QVERIFY(chain.initLocal(actorId, "file", ""));
+            for (uint64_t i = 1; i <= edits; i++) {
+                const uint64_t offset = random() % (state.size() + 1);
+                std::string data(1 + random() % 100, char('A' + i % 26));
+                DFSP::EditSegmentMessage msg = { .Actor = actorId,
+                                                 .FileName = "file",
+                                                 .FileHash = "",
+                                                 .NewFileHash = "",
+                                                 .Data = data,
+                                                 .Offset = offset,
+                                                 .ActionType = DFSP::SegmentMessageType(i % 4) };
+                if (msg.ActionType == DFSP::SegmentMessageType::remove) {
+                    DFSP::DeleteSegmentMessage remove = { .Actor = actorId,
+                                                          .FileName = "file",
+                                                          .FileHash = "",
+                                                          .Offset = offset,
+                                                          .Size = data.size() };
+                    msg = chain.makeEditSegmentMessage(remove, DFSP::SegmentMessageType::remove);
+                    state.erase(offset, data.size());
+                } else if (msg.ActionType == DFSP::SegmentMessageType::replace) {
+                    state.replace(offset, data.size(), data);
+                } else {
+                    state.insert(offset, data);
+                }
+                QVERIFY(chain.apply(msg));
+                versions.push_back(state);
+            }
+            QCOMPARE(chain.lastVersion(), std::optional<uint64_t>(edits));
+
+            // any version is rebuilt from the nearest checkpoint
+            QElapsedTimer timer;
+            timer.start();
+            uint64_t maxReplayed = 0;
+            const uint64_t oldest = edits - HistoricalChain::RETENTION / 2;
+            for (uint64_t num = oldest; num <= edits; num++) {
+                QCOMPARE(chain.version(num), std::optional<std::string>(versions[num]));
+                maxReplayed = std::max(maxReplayed, chain.replayed());
+            }
+            QVERIFY(maxReplayed < HistoricalChain::CHECKPOINT_INTERVAL);
+            qDebug() << "[HistoricalChain]" << edits - oldest + 1 << "versions rebuilt in" << timer.elapsed()
+                     << "ms, at most" << maxReplayed << "entries replayed";
+
+            QVERIFY(chain.compact(100));
+            QVERIFY(!chain.version(edits - 200));
+            QCOMPARE(chain.version(edits - 100), std::optional<std::string>(versions[edits - 100]));
+        }
+
+        // chain is kept after reopening, initLocal doesn't restart it
+        HistoricalChain chain(path.string() + DFSF::Extension, path.string());
+        QVERIFY(chain.initLocal(actorId, "file", ""));
+        QCOMPARE(chain.version(edits), std::optional<std::string>(versions[edits]));
+        std::filesystem::remove_all(path.parent_path());
+    }
+
+    void dfsReadCache() {
+        const uint64_t fileSize = 1024 * 1024;
+        std::vector<std::string> paths;
+        for (int i = 0; i < 6; i++) {
+            paths.push_back("dfs-cache-" + std::to_string(i) + ".bin");
+            std::string data(fileSize, char('a' + i));
+            std::ofstream(paths.back(), std::ios::binary | std::ios::trunc) << data;
+        }
+
+        // hot files fit, cold ones evict each other
+        MappedFileCache cache(4 * fileSize);
+        for (int round = 0; round < 10; round++)
+            for (int i = 0; i < 3; i++)
+                QCOMPARE(cache.get(paths[i])->slice(fileSize - 1, 1), std::string(1, char('a' + i)));
+        auto stats = cache.stats();
+        QCOMPARE(stats.misses, uint64_t(3));
+        QCOMPARE(stats.hits, uint64_t(27));
+        for (int i = 3; i < 6; i++)
+            cache.get(paths[i]);
+        stats = cache.stats();
+        QVERIFY(stats.bytes <= cache.capacity());
+        QCOMPARE(stats.files, uint64_t(4));
+        QCOMPARE(stats.evictions, uint64_t(2));
+
+        // held mapping outlives eviction
+        auto held = cache.get(paths[0]);
+        cache.clear();
+        QCOMPARE(held->slice(0, 1), std::string("a"));
+
+        // write after invalidation and write without it are both seen
+        std::ofstream(paths[1], std::ios::binary | std::ios::app) << "tail";
+        cache.invalidate(paths[1]);
+        QCOMPARE(cache.get(paths[1])->size(), fileSize + 4);
+        std::filesystem::resize_file(paths[1], fileSize);
+        QCOMPARE(cache.get(paths[1])->size(), fileSize);
+        QVERIFY(!cache.get("dfs-cache-missing.bin")->isOpen());
+
+        // repeated segment requests of hot files
+        std::mt19937 random(42);
+        std::vector<std::pair<int, uint64_t>> requests(20000);
+        for (auto &request : requests)
+            request = { int(random() % 3), random() % (fileSize / DFSB::sectionSize) * DFSB::sectionSize };
+        auto measure = [&](const char *name, MappedFileCache &cache) {
+            uint64_t bytes = 0;
+            QElapsedTimer timer;
+            timer.start();
+            for (const auto &[file, offset] : requests)
+                bytes += cache.get(paths[file])->slice(offset, DFSB::sectionSize).size();
+            const qint64 elapsed = std::max<qint64>(timer.elapsed(), 1);
+            const auto stats = cache.stats();
+            qDebug() << "[DfsReadCache]" << name << ":" << requests.size() << "segments in" << elapsed
+                     << "ms, hit rate" << stats.hitRate();
+            return bytes;
+        };
+        MappedFileCache uncached(0);
+        MappedFileCache cached(4 * fileSize);
+        QCOMPARE(measure("without cache", uncached), measure("with cache", cached));
+        QCOMPARE(uncached.stats().hits, uint64_t(0));
+        QVERIFY(cached.stats().hitRate() > 0.99);
+
+        for (const auto &path : paths)
+            std::filesystem::remove(path);
+    }
+
+    void threadPool() {
+        ThreadPool pool(4);
+        QCOMPARE(pool.size(), std::size_t(4));
+
+        // futures carry results and exceptions
+        auto sum = pool.submit([] { return 2 + 2; });
+        auto error = pool.submit([]() -> int { throw std::runtime_error("task"); });
+        QCOMPARE(sum.get(), 4);
+        bool thrown = false;
+        try {
+            error.get();
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        QVERIFY(thrown);
+
+        // result is delivered to thread of context
+        QObject context;
+        int result = 0;
+        QThread *resultThread = nullptr;
+        pool.submit([] { return 42; }, &context, [&](int value) {
+            result = value;
+            resultThread = QThread::currentThread();
+        });
+        QTRY_COMPARE(result, 42);
+        QCOMPARE(resultThread, QThread::currentThread());
+
+        // waiting from a worker runs queued tasks instead of waiting for its own task
+        auto helped = pool.submit([&pool] {
+            std::atomic<int> done = 0;
+            for (int i = 0; i < 100; i++)
+                pool.post([&done] {
+                    QThread::usleep(100);
+                    done++;
+                });
+            pool.waitForDone();
+            return done.load();
+        });
+        QVERIFY(helped.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+        QCOMPARE(helped.get(), 100);
+
+        // queued tasks are taken by priority
+        {
+            ThreadPool single(1);
+            std::promise<void> gate;
+            auto opened = gate.get_future().share();
+            single.post([opened] { opened.wait(); });
+            std::vector<ThreadPool::Priority> order;
+            for (auto priority : { ThreadPool::Priority::Low, ThreadPool::Priority::Normal,
+                                   ThreadPool::Priority::High })
+                single.post([&order, priority] { order.push_back(priority); }, priority);
+            gate.set_value();
+            single.waitForDone();
+            QVERIFY(order
+                    == std::vector({ ThreadPool::Priority::High, ThreadPool::Priority::Normal,
+                                     ThreadPool::Priority::Low }));
+        }
+
+        // tasks submitted from a worker are stolen by idle ones
+        std::atomic<int> nested = 0;
+        pool.post([&] {
+            for (int i = 0; i < 200; i++)
+                pool.post([&nested] {
+                    QThread::usleep(100);
+                    nested++;
+                });
+        });
+        pool.waitForDone();
+        QCOMPARE(nested.load(), 200);
+        QVERIFY(pool.stats().stolen > 0);
+
+        // previous model: a thread per task
+        std::atomic<int> executed = 0;
+        auto report = [](const char *name, int tasks, qint64 elapsed) {
+            elapsed = std::max<qint64>(elapsed, 1);
+            qDebug() << "[ThreadPool]" << name << ":" << tasks << "tasks in" << elapsed << "ms,"
+                     << double(elapsed) * 1000 / tasks << "us per task";
+        };
+        const int threadTasks = 500;
+        QElapsedTimer timer;
+        timer.start();
+        std::vector<std::unique_ptr<QThread>> threads;
+        for (int i = 0; i < threadTasks; i++) {
+            threads.emplace_back(QThread::create([&executed] { executed++; }));
+            threads.back()->start();
+        }
+        for (auto &thread : threads)
+            thread->wait();
+        report("thread per task", threadTasks, timer.elapsed());
+        QCOMPARE(executed.load(), threadTasks);
+
+        const int poolTasks = 100000;
+        executed = 0;
+        timer.restart();
+        for (int i = 0; i < poolTasks; i++)
+            pool.post([&executed] { executed++; });
+        pool.waitForDone();
+        report("pool", poolTasks, timer.elapsed());
+        QCOMPARE(executed.load(), poolTasks);
+
+        // throughput of small tasks with results
+        timer.restart();
+        std::vector<std::future<uint64_t>> hashes;
+        for (int i = 0; i < 10000; i++)
+            hashes.push_back(pool.submit([i] {
+                uint64_t hash = 1469598103934665603ull;
+                for (int j = 0; j < 1000; j++)
+                    hash = (hash ^ uint64_t(i + j)) * 1099511628211ull;
+                return hash;
+            }));
+        for (auto &hash : hashes)
+            hash.get();
+        report("pool with results", int(hashes.size()), timer.elapsed());
+    }
+
+    void logging() {
+        const int threads = 4;
+        const int perThread = 20000;
+        std::vector<int> last(threads + 1, -1);
+        uint64_t received = 0, reported = 0;
+        bool ordered = true;
+        {
+            LogWriter writer([&](std::vector<LogWriter::Record> &batch) {
+                for (const auto &record : batch) {
+                    if (record.message.startsWith("[Logs]")) {
+                        reported++;
+                        continue;
+                    }
+                    const int number = record.message.toInt();
+                    ordered = ordered && number > last[record.line];
+                    last[record.line] = number;
+                    received++;
+                }
+            });
+            std::vector<std::thread> workers;
+            for (int t = 1; t <= threads; t++)
+                workers.emplace_back([&writer, t] {
+                    for (int i = 0; i < perThread; i++)
+                        writer.push({ .message = QString::number(i), .line = t });
+                });
+            for (auto &worker : workers)
+                worker.join();
+            writer.flush();
+            const auto stats = writer.stats();
+            QCOMPARE(received + stats.dropped, uint64_t(threads * perThread));
+            QCOMPARE(reported > 0, stats.dropped > 0);
+            qDebug() << "[Logging] batches:" << stats.batches << "dropped:" << stats.dropped;
+        }
+        QVERIFY(ordered);
+
+        // same messages through LogsManager, synchronous and asynchronous
+        const QString logsPath = LogsManager::logsPath;
+        const qint64 maxFileSize = LogsManager::maxFileSize;
+        const int maxFiles = LogsManager::maxFiles;
+        LogsManager::logsPath = "test-logs";
+        LogsManager::setRotation(256 * 1024, 3);
+        LogsManager::offConsole();
+        LogsManager::offQml();
+        LogsManager::onFile();
+        auto measure = [&](const char *name, auto log) {
+            QElapsedTimer timer;
+            timer.start();
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; t++)
+                workers.emplace_back([&log, t] {
+                    for (int i = 0; i < perThread / 4; i++)
+                        log(QString("[Logging] thread %1 message %2").arg(t).arg(i));
+                });
+            for (auto &worker : workers)
+                worker.join();
+            const qint64 logged = timer.nsecsElapsed();
+            LogsManager::flush();
+            qDebug() << "[Logging]" << name << ":" << double(logged) / (threads * perThread / 4)
+                     << "ns per call," << timer.elapsed() << "ms until written";
+        };
+        measure("synchronous", [](const QString &message) { LogsManager::makeLog("", 0, "", message); });
+        qInstallMessageHandler(LogsManager::messageHandler);
+        LogsManager::setAsync(true);
+        measure("asynchronous", [](const QString &message) { qInfo().noquote() << message; });
+        LogsManager::qtHandler();
+
+        const auto files = QDir("test-logs").entryInfoList({ "extrachain-*.log" }, QDir::Files);
+        QVERIFY(files.size() > 1);
+        QVERIFY(files.size() <= 3);
+
+        LogsManager::onConsole();
+        LogsManager::onQml();
+        LogsManager::offFile();
+        LogsManager::setRotation(maxFileSize, maxFiles);
+        LogsManager::logsPath = logsPath;
+        QDir("test-logs").removeRecursively();
+    }
+
+    void metrics() {
+        Metrics::Registry registry;
+        auto &counter = registry.counter("test_events_total", "Events", { { "kind", "a\"b" } });
+        counter.inc();
+        counter.inc(2);
+        QCOMPARE(&registry.counter("test_events_total", "Events", { { "kind", "a\"b" } }), &counter);
+        registry.gauge("test_depth", "Depth").set(-3);
+        auto &histogram = registry.histogram("test_seconds", "Time", {}, { 0.1, 1 });
+
+        const int threads = 4;
+        const int perThread = 50000;
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++)
+            workers.emplace_back([&histogram] {
+                for (int i = 0; i < perThread; i++)
+                    histogram.observe(i % 2 ? 0.05 : 5);
+            });
+        for (auto &worker : workers)
+            worker.join();
+        QCOMPARE(histogram.count(), uint64_t(threads * perThread));
+        QCOMPARE(histogram.cumulative(), std::vector<uint64_t>({ threads * perThread / 2,
+                                                                 threads * perThread / 2,
+                                                                 threads * perThread }));
+
+        const std::string text = registry.expose();
+        QVERIFY(text.find("# TYPE test_events_total counter\n") != std::string::npos);
+        QVERIFY(text.find("test_events_total{kind=\"a\\\"b\"} 3\n") != std::string::npos);
+        QVERIFY(text.find("test_depth -3\n") != std::string::npos);
+        QVERIFY(text.find("test_seconds_bucket{le=\"0.1\"} 100000\n") != std::string::npos);
+        QVERIFY(text.find("test_seconds_bucket{le=\"+Inf\"} 200000\n") != std::string::npos);
+        QVERIFY(text.find("test_seconds_count 200000\n") != std::string::npos);
+
+        // scrape over loopback
+        Metrics::counter("test_scrapes_total", "Scrapes").inc();
+        MetricsServer server;
+        QVERIFY(server.listen(0));
+        auto request = [&server](const QByteArray &path) {
+            auto socket = std::make_unique<QTcpSocket>();
+            socket->connectToHost(QHostAddress::LocalHost, server.port());
+            socket->write("GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+            return socket;
+        };
+        auto socket = request("/metrics");
+        QTRY_COMPARE_WITH_TIMEOUT(socket->state(), QAbstractSocket::UnconnectedState, 5000);
+        const QByteArray page = socket->readAll();
+        QVERIFY(page.startsWith("HTTP/1.1 200 OK"));
+        QVERIFY(page.contains("test_scrapes_total 1\n"));
+        socket = request("/other");
+        QTRY_COMPARE_WITH_TIMEOUT(socket->state(), QAbstractSocket::UnconnectedState, 5000);
+        QVERIFY(socket->readAll().startsWith("HTTP/1.1 404"));
+    }
+
+    void dbBatch() {
+        std::filesystem::remove("test-batch.db");
+        {
+            DBConnector db("test-batch.db");
+            QVERIFY(db.open());
+            db.query("CREATE TABLE balances "
+                     "(actor TEXT NOT NULL, token TEXT NOT NULL, state TEXT NOT NULL);");
+            db.query("CREATE UNIQUE INDEX balancesKey ON balances (actor, token);");
+            const std::string upsert = "INSERT INTO balances (actor, token, state) VALUES (?, ?, ?) "
+                                       "ON CONFLICT (actor, token) DO UPDATE SET state = excluded.state;";
+
+            std::vector<std::vector<std::string>> rows;
+            for (int i = 0; i < 1000; i++)
+                rows.push_back({ "actor" + std::to_string(i % 100), "token", std::to_string(i) });
+            QVERIFY(db.execMany(upsert, rows));
+            QCOMPARE(db.count("balances"), qint64(100));
+
+            const auto found =
+                db.selectMany("SELECT state FROM balances WHERE actor = ? AND token = ?;",
+                              { { "actor7", "token" }, { "none", "token" }, { "actor42", "token" } });
+            QCOMPARE(found.size(), std::size_t(2));
+            QCOMPARE(found[0].at("state"), std::string("907"));
+            QCOMPARE(found[1].at("state"), std::string("942"));
+
+            // failed run changes nothing, also inside of an open transaction
+            QVERIFY(!db.execMany("INSERT INTO balances (actor, token, state) VALUES (?, ?, ?);",
+                                 { { "new", "token", "1" }, { "actor1", "token", "1" } }));
+            QCOMPARE(db.count("balances"), qint64(100));
+            QVERIFY(db.query("BEGIN TRANSACTION;"));
+            QVERIFY(db.execMany(upsert, { { "new", "token", "1" } }));
+            QVERIFY(db.query("COMMIT;"));
+            QCOMPARE(db.count("balances"), qint64(101));
+        }
+        std::filesystem::remove("test-batch.db");
+    }
+
+    void amount() {
+        QCOMPARE(Amount::fromVisible("1.5").toStdString(), std::string("1500000000000000000"));
+        QCOMPARE(Amount::fromVisible("-0.000000000000000001"), Amount(-1));
+        QCOMPARE(Amount::fromVisible("2.50").toVisible(), std::string("2.5"));
+        QVERIFY(Amount::fromVisible("0.0000000000000000001").isEmpty());
+        QCOMPARE(Amount::fromVisible("0.1") + Amount::fromVisible("0.2"), Amount::fromVisible("0.3"));
+        QCOMPARE(Amount::fromVisible("1.5").mul(Amount::fromVisible("3")), Amount::fromVisible("4.5"));
+
+        // text and hash form of older versions
+        QCOMPARE(Amount::fromString("1.5e+18"), Amount::fromVisible("1.5"));
+        QCOMPARE(Amount::fromVisible("1.5").toLegacyString(), std::string("1.5e+18"));
+
+        const Amount max(std::numeric_limits<Amount::Units>::max());
+        QVERIFY_THROWS_EXCEPTION(std::overflow_error, max + Amount(1));
+        for (const Amount &amount : { Amount(), Amount(-129), Amount::unit(), -max, max }) {
+            const auto serialized = MessagePack::serialize(amount);
+            QCOMPARE(MessagePack::deserialize<Amount>(serialized), amount);
+        }
+        QCOMPARE(MessagePack::serialize(Amount::unit()).size(), std::size_t(10));
+
+        Transaction tx(ActorId(), ActorId(), Amount::fromVisible("12.345"));
+        QCOMPARE(Transaction(tx.serialize()).getAmount(), Amount::fromVisible("12.345"));
+        QCOMPARE(Transaction(tx.serialize()).getHash(), tx.getHash());
+
+        // exact units are hashed, amounts differing in the last unit have different hashes
+        Transaction nextUnit(tx);
+        nextUnit.setAmount(tx.getAmount() + Amount(1));
+        QVERIFY(nextUnit.getDataForHash() != tx.getDataForHash());
+        QVERIFY(Transaction(nextUnit).getHash() != Transaction(tx).getHash());
+
+        // amount of older versions is text, it stays in hash and in serialized tx
+        const auto legacySerialized = MessagePack::serialize(std::make_tuple(
+            ActorId(), ActorId(), std::string("1.5e+18"), tx.getDate(), std::string(), ActorId(),
+            BigNumber(0), 0, 0, std::string(), ActorId(), ActorId(), std::string(), TypeTx::Transaction));
+        Transaction legacy(legacySerialized);
+        QVERIFY(legacy.hasLegacyAmount());
+        QCOMPARE(legacy.getAmount(), Amount::fromVisible("1.5"));
+        QVERIFY(legacy.getDataForHash().find("1.5e+18") != std::string::npos);
+        Transaction relayed(legacy.serialize());
+        QVERIFY(relayed.hasLegacyAmount());
+        QCOMPARE(relayed.getHash(), legacy.getHash());
+        QVERIFY(!tx.hasLegacyAmount());
+    }
+
+    void binaryEncoding() {
+        const BigNumber large("123456789abcdef0123456789abcdef");
+        for (const BigNumber &number : { BigNumber(), BigNumber(255), BigNumber(-1000), large, -large }) {
+            const auto serialized = MessagePack::serialize(number);
+            QCOMPARE(MessagePack::deserialize<BigNumber>(serialized), number);
+        }
+        QCOMPARE(MessagePack::serialize(BigNumber(255)).size(), std::size_t(2));
+        // hex string of older versions
+        const auto legacy = MessagePack::serialize(std::string("ff"));
+        QCOMPARE(MessagePack::deserialize<BigNumber>(legacy), BigNumber(255));
+
+        const ActorId id(std::string("0123456789abcdef0123"));
+        QCOMPARE(MessagePack::serialize(id).size(), std::size_t(13));
+        QCOMPARE(MessagePack::deserialize<ActorId>(MessagePack::serialize(id)), id);
+        QCOMPARE(MessagePack::deserialize<ActorId>(MessagePack::serialize(id.toStdString())), id);
+        const ActorId text(std::string("0123456789ABCDEF0123"));
+        QCOMPARE(MessagePack::deserialize<ActorId>(MessagePack::serialize(text)), text);
+
+        // block of older versions has ids and numbers of its txs as strings, its hash stays valid
+        const std::string legacyTx = MessagePack::serialize(std::make_tuple(
+            id.toStdString(), id.toStdString(), std::string("1.5e+18"), 0LL, std::string(), std::string(),
+            std::string("ff"), 0, 0, std::string(), std::string(), std::string(), std::string(),
+            TypeTx::Transaction));
+        QVERIFY(Transaction(legacyTx).serialize() != legacyTx);
+        const std::string hash = Utils::calcHash(Utils::calcHash(BigNumber(0).toStdString())
+                                                 + Utils::calcHash(legacyTx));
+        const Block block(QByteArray::fromStdString(MessagePack::serialize(
+            std::make_tuple(Config::DATA_BLOCK_TYPE, BigNumber(0).toStdString(), 0LL,
+                            Serialization::serialize({ legacyTx }), hash, std::string(),
+                            std::vector<Approvers>()))));
+        QCOMPARE(block.extractTransactions().size(), std::size_t(1));
+        QVERIFY(block.checkHash());
+    }
+
+    void bigNumberSmall() {
+        const BigNumber max(std::numeric_limits<long long>::max());
+        BigNumber promoted = max;
+        ++promoted;
+        QCOMPARE(promoted, BigNumber("8000000000000000"));
+        QCOMPARE(promoted.toStdString(10), std::string("9223372036854775808"));
+        QVERIFY(promoted > max);
+        QCOMPARE(promoted - 1, max);
+        QCOMPARE(max * BigNumber(16), BigNumber("7fffffffffffffff0"));
+        QCOMPARE(-BigNumber(std::numeric_limits<long long>::min()), promoted);
+
+        QCOMPARE(BigNumber("-FF").toStdString(), std::string("-ff"));
+        QCOMPARE(BigNumber("0000000000000000000a"), BigNumber(10));
+        QCOMPARE(BigNumber("0x1f"), BigNumber(31)); // parsed as before
+        QCOMPARE(BigNumber("123456789abcdef0123").toStdString(), std::string("123456789abcdef0123"));
+        QCOMPARE(BigNumber("-42", 10), BigNumber(-42));
+        QVERIFY_THROWS_EXCEPTION(std::overflow_error, BigNumber(1) / BigNumber(0));
+    }
+
+    void actorDirectory() {
+        const std::string folder = "actor-directory/";
+        std::filesystem::remove_all(folder);
+        std::filesystem::create_directories(folder);
+        std::vector<Actor<KeyPrivate>> actors(4);
+        for (auto &actor : actors)
+            actor.create(ActorType::User);
+
+        {
+            ActorDirectory directory(folder, 2);
+            for (int i = 0; i < 3; i++)
+                QCOMPARE(directory.add(actors[i].convertToPublic()), 0);
+            QCOMPARE(directory.add(actors[0].convertToPublic()), Errors::FILE_ALREADY_EXISTS);
+            QCOMPARE(directory.stats().actors, uint64_t(2));
+            QVERIFY(directory.stats().evictions > 0);
+
+            const auto stored = directory.get(actors[1].id());
+            QVERIFY(stored);
+            QCOMPARE(stored->key().publicKey(), actors[1].key().publicKey());
+            QVERIFY(!directory.get(ActorId("00000000000000000abc")));
+        }
+
+        // json file of older versions is moved into table
+        const std::string id = actors[3].id().toStdString();
+        const std::string legacyPath = folder + id.substr(18) + "/" + id;
+        std::filesystem::create_directories(folder + id.substr(18));
+        std::ofstream(legacyPath) << actors[3].convertToPublic().toJson().toStdString();
+        ActorDirectory directory(folder);
+        QCOMPARE(directory.count(), uint64_t(3));
+        const auto moved = directory.get(actors[3].id());
+        QVERIFY(moved);
+        QCOMPARE(moved->key().publicKey(), actors[3].key().publicKey());
+        QVERIFY(!std::filesystem::exists(legacyPath));
+        QCOMPARE(directory.count(), uint64_t(4));
+        QVERIFY(directory.get(actors[3].id()));
+        QCOMPARE(directory.stats().hits, uint64_t(1));
+        std::filesystem::remove_all(folder);
+    }
+
+    void memIndex() {
+        Actor<KeyPrivate> approver;
+        approver.create(ActorType::User);
+        std::vector<Block> chain;
+        Block prev;
+        for (int i = 0; i < 6; i++) {
+            Block block(std::string("mem ") + std::to_string(i), prev);
+            block.sign(approver);
+            chain.push_back(block);
+            prev = block;
+        }
+
+        MemIndex index(4);
+        for (int i = 0; i < 4; i++)
+            QCOMPARE(index.addBlock(chain[i]), 0);
+        QCOMPARE(index.addBlock(chain[2]), 1);
+        QCOMPARE(index[BigNumber(2)].getHash(), chain[2].getHash());
+        QCOMPARE(index.getByHash(QByteArray::fromStdString(chain[1].getHash())).getIndex(), BigNumber(1));
+        const BigNumber approverId(approver.id().toStdString());
+        QCOMPARE(index.getByApprover(approverId).getIndex(), BigNumber(3));
+
+        // oldest blocks are dropped
+        QCOMPARE(index.addBlock(chain[5]), 0);
+        QVERIFY(!index.contains(BigNumber(1)));
+        QCOMPARE(index.getRecords(), 3);
+        QCOMPARE(index.getByPosition(0).getIndex(), BigNumber(2));
+        QCOMPARE(index.addBlock(chain[0]), 2);
+        QCOMPARE(index.removeById(BigNumber(5)), 0);
+        QCOMPARE(index.getLastBlock().getIndex(), BigNumber(3));
+    }
+
     void createNetwork() {
         LogsManager::qtHandler();
         QDir().mkdir("test-data");
@@ -114,6 +1445,25 @@ private slots:
         QVERIFY(isCreated);
     }
 
+    void txProving() {
+        auto *txManager = node->txManager();
+        const auto &actor = node->accountController()->mainActor();
+        // sender is receiver, rejected
+        Transaction tx(actor.id(), actor.id(), Amount(1));
+        tx.sign(actor);
+        const std::string hash = tx.getHash();
+
+        txManager->addTransaction(tx);
+        QVERIFY(txManager->txState(hash) == TransactionManager::TxState::Received);
+        QTRY_VERIFY(txManager->txState(hash) == TransactionManager::TxState::Rejected);
+        QVERIFY(!txManager->getReceivedTxList().contains(tx));
+
+        // known tx is not proved again
+        txManager->addTransaction(tx);
+        QVERIFY(txManager->txState(hash) == TransactionManager::TxState::Rejected);
+        QVERIFY(!txManager->getReceivedTxList().contains(tx));
+    }
+
     void blocks() {
         //        Block a;
         //        Block b;